@@ -631,7 +631,6 @@ void Init_gsl_blas1(VALUE module)
   rb_define_method(cgsl_vector, "blas_dnrm", rb_gsl_blas_dnrm, -1);
   rb_define_alias(cgsl_vector, "dnrm", "blas_dnrm");
   rb_define_alias(cgsl_vector, "nrm", "blas_dnrm");
-  rb_define_alias(cgsl_vector, "sumsq", "blas_dnrm");
 
   rb_define_module_function(module, "dznrm2", rb_gsl_blas_dznrm2, -1);
   rb_define_method(cgsl_vector_complex, "blas_dznrm2", rb_gsl_blas_dznrm2, -1);
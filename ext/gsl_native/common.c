@@ -71,6 +71,13 @@ VALUE rb_gsl_obj_read_only(int argc, VALUE *argv, VALUE obj)
   rb_raise(rb_eRuntimeError, "Read only object.");
 }
 
+/* Looks up the symbol key in an option hash, nil-safe */
+VALUE rb_gsl_hash_get(VALUE hash, const char *key)
+{
+  if (NIL_P(hash)) return Qnil;
+  return rb_hash_aref(hash, ID2SYM(rb_intern(key)));
+}
+
 int str_tail_grep(const char *s0, const char *s1)
 {
   int len0, len1;
@@ -13,6 +13,7 @@
 #include "include/rb_gsl_array.h"
 
 #include "include/rb_gsl_eigen.h"
+#include "include/rb_gsl_workspace_pool.h"
 #include "include/rb_gsl_complex.h"
 #include <gsl/gsl_complex.h>
 #include <gsl/gsl_complex_math.h>
@@ -121,7 +122,7 @@ static VALUE rb_gsl_eigen_symm_narray(int argc, VALUE *argv, VALUE obj)
       rb_raise(rb_eRuntimeError, "square matrix required");
     A = gsl_matrix_alloc(na->shape[1], na->shape[0]);
     memcpy(A->data, (double*) na->ptr, sizeof(double)*A->size1*A->size2);
-    w = gsl_eigen_symm_alloc(A->size1);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_symm, A->size1);
     flagw = 1;
     break;
   default:
@@ -134,7 +135,7 @@ static VALUE rb_gsl_eigen_symm_narray(int argc, VALUE *argv, VALUE obj)
   gsl_eigen_symm(A, &vv.vector, w);
   /*  gsl_sort_vector(v);*/
   gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_symm_free(w);
+  if (flagw == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_symm, w);
   return nary;
 }
 #endif
@@ -169,7 +170,7 @@ static VALUE rb_gsl_eigen_symm_nmatrix(int argc, VALUE *argv, VALUE obj)
     flagw = 0;
     break;
   case 1:
-    w = gsl_eigen_symm_alloc(A->size1);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_symm, A->size1);
     flagw = 1;
     break;
   default:
@@ -182,7 +183,7 @@ static VALUE rb_gsl_eigen_symm_nmatrix(int argc, VALUE *argv, VALUE obj)
   gsl_eigen_symm(A, &vv.vector, w);
   /*  gsl_sort_vector(v);*/
   gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_symm_free(w);
+  if (flagw == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_symm, w);
   return nmatrix;
 }
 #endif
@@ -224,7 +225,7 @@ static VALUE rb_gsl_eigen_symm(int argc, VALUE *argv, VALUE obj)
 #endif
       CHECK_MATRIX(argv[0]);
       Data_Get_Struct(argv[0], gsl_matrix, Atmp);
-      w = gsl_eigen_symm_alloc(Atmp->size1);
+      w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_symm, Atmp->size1);
       flagw = 1;
       break;
     default:
@@ -244,7 +245,7 @@ static VALUE rb_gsl_eigen_symm(int argc, VALUE *argv, VALUE obj)
       Data_Get_Struct(argv[0], gsl_eigen_symm_workspace, w);
       break;
     case 0:
-      w = gsl_eigen_symm_alloc(Atmp->size1);
+      w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_symm, Atmp->size1);
       flagw = 1;
       break;
     default:
@@ -256,7 +257,7 @@ static VALUE rb_gsl_eigen_symm(int argc, VALUE *argv, VALUE obj)
   gsl_eigen_symm(A, v, w);
   /*  gsl_sort_vector(v);*/
   gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_symm_free(w);
+  if (flagw == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_symm, w);
   return Data_Wrap_Struct(cgsl_eigen_values, 0, gsl_vector_free, v);
 }
 
@@ -299,7 +300,7 @@ static VALUE rb_gsl_eigen_symmv_narray(int argc, VALUE *argv, VALUE obj)
       rb_raise(rb_eRuntimeError, "square matrix required");
     A = gsl_matrix_alloc(na->shape[1], na->shape[0]);
     memcpy(A->data, (double*) na->ptr, sizeof(double)*A->size1*A->size2);
-    w = gsl_eigen_symmv_alloc(A->size1);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_symmv, A->size1);
     flagw = 1;
     break;
   default:
@@ -316,7 +317,7 @@ static VALUE rb_gsl_eigen_symmv_narray(int argc, VALUE *argv, VALUE obj)
   gsl_eigen_symmv(A, &vv.vector, &mv.matrix, w);
   /*  gsl_sort_vector(v);*/
   gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_symmv_free(w);
+  if (flagw == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_symmv, w);
   return rb_ary_new3(2, eval, evec);
 }
 #endif
@@ -360,7 +361,7 @@ static VALUE rb_gsl_eigen_symmv_nmatrix(int argc, VALUE *argv, VALUE obj)
       rb_raise(rb_eRuntimeError, "square matrix required");
     A = gsl_matrix_alloc(nm->shape[1], nm->shape[0]);
     memcpy(A->data, (double*) nm->elements, sizeof(double)*A->size1*A->size2);
-    w = gsl_eigen_symmv_alloc(A->size1);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_symmv, A->size1);
     flagw = 1;
     break;
   default:
@@ -377,7 +378,7 @@ static VALUE rb_gsl_eigen_symmv_nmatrix(int argc, VALUE *argv, VALUE obj)
   gsl_eigen_symmv(A, &vv.vector, &mv.matrix, w);
   /*  gsl_sort_vector(v);*/
   gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_symmv_free(w);
+  if (flagw == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_symmv, w);
   return rb_ary_new3(2, eval, evec);
 }
 #endif
@@ -420,7 +421,7 @@ static VALUE rb_gsl_eigen_symmv(int argc, VALUE *argv, VALUE obj)
 #endif
       CHECK_MATRIX(argv[0]);
       Data_Get_Struct(argv[0], gsl_matrix, Atmp);
-      w = gsl_eigen_symmv_alloc(Atmp->size1);
+      w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_symmv, Atmp->size1);
       flagw = 1;
       break;
     default:
@@ -439,7 +440,7 @@ static VALUE rb_gsl_eigen_symmv(int argc, VALUE *argv, VALUE obj)
       Data_Get_Struct(argv[0], gsl_eigen_symmv_workspace, w);
       break;
     case 0:
-      w = gsl_eigen_symmv_alloc(Atmp->size1);
+      w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_symmv, Atmp->size1);
       flagw = 1;
       break;
     default:
@@ -453,7 +454,7 @@ static VALUE rb_gsl_eigen_symmv(int argc, VALUE *argv, VALUE obj)
   gsl_eigen_symmv(A, v, em, w);
   /*  gsl_eigen_symmv_sort(v, em, GSL_EIGEN_SORT_VAL_DESC);*/
   gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_symmv_free(w);
+  if (flagw == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_symmv, w);
   vval = Data_Wrap_Struct(cgsl_eigen_values, 0, gsl_vector_free, v);
   vvec = Data_Wrap_Struct(cgsl_eigen_vectors, 0, gsl_matrix_free, em);
   return rb_ary_new3(2, vval, vvec);
@@ -483,7 +484,7 @@ static VALUE rb_gsl_eigen_herm(int argc, VALUE *argv, VALUE obj)
     case 1:
       CHECK_MATRIX_COMPLEX(argv[0]);
       Data_Get_Struct(argv[0], gsl_matrix_complex, Atmp);
-      w = gsl_eigen_herm_alloc(Atmp->size1);
+      w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_herm, Atmp->size1);
       flagw = 1;
       break;
     default:
@@ -502,7 +503,7 @@ static VALUE rb_gsl_eigen_herm(int argc, VALUE *argv, VALUE obj)
       Data_Get_Struct(argv[0], gsl_eigen_herm_workspace, w);
       break;
     case 0:
-      w = gsl_eigen_herm_alloc(Atmp->size1);
+      w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_herm, Atmp->size1);
       flagw = 1;
       break;
     default:
@@ -514,7 +515,7 @@ static VALUE rb_gsl_eigen_herm(int argc, VALUE *argv, VALUE obj)
   gsl_eigen_herm(A, v, w);
   /*  gsl_sort_vector(v);*/
   gsl_matrix_complex_free(A);
-  if (flagw == 1) gsl_eigen_herm_free(w);
+  if (flagw == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_herm, w);
   return Data_Wrap_Struct(cgsl_eigen_values, 0, gsl_vector_free, v);
 }
 
@@ -542,7 +543,7 @@ static VALUE rb_gsl_eigen_hermv(int argc, VALUE *argv, VALUE obj)
     case 1:
       CHECK_MATRIX_COMPLEX(argv[0]);
       Data_Get_Struct(argv[0], gsl_matrix_complex, Atmp);
-      w = gsl_eigen_hermv_alloc(Atmp->size1);
+      w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_hermv, Atmp->size1);
       flagw = 1;
       break;
     default:
@@ -561,7 +562,7 @@ static VALUE rb_gsl_eigen_hermv(int argc, VALUE *argv, VALUE obj)
       Data_Get_Struct(argv[0], gsl_eigen_hermv_workspace, w);
       break;
     case 0:
-      w = gsl_eigen_hermv_alloc(Atmp->size1);
+      w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_hermv, Atmp->size1);
       flagw = 1;
       break;
     default:
@@ -574,7 +575,7 @@ static VALUE rb_gsl_eigen_hermv(int argc, VALUE *argv, VALUE obj)
   gsl_eigen_hermv(A, v, em, w);
   /*  gsl_eigen_hermv_sort(v, em, GSL_EIGEN_SORT_VAL_DESC);*/
   gsl_matrix_complex_free(A);
-  if (flagw == 1) gsl_eigen_hermv_free(w);
+  if (flagw == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_hermv, w);
   vval = Data_Wrap_Struct(cgsl_eigen_values, 0, gsl_vector_free, v);
   vvec = Data_Wrap_Struct(cgsl_eigen_herm_vectors, 0, gsl_matrix_complex_free, em);
   return rb_ary_new3(2, vval, vvec);
@@ -995,7 +996,7 @@ static VALUE rb_gsl_eigen_nonsymm_narray(int argc, VALUE *argv, VALUE obj)
       rb_raise(rb_eRuntimeError, "square matrix required");
     A = gsl_matrix_alloc(na->shape[1], na->shape[0]);
     memcpy(A->data, (double*) na->ptr, sizeof(double)*A->size1*A->size2);
-    w = gsl_eigen_nonsymm_alloc(A->size1);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_nonsymm, A->size1);
     flagw = 1;
     break;
   default:
@@ -1008,7 +1009,7 @@ static VALUE rb_gsl_eigen_nonsymm_narray(int argc, VALUE *argv, VALUE obj)
   gsl_eigen_nonsymm(A, &vv.vector, w);
   /*  gsl_sort_vector(v);*/
   gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_nonsymm_free(w);
+  if (flagw == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_nonsymm, w);
   return nary;
 }
 #endif
@@ -1041,14 +1042,14 @@ static VALUE rb_gsl_eigen_nonsymm(int argc, VALUE *argv, VALUE obj)
   switch (argc-istart) {
   case 0:
     v = gsl_vector_complex_alloc(m->size1);
-    w = gsl_eigen_nonsymm_alloc(m->size1);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_nonsymm, m->size1);
     vflag = 1;
     wflag = 1;
     break;
   case 1:
     if (CLASS_OF(argv2[0]) == cgsl_vector_complex) {
       Data_Get_Struct(argv2[0], gsl_vector_complex, v);
-      w = gsl_eigen_nonsymm_alloc(m->size1);
+      w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_nonsymm, m->size1);
       wflag = 1;
     } else if (CLASS_OF(argv2[0]) == cgsl_eigen_nonsymm_workspace) {
       v = gsl_vector_complex_alloc(m->size1);
@@ -1072,7 +1073,7 @@ static VALUE rb_gsl_eigen_nonsymm(int argc, VALUE *argv, VALUE obj)
 //  mtmp = make_matrix_clone(m);
   gsl_eigen_nonsymm(m, v, w);
 //  gsl_matrix_free(mtmp);
-  if (wflag == 1) gsl_eigen_nonsymm_free(w);
+  if (wflag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_nonsymm, w);
   if (vflag == 1)
     return Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, v);
   else
@@ -1102,7 +1103,7 @@ static VALUE rb_gsl_eigen_nonsymm_Z(int argc, VALUE *argv, VALUE obj)
   case 0:
     v = gsl_vector_complex_alloc(m->size1);
     Z = gsl_matrix_alloc(m->size1, m->size2);
-    w = gsl_eigen_nonsymm_alloc(m->size1);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_nonsymm, m->size1);
     vflag = 1;
     wflag = 1;
     break;
@@ -1133,7 +1134,7 @@ static VALUE rb_gsl_eigen_nonsymm_Z(int argc, VALUE *argv, VALUE obj)
   gsl_eigen_nonsymm_Z(m, v, Z, w);
 //  gsl_matrix_free(mtmp);
 
-  if (wflag == 1) gsl_eigen_nonsymm_free(w);
+  if (wflag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_nonsymm, w);
   if (vflag == 1) {
     vv = Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, v);
     ZZ = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, Z);
@@ -1192,7 +1193,7 @@ static VALUE rb_gsl_eigen_nonsymmv_narray(int argc, VALUE *argv, VALUE obj)
       rb_raise(rb_eRuntimeError, "square matrix required");
     A = gsl_matrix_alloc(na->shape[1], na->shape[0]);
     memcpy(A->data, (double*) na->ptr, sizeof(double)*A->size1*A->size2);
-    w = gsl_eigen_nonsymmv_alloc(A->size1);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_nonsymmv, A->size1);
     flagw = 1;
     break;
   default:
@@ -1207,7 +1208,7 @@ static VALUE rb_gsl_eigen_nonsymmv_narray(int argc, VALUE *argv, VALUE obj)
   gsl_eigen_nonsymmv(A, &vv.vector, &mm.matrix, w);
   /*  gsl_sort_vector(v);*/
   gsl_matrix_free(A);
-  if (flagw == 1) gsl_eigen_nonsymmv_free(w);
+  if (flagw == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_nonsymmv, w);
   return rb_ary_new3(2, nary, nvec);
 }
 #endif
@@ -1242,7 +1243,7 @@ static VALUE rb_gsl_eigen_nonsymmv(int argc, VALUE *argv, VALUE obj)
   case 0:
     v = gsl_vector_complex_alloc(m->size1);
     evec = gsl_matrix_complex_alloc(m->size1, m->size2);
-    w = gsl_eigen_nonsymmv_alloc(m->size1);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_nonsymmv, m->size1);
     vflag = 1;
     wflag = 1;
     break;
@@ -1259,7 +1260,7 @@ static VALUE rb_gsl_eigen_nonsymmv(int argc, VALUE *argv, VALUE obj)
   case 2:
     CHECK_VECTOR_COMPLEX(argv2[0]);
     CHECK_MATRIX_COMPLEX(argv2[1]);
-    w = gsl_eigen_nonsymmv_alloc(m->size1);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_nonsymmv, m->size1);
     wflag = 1;
     break;
   case 3:
@@ -1279,7 +1280,7 @@ static VALUE rb_gsl_eigen_nonsymmv(int argc, VALUE *argv, VALUE obj)
   gsl_eigen_nonsymmv(m, v, evec, w);
 //  gsl_matrix_free(mtmp);
 
-  if (wflag == 1) gsl_eigen_nonsymmv_free(w);
+  if (wflag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_nonsymmv, w);
   if (vflag == 1) {
     return rb_ary_new3(2,
                        Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, v),
@@ -1314,7 +1315,7 @@ static VALUE rb_gsl_eigen_nonsymmv_Z(int argc, VALUE *argv, VALUE obj)
     v = gsl_vector_complex_alloc(m->size1);
     evec = gsl_matrix_complex_alloc(m->size1, m->size2);
     Z = gsl_matrix_alloc(m->size1, m->size2);
-    w = gsl_eigen_nonsymmv_alloc(m->size1);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_nonsymmv, m->size1);
     vflag = 1;
     wflag = 1;
     break;
@@ -1332,7 +1333,7 @@ static VALUE rb_gsl_eigen_nonsymmv_Z(int argc, VALUE *argv, VALUE obj)
     CHECK_VECTOR_COMPLEX(argv2[0]);
     CHECK_MATRIX_COMPLEX(argv2[1]);
     CHECK_MATRIX(argv2[2]);
-    w = gsl_eigen_nonsymmv_alloc(m->size1);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_eigen_nonsymmv, m->size1);
     wflag = 1;
     break;
   case 4:
@@ -1354,7 +1355,7 @@ static VALUE rb_gsl_eigen_nonsymmv_Z(int argc, VALUE *argv, VALUE obj)
   gsl_eigen_nonsymmv_Z(m, v, evec, Z, w);
 //  gsl_matrix_free(mtmp);
 
-  if (wflag == 1) gsl_eigen_nonsymmv_free(w);
+  if (wflag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_eigen_nonsymmv, w);
   if (vflag == 1) {
     return rb_ary_new3(3,
                        Data_Wrap_Struct(cgsl_vector_complex, 0, gsl_vector_complex_free, v),
@@ -2199,6 +2200,8 @@ static VALUE rb_gsl_eigen_genv_sort(int argc, VALUE *argv, VALUE obj)
   return INT2FIX(gsl_eigen_genv_sort(alpha, beta, evec, type));
 }
 
+void Init_gsl_eigen_krylov(VALUE module);
+
 void Init_gsl_eigen(VALUE module)
 {
   VALUE mgsl_eigen;
@@ -2447,5 +2450,7 @@ void Init_gsl_eigen(VALUE module)
                             rb_gsl_eigen_genv_sort, -1);
   rb_define_module_function(module, "eigen_genv_sort",
                             rb_gsl_eigen_genv_sort, -1);
+
+  Init_gsl_eigen_krylov(mgsl_eigen);
 }
 
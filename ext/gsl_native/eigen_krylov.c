@@ -0,0 +1,611 @@
+/*
+  eigen_krylov.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Partial eigensolvers for a few eigenpairs of large matrices:
+  restarted Lanczos (symmetric) and Arnoldi (nonsymmetric).
+
+  Both keep a Krylov decomposition A V_m = V_m H_m + beta v_m e_m^T with
+  full (twice iterated) Gram-Schmidt orthogonalization, and restart by
+  keeping an orthonormal basis Q of the wanted Ritz vectors of H_m
+  (Krylov-Schur restart). This is mathematically equivalent to implicit
+  restarting with exact shifts, but needs no bulge chasing and handles
+  complex conjugate Ritz pairs of the Arnoldi case with real arithmetic.
+*/
+
+#include "include/rb_gsl.h"
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_eigen.h"
+#include "include/rb_gsl_function.h"
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_sort.h>
+#include <gsl/gsl_complex_math.h>
+
+#ifdef GSL_2_6_LATER
+#include <gsl/gsl_spmatrix.h>
+#include <gsl/gsl_spblas.h>
+EXTERN VALUE cgsl_spmatrix;
+#endif
+
+static VALUE cgsl_eigen_values, cgsl_eigen_vectors;
+static VALUE cgsl_eigen_complex_values, cgsl_eigen_complex_vectors;
+
+typedef struct {
+  size_t n, m;
+  gsl_matrix *V;    /* n x (m+1), orthonormal Krylov basis */
+  gsl_matrix *H;    /* (m+1) x m, projection of A */
+  gsl_vector *w;    /* n */
+  gsl_vector *h, *h2;  /* m+1, Gram-Schmidt coefficients */
+  gsl_rng *r;
+} mygsl_krylov_workspace;
+
+static mygsl_krylov_workspace* mygsl_krylov_alloc(size_t n, size_t m)
+{
+  mygsl_krylov_workspace *ws = NULL;
+  ws = ALLOC(mygsl_krylov_workspace);
+  ws->n = n;
+  ws->m = m;
+  ws->V = gsl_matrix_alloc(n, m + 1);
+  ws->H = gsl_matrix_calloc(m + 1, m);
+  ws->w = gsl_vector_alloc(n);
+  ws->h = gsl_vector_alloc(m + 1);
+  ws->h2 = gsl_vector_alloc(m + 1);
+  ws->r = gsl_rng_alloc(gsl_rng_mt19937);
+  return ws;
+}
+
+static void mygsl_krylov_free(mygsl_krylov_workspace *ws)
+{
+  gsl_matrix_free(ws->V);
+  gsl_matrix_free(ws->H);
+  gsl_vector_free(ws->w);
+  gsl_vector_free(ws->h);
+  gsl_vector_free(ws->h2);
+  gsl_rng_free(ws->r);
+  free(ws);
+}
+
+/* Orthogonalizes w against V[:,0:ncol] (classical Gram-Schmidt, twice),
+   stores the coefficients in h[0:ncol] and returns |w|. */
+static double mygsl_krylov_orthogonalize(mygsl_krylov_workspace *ws, size_t ncol,
+                                         gsl_vector *w)
+{
+  gsl_matrix_view Vj = gsl_matrix_submatrix(ws->V, 0, 0, ws->n, ncol);
+  gsl_vector_view h = gsl_vector_subvector(ws->h, 0, ncol);
+  gsl_vector_view h2 = gsl_vector_subvector(ws->h2, 0, ncol);
+  gsl_blas_dgemv(CblasTrans, 1.0, &Vj.matrix, w, 0.0, &h.vector);
+  gsl_blas_dgemv(CblasNoTrans, -1.0, &Vj.matrix, &h.vector, 1.0, w);
+  gsl_blas_dgemv(CblasTrans, 1.0, &Vj.matrix, w, 0.0, &h2.vector);
+  gsl_blas_dgemv(CblasNoTrans, -1.0, &Vj.matrix, &h2.vector, 1.0, w);
+  gsl_vector_add(&h.vector, &h2.vector);
+  return gsl_blas_dnrm2(w);
+}
+
+/* Sets V[:,j] to a random unit vector orthogonal to V[:,0:j]. */
+static void mygsl_krylov_random(mygsl_krylov_workspace *ws, size_t j)
+{
+  gsl_vector_view vj = gsl_matrix_column(ws->V, j);
+  size_t i;
+  double nrm;
+  do {
+    for (i = 0; i < ws->n; i++) gsl_vector_set(ws->w, i, gsl_rng_uniform(ws->r) - 0.5);
+    nrm = j > 0 ? mygsl_krylov_orthogonalize(ws, j, ws->w) : gsl_blas_dnrm2(ws->w);
+  } while (nrm == 0.0);
+  gsl_vector_scale(ws->w, 1.0 / nrm);
+  gsl_vector_memcpy(&vj.vector, ws->w);
+}
+
+/* Extends the Krylov decomposition from p to m columns. */
+static int mygsl_krylov_expand(const rb_gsl_linop *A, mygsl_krylov_workspace *ws, size_t p)
+{
+  size_t i, j;
+  double beta, nrm0;
+  int status;
+  for (j = p; j < ws->m; j++) {
+    gsl_vector_view vj = gsl_matrix_column(ws->V, j);
+    gsl_vector_view vj1 = gsl_matrix_column(ws->V, j + 1);
+    status = (*A->apply)(&vj.vector, ws->w, A->params);
+    if (status != GSL_SUCCESS) return status;
+    nrm0 = gsl_blas_dnrm2(ws->w);
+    beta = mygsl_krylov_orthogonalize(ws, j + 1, ws->w);
+    for (i = 0; i <= j; i++) gsl_matrix_set(ws->H, i, j, gsl_vector_get(ws->h, i));
+    if (beta <= GSL_DBL_EPSILON * nrm0 || beta == 0.0) {
+      /* invariant subspace found: continue with a fresh direction */
+      gsl_matrix_set(ws->H, j + 1, j, 0.0);
+      mygsl_krylov_random(ws, j + 1);
+    } else {
+      gsl_matrix_set(ws->H, j + 1, j, beta);
+      gsl_vector_scale(ws->w, 1.0 / beta);
+      gsl_vector_memcpy(&vj1.vector, ws->w);
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+/* Restarts with the basis V_m Q, where the columns of Q (m x p) are
+   orthonormal and span an invariant subspace of H_m. */
+static void mygsl_krylov_restart(mygsl_krylov_workspace *ws, const gsl_matrix *Q)
+{
+  size_t n = ws->n, m = ws->m, p = Q->size2, i;
+  double beta = gsl_matrix_get(ws->H, m, m - 1);
+  gsl_matrix_view Vm = gsl_matrix_submatrix(ws->V, 0, 0, n, m);
+  gsl_matrix_view Hm = gsl_matrix_submatrix(ws->H, 0, 0, m, m);
+  gsl_matrix_view Vp = gsl_matrix_submatrix(ws->V, 0, 0, n, p);
+  gsl_matrix_view Hp = gsl_matrix_submatrix(ws->H, 0, 0, p, p);
+  gsl_vector_view vm = gsl_matrix_column(ws->V, m);
+  gsl_vector_view vp = gsl_matrix_column(ws->V, p);
+  gsl_matrix *HQ = NULL, *R = NULL, *VQ = NULL;
+  HQ = gsl_matrix_alloc(m, p);
+  R = gsl_matrix_alloc(p, p);
+  VQ = gsl_matrix_alloc(n, p);
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, &Hm.matrix, Q, 0.0, HQ);
+  gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, Q, HQ, 0.0, R);
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, &Vm.matrix, Q, 0.0, VQ);
+  gsl_matrix_memcpy(&Vp.matrix, VQ);
+  gsl_vector_memcpy(&vp.vector, &vm.vector);
+  gsl_matrix_set_zero(ws->H);
+  gsl_matrix_memcpy(&Hp.matrix, R);
+  for (i = 0; i < p; i++) gsl_matrix_set(ws->H, p, i, beta * gsl_matrix_get(Q, m - 1, i));
+  gsl_matrix_free(HQ);
+  gsl_matrix_free(R);
+  gsl_matrix_free(VQ);
+}
+
+static void mygsl_krylov_init(mygsl_krylov_workspace *ws, const gsl_vector *v0)
+{
+  gsl_vector_view vv = gsl_matrix_column(ws->V, 0);
+  double nrm;
+  if (v0 && (nrm = gsl_blas_dnrm2(v0)) > 0.0) {
+    gsl_vector_memcpy(&vv.vector, v0);
+    gsl_vector_scale(&vv.vector, 1.0 / nrm);
+  } else {
+    mygsl_krylov_random(ws, 0);
+  }
+}
+
+/* Sort keys such that the wanted eigenvalues come first in ascending order */
+static double mygsl_krylov_key(int which, double re, double im)
+{
+  switch (which) {
+  case RB_GSL_EIGEN_SMALLEST:
+    return re;
+  case RB_GSL_EIGEN_LARGEST_MAGNITUDE:
+    return -hypot(re, im);
+  case RB_GSL_EIGEN_SMALLEST_MAGNITUDE:
+    return hypot(re, im);
+  case RB_GSL_EIGEN_LARGEST:
+  default:
+    return -re;
+  }
+}
+
+static size_t mygsl_krylov_keep(size_t k, size_t nconv, size_t m)
+{
+  size_t p = k + GSL_MIN(nconv, (m - k) / 2);
+  if (p >= m) p = m - 1;
+  if (p < 1) p = 1;
+  return p;
+}
+
+/*
+  Symmetric eigenproblem by restarted Lanczos. On success eval[0..k-1] and the
+  columns of evec (n x k) hold the k wanted eigenpairs, in order of preference.
+*/
+int rb_gsl_eigen_lanczos(const rb_gsl_linop *A, size_t k, int which, double tol,
+                         size_t ncv, size_t maxiter, const gsl_vector *v0,
+                         gsl_vector *eval, gsl_matrix *evec, size_t *nconv)
+{
+  size_t n = A->n, m = ncv, iter, i, p;
+  mygsl_krylov_workspace *ws = NULL;
+  gsl_eigen_symmv_workspace *wsymm = NULL;
+  gsl_matrix *S = NULL, *Y = NULL, *Q = NULL;
+  gsl_vector *theta = NULL, *key = NULL;
+  size_t *idx = NULL;
+  double beta, thr, res;
+  int status = GSL_EMAXITER, err = GSL_SUCCESS;
+  ws = mygsl_krylov_alloc(n, m);
+  wsymm = gsl_eigen_symmv_alloc(m);
+  S = gsl_matrix_alloc(m, m);
+  Y = gsl_matrix_alloc(m, m);
+  theta = gsl_vector_alloc(m);
+  key = gsl_vector_alloc(m);
+  idx = ALLOC_N(size_t, m);
+  mygsl_krylov_init(ws, v0);
+  p = 0;
+  *nconv = 0;
+  for (iter = 0; iter < maxiter; iter++) {
+    gsl_matrix_view Hm = gsl_matrix_submatrix(ws->H, 0, 0, m, m);
+    if ((err = mygsl_krylov_expand(A, ws, p)) != GSL_SUCCESS) break;
+    /* the projection is symmetric up to rounding */
+    gsl_matrix_transpose_memcpy(S, &Hm.matrix);
+    gsl_matrix_add(S, &Hm.matrix);
+    gsl_matrix_scale(S, 0.5);
+    gsl_eigen_symmv(S, theta, Y, wsymm);
+    for (i = 0; i < m; i++)
+      gsl_vector_set(key, i, mygsl_krylov_key(which, gsl_vector_get(theta, i), 0.0));
+    gsl_sort_index(idx, key->data, 1, m);
+    beta = gsl_matrix_get(ws->H, m, m - 1);
+    *nconv = 0;
+    for (i = 0; i < k; i++) {
+      thr = GSL_MAX(fabs(gsl_vector_get(theta, idx[i])), GSL_SQRT_DBL_EPSILON);
+      res = fabs(beta * gsl_matrix_get(Y, m - 1, idx[i]));
+      if (res <= tol * thr) (*nconv)++;
+      else break;
+    }
+    if (*nconv >= k) {
+      status = GSL_SUCCESS;
+      break;
+    }
+    if (iter + 1 == maxiter) break;
+    p = mygsl_krylov_keep(k, *nconv, m);
+    Q = gsl_matrix_alloc(m, p);
+    for (i = 0; i < p; i++) {
+      gsl_vector_view y = gsl_matrix_column(Y, idx[i]);
+      gsl_vector_view q = gsl_matrix_column(Q, i);
+      gsl_vector_memcpy(&q.vector, &y.vector);
+    }
+    mygsl_krylov_restart(ws, Q);
+    gsl_matrix_free(Q);
+  }
+  if (err != GSL_SUCCESS) {
+    status = err;
+  } else {
+    gsl_matrix_view Vm = gsl_matrix_submatrix(ws->V, 0, 0, n, m);
+    for (i = 0; i < k; i++) {
+      gsl_vector_view y = gsl_matrix_column(Y, idx[i]);
+      gsl_vector_view x = gsl_matrix_column(evec, i);
+      gsl_vector_set(eval, i, gsl_vector_get(theta, idx[i]));
+      gsl_blas_dgemv(CblasNoTrans, 1.0, &Vm.matrix, &y.vector, 0.0, &x.vector);
+    }
+  }
+  free(idx);
+  gsl_vector_free(key);
+  gsl_vector_free(theta);
+  gsl_matrix_free(Y);
+  gsl_matrix_free(S);
+  gsl_eigen_symmv_free(wsymm);
+  mygsl_krylov_free(ws);
+  return status;
+}
+
+/*
+  Nonsymmetric eigenproblem by restarted Arnoldi. Complex conjugate Ritz pairs
+  are kept together across restarts, through the real basis (Re y, Im y).
+*/
+int rb_gsl_eigen_arnoldi(const rb_gsl_linop *A, size_t k, int which, double tol,
+                         size_t ncv, size_t maxiter, const gsl_vector *v0,
+                         gsl_vector_complex *eval, gsl_matrix_complex *evec,
+                         size_t *nconv)
+{
+  size_t n = A->n, m = ncv, iter, i, j, p, c;
+  mygsl_krylov_workspace *ws = NULL;
+  gsl_eigen_nonsymmv_workspace *wns = NULL;
+  gsl_matrix *Hc = NULL, *Q = NULL;
+  gsl_matrix_complex *Y = NULL;
+  gsl_vector_complex *lambda = NULL;
+  gsl_vector *key = NULL, *yr = NULL, *yi = NULL;
+  size_t *idx = NULL;
+  char *used = NULL;
+  double beta, thr, res, nrm;
+  gsl_complex z;
+  int status = GSL_EMAXITER, err = GSL_SUCCESS;
+  ws = mygsl_krylov_alloc(n, m);
+  wns = gsl_eigen_nonsymmv_alloc(m);
+  Hc = gsl_matrix_alloc(m, m);
+  Y = gsl_matrix_complex_alloc(m, m);
+  lambda = gsl_vector_complex_alloc(m);
+  key = gsl_vector_alloc(m);
+  yr = gsl_vector_alloc(n);
+  yi = gsl_vector_alloc(n);
+  idx = ALLOC_N(size_t, m);
+  used = ALLOC_N(char, m);
+  mygsl_krylov_init(ws, v0);
+  p = 0;
+  *nconv = 0;
+  for (iter = 0; iter < maxiter; iter++) {
+    gsl_matrix_view Hm = gsl_matrix_submatrix(ws->H, 0, 0, m, m);
+    if ((err = mygsl_krylov_expand(A, ws, p)) != GSL_SUCCESS) break;
+    gsl_matrix_memcpy(Hc, &Hm.matrix);
+    gsl_eigen_nonsymmv(Hc, lambda, Y, wns);
+    for (i = 0; i < m; i++) {
+      z = gsl_vector_complex_get(lambda, i);
+      gsl_vector_set(key, i, mygsl_krylov_key(which, GSL_REAL(z), GSL_IMAG(z)));
+    }
+    gsl_sort_index(idx, key->data, 1, m);
+    beta = gsl_matrix_get(ws->H, m, m - 1);
+    *nconv = 0;
+    for (i = 0; i < k; i++) {
+      thr = GSL_MAX(gsl_complex_abs(gsl_vector_complex_get(lambda, idx[i])), GSL_SQRT_DBL_EPSILON);
+      res = fabs(beta) * gsl_complex_abs(gsl_matrix_complex_get(Y, m - 1, idx[i]));
+      if (res <= tol * thr) (*nconv)++;
+      else break;
+    }
+    if (*nconv >= k) {
+      status = GSL_SUCCESS;
+      break;
+    }
+    if (iter + 1 == maxiter) break;
+    p = mygsl_krylov_keep(k, *nconv, m);
+    /* do not split a conjugate pair at the cut */
+    if (GSL_IMAG(gsl_vector_complex_get(lambda, idx[p - 1])) != 0.0) {
+      for (c = 0, i = 0; i < p; i++)
+        if (GSL_IMAG(gsl_vector_complex_get(lambda, idx[i])) != 0.0) c++;
+      if (c % 2 == 1) p = (p + 1 < m) ? p + 1 : p - 1;
+    }
+    /* real orthonormal basis of the wanted Ritz vectors */
+    Q = gsl_matrix_alloc(m, p);
+    memset(used, 0, m);
+    for (c = 0, i = 0; i < p && c < p; i++) {
+      size_t col = idx[i];
+      if (used[col]) continue;
+      used[col] = 1;
+      z = gsl_vector_complex_get(lambda, col);
+      for (j = 0; j < m; j++) gsl_matrix_set(Q, j, c, GSL_REAL(gsl_matrix_complex_get(Y, j, col)));
+      c++;
+      if (GSL_IMAG(z) != 0.0 && c < p) {
+        size_t t;
+        for (t = i + 1; t < m; t++) {
+          gsl_complex zt = gsl_vector_complex_get(lambda, idx[t]);
+          if (!used[idx[t]] && GSL_REAL(zt) == GSL_REAL(z) && GSL_IMAG(zt) == -GSL_IMAG(z)) {
+            used[idx[t]] = 1;
+            break;
+          }
+        }
+        for (j = 0; j < m; j++) gsl_matrix_set(Q, j, c, GSL_IMAG(gsl_matrix_complex_get(Y, j, col)));
+        c++;
+      }
+    }
+    /* orthonormalize, dropping the columns that depend on the previous ones */
+    for (p = 0, j = 0; j < c; j++) {
+      gsl_vector_view qj = gsl_matrix_column(Q, j);
+      gsl_vector_view qp = gsl_matrix_column(Q, p);
+      size_t l;
+      double d, nrm0 = gsl_blas_dnrm2(&qj.vector);
+      for (l = 0; l < p; l++) {
+        gsl_vector_view ql = gsl_matrix_column(Q, l);
+        gsl_blas_ddot(&ql.vector, &qj.vector, &d);
+        gsl_blas_daxpy(-d, &ql.vector, &qj.vector);
+      }
+      nrm = gsl_blas_dnrm2(&qj.vector);
+      if (nrm == 0.0 || nrm <= GSL_SQRT_DBL_EPSILON * nrm0) continue;
+      gsl_vector_scale(&qj.vector, 1.0 / nrm);
+      if (p != j) gsl_vector_memcpy(&qp.vector, &qj.vector);
+      p++;
+    }
+    if (p > 0) {
+      gsl_matrix_view Qc = gsl_matrix_submatrix(Q, 0, 0, m, p);
+      mygsl_krylov_restart(ws, &Qc.matrix);
+    } else {
+      /* nothing to keep: start over from the first basis vector */
+      gsl_matrix_set_zero(ws->H);
+    }
+    gsl_matrix_free(Q);
+  }
+  if (err != GSL_SUCCESS) {
+    status = err;
+  } else {
+    gsl_matrix_view Vm = gsl_matrix_submatrix(ws->V, 0, 0, n, m);
+    gsl_vector *tr = gsl_vector_alloc(m), *ti = gsl_vector_alloc(m);
+    for (i = 0; i < k; i++) {
+      gsl_vector_complex_set(eval, i, gsl_vector_complex_get(lambda, idx[i]));
+      for (j = 0; j < m; j++) {
+        z = gsl_matrix_complex_get(Y, j, idx[i]);
+        gsl_vector_set(tr, j, GSL_REAL(z));
+        gsl_vector_set(ti, j, GSL_IMAG(z));
+      }
+      gsl_blas_dgemv(CblasNoTrans, 1.0, &Vm.matrix, tr, 0.0, yr);
+      gsl_blas_dgemv(CblasNoTrans, 1.0, &Vm.matrix, ti, 0.0, yi);
+      for (j = 0; j < n; j++) {
+        GSL_SET_COMPLEX(&z, gsl_vector_get(yr, j), gsl_vector_get(yi, j));
+        gsl_matrix_complex_set(evec, j, i, z);
+      }
+    }
+    gsl_vector_free(tr);
+    gsl_vector_free(ti);
+  }
+  free(used);
+  free(idx);
+  gsl_vector_free(yi);
+  gsl_vector_free(yr);
+  gsl_vector_free(key);
+  gsl_vector_complex_free(lambda);
+  gsl_matrix_complex_free(Y);
+  gsl_matrix_free(Hc);
+  gsl_eigen_nonsymmv_free(wns);
+  mygsl_krylov_free(ws);
+  return status;
+}
+
+/*****/
+
+static int rb_gsl_linop_matrix_apply(const gsl_vector *x, gsl_vector *y, void *params)
+{
+  return gsl_blas_dgemv(CblasNoTrans, 1.0, (gsl_matrix *) params, x, 0.0, y);
+}
+
+#ifdef GSL_2_6_LATER
+static int rb_gsl_linop_spmatrix_apply(const gsl_vector *x, gsl_vector *y, void *params)
+{
+  return gsl_spblas_dgemv(CblasNoTrans, 1.0, (gsl_spmatrix *) params, x, 0.0, y);
+}
+#endif
+
+/*
+  A Ruby operator is called under rb_protect, so that an exception stops
+  the solver, which frees its workspace, and is raised again afterwards.
+*/
+typedef struct {
+  VALUE proc;
+  int state;
+} rb_gsl_linop_proc;
+
+typedef struct {
+  VALUE proc;
+  const gsl_vector *x;
+  gsl_vector *y;
+} rb_gsl_linop_call;
+
+static VALUE rb_gsl_linop_proc_call(VALUE data)
+{
+  rb_gsl_linop_call *c = (rb_gsl_linop_call *) data;
+  gsl_vector *vx = NULL, *vy = NULL;
+  VALUE result;
+  vx = gsl_vector_alloc(c->x->size);
+  gsl_vector_memcpy(vx, c->x);
+  result = rb_funcall(c->proc, RBGSL_ID_call, 1,
+                      Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vx));
+  CHECK_VECTOR(result);
+  Data_Get_Vector(result, vy);
+  if (vy->size != c->y->size)
+    rb_raise(rb_eRangeError, "operator returned a vector of length %d (%d expected)",
+             (int) vy->size, (int) c->y->size);
+  gsl_vector_memcpy(c->y, vy);
+  return Qnil;
+}
+
+static int rb_gsl_linop_proc_apply(const gsl_vector *x, gsl_vector *y, void *params)
+{
+  rb_gsl_linop_proc *P = (rb_gsl_linop_proc *) params;
+  rb_gsl_linop_call c;
+  c.proc = P->proc;
+  c.x = x;
+  c.y = y;
+  rb_protect(rb_gsl_linop_proc_call, (VALUE) &c, &P->state);
+  return P->state ? GSL_EFAILED : GSL_SUCCESS;
+}
+
+static int rb_gsl_eigen_krylov_which(VALUE val, int defval)
+{
+  const char *name;
+  if (NIL_P(val)) return defval;
+  name = SYMBOL_P(val) ? rb_id2name(SYM2ID(val)) : StringValuePtr(val);
+  if (strcmp(name, "largest") == 0) return RB_GSL_EIGEN_LARGEST;
+  if (strcmp(name, "smallest") == 0) return RB_GSL_EIGEN_SMALLEST;
+  if (strcmp(name, "largest_magnitude") == 0) return RB_GSL_EIGEN_LARGEST_MAGNITUDE;
+  if (strcmp(name, "smallest_magnitude") == 0) return RB_GSL_EIGEN_SMALLEST_MAGNITUDE;
+  rb_raise(rb_eArgError, "unknown which: %s (largest, smallest, largest_magnitude or smallest_magnitude expected)", name);
+  return defval;
+}
+
+/* Builds the operator from a GSL::Matrix, a GSL::SpMatrix, or an object
+   responding to call (which needs the :n option) */
+static void rb_gsl_eigen_krylov_linop(VALUE vA, VALUE opts, rb_gsl_linop *op, rb_gsl_linop_proc *P)
+{
+  gsl_matrix *m = NULL;
+  VALUE val;
+  if (MATRIX_P(vA)) {
+    Data_Get_Struct(vA, gsl_matrix, m);
+    if (m->size1 != m->size2) rb_raise(rb_eArgError, "matrix must be square");
+    op->n = m->size1;
+    op->apply = rb_gsl_linop_matrix_apply;
+    op->params = m;
+#ifdef GSL_2_6_LATER
+  } else if (rb_obj_is_kind_of(vA, cgsl_spmatrix)) {
+    gsl_spmatrix *sp = NULL;
+    Data_Get_Struct(vA, gsl_spmatrix, sp);
+    if (sp->size1 != sp->size2) rb_raise(rb_eArgError, "matrix must be square");
+    op->n = sp->size1;
+    op->apply = rb_gsl_linop_spmatrix_apply;
+    op->params = sp;
+#endif
+  } else if (rb_respond_to(vA, RBGSL_ID_call)) {
+    if (NIL_P(val = rb_gsl_hash_get(opts, "n")))
+      rb_raise(rb_eArgError, "the :n option is required for a matrix-free operator");
+    op->n = NUM2ULONG(val);
+    P->proc = vA;
+    P->state = 0;
+    op->apply = rb_gsl_linop_proc_apply;
+    op->params = P;
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (Matrix, SpMatrix or Proc expected)",
+             rb_class2name(CLASS_OF(vA)));
+  }
+}
+
+static VALUE rb_gsl_eigen_krylov(int argc, VALUE *argv, VALUE obj, int symmetric)
+{
+  rb_gsl_linop op;
+  rb_gsl_linop_proc P;
+  VALUE vA, opts = Qnil, val, veval, vevec;
+  gsl_vector *v0 = NULL;
+  size_t k = 6, ncv, maxiter = 300, nconv;
+  double tol = 1e-10;
+  int which, status;
+  if (TYPE(obj) != T_MODULE) {
+    vA = obj;
+    if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+    if (argc == 1) opts = argv[0];
+  } else {
+    if (argc < 1 || argc > 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+    vA = argv[0];
+    if (argc == 2) opts = argv[1];
+  }
+  if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+  rb_gsl_eigen_krylov_linop(vA, opts, &op, &P);
+  if (!NIL_P(val = rb_gsl_hash_get(opts, "k"))) k = NUM2ULONG(val);
+  if (!NIL_P(val = rb_gsl_hash_get(opts, "tol"))) tol = NUM2DBL(val);
+  if (!NIL_P(val = rb_gsl_hash_get(opts, "maxiter"))) maxiter = NUM2ULONG(val);
+  which = rb_gsl_eigen_krylov_which(rb_gsl_hash_get(opts, "which"),
+                                    symmetric ? RB_GSL_EIGEN_LARGEST : RB_GSL_EIGEN_LARGEST_MAGNITUDE);
+  ncv = GSL_MAX(2 * k + 1, 20);
+  if (!NIL_P(val = rb_gsl_hash_get(opts, "ncv"))) ncv = NUM2ULONG(val);
+  ncv = GSL_MIN(ncv, op.n);
+  if (k < 1 || k >= ncv)
+    rb_raise(rb_eArgError, "k = %d must satisfy 0 < k < ncv = %d", (int) k, (int) ncv);
+  if (!NIL_P(val = rb_gsl_hash_get(opts, "v0"))) {
+    Data_Get_Vector(val, v0);
+    if (v0->size != op.n) rb_raise(rb_eRangeError, "v0 must have length %d", (int) op.n);
+  }
+  if (symmetric) {
+    gsl_vector *eval = gsl_vector_alloc(k);
+    gsl_matrix *evec = gsl_matrix_alloc(op.n, k);
+    veval = Data_Wrap_Struct(cgsl_eigen_values, 0, gsl_vector_free, eval);
+    vevec = Data_Wrap_Struct(cgsl_eigen_vectors, 0, gsl_matrix_free, evec);
+    status = rb_gsl_eigen_lanczos(&op, k, which, tol, ncv, maxiter, v0, eval, evec, &nconv);
+  } else {
+    gsl_vector_complex *eval = gsl_vector_complex_alloc(k);
+    gsl_matrix_complex *evec = gsl_matrix_complex_alloc(op.n, k);
+    veval = Data_Wrap_Struct(cgsl_eigen_complex_values, 0, gsl_vector_complex_free, eval);
+    vevec = Data_Wrap_Struct(cgsl_eigen_complex_vectors, 0, gsl_matrix_complex_free, evec);
+    status = rb_gsl_eigen_arnoldi(&op, k, which, tol, ncv, maxiter, v0, eval, evec, &nconv);
+  }
+  if (op.apply == rb_gsl_linop_proc_apply && P.state) rb_jump_tag(P.state);
+  if (status != GSL_SUCCESS)
+    rb_raise(rb_eRuntimeError, "%s: only %d of %d eigenpairs converged in %d restarts",
+             symmetric ? "Lanczos" : "Arnoldi", (int) nconv, (int) k, (int) maxiter);
+  return rb_ary_new3(2, veval, vevec);
+}
+
+static VALUE rb_gsl_eigen_lanczos_method(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_eigen_krylov(argc, argv, obj, 1);
+}
+
+static VALUE rb_gsl_eigen_arnoldi_method(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_eigen_krylov(argc, argv, obj, 0);
+}
+
+void Init_gsl_eigen_krylov(VALUE module)
+{
+  cgsl_eigen_values = rb_const_get(module, rb_intern("EigenValues"));
+  cgsl_eigen_vectors = rb_const_get(module, rb_intern("EigenVectors"));
+  cgsl_eigen_complex_values = cgsl_vector_complex;
+  cgsl_eigen_complex_vectors = rb_const_get(module, rb_intern("ComplexEigenVectors"));
+
+  rb_define_module_function(module, "lanczos", rb_gsl_eigen_lanczos_method, -1);
+  rb_define_module_function(module, "arnoldi", rb_gsl_eigen_arnoldi_method, -1);
+  rb_define_method(cgsl_matrix, "eigen_lanczos", rb_gsl_eigen_lanczos_method, -1);
+  rb_define_method(cgsl_matrix, "eigen_arnoldi", rb_gsl_eigen_arnoldi_method, -1);
+#ifdef GSL_2_6_LATER
+  rb_define_method(cgsl_spmatrix, "eigen_lanczos", rb_gsl_eigen_lanczos_method, -1);
+  rb_define_method(cgsl_spmatrix, "eigen_arnoldi", rb_gsl_eigen_arnoldi_method, -1);
+#endif
+}
@@ -13,6 +13,7 @@
 #include "include/rb_gsl_array.h"
 #include "include/rb_gsl_common.h"
 #include "include/rb_gsl_function.h"
+#include "include/rb_gsl_parallel.h"
 
 static VALUE eHandler;
 static VALUE cgsl_error[35];
@@ -28,6 +29,7 @@ void rb_gsl_error_handler(const char *reason, const char *file,
                           int line, int gsl_errno)
 {
   const char *emessage = gsl_strerror(gsl_errno);
+  if (rb_gsl_parallel_trap_error(reason, file, line, gsl_errno)) return;
   rb_raise(pgsl_error[gsl_errno],
            "Ruby/GSL error code %d, %s (file %s, line %d), %s",
            gsl_errno, reason, file, line, emessage);
@@ -38,6 +40,7 @@ static void rb_gsl_my_error_handler(const char *reason, const char *file,
 {
   VALUE vreason, vfile;
   VALUE vline, verrno;
+  if (rb_gsl_parallel_trap_error(reason, file, line, gsl_errno)) return;
   vreason = rb_str_new2(reason);
   vfile = rb_str_new2(file);
   vline = INT2FIX(line);
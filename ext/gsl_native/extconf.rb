@@ -106,7 +106,7 @@ gsl_config_arg(:version) { |version, check|
 
   raise 'Ruby/GSL requires gsl-1.15 or later.' unless later['1.15']
 
-  %w[1.15 1.16 2.0 2.1].each { |v| later[v] }
+  %w[1.15 1.16 2.0 2.1 2.6].each { |v| later[v] }
 }
 
 gsl_config_arg(:cflags) { |cflags, check|
@@ -129,6 +129,10 @@ gsl_config_arg(:libs) { |libs, check|
 }
 
 have_func('round')
+have_header('pthread.h')
+have_header('ruby/thread.h')
+have_header('sys/mman.h')
+gsl_have_header('z', 'zlib.h')
 
 %w[alf qrngextra rngextra tensor].each { |library|
   gsl_have_header(library, "#{library}/#{library}.h")
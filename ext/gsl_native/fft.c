@@ -936,6 +936,31 @@ static VALUE rb_gsl_fft_halfcomplex_amp_phase(VALUE obj)
   return rb_ary_new3(2, vamp, vphase);
 }
 
+/*
+  Circular convolution of data (length n, a power of 2) with a kernel
+  whose transform by gsl_fft_real_radix2_transform is kfft; the result
+  replaces data. The radix-2 routines need no wavetable, so C code such
+  as kde.c can call this from several threads at once.
+*/
+int mygsl_fft_real_radix2_convolve(double *data, const double *kfft, size_t n)
+{
+  double re, im;
+  size_t k;
+  int status;
+  status = gsl_fft_real_radix2_transform(data, 1, n);
+  if (status) return status;
+  /* halfcomplex: data[k] and data[n-k] are the real and imaginary parts */
+  data[0] *= kfft[0];
+  if (n > 1) data[n/2] *= kfft[n/2];
+  for (k = 1; k < n/2; k++) {
+    re = data[k]*kfft[k] - data[n-k]*kfft[n-k];
+    im = data[k]*kfft[n-k] + data[n-k]*kfft[k];
+    data[k] = re;
+    data[n-k] = im;
+  }
+  return gsl_fft_halfcomplex_radix2_inverse(data, 1, n);
+}
+
 void Init_gsl_fft(VALUE module)
 {
   mgsl_fft = rb_define_module_under(module, "FFT");
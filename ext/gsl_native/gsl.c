@@ -77,6 +77,8 @@ void Init_gsl_native()
   rb_gsl_define_intern(mgsl);
 
   Init_gsl_error(mgsl);
+  Init_gsl_workspace_pool(mgsl);
+  Init_gsl_parallel(mgsl);
 
   Init_gsl_math(mgsl);
   Init_gsl_complex(mgsl);
@@ -95,6 +97,11 @@ void Init_gsl_native()
   Init_gsl_sf(mgsl);
 
   Init_gsl_linalg(mgsl); /*  Init_gsl_linalg_complex() is called in Init_gsl_linalg() */
+  Init_gsl_rsvd(mgsl);
+
+#ifdef GSL_2_6_LATER
+  Init_gsl_spmatrix(mgsl);
+#endif
 
   Init_gsl_eigen(mgsl);
 
@@ -108,10 +115,13 @@ void Init_gsl_native()
   Init_gsl_ran(mgsl);
   Init_gsl_cdf(mgsl);
   Init_gsl_stats(mgsl);
+  Init_gsl_sketch(mgsl);
+  Init_gsl_kde(mgsl);
 
   Init_gsl_histogram(mgsl);
   Init_gsl_histogram2d(mgsl);
   Init_gsl_histogram3d(mgsl);
+  Init_gsl_histogram_io(mgsl);
   Init_gsl_ntuple(mgsl);
   Init_gsl_monte(mgsl);
   Init_gsl_siman(mgsl);
@@ -11,6 +11,7 @@
 
 #include "include/rb_gsl_histogram.h"
 #include "include/rb_gsl_array.h"
+#include "include/rb_gsl_parallel.h"
 #include <gsl/gsl_fit.h>
 #include <gsl/gsl_multifit_nlin.h>
 #include <gsl/gsl_blas.h>
@@ -327,17 +328,31 @@ static VALUE rb_gsl_histogram_clone(VALUE obj)
   return Data_Wrap_Struct(CLASS_OF(obj), 0, gsl_histogram_free, hnew);
 }
 
+/*
+  Histogram#increment(x, weight = 1, threads: GSL.threads)
+
+  x is a number or an Array, Vector, Vector::Int or NArray of values.
+  weight is a number, or a Vector of one weight for each value. Arrays
+  of values go through mygsl_histogram_fill in histogram_fill.c.
+*/
 static VALUE rb_gsl_histogram_accumulate(int argc, VALUE *argv, VALUE obj)
 {
   gsl_histogram *h = NULL;
-  gsl_vector *v;
+  gsl_vector *v, *vw = NULL;
   gsl_vector_int *vi;
-  size_t i;
+  VALUE opts = Qnil, holder = Qnil;
+  const double *ptr;
+  size_t i, n, stride;
   double weight = 1;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
   switch (argc) {
   case 2:
-    Need_Float(argv[1]);
-    weight = NUM2DBL(argv[1]);
+    if (VECTOR_P(argv[1])) {
+      Data_Get_Vector(argv[1], vw);
+    } else {
+      Need_Float(argv[1]);
+      weight = NUM2DBL(argv[1]);
+    }
     break;
   case 1:
     weight = 1;
@@ -348,28 +363,41 @@ static VALUE rb_gsl_histogram_accumulate(int argc, VALUE *argv, VALUE obj)
   }
   Data_Get_Struct(obj, gsl_histogram, h);
   if (TYPE(argv[0]) == T_ARRAY) {
-    //    for (i = 0; i < RARRAY(argv[0])->len; i++)
-    for (i = 0; (int) i < RARRAY_LEN(argv[0]); i++)
-      gsl_histogram_accumulate(h, NUM2DBL(rb_ary_entry(argv[0], i)), weight);
+    n = RARRAY_LEN(argv[0]);
+    v = gsl_vector_alloc(n > 0 ? n : 1);
+    holder = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+    for (i = 0; i < n; i++) v->data[i] = NUM2DBL(rb_ary_entry(argv[0], i));
+    ptr = v->data;
+    stride = 1;
   } else if (VECTOR_P(argv[0])) {
     Data_Get_Struct(argv[0], gsl_vector, v);
-    for (i = 0; i < v->size; i++)
-      gsl_histogram_accumulate(h, gsl_vector_get(v, i), weight);
+    ptr = v->data;
+    stride = v->stride;
+    n = v->size;
   } else if (VECTOR_INT_P(argv[0])) {
     Data_Get_Struct(argv[0], gsl_vector_int, vi);
-    for (i = 0; i < vi->size; i++)
-      gsl_histogram_accumulate(h, (double)gsl_vector_int_get(vi, i), weight);
+    n = vi->size;
+    v = gsl_vector_alloc(n > 0 ? n : 1);
+    holder = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+    for (i = 0; i < n; i++) v->data[i] = (double) gsl_vector_int_get(vi, i);
+    ptr = v->data;
+    stride = 1;
 #ifdef HAVE_NARRAY_H
   } else if (NA_IsNArray(argv[0])) {
-    double *ptr;
-    size_t size, stride;
-    ptr = get_vector_ptr(argv[0], &stride, &size);
-    for (i = 0; i < size; i++)
-      gsl_histogram_accumulate(h, ptr[i], weight);
+    ptr = get_vector_ptr(argv[0], &stride, &n);
 #endif
   } else {
+    if (vw) rb_raise(rb_eTypeError, "a vector of weights needs a vector of values");
     gsl_histogram_accumulate(h, NUM2DBL(argv[0]), weight);
+    return argv[0];
   }
+  if (vw && vw->size != n)
+    rb_raise(rb_eArgError, "%d weights for %d values", (int) vw->size, (int) n);
+  /* NaN raises as in the scalar case, before anything is added */
+  if (mygsl_histogram_check_nan(ptr, stride, n) != GSL_SUCCESS) return argv[0];
+  mygsl_histogram_fill(h, ptr, stride, n, vw ? vw->data : NULL, vw ? vw->stride : 0,
+                       weight, rb_gsl_parallel_threads(opts));
+  RB_GC_GUARD(holder);
   return argv[0];
 }
 
@@ -1847,6 +1875,8 @@ static VALUE rb_gsl_histogram_percentile_inv(VALUE obj, VALUE x)
   return rb_float_new(histogram_percentile_inv(h, NUM2DBL(x)));
 }
 
+void Init_gsl_histogram_sparse(VALUE module);
+
 void Init_gsl_histogram(VALUE module)
 {
   VALUE cgsl_histogram_pdf;
@@ -2003,4 +2033,6 @@ void Init_gsl_histogram(VALUE module)
   rb_define_method(cgsl_histogram, "percentile", rb_gsl_histogram_percentile, 1);
   rb_define_method(cgsl_histogram, "median", rb_gsl_histogram_median, 0);
   rb_define_method(cgsl_histogram, "percentile_inv", rb_gsl_histogram_percentile_inv, 1);
+
+  Init_gsl_histogram_sparse(module);
 }
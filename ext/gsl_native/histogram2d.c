@@ -12,6 +12,7 @@
 #include "include/rb_gsl_histogram.h"
 #include "include/rb_gsl_common.h"
 #include "include/rb_gsl_array.h"
+#include "include/rb_gsl_parallel.h"
 
 VALUE cgsl_histogram2d;
 VALUE cgsl_histogram2d_view;
@@ -178,16 +179,28 @@ static VALUE rb_gsl_histogram2d_memcpy(VALUE obj, VALUE vhdest, VALUE vhsrc)
   return vhdest;
 }
 
+/*
+  Histogram2d#increment(x, y, weight = 1, threads: GSL.threads)
+
+  x and y are numbers or Vectors; weight is a number, or a Vector of
+  one weight for each pair.
+*/
 static VALUE rb_gsl_histogram2d_accumulate(int argc, VALUE *argv, VALUE obj)
 {
   gsl_histogram2d *h = NULL;
-  gsl_vector *vx, *vy;
-  size_t n, i;
+  gsl_vector *vx, *vy, *vw = NULL;
+  VALUE opts = Qnil;
+  size_t n;
   double weight = 1;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
   switch (argc) {
   case 3:
-    Need_Float(argv[2]);
-    weight = NUM2DBL(argv[2]);
+    if (VECTOR_P(argv[2])) {
+      Data_Get_Vector(argv[2], vw);
+    } else {
+      Need_Float(argv[2]);
+      weight = NUM2DBL(argv[2]);
+    }
     break;
   case 2:
     weight = 1;
@@ -201,10 +214,16 @@ static VALUE rb_gsl_histogram2d_accumulate(int argc, VALUE *argv, VALUE obj)
     Data_Get_Struct(argv[0], gsl_vector, vx);
     Data_Get_Struct(argv[1], gsl_vector, vy);
     n = (size_t) GSL_MIN_INT((int) vx->size, (int) vy->size);
-    for (i = 0; i < n; i++)
-      gsl_histogram2d_accumulate(h, gsl_vector_get(vx, i), gsl_vector_get(vy, i),
-                                 weight);
+    if (vw && vw->size != n)
+      rb_raise(rb_eArgError, "%d weights for %d values", (int) vw->size, (int) n);
+    /* NaN raises as in the scalar case, before anything is added */
+    if (mygsl_histogram_check_nan(vx->data, vx->stride, n) != GSL_SUCCESS
+        || mygsl_histogram_check_nan(vy->data, vy->stride, n) != GSL_SUCCESS) return obj;
+    mygsl_histogram2d_fill(h, vx->data, vx->stride, vy->data, vy->stride, n,
+                           vw ? vw->data : NULL, vw ? vw->stride : 0,
+                           weight, rb_gsl_parallel_threads(opts));
   } else {
+    if (vw) rb_raise(rb_eTypeError, "a vector of weights needs vectors of values");
     gsl_histogram2d_accumulate(h, NUM2DBL(argv[0]), NUM2DBL(argv[1]), weight);
   }
   return obj;
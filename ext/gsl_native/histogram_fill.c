@@ -0,0 +1,248 @@
+/*
+  histogram_fill.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Bulk fill of 1-D and 2-D histograms, used by Histogram#increment and
+  Histogram2d#increment for vector arguments. The result is the same as
+  calling gsl_histogram_accumulate for each element: bin i takes the
+  values range[i] <= x < range[i+1], and values outside the ranges (or
+  NaN) are dropped. GSL raises GSL_ESANITY for NaN instead: callers that
+  keep its behaviour check the values first with mygsl_histogram_check_nan.
+
+  Values are handled in blocks of HIST_FILL_LANES. For ranges with equal
+  bin widths the bin is computed directly and corrected by at most one
+  step against the range array, so rounding never puts a value in the
+  wrong bin. Otherwise all the values of a block run the same
+  branchless binary search in lock step, which the compiler can keep in
+  registers and vectorize.
+
+  The input is cut into chunks of HIST_FILL_CHUNK elements, dealt out to
+  the threads. Each thread adds into its own copy of the bins, and the
+  copies are summed into the histogram in thread order at the end. Unit
+  weights give exact counts whatever the number of threads; with
+  fractional weights the last bits of a sum may depend on it.
+*/
+
+#include "include/rb_gsl_histogram.h"
+#include "include/rb_gsl_parallel.h"
+
+#define HIST_FILL_LANES 16
+#define HIST_FILL_CHUNK 65536
+/* limit of the memory taken by the private copies of the bins */
+#define HIST_FILL_PARTIAL_MAX (256 * 1024 * 1024)
+
+typedef struct {
+  size_t n;
+  const double *range;
+  double lo, hi, scale;
+  int uniform;
+} hist_fill_axis;
+
+typedef struct {
+  int naxes;
+  hist_fill_axis axis[2];
+  const double *x[2];
+  size_t stride[2];
+  const double *w;
+  size_t wstride;
+  double weight;
+  size_t n, nchunks, nbins, nthreads;
+  double **bins;     /* bins[tid], bins[0] is the histogram itself */
+} hist_fill_job;
+
+static void hist_fill_axis_init(hist_fill_axis *a, size_t n, const double *range)
+{
+  double width, tol;
+  size_t i;
+  a->n = n;
+  a->range = range;
+  a->lo = range[0];
+  a->hi = range[n];
+  width = (a->hi - a->lo) / n;
+  a->scale = n / (a->hi - a->lo);
+  tol = 1e-9 * width;
+  a->uniform = 1;
+  for (i = 1; i < n; i++) {
+    if (fabs(range[i] - (a->lo + i * width)) > tol) {
+      a->uniform = 0;
+      break;
+    }
+  }
+}
+
+/* bins of the m values xs, all in [lo, hi) */
+static void hist_fill_find_block(const hist_fill_axis *a, const double *xs, size_t *idx, size_t m)
+{
+  const double *range = a->range;
+  size_t l, i, len, half;
+  if (a->uniform) {
+    for (l = 0; l < m; l++) {
+      i = (size_t) ((xs[l] - a->lo) * a->scale);
+      if (i >= a->n) i = a->n - 1;
+      i -= (xs[l] < range[i]);
+      i += (xs[l] >= range[i + 1]);
+      idx[l] = i;
+    }
+    return;
+  }
+  for (l = 0; l < m; l++) idx[l] = 0;
+  for (len = a->n; len > 1; len -= half) {
+    half = len / 2;
+    for (l = 0; l < m; l++) idx[l] += (range[idx[l] + half] <= xs[l]) ? half : 0;
+  }
+}
+
+static void hist_fill_chunk(const hist_fill_job *job, size_t start, size_t end, double *bins)
+{
+  double xs[2][HIST_FILL_LANES], ws[HIST_FILL_LANES], x, y;
+  size_t idx[2][HIST_FILL_LANES];
+  const hist_fill_axis *ax = &job->axis[0], *ay = &job->axis[1];
+  size_t i, l, m = 0, ny = job->naxes == 2 ? ay->n : 1;
+  for (i = start; i <= end; i++) {
+    if (i < end) {
+      x = job->x[0][i * job->stride[0]];
+      if (!(x >= ax->lo && x < ax->hi)) continue;
+      xs[0][m] = x;
+      if (job->naxes == 2) {
+        y = job->x[1][i * job->stride[1]];
+        if (!(y >= ay->lo && y < ay->hi)) continue;
+        xs[1][m] = y;
+      }
+      ws[m] = job->w ? job->w[i * job->wstride] : job->weight;
+      if (++m < HIST_FILL_LANES) continue;
+    }
+    if (m == 0) continue;
+    hist_fill_find_block(ax, xs[0], idx[0], m);
+    if (job->naxes == 2) {
+      hist_fill_find_block(ay, xs[1], idx[1], m);
+      for (l = 0; l < m; l++) bins[idx[0][l] * ny + idx[1][l]] += ws[l];
+    } else {
+      for (l = 0; l < m; l++) bins[idx[0][l]] += ws[l];
+    }
+    m = 0;
+  }
+}
+
+static void hist_fill_worker(size_t tid, size_t nthreads, void *data)
+{
+  hist_fill_job *job = (hist_fill_job *) data;
+  size_t k, start, end;
+  for (k = tid; k < job->nchunks && !rb_gsl_parallel_interrupted(); k += nthreads) {
+    start = k * HIST_FILL_CHUNK;
+    end = start + HIST_FILL_CHUNK;
+    if (end > job->n) end = job->n;
+    hist_fill_chunk(job, start, end, job->bins[tid]);
+  }
+}
+
+static void hist_fill_merge_worker(size_t tid, size_t nthreads, void *data)
+{
+  hist_fill_job *job = (hist_fill_job *) data;
+  size_t start = job->nbins * tid / nthreads, end = job->nbins * (tid + 1) / nthreads;
+  size_t i, t;
+  for (t = 1; job->bins[t] != NULL; t++)
+    for (i = start; i < end; i++) job->bins[0][i] += job->bins[t][i];
+}
+
+static VALUE hist_fill_run_threads(VALUE p)
+{
+  hist_fill_job *job = (hist_fill_job *) p;
+  rb_gsl_parallel_run(job->nthreads, hist_fill_worker, job);
+  rb_gsl_parallel_run(job->nthreads, hist_fill_merge_worker, job);
+  return Qnil;
+}
+
+/* the partial histograms are freed even if the run is interrupted */
+static VALUE hist_fill_free_partial(VALUE p)
+{
+  hist_fill_job *job = (hist_fill_job *) p;
+  size_t t;
+  for (t = 1; t < job->nthreads; t++) free(job->bins[t]);
+  free(job->bins);
+  return Qnil;
+}
+
+static void hist_fill_run(hist_fill_job *job, double *bins, size_t nthreads)
+{
+  size_t t, maxthreads;
+  job->nchunks = (job->n + HIST_FILL_CHUNK - 1) / HIST_FILL_CHUNK;
+  maxthreads = 1 + HIST_FILL_PARTIAL_MAX / (job->nbins * sizeof(double));
+  if (nthreads > maxthreads) nthreads = maxthreads;
+  if (nthreads > job->nchunks) nthreads = job->nchunks;
+  if (nthreads <= 1) {
+    if (job->n > 0) hist_fill_chunk(job, 0, job->n, bins);
+    return;
+  }
+  job->bins = (double **) calloc(nthreads + 1, sizeof(double *));
+  if (job->bins == NULL) rb_raise(rb_eNoMemError, "failed to allocate the partial histograms");
+  job->bins[0] = bins;
+  for (t = 1; t < nthreads; t++) {
+    job->bins[t] = (double *) calloc(job->nbins, sizeof(double));
+    if (job->bins[t] == NULL) {
+      while (--t > 0) free(job->bins[t]);
+      free(job->bins);
+      rb_raise(rb_eNoMemError, "failed to allocate the partial histograms");
+    }
+  }
+  job->nthreads = nthreads;
+  rb_ensure(hist_fill_run_threads, (VALUE) job, hist_fill_free_partial, (VALUE) job);
+}
+
+/* GSL_ESANITY, as gsl_histogram_accumulate gives, if one of the n values x[i*stride] is NaN */
+int mygsl_histogram_check_nan(const double *x, size_t stride, size_t n)
+{
+  size_t i;
+  int nan = 0;
+  for (i = 0; i < n; i++) nan |= (x[i * stride] != x[i * stride]);
+  if (nan) GSL_ERROR("x not found in range", GSL_ESANITY);
+  return GSL_SUCCESS;
+}
+
+/*
+  Adds w[i*wstride] (or weight if w is NULL) to the bin of x[i*xstride]
+  for i < n.
+*/
+void mygsl_histogram_fill(gsl_histogram *h, const double *x, size_t xstride, size_t n,
+                          const double *w, size_t wstride, double weight, size_t nthreads)
+{
+  hist_fill_job job;
+  memset(&job, 0, sizeof(hist_fill_job));
+  job.naxes = 1;
+  hist_fill_axis_init(&job.axis[0], h->n, h->range);
+  job.x[0] = x;
+  job.stride[0] = xstride;
+  job.w = w;
+  job.wstride = wstride;
+  job.weight = weight;
+  job.n = n;
+  job.nbins = h->n;
+  hist_fill_run(&job, h->bin, nthreads);
+}
+
+void mygsl_histogram2d_fill(gsl_histogram2d *h, const double *x, size_t xstride,
+                            const double *y, size_t ystride, size_t n,
+                            const double *w, size_t wstride, double weight, size_t nthreads)
+{
+  hist_fill_job job;
+  memset(&job, 0, sizeof(hist_fill_job));
+  job.naxes = 2;
+  hist_fill_axis_init(&job.axis[0], h->nx, h->xrange);
+  hist_fill_axis_init(&job.axis[1], h->ny, h->yrange);
+  job.x[0] = x;
+  job.stride[0] = xstride;
+  job.x[1] = y;
+  job.stride[1] = ystride;
+  job.w = w;
+  job.wstride = wstride;
+  job.weight = weight;
+  job.n = n;
+  job.nbins = h->nx * h->ny;
+  hist_fill_run(&job, h->bin, nthreads);
+}
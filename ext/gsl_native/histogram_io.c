@@ -0,0 +1,616 @@
+/*
+  histogram_io.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Binary container for GSL::Histogram, Histogram2d and Histogram3d.
+
+  A dump is "GSLH", the number of dimensions, the format version, the
+  flags and a zero byte, then the number of bins along each axis as
+  little-endian 64-bit integers, then the values: the ranges of each
+  axis followed by the bins (row-major), as little-endian doubles.
+
+  With HIO_COMPRESSED set, the values are instead stored as the 64-bit
+  length of a zlib stream followed by the stream. The stream holds the
+  bytes of the values grouped by significance (all the lowest bytes
+  first, and so on), which deflate compresses much better than the
+  doubles themselves.
+
+  The parser below does not touch Ruby, so that merge_files can read
+  and add the shards on several threads.
+*/
+
+#include "include/rb_gsl_histogram.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_parallel.h"
+#include <stdint.h>
+#include <errno.h>
+#ifdef HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+
+#define HIO_VERSION 1
+#define HIO_COMPRESSED 1
+#define HIO_MAXDIM 3
+/* deflate never compresses by more than this factor */
+#define HIO_MAXRATIO 1032
+
+static VALUE cgsl_histogram3d_io;
+
+typedef struct {
+  int dims;
+  size_t n[HIO_MAXDIM];
+  size_t nvalues;             /* ranges and bins */
+  double *data;               /* the nvalues values, owned */
+  size_t cap;
+  unsigned char *scratch;     /* decompression buffer, owned */
+  size_t scratchcap;
+} hio_hist;
+
+static void hio_hist_free(hio_hist *h)
+{
+  free(h->data);
+  free(h->scratch);
+  h->data = NULL;
+  h->scratch = NULL;
+  h->cap = h->scratchcap = 0;
+}
+
+static size_t hio_nranges(const hio_hist *h)
+{
+  size_t d, n = 0;
+  for (d = 0; d < (size_t) h->dims; d++) n += h->n[d] + 1;
+  return n;
+}
+
+static size_t hio_nbins(const hio_hist *h)
+{
+  size_t d, n = 1;
+  for (d = 0; d < (size_t) h->dims; d++) n *= h->n[d];
+  return n;
+}
+
+static uint64_t hio_get_u64(const unsigned char *p)
+{
+  uint64_t v = 0;
+  int i;
+  for (i = 7; i >= 0; i--) v = (v << 8) | p[i];
+  return v;
+}
+
+static void hio_put_u64(unsigned char *p, uint64_t v)
+{
+  int i;
+  for (i = 0; i < 8; i++) p[i] = (unsigned char) (v >> (8 * i));
+}
+
+static int hio_reserve(void **p, size_t *cap, size_t size)
+{
+  void *q;
+  if (size <= *cap) return 0;
+  q = realloc(*p, size);
+  if (q == NULL) return -1;
+  *p = q;
+  *cap = size;
+  return 0;
+}
+
+/*
+  Decodes the dump p[0, len) into h. Returns NULL, or a message saying
+  what is wrong with the dump.
+*/
+static const char* hio_parse(const unsigned char *p, size_t len, hio_hist *h)
+{
+  const unsigned char *end = p + len, *src;
+  uint64_t v;
+  size_t d, i, nbytes, nbins, off;
+  int flags;
+  if (len < 8 || memcmp(p, "GSLH", 4) != 0) return "not a histogram dump";
+  if (p[5] != HIO_VERSION) return "unsupported histogram dump version";
+  h->dims = p[4];
+  flags = p[6];
+  if (h->dims < 1 || h->dims > HIO_MAXDIM || (flags & ~HIO_COMPRESSED) || p[7] != 0)
+    return "corrupt histogram dump header";
+  p += 8;
+  if ((size_t) (end - p) < 8 * (size_t) h->dims) return "truncated histogram dump";
+  h->nvalues = 0;
+  nbins = 1;
+  for (d = 0; d < (size_t) h->dims; d++, p += 8) {
+    v = hio_get_u64(p);
+    if (v == 0 || v > SIZE_MAX / 16 || nbins > SIZE_MAX / 16 / v) return "corrupt histogram dump header";
+    h->n[d] = (size_t) v;
+    nbins *= h->n[d];
+    if (h->nvalues > SIZE_MAX / 8 - h->n[d] - 1) return "corrupt histogram dump header";
+    h->nvalues += h->n[d] + 1;
+  }
+  if (h->nvalues > SIZE_MAX / 8 - nbins) return "corrupt histogram dump header";
+  h->nvalues += nbins;
+  nbytes = 8 * h->nvalues;
+  if (flags & HIO_COMPRESSED) {
+#ifdef HAVE_ZLIB_H
+    uLongf dlen = (uLongf) nbytes;
+    uint64_t clen;
+    size_t b;
+    if ((size_t) (end - p) < 8) return "truncated histogram dump";
+    clen = hio_get_u64(p);
+    p += 8;
+    if (clen != (uint64_t) (end - p)) return "truncated histogram dump";
+    if (h->nvalues / HIO_MAXRATIO > clen / 8) return "corrupt compressed histogram dump";
+    if ((size_t) dlen != nbytes || (uLong) clen != clen) return "histogram dump too large";
+    if (hio_reserve((void **) &h->data, &h->cap, nbytes)
+        || hio_reserve((void **) &h->scratch, &h->scratchcap, nbytes))
+      return "failed to allocate the histogram";
+    if (uncompress(h->scratch, &dlen, p, (uLong) clen) != Z_OK || dlen != nbytes)
+      return "corrupt compressed histogram dump";
+    for (i = 0; i < h->nvalues; i++) {
+      v = 0;
+      for (b = 8; b-- > 0;) v = (v << 8) | h->scratch[b * h->nvalues + i];
+      memcpy(&h->data[i], &v, 8);
+    }
+#else
+    return "compressed histogram dumps need zlib, which was not found at build time";
+#endif
+  } else {
+    if (h->nvalues != (size_t) (end - p) / 8 || (size_t) (end - p) != nbytes)
+      return "truncated histogram dump";
+    if (hio_reserve((void **) &h->data, &h->cap, nbytes)) return "failed to allocate the histogram";
+    for (i = 0, src = p; i < h->nvalues; i++, src += 8) {
+      v = hio_get_u64(src);
+      memcpy(&h->data[i], &v, 8);
+    }
+  }
+  /* the ranges must increase strictly */
+  for (d = 0, off = 0; d < (size_t) h->dims; off += h->n[d] + 1, d++)
+    for (i = 0; i < h->n[d]; i++)
+      if (!(h->data[off + i] < h->data[off + i + 1])) return "histogram ranges are not increasing";
+  return NULL;
+}
+
+/* reads the whole file into *buf; returns 0, or an errno value */
+static int hio_read_file(const char *path, unsigned char **buf, size_t *cap, size_t *len)
+{
+  FILE *fp = fopen(path, "rb");
+  size_t n;
+  int err;
+  if (fp == NULL) return errno ? errno : EIO;
+  *len = 0;
+  for (;;) {
+    if (*len == *cap && hio_reserve((void **) buf, cap, *cap ? 2 * *cap : 65536)) {
+      fclose(fp);
+      return ENOMEM;
+    }
+    n = fread(*buf + *len, 1, *cap - *len, fp);
+    *len += n;
+    if (n == 0) break;
+  }
+  err = ferror(fp) ? (errno ? errno : EIO) : 0;
+  fclose(fp);
+  return err;
+}
+
+/*****/
+
+/* the dims, sizes and value arrays of a histogram object */
+static int hio_segments(VALUE obj, size_t *n, const double **seg, size_t *segn)
+{
+  gsl_histogram *h1;
+  gsl_histogram2d *h2;
+  mygsl_histogram3d *h3;
+  if (rb_obj_is_kind_of(obj, cgsl_histogram3d_io)) {
+    Data_Get_Struct(obj, mygsl_histogram3d, h3);
+    n[0] = h3->nx; n[1] = h3->ny; n[2] = h3->nz;
+    seg[0] = h3->xrange; segn[0] = h3->nx + 1;
+    seg[1] = h3->yrange; segn[1] = h3->ny + 1;
+    seg[2] = h3->zrange; segn[2] = h3->nz + 1;
+    seg[3] = h3->bin; segn[3] = h3->nx * h3->ny * h3->nz;
+    return 3;
+  }
+  if (HISTOGRAM2D_P(obj)) {
+    Data_Get_Struct(obj, gsl_histogram2d, h2);
+    n[0] = h2->nx; n[1] = h2->ny;
+    seg[0] = h2->xrange; segn[0] = h2->nx + 1;
+    seg[1] = h2->yrange; segn[1] = h2->ny + 1;
+    seg[2] = h2->bin; segn[2] = h2->nx * h2->ny;
+    return 2;
+  }
+  CHECK_HISTOGRAM(obj);
+  Data_Get_Struct(obj, gsl_histogram, h1);
+  n[0] = h1->n;
+  seg[0] = h1->range; segn[0] = h1->n + 1;
+  seg[1] = h1->bin; segn[1] = h1->n;
+  return 1;
+}
+
+/* compress: option: false, true (level 6) or a zlib level 1..9 */
+static int hio_get_level(VALUE opts)
+{
+  VALUE c = rb_gsl_hash_get(opts, "compress");
+  int level;
+  if (NIL_P(c) || c == Qfalse) return 0;
+  level = (c == Qtrue) ? 6 : NUM2INT(c);
+  if (level < 0 || level > 9) rb_raise(rb_eArgError, "compression level must be in 0..9");
+#ifndef HAVE_ZLIB_H
+  if (level > 0) rb_raise(rb_eNotImpError, "compression needs zlib, which was not found at build time");
+#endif
+  return level;
+}
+
+static VALUE hio_dump(VALUE obj, int level)
+{
+  const double *seg[HIO_MAXDIM + 1];
+  size_t segn[HIO_MAXDIM + 1], n[HIO_MAXDIM], nvalues = 0, i;
+  unsigned char head[8] = {'G', 'S', 'L', 'H', 0, HIO_VERSION, 0, 0}, word[8];
+  int dims = hio_segments(obj, n, seg, segn), s;
+  uint64_t v;
+  VALUE str;
+  for (s = 0; s <= dims; s++) nvalues += segn[s];
+  head[4] = (unsigned char) dims;
+  if (level > 0) head[6] = HIO_COMPRESSED;
+  str = rb_str_buf_new(8 + 8 * dims + (level > 0 ? 8 : 8 * nvalues));
+  rb_str_buf_cat(str, (const char *) head, 8);
+  for (s = 0; s < dims; s++) {
+    hio_put_u64(word, n[s]);
+    rb_str_buf_cat(str, (const char *) word, 8);
+  }
+  if (level == 0) {
+    for (s = 0; s <= dims; s++) {
+      for (i = 0; i < segn[s]; i++) {
+        memcpy(&v, &seg[s][i], 8);
+        hio_put_u64(word, v);
+        rb_str_buf_cat(str, (const char *) word, 8);
+      }
+    }
+    return str;
+  }
+#ifdef HAVE_ZLIB_H
+  {
+    VALUE holder = rb_ary_new();
+    unsigned char *plane, *z;
+    uLongf zlen;
+    size_t j, k, b;
+    plane = ALLOC_N(unsigned char, 8 * nvalues);
+    rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, free, plane));
+    for (s = 0, k = 0; s <= dims; s++) {
+      for (j = 0; j < segn[s]; j++, k++) {
+        memcpy(&v, &seg[s][j], 8);
+        for (b = 0; b < 8; b++) plane[b * nvalues + k] = (unsigned char) (v >> (8 * b));
+      }
+    }
+    zlen = compressBound((uLong) (8 * nvalues));
+    z = ALLOC_N(unsigned char, zlen);
+    rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, free, z));
+    if (compress2(z, &zlen, plane, (uLong) (8 * nvalues), level) != Z_OK)
+      rb_raise(rb_eRuntimeError, "failed to compress the histogram");
+    hio_put_u64(word, zlen);
+    rb_str_buf_cat(str, (const char *) word, 8);
+    rb_str_buf_cat(str, (const char *) z, zlen);
+    RB_GC_GUARD(holder);
+  }
+#endif
+  return str;
+}
+
+/* a new histogram object holding the values of h */
+static VALUE hio_new(const hio_hist *h)
+{
+  const double *x = h->data;
+  gsl_histogram *h1;
+  gsl_histogram2d *h2;
+  mygsl_histogram3d *h3;
+  switch (h->dims) {
+  case 1:
+    h1 = gsl_histogram_alloc(h->n[0]);
+    memcpy(h1->range, x, (h->n[0] + 1) * sizeof(double));
+    memcpy(h1->bin, x + h->n[0] + 1, h->n[0] * sizeof(double));
+    return Data_Wrap_Struct(cgsl_histogram, 0, gsl_histogram_free, h1);
+  case 2:
+    h2 = gsl_histogram2d_alloc(h->n[0], h->n[1]);
+    memcpy(h2->xrange, x, (h->n[0] + 1) * sizeof(double));
+    x += h->n[0] + 1;
+    memcpy(h2->yrange, x, (h->n[1] + 1) * sizeof(double));
+    x += h->n[1] + 1;
+    memcpy(h2->bin, x, h->n[0] * h->n[1] * sizeof(double));
+    return Data_Wrap_Struct(cgsl_histogram2d, 0, gsl_histogram2d_free, h2);
+  default:
+    h3 = mygsl_histogram3d_alloc(h->n[0], h->n[1], h->n[2]);
+    memcpy(h3->xrange, x, (h->n[0] + 1) * sizeof(double));
+    x += h->n[0] + 1;
+    memcpy(h3->yrange, x, (h->n[1] + 1) * sizeof(double));
+    x += h->n[1] + 1;
+    memcpy(h3->zrange, x, (h->n[2] + 1) * sizeof(double));
+    x += h->n[2] + 1;
+    memcpy(h3->bin, x, h->n[0] * h->n[1] * h->n[2] * sizeof(double));
+    return Data_Wrap_Struct(cgsl_histogram3d_io, 0, mygsl_histogram3d_free, h3);
+  }
+}
+
+static VALUE hio_load(const unsigned char *p, size_t len, int dims)
+{
+  hio_hist h;
+  const char *msg;
+  VALUE obj;
+  memset(&h, 0, sizeof(hio_hist));
+  msg = hio_parse(p, len, &h);
+  if (msg == NULL && dims != h.dims) msg = "histogram dump of another dimension";
+  if (msg != NULL) {
+    hio_hist_free(&h);
+    rb_raise(rb_eArgError, "%s", msg);
+  }
+  obj = hio_new(&h);
+  hio_hist_free(&h);
+  return obj;
+}
+
+/*
+  Histogram#dump(compress: false), Histogram2d#dump, Histogram3d#dump
+
+  The histogram as a String in the container format; compress: true or
+  a zlib level 1..9 compresses the values. _dump (for Marshal) takes
+  the Marshal depth and writes an uncompressed dump.
+*/
+static VALUE rb_gsl_histogram_dump(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE opts = Qnil;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  return hio_dump(obj, hio_get_level(opts));
+}
+
+static VALUE hio_load_str(VALUE str, int dims)
+{
+  StringValue(str);
+  return hio_load((const unsigned char *) RSTRING_PTR(str), RSTRING_LEN(str), dims);
+}
+
+static VALUE rb_gsl_histogram_load(VALUE klass, VALUE str)
+{
+  return hio_load_str(str, 1);
+}
+
+static VALUE rb_gsl_histogram2d_load(VALUE klass, VALUE str)
+{
+  return hio_load_str(str, 2);
+}
+
+static VALUE rb_gsl_histogram3d_load(VALUE klass, VALUE str)
+{
+  return hio_load_str(str, 3);
+}
+
+/*
+  Histogram#dump_file(path, compress: false), Histogram.load_file(path)
+  and the same for Histogram2d and Histogram3d.
+*/
+static VALUE rb_gsl_histogram_dump_file(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE opts = Qnil, str;
+  FILE *fp;
+  const char *path;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1)", argc);
+  path = StringValuePtr(argv[0]);
+  str = hio_dump(obj, hio_get_level(opts));
+  fp = fopen(path, "wb");
+  if (fp == NULL) rb_sys_fail(path);
+  if (fwrite(RSTRING_PTR(str), 1, RSTRING_LEN(str), fp) != (size_t) RSTRING_LEN(str)) {
+    fclose(fp);
+    rb_sys_fail(path);
+  }
+  if (fclose(fp) != 0) rb_sys_fail(path);
+  return obj;
+}
+
+static VALUE hio_load_file(VALUE vpath, int dims)
+{
+  unsigned char *buf = NULL;
+  size_t cap = 0, len = 0;
+  const char *path = StringValuePtr(vpath);
+  VALUE holder = rb_ary_new(), obj;
+  int err = hio_read_file(path, &buf, &cap, &len);
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, free, buf));
+  if (err) {
+    errno = err;
+    rb_sys_fail(path);
+  }
+  obj = hio_load(buf, len, dims);
+  RB_GC_GUARD(holder);
+  return obj;
+}
+
+static VALUE rb_gsl_histogram_load_file(VALUE klass, VALUE path)
+{
+  return hio_load_file(path, 1);
+}
+
+static VALUE rb_gsl_histogram2d_load_file(VALUE klass, VALUE path)
+{
+  return hio_load_file(path, 2);
+}
+
+static VALUE rb_gsl_histogram3d_load_file(VALUE klass, VALUE path)
+{
+  return hio_load_file(path, 3);
+}
+
+/*****/
+
+typedef struct {
+  const char **paths;
+  size_t npaths;
+  const hio_hist *ref;      /* the geometry every shard must have */
+  size_t nranges, nbins;
+  double **bins;            /* bins[tid] */
+  /* the first failure of each thread: file index, errno or message */
+  size_t *fail;
+  int *err;
+  const char **msg;
+} hio_merge_job;
+
+static void hio_merge_worker(size_t tid, size_t nthreads, void *data)
+{
+  hio_merge_job *job = (hio_merge_job *) data;
+  hio_hist h;
+  unsigned char *buf = NULL;
+  size_t cap = 0, len, k, i;
+  double *acc = job->bins[tid];
+  const char *msg;
+  int err;
+  memset(&h, 0, sizeof(hio_hist));
+  for (k = tid; k < job->npaths && !rb_gsl_parallel_interrupted(); k += nthreads) {
+    err = hio_read_file(job->paths[k], &buf, &cap, &len);
+    msg = NULL;
+    if (err == 0) msg = hio_parse(buf, len, &h);
+    if (err == 0 && msg == NULL) {
+      if (h.dims != job->ref->dims || memcmp(h.n, job->ref->n, sizeof(h.n)) != 0)
+        msg = "histogram shards of different sizes";
+      for (i = 0; msg == NULL && i < job->nranges; i++)
+        if (h.data[i] != job->ref->data[i]) msg = "histogram shards with different ranges";
+    }
+    if (err || msg) {
+      job->fail[tid] = k;
+      job->err[tid] = err;
+      job->msg[tid] = msg;
+      break;
+    }
+    for (i = 0; i < job->nbins; i++) acc[i] += h.data[job->nranges + i];
+  }
+  free(buf);
+  hio_hist_free(&h);
+}
+
+/*
+  GSL::Histogram.merge_files(paths, threads: n)
+
+  Reads the histogram dumps in the files of paths (all with the same
+  dimension, sizes and ranges) and returns their sum, as a Histogram,
+  Histogram2d or Histogram3d. The files are dealt out to the threads,
+  each of which adds its shards into its own bins, and the bins of the
+  threads are added in thread order at the end.
+*/
+static VALUE rb_gsl_histogram_merge_files(int argc, VALUE *argv, VALUE klass)
+{
+  VALUE opts = Qnil, paths, holder = rb_ary_new(), obj, s;
+  hio_merge_job job;
+  hio_hist ref;
+  const char *msg = NULL, *failpath = NULL;
+  unsigned char *buf = NULL;
+  size_t cap = 0, len, k, t, i, nthreads;
+  int err = 0, failed = 0;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1)", argc);
+  paths = rb_Array(argv[0]);
+  rb_ary_push(holder, paths);
+  if (RARRAY_LEN(paths) == 0) rb_raise(rb_eArgError, "no files to merge");
+  memset(&job, 0, sizeof(hio_merge_job));
+  job.npaths = RARRAY_LEN(paths);
+  job.paths = ALLOC_N(const char *, job.npaths);
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, free, job.paths));
+  for (k = 0; k < job.npaths; k++) {
+    s = rb_get_path(rb_ary_entry(paths, k));
+    rb_ary_push(holder, s);
+    job.paths[k] = StringValueCStr(s);
+  }
+  nthreads = rb_gsl_parallel_threads(opts);
+  if (nthreads > job.npaths) nthreads = job.npaths;
+  if (nthreads < 1) nthreads = 1;
+
+  /* the first file gives the geometry */
+  memset(&ref, 0, sizeof(hio_hist));
+  err = hio_read_file(job.paths[0], &buf, &cap, &len);
+  if (err == 0) msg = hio_parse(buf, len, &ref);
+  free(buf);
+  if (err || msg) {
+    hio_hist_free(&ref);
+    if (err) {
+      errno = err;
+      rb_sys_fail(job.paths[0]);
+    }
+    rb_raise(rb_eArgError, "%s: %s", job.paths[0], msg);
+  }
+  job.ref = &ref;
+  job.nranges = hio_nranges(&ref);
+  job.nbins = hio_nbins(&ref);
+  job.bins = (double **) calloc(nthreads, sizeof(double *));
+  job.fail = (size_t *) calloc(nthreads, sizeof(size_t));
+  job.err = (int *) calloc(nthreads, sizeof(int));
+  job.msg = (const char **) calloc(nthreads, sizeof(const char *));
+  failed = job.bins == NULL || job.fail == NULL || job.err == NULL || job.msg == NULL;
+  for (t = 0; t < nthreads && !failed; t++) {
+    job.bins[t] = (double *) calloc(job.nbins, sizeof(double));
+    if (job.bins[t] == NULL) failed = 1;
+  }
+  if (!failed) {
+    for (t = 0; t < nthreads; t++) job.fail[t] = job.npaths;
+    if (nthreads == 1) hio_merge_worker(0, 1, &job);
+    else rb_gsl_parallel_run(nthreads, hio_merge_worker, &job);
+    /* report the failure of the first file in the list */
+    k = job.npaths;
+    for (t = 0; t < nthreads; t++) {
+      if (job.fail[t] < k) {
+        k = job.fail[t];
+        err = job.err[t];
+        msg = job.msg[t];
+      }
+    }
+    if (k < job.npaths) failpath = job.paths[k];
+    else {
+      /* the sum goes into the bins of ref, which become the result */
+      for (i = 0; i < job.nbins; i++) ref.data[job.nranges + i] = 0.0;
+      for (t = 0; t < nthreads; t++)
+        for (i = 0; i < job.nbins; i++) ref.data[job.nranges + i] += job.bins[t][i];
+    }
+  }
+  if (job.bins) for (t = 0; t < nthreads; t++) free(job.bins[t]);
+  free(job.bins);
+  free(job.fail);
+  free(job.err);
+  free(job.msg);
+  if (failed) {
+    hio_hist_free(&ref);
+    rb_raise(rb_eNoMemError, "failed to allocate the partial histograms");
+  }
+  if (failpath) {
+    hio_hist_free(&ref);
+    if (err) {
+      errno = err;
+      rb_sys_fail(failpath);
+    }
+    rb_raise(rb_eArgError, "%s: %s", failpath, msg);
+  }
+  obj = hio_new(&ref);
+  hio_hist_free(&ref);
+  RB_GC_GUARD(holder);
+  return obj;
+}
+
+void Init_gsl_histogram_io(VALUE module)
+{
+  VALUE klass[3];
+  int i;
+  cgsl_histogram3d_io = rb_const_get(module, rb_intern("Histogram3d"));
+  klass[0] = cgsl_histogram;
+  klass[1] = cgsl_histogram2d;
+  klass[2] = cgsl_histogram3d_io;
+  for (i = 0; i < 3; i++) {
+    rb_define_method(klass[i], "dump", rb_gsl_histogram_dump, -1);
+    rb_define_method(klass[i], "_dump", rb_gsl_histogram_dump, -1);
+    rb_define_method(klass[i], "dump_file", rb_gsl_histogram_dump_file, -1);
+  }
+  rb_define_singleton_method(cgsl_histogram, "load", rb_gsl_histogram_load, 1);
+  rb_define_singleton_method(cgsl_histogram, "_load", rb_gsl_histogram_load, 1);
+  rb_define_singleton_method(cgsl_histogram, "load_file", rb_gsl_histogram_load_file, 1);
+  rb_define_singleton_method(cgsl_histogram2d, "load", rb_gsl_histogram2d_load, 1);
+  rb_define_singleton_method(cgsl_histogram2d, "_load", rb_gsl_histogram2d_load, 1);
+  rb_define_singleton_method(cgsl_histogram2d, "load_file", rb_gsl_histogram2d_load_file, 1);
+  rb_define_singleton_method(cgsl_histogram3d_io, "load", rb_gsl_histogram3d_load, 1);
+  rb_define_singleton_method(cgsl_histogram3d_io, "_load", rb_gsl_histogram3d_load, 1);
+  rb_define_singleton_method(cgsl_histogram3d_io, "load_file", rb_gsl_histogram3d_load_file, 1);
+
+  rb_define_singleton_method(cgsl_histogram, "merge_files", rb_gsl_histogram_merge_files, -1);
+}
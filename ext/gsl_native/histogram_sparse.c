@@ -0,0 +1,660 @@
+/*
+  histogram_sparse.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Histogram::Sparse, a histogram of any dimension that stores only
+  the bins that were filled, in an open-addressing hash table (linear
+  probing, at most 3/4 full) from the bin index vector to the weight.
+
+  An axis is either uniform, given by a number of bins and limits, or
+  explicit, given by its bin edges. Bins of a uniform axis are numbered
+  from its lower limit, so with extend: true values beyond the limits
+  simply get bins with negative or larger numbers, and the ranges grow
+  to cover all the bins filled so far. Explicit axes cannot grow.
+*/
+
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_histogram.h"
+#include <stdint.h>
+
+typedef struct {
+  double *edges;        /* n0 + 1 edges of an explicit axis, NULL if uniform */
+  double origin, width;
+  int64_t n0;           /* number of bins given at creation */
+  int64_t imin, imax;   /* the bins [imin, imax) cover all the data */
+} sparse_axis;
+
+typedef struct {
+  size_t dim;
+  int extend;
+  sparse_axis *axis;
+  size_t cap, nnz;      /* cap is a power of 2 */
+  int64_t *keys;        /* cap * dim bin numbers */
+  double *vals;
+  unsigned char *used;
+} mygsl_histogram_sparse;
+
+static VALUE cgsl_histogram_sparse;
+
+/* bins of a uniform axis beyond this are dropped even with extend */
+#define SPARSE_KEY_MAX 4.0e18
+
+static void mygsl_histogram_sparse_free(mygsl_histogram_sparse *h)
+{
+  size_t d;
+  for (d = 0; d < h->dim; d++) free(h->axis[d].edges);
+  free(h->axis);
+  free(h->keys);
+  free(h->vals);
+  free(h->used);
+  free(h);
+}
+
+static int sparse_table_alloc(mygsl_histogram_sparse *h, size_t cap)
+{
+  h->keys = (int64_t *) malloc(cap * h->dim * sizeof(int64_t));
+  h->vals = (double *) malloc(cap * sizeof(double));
+  h->used = (unsigned char *) calloc(cap, 1);
+  h->cap = cap;
+  h->nnz = 0;
+  return h->keys && h->vals && h->used;
+}
+
+static mygsl_histogram_sparse* sparse_alloc(size_t dim, size_t cap)
+{
+  mygsl_histogram_sparse *h;
+  h = (mygsl_histogram_sparse *) calloc(1, sizeof(mygsl_histogram_sparse));
+  if (h == NULL) rb_raise(rb_eNoMemError, "failed to allocate a sparse histogram");
+  h->dim = dim;
+  h->axis = (sparse_axis *) calloc(dim, sizeof(sparse_axis));
+  if (h->axis == NULL || !sparse_table_alloc(h, cap)) {
+    mygsl_histogram_sparse_free(h);
+    rb_raise(rb_eNoMemError, "failed to allocate a sparse histogram");
+  }
+  return h;
+}
+
+static uint64_t sparse_hash(const int64_t *k, size_t dim)
+{
+  uint64_t x = 0x243F6A8885A308D3ULL;
+  size_t d;
+  for (d = 0; d < dim; d++) {
+    x ^= (uint64_t) k[d];
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+  }
+  return x;
+}
+
+/* the slot holding the bin k, or the empty slot where it goes */
+static size_t sparse_slot(const mygsl_histogram_sparse *h, const int64_t *k)
+{
+  size_t i = (size_t) sparse_hash(k, h->dim) & (h->cap - 1);
+  while (h->used[i] && memcmp(h->keys + i * h->dim, k, h->dim * sizeof(int64_t)) != 0)
+    i = (i + 1) & (h->cap - 1);
+  return i;
+}
+
+static void sparse_grow(mygsl_histogram_sparse *h)
+{
+  int64_t *keys = h->keys;
+  double *vals = h->vals;
+  unsigned char *used = h->used;
+  size_t cap = h->cap, nnz = h->nnz, i, s;
+  if (!sparse_table_alloc(h, 2 * cap)) {
+    free(h->keys); free(h->vals); free(h->used);
+    h->keys = keys; h->vals = vals; h->used = used;
+    h->cap = cap; h->nnz = nnz;
+    rb_raise(rb_eNoMemError, "failed to grow a sparse histogram of %d bins", (int) nnz);
+  }
+  for (i = 0; i < cap; i++) {
+    if (!used[i]) continue;
+    s = sparse_slot(h, keys + i * h->dim);
+    memcpy(h->keys + s * h->dim, keys + i * h->dim, h->dim * sizeof(int64_t));
+    h->vals[s] = vals[i];
+    h->used[s] = 1;
+  }
+  h->nnz = nnz;
+  free(keys); free(vals); free(used);
+}
+
+/* grows the table only for a new bin, so k may point into the table */
+static void sparse_add(mygsl_histogram_sparse *h, const int64_t *k, double w)
+{
+  size_t s, d;
+  s = sparse_slot(h, k);
+  if (h->used[s]) {
+    h->vals[s] += w;
+    return;
+  }
+  if (4 * (h->nnz + 1) > 3 * h->cap) {
+    sparse_grow(h);
+    s = sparse_slot(h, k);
+  }
+  memcpy(h->keys + s * h->dim, k, h->dim * sizeof(int64_t));
+  h->vals[s] = w;
+  h->used[s] = 1;
+  h->nnz++;
+  for (d = 0; d < h->dim; d++) {
+    if (k[d] < h->axis[d].imin) h->axis[d].imin = k[d];
+    if (k[d] >= h->axis[d].imax) h->axis[d].imax = k[d] + 1;
+  }
+}
+
+static double sparse_edge(const sparse_axis *a, int64_t k)
+{
+  return a->edges ? a->edges[k] : a->origin + k * a->width;
+}
+
+/* bin number of x on the axis a, 0 on success and -1 if x is dropped */
+static int sparse_axis_find(const sparse_axis *a, int extend, double x, int64_t *k)
+{
+  size_t lo, hi, mid;
+  double t;
+  if (a->edges) {
+    if (!(x >= a->edges[0] && x < a->edges[a->n0])) return -1;
+    lo = 0; hi = a->n0;
+    while (hi - lo > 1) {
+      mid = (lo + hi) / 2;
+      if (x >= a->edges[mid]) lo = mid;
+      else hi = mid;
+    }
+    *k = (int64_t) lo;
+    return 0;
+  }
+  t = floor((x - a->origin) / a->width);
+  if (!(t > -SPARSE_KEY_MAX && t < SPARSE_KEY_MAX)) return -1;
+  *k = (int64_t) t;
+  if (x < sparse_edge(a, *k)) (*k)--;
+  else if (x >= sparse_edge(a, *k + 1)) (*k)++;
+  if (!extend && (*k < 0 || *k >= a->n0)) return -1;
+  return 0;
+}
+
+static void sparse_fill(mygsl_histogram_sparse *h, const double *x, size_t stride, double w)
+{
+  int64_t *k = ALLOCA_N(int64_t, h->dim);
+  size_t d;
+  for (d = 0; d < h->dim; d++)
+    if (sparse_axis_find(&h->axis[d], h->extend, x[d * stride], &k[d])) return;
+  sparse_add(h, k, w);
+}
+
+static void sparse_axis_init(sparse_axis *a, VALUE v)
+{
+  gsl_vector *e;
+  size_t i;
+  if (TYPE(v) == T_ARRAY && RARRAY_LEN(v) == 3) {
+    a->n0 = NUM2LONG(rb_ary_entry(v, 0));
+    a->origin = NUM2DBL(rb_ary_entry(v, 1));
+    a->width = (NUM2DBL(rb_ary_entry(v, 2)) - a->origin) / a->n0;
+    if (a->n0 < 1 || !(a->width > 0))
+      rb_raise(rb_eArgError, "an axis needs n >= 1 bins and min < max");
+  } else if (VECTOR_P(v)) {
+    Data_Get_Vector(v, e);
+    if (e->size < 2) rb_raise(rb_eArgError, "an axis needs at least 2 edges");
+    a->n0 = e->size - 1;
+    a->edges = (double *) malloc(e->size * sizeof(double));
+    if (a->edges == NULL) rb_raise(rb_eNoMemError, "failed to allocate the edges");
+    for (i = 0; i < e->size; i++) {
+      a->edges[i] = gsl_vector_get(e, i);
+      if (i > 0 && !(a->edges[i] > a->edges[i - 1])) {
+        free(a->edges);
+        a->edges = NULL;
+        rb_raise(rb_eArgError, "the edges of an axis must increase");
+      }
+    }
+  } else {
+    rb_raise(rb_eTypeError, "wrong axis %s ([n, min, max] or GSL::Vector of edges expected)",
+             rb_class2name(CLASS_OF(v)));
+  }
+  a->imin = 0;
+  a->imax = a->n0;
+}
+
+static VALUE sparse_wrap(mygsl_histogram_sparse *h)
+{
+  return Data_Wrap_Struct(cgsl_histogram_sparse, 0, mygsl_histogram_sparse_free, h);
+}
+
+/* an empty histogram with the axes of src */
+static mygsl_histogram_sparse* sparse_alloc_like(const mygsl_histogram_sparse *src, size_t cap)
+{
+  mygsl_histogram_sparse *h = sparse_alloc(src->dim, cap);
+  size_t d;
+  h->extend = src->extend;
+  for (d = 0; d < src->dim; d++) {
+    h->axis[d] = src->axis[d];
+    if (src->axis[d].edges) {
+      h->axis[d].edges = (double *) malloc((src->axis[d].n0 + 1) * sizeof(double));
+      if (h->axis[d].edges == NULL) {
+        mygsl_histogram_sparse_free(h);
+        rb_raise(rb_eNoMemError, "failed to allocate the edges");
+      }
+      memcpy(h->axis[d].edges, src->axis[d].edges, (src->axis[d].n0 + 1) * sizeof(double));
+    }
+  }
+  return h;
+}
+
+/*
+  Document-method: <i>GSL::Histogram::Sparse.new</i>
+    Sparse.new(axis0, axis1, ..., extend: false), each axis [n, min, max]
+    or a GSL::Vector of bin edges.
+*/
+static VALUE rb_gsl_histogram_sparse_new(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_histogram_sparse *h;
+  VALUE opts = Qnil, obj;
+  int d;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc < 1) rb_raise(rb_eArgError, "too few arguments (at least one axis expected)");
+  h = sparse_alloc(argc, 64);
+  obj = sparse_wrap(h);
+  h->extend = RTEST(rb_gsl_hash_get(opts, "extend"));
+  for (d = 0; d < argc; d++) {
+    sparse_axis_init(&h->axis[d], argv[d]);
+    if (h->extend && h->axis[d].edges)
+      rb_raise(rb_eArgError, "axis %d has explicit edges and cannot extend", d);
+  }
+  return obj;
+}
+
+static VALUE rb_gsl_histogram_sparse_dim(VALUE obj)
+{
+  mygsl_histogram_sparse *h;
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  return INT2FIX((int) h->dim);
+}
+
+static VALUE rb_gsl_histogram_sparse_nnz(VALUE obj)
+{
+  mygsl_histogram_sparse *h;
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  return SIZET2NUM(h->nnz);
+}
+
+static VALUE rb_gsl_histogram_sparse_shape(VALUE obj)
+{
+  mygsl_histogram_sparse *h;
+  VALUE ary;
+  size_t d;
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  ary = rb_ary_new2(h->dim);
+  for (d = 0; d < h->dim; d++)
+    rb_ary_store(ary, d, LL2NUM(h->axis[d].imax - h->axis[d].imin));
+  return ary;
+}
+
+static VALUE rb_gsl_histogram_sparse_extend_p(VALUE obj)
+{
+  mygsl_histogram_sparse *h;
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  return h->extend ? Qtrue : Qfalse;
+}
+
+static size_t sparse_axis_index(const mygsl_histogram_sparse *h, VALUE vd)
+{
+  long d = NUM2LONG(vd);
+  if (d < 0) d += h->dim;
+  if (d < 0 || d >= (long) h->dim)
+    rb_raise(rb_eIndexError, "axis %ld out of range (dimension %d)", NUM2LONG(vd), (int) h->dim);
+  return (size_t) d;
+}
+
+/* the current edges of axis d */
+static gsl_vector* sparse_axis_edges(const mygsl_histogram_sparse *h, size_t d)
+{
+  const sparse_axis *a = &h->axis[d];
+  gsl_vector *v = gsl_vector_alloc(a->imax - a->imin + 1);
+  int64_t i;
+  for (i = a->imin; i <= a->imax; i++) gsl_vector_set(v, i - a->imin, sparse_edge(a, i));
+  return v;
+}
+
+static VALUE rb_gsl_histogram_sparse_range(VALUE obj, VALUE vd)
+{
+  mygsl_histogram_sparse *h;
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, sparse_axis_edges(h, sparse_axis_index(h, vd)));
+}
+
+static VALUE rb_gsl_histogram_sparse_get(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_histogram_sparse *h;
+  int64_t *k;
+  size_t d, s;
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  if (argc == 1 && TYPE(argv[0]) == T_ARRAY) {
+    argc = RARRAY_LEN(argv[0]);
+    argv = RARRAY_PTR(argv[0]);
+  }
+  if (argc != (int) h->dim)
+    rb_raise(rb_eArgError, "wrong number of indices (%d for %d)", argc, (int) h->dim);
+  k = ALLOCA_N(int64_t, h->dim);
+  for (d = 0; d < h->dim; d++) k[d] = NUM2LL(argv[d]) + h->axis[d].imin;
+  s = sparse_slot(h, k);
+  return rb_float_new(h->used[s] ? h->vals[s] : 0.0);
+}
+
+/*
+  Document-method: <i>GSL::Histogram::Sparse#increment</i>
+    increment(x, weight = 1): x is one point (Array or Vector of dim
+    coordinates) or a Matrix with one point per row; weight is a number
+    or, for a Matrix, a Vector of one weight per row.
+*/
+static VALUE rb_gsl_histogram_sparse_increment(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_histogram_sparse *h;
+  gsl_matrix *m;
+  gsl_vector *v, *vw = NULL;
+  double weight = 1, *x;
+  size_t i;
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  switch (argc) {
+  case 2:
+    if (VECTOR_P(argv[1])) {
+      Data_Get_Vector(argv[1], vw);
+    } else {
+      Need_Float(argv[1]);
+      weight = NUM2DBL(argv[1]);
+    }
+    break;
+  case 1:
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+    break;
+  }
+  if (MATRIX_P(argv[0])) {
+    Data_Get_Matrix(argv[0], m);
+    if (m->size2 != h->dim)
+      rb_raise(rb_eArgError, "matrix has %d columns for dimension %d", (int) m->size2, (int) h->dim);
+    if (vw && vw->size != m->size1)
+      rb_raise(rb_eArgError, "%d weights for %d points", (int) vw->size, (int) m->size1);
+    for (i = 0; i < m->size1; i++)
+      if (mygsl_histogram_check_nan(m->data + i * m->tda, 1, m->size2) != GSL_SUCCESS) return obj;
+    for (i = 0; i < m->size1; i++)
+      sparse_fill(h, m->data + i * m->tda, 1, vw ? gsl_vector_get(vw, i) : weight);
+    return obj;
+  }
+  if (vw) rb_raise(rb_eTypeError, "a vector of weights needs a matrix of points");
+  if (VECTOR_P(argv[0])) {
+    Data_Get_Vector(argv[0], v);
+    if (v->size != h->dim)
+      rb_raise(rb_eArgError, "point has %d coordinates for dimension %d", (int) v->size, (int) h->dim);
+    if (mygsl_histogram_check_nan(v->data, v->stride, v->size) != GSL_SUCCESS) return obj;
+    sparse_fill(h, v->data, v->stride, weight);
+  } else {
+    Check_Type(argv[0], T_ARRAY);
+    if (RARRAY_LEN(argv[0]) != (long) h->dim)
+      rb_raise(rb_eArgError, "point has %d coordinates for dimension %d",
+               (int) RARRAY_LEN(argv[0]), (int) h->dim);
+    x = ALLOCA_N(double, h->dim);
+    for (i = 0; i < h->dim; i++) x[i] = NUM2DBL(rb_ary_entry(argv[0], i));
+    if (mygsl_histogram_check_nan(x, 1, h->dim) != GSL_SUCCESS) return obj;
+    sparse_fill(h, x, 1, weight);
+  }
+  return obj;
+}
+
+static VALUE rb_gsl_histogram_sparse_each(VALUE obj)
+{
+  mygsl_histogram_sparse *h;
+  VALUE idx;
+  size_t i, d;
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  for (i = 0; i < h->cap; i++) {
+    if (!h->used[i]) continue;
+    idx = rb_ary_new2(h->dim);
+    for (d = 0; d < h->dim; d++)
+      rb_ary_store(idx, d, LL2NUM(h->keys[i * h->dim + d] - h->axis[d].imin));
+    rb_yield_values(2, idx, rb_float_new(h->vals[i]));
+  }
+  return obj;
+}
+
+static VALUE rb_gsl_histogram_sparse_sum(VALUE obj)
+{
+  mygsl_histogram_sparse *h;
+  double s = 0.0;
+  size_t i;
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  for (i = 0; i < h->cap; i++) if (h->used[i]) s += h->vals[i];
+  return rb_float_new(s);
+}
+
+static VALUE rb_gsl_histogram_sparse_reset(VALUE obj)
+{
+  mygsl_histogram_sparse *h;
+  size_t d;
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  memset(h->used, 0, h->cap);
+  h->nnz = 0;
+  for (d = 0; d < h->dim; d++) {
+    h->axis[d].imin = 0;
+    h->axis[d].imax = h->axis[d].n0;
+  }
+  return obj;
+}
+
+static VALUE rb_gsl_histogram_sparse_clone(VALUE obj)
+{
+  mygsl_histogram_sparse *h, *hnew;
+  VALUE vnew;
+  size_t d;
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  hnew = sparse_alloc_like(h, h->cap);
+  vnew = sparse_wrap(hnew);
+  memcpy(hnew->keys, h->keys, h->cap * h->dim * sizeof(int64_t));
+  memcpy(hnew->vals, h->vals, h->cap * sizeof(double));
+  memcpy(hnew->used, h->used, h->cap);
+  hnew->nnz = h->nnz;
+  for (d = 0; d < h->dim; d++) {
+    hnew->axis[d].imin = h->axis[d].imin;
+    hnew->axis[d].imax = h->axis[d].imax;
+  }
+  return vnew;
+}
+
+/* same dimension and the same bins where they overlap */
+static int sparse_compatible(const mygsl_histogram_sparse *a, const mygsl_histogram_sparse *b)
+{
+  size_t d;
+  if (a->dim != b->dim) return 0;
+  for (d = 0; d < a->dim; d++) {
+    const sparse_axis *x = &a->axis[d], *y = &b->axis[d];
+    if ((x->edges == NULL) != (y->edges == NULL)) return 0;
+    if (x->edges) {
+      if (x->n0 != y->n0 || memcmp(x->edges, y->edges, (x->n0 + 1) * sizeof(double)) != 0) return 0;
+    } else if (x->origin != y->origin || x->width != y->width) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+  Document-method: <i>GSL::Histogram::Sparse#merge!</i>
+    Adds the bins of other, which must have the same axes.
+*/
+static VALUE rb_gsl_histogram_sparse_merge_bang(VALUE obj, VALUE other)
+{
+  mygsl_histogram_sparse *h, *h2;
+  size_t i, d;
+  int64_t k;
+  if (!rb_obj_is_kind_of(other, cgsl_histogram_sparse))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Histogram::Sparse expected)",
+             rb_class2name(CLASS_OF(other)));
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  Data_Get_Struct(other, mygsl_histogram_sparse, h2);
+  if (!sparse_compatible(h, h2)) rb_raise(rb_eArgError, "histograms with different axes");
+  if (!h->extend) {
+    for (i = 0; i < h2->cap; i++) {
+      if (!h2->used[i]) continue;
+      for (d = 0; d < h->dim; d++) {
+        k = h2->keys[i * h->dim + d];
+        if (k < 0 || k >= h->axis[d].n0)
+          rb_raise(rb_eArgError, "bins outside the ranges of a histogram that does not extend");
+      }
+    }
+  }
+  if (h2 == h) {
+    /* every bin of the snapshot is already there */
+    for (i = 0; i < h->cap; i++) if (h->used[i]) h->vals[i] += h->vals[i];
+    return obj;
+  }
+  for (i = 0; i < h2->cap; i++)
+    if (h2->used[i]) sparse_add(h, h2->keys + i * h->dim, h2->vals[i]);
+  return obj;
+}
+
+static VALUE rb_gsl_histogram_sparse_merge(VALUE obj, VALUE other)
+{
+  return rb_gsl_histogram_sparse_merge_bang(rb_gsl_histogram_sparse_clone(obj), other);
+}
+
+/* the axis numbers of argv, owned by holder */
+static size_t* sparse_get_axes(const mygsl_histogram_sparse *h, int argc, VALUE *argv, VALUE holder)
+{
+  size_t *axes = ALLOC_N(size_t, argc > 0 ? argc : 1);
+  int i, j;
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, RUBY_DEFAULT_FREE, axes));
+  for (i = 0; i < argc; i++) {
+    axes[i] = sparse_axis_index(h, argv[i]);
+    for (j = 0; j < i; j++)
+      if (axes[j] == axes[i]) rb_raise(rb_eArgError, "axis %d given twice", (int) axes[i]);
+  }
+  return axes;
+}
+
+/*
+  Document-method: <i>GSL::Histogram::Sparse#marginalize</i>
+    marginalize(*axes): the sparse histogram over the given axes, summed
+    over all the others.
+*/
+static VALUE rb_gsl_histogram_sparse_marginalize(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_histogram_sparse *h, *hnew;
+  VALUE vnew, holder = rb_ary_new();
+  size_t *axes, i, d;
+  int64_t *k;
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  if (argc < 1) rb_raise(rb_eArgError, "too few arguments (at least one axis expected)");
+  axes = sparse_get_axes(h, argc, argv, holder);
+  hnew = (mygsl_histogram_sparse *) calloc(1, sizeof(mygsl_histogram_sparse));
+  if (hnew == NULL) rb_raise(rb_eNoMemError, "failed to allocate a sparse histogram");
+  hnew->dim = argc;
+  hnew->extend = h->extend;
+  hnew->axis = (sparse_axis *) calloc(argc, sizeof(sparse_axis));
+  if (hnew->axis == NULL || !sparse_table_alloc(hnew, 64)) {
+    mygsl_histogram_sparse_free(hnew);
+    rb_raise(rb_eNoMemError, "failed to allocate a sparse histogram");
+  }
+  vnew = sparse_wrap(hnew);
+  for (d = 0; d < (size_t) argc; d++) {
+    const sparse_axis *a = &h->axis[axes[d]];
+    hnew->axis[d] = *a;
+    hnew->axis[d].edges = NULL;
+    if (a->edges) {
+      hnew->axis[d].edges = (double *) malloc((a->n0 + 1) * sizeof(double));
+      if (hnew->axis[d].edges == NULL) rb_raise(rb_eNoMemError, "failed to allocate the edges");
+      memcpy(hnew->axis[d].edges, a->edges, (a->n0 + 1) * sizeof(double));
+    }
+  }
+  k = ALLOCA_N(int64_t, argc);
+  for (i = 0; i < h->cap; i++) {
+    if (!h->used[i]) continue;
+    for (d = 0; d < (size_t) argc; d++) k[d] = h->keys[i * h->dim + axes[d]];
+    sparse_add(hnew, k, h->vals[i]);
+  }
+  RB_GC_GUARD(holder);
+  return vnew;
+}
+
+/*
+  Document-method: <i>GSL::Histogram::Sparse#project</i>
+    project(*axes): a dense GSL::Histogram, Histogram2d or Histogram3d
+    over 1, 2 or 3 of the axes, summed over all the others.
+*/
+static VALUE rb_gsl_histogram_sparse_project(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_histogram_sparse *h;
+  gsl_vector *e[3] = {NULL, NULL, NULL};
+  size_t *axes, n[3] = {1, 1, 1}, i, d, off;
+  double *bin;
+  VALUE vh, holder = rb_ary_new();
+  Data_Get_Struct(obj, mygsl_histogram_sparse, h);
+  if (argc < 1 || argc > 3) rb_raise(rb_eArgError, "wrong number of axes (%d for 1-3)", argc);
+  axes = sparse_get_axes(h, argc, argv, holder);
+  for (d = 0; d < (size_t) argc; d++) {
+    e[d] = sparse_axis_edges(h, axes[d]);
+    rb_ary_push(holder, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, e[d]));
+    n[d] = e[d]->size - 1;
+  }
+  if (argc == 1) {
+    gsl_histogram *h1 = gsl_histogram_calloc(n[0]);
+    gsl_histogram_set_ranges(h1, e[0]->data, e[0]->size);
+    bin = h1->bin;
+    vh = Data_Wrap_Struct(cgsl_histogram, 0, gsl_histogram_free, h1);
+  } else if (argc == 2) {
+    gsl_histogram2d *h2 = gsl_histogram2d_calloc(n[0], n[1]);
+    gsl_histogram2d_set_ranges(h2, e[0]->data, e[0]->size, e[1]->data, e[1]->size);
+    bin = h2->bin;
+    vh = Data_Wrap_Struct(cgsl_histogram2d, 0, gsl_histogram2d_free, h2);
+  } else {
+    mygsl_histogram3d *h3 = mygsl_histogram3d_calloc(n[0], n[1], n[2]);
+    mygsl_histogram3d_set_ranges(h3, e[0]->data, e[0]->size, e[1]->data, e[1]->size,
+                                 e[2]->data, e[2]->size);
+    bin = h3->bin;
+    vh = Data_Wrap_Struct(rb_path2class("GSL::Histogram3d"), 0, mygsl_histogram3d_free, h3);
+  }
+  for (i = 0; i < h->cap; i++) {
+    if (!h->used[i]) continue;
+    for (off = 0, d = 0; d < (size_t) argc; d++)
+      off = off * n[d] + (size_t) (h->keys[i * h->dim + axes[d]] - h->axis[axes[d]].imin);
+    bin[off] += h->vals[i];
+  }
+  RB_GC_GUARD(holder);
+  return vh;
+}
+
+void Init_gsl_histogram_sparse(VALUE module)
+{
+  cgsl_histogram_sparse = rb_define_class_under(cgsl_histogram, "Sparse", cGSL_Object);
+  rb_define_singleton_method(cgsl_histogram_sparse, "new", rb_gsl_histogram_sparse_new, -1);
+  rb_define_singleton_method(cgsl_histogram_sparse, "alloc", rb_gsl_histogram_sparse_new, -1);
+
+  rb_define_method(cgsl_histogram_sparse, "dim", rb_gsl_histogram_sparse_dim, 0);
+  rb_define_method(cgsl_histogram_sparse, "shape", rb_gsl_histogram_sparse_shape, 0);
+  rb_define_method(cgsl_histogram_sparse, "nnz", rb_gsl_histogram_sparse_nnz, 0);
+  rb_define_method(cgsl_histogram_sparse, "extend?", rb_gsl_histogram_sparse_extend_p, 0);
+  rb_define_method(cgsl_histogram_sparse, "range", rb_gsl_histogram_sparse_range, 1);
+
+  rb_define_method(cgsl_histogram_sparse, "get", rb_gsl_histogram_sparse_get, -1);
+  rb_define_alias(cgsl_histogram_sparse, "[]", "get");
+  rb_define_method(cgsl_histogram_sparse, "increment", rb_gsl_histogram_sparse_increment, -1);
+  rb_define_alias(cgsl_histogram_sparse, "fill", "increment");
+  rb_define_alias(cgsl_histogram_sparse, "accumulate", "increment");
+  rb_define_method(cgsl_histogram_sparse, "each", rb_gsl_histogram_sparse_each, 0);
+  rb_define_method(cgsl_histogram_sparse, "sum", rb_gsl_histogram_sparse_sum, 0);
+  rb_define_alias(cgsl_histogram_sparse, "integral", "sum");
+  rb_define_method(cgsl_histogram_sparse, "reset", rb_gsl_histogram_sparse_reset, 0);
+  rb_define_method(cgsl_histogram_sparse, "clone", rb_gsl_histogram_sparse_clone, 0);
+  rb_define_alias(cgsl_histogram_sparse, "duplicate", "clone");
+
+  rb_define_method(cgsl_histogram_sparse, "merge!", rb_gsl_histogram_sparse_merge_bang, 1);
+  rb_define_method(cgsl_histogram_sparse, "merge", rb_gsl_histogram_sparse_merge, 1);
+  rb_define_alias(cgsl_histogram_sparse, "+", "merge");
+  rb_define_method(cgsl_histogram_sparse, "marginalize", rb_gsl_histogram_sparse_marginalize, -1);
+  rb_define_method(cgsl_histogram_sparse, "project", rb_gsl_histogram_sparse_project, -1);
+}
@@ -33,6 +33,8 @@
 #include "rb_gsl_const.h"
 
 void Init_gsl_error(VALUE module);
+void Init_gsl_workspace_pool(VALUE module);
+void Init_gsl_parallel(VALUE module);
 void Init_gsl_math(VALUE module);
 void Init_gsl_complex(VALUE module);
 void Init_gsl_array(VALUE module);
@@ -44,6 +46,10 @@ void Init_gsl_poly2(VALUE module);
 void Init_gsl_rational(VALUE module);
 void Init_gsl_sf(VALUE module);
 void Init_gsl_linalg(VALUE module);
+void Init_gsl_rsvd(VALUE module);
+#ifdef GSL_2_6_LATER
+void Init_gsl_spmatrix(VALUE module);
+#endif
 void Init_gsl_eigen(VALUE module);
 void Init_gsl_fft(VALUE module);
 void Init_gsl_signal(VALUE module);
@@ -55,10 +61,13 @@ void Init_gsl_qrng(VALUE module);
 void Init_gsl_ran(VALUE module);
 void Init_gsl_cdf(VALUE module);
 void Init_gsl_stats(VALUE module);
+void Init_gsl_sketch(VALUE module);
+void Init_gsl_kde(VALUE module);
 
 void Init_gsl_histogram(VALUE module);
 void Init_gsl_histogram2d(VALUE module);
 void Init_gsl_histogram3d(VALUE module);
+void Init_gsl_histogram_io(VALUE module);
 void Init_gsl_ntuple(VALUE module);
 void Init_gsl_monte(VALUE module);
 void Init_gsl_siman(VALUE module);
@@ -310,6 +310,7 @@ FILE* rb_gsl_open_writefile(VALUE io, int *flag);
 FILE* rb_gsl_open_readfile(VALUE io, int *flag);
 
 VALUE rb_gsl_obj_read_only(int argc, VALUE *argv, VALUE obj);
+VALUE rb_gsl_hash_get(VALUE hash, const char *key);
 
 int str_tail_grep(const char *s0, const char *s1);
 int str_head_grep(const char *s0, const char *s1);
@@ -13,5 +13,33 @@
 #define ___RB_GSL_EIGEN_H___
 
 #include <gsl/gsl_eigen.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+
+/*
+  A linear operator given by its action y = A x, for matrix-free solvers.
+  apply returns GSL_SUCCESS, or an error code that stops the solver, which
+  then returns it.
+*/
+typedef struct {
+  size_t n;
+  int (*apply)(const gsl_vector *x, gsl_vector *y, void *params);
+  void *params;
+} rb_gsl_linop;
+
+enum {
+  RB_GSL_EIGEN_LARGEST,
+  RB_GSL_EIGEN_SMALLEST,
+  RB_GSL_EIGEN_LARGEST_MAGNITUDE,
+  RB_GSL_EIGEN_SMALLEST_MAGNITUDE,
+};
+
+int rb_gsl_eigen_lanczos(const rb_gsl_linop *A, size_t k, int which, double tol,
+                         size_t ncv, size_t maxiter, const gsl_vector *v0,
+                         gsl_vector *eval, gsl_matrix *evec, size_t *nconv);
+int rb_gsl_eigen_arnoldi(const rb_gsl_linop *A, size_t k, int which, double tol,
+                         size_t ncv, size_t maxiter, const gsl_vector *v0,
+                         gsl_vector_complex *eval, gsl_matrix_complex *evec,
+                         size_t *nconv);
 
 #endif
@@ -46,4 +46,6 @@ EXTERN VALUE cgsl_fft_complex_wavetable, cgsl_fft_complex_workspace;
 EXTERN VALUE cgsl_fft_real_wavetable, cgsl_fft_halfcomplex_wavetable;
 EXTERN VALUE cgsl_fft_real_workspace;
 
+int mygsl_fft_real_radix2_convolve(double *data, const double *kfft, size_t n);
+
 #endif
@@ -60,4 +60,12 @@ mygsl_histogram_mul (gsl_histogram * h1, const gsl_histogram * h2);
 int
 mygsl_histogram_div (gsl_histogram * h1, const gsl_histogram * h2);
 
+/* Bulk fill, histogram_fill.c */
+void mygsl_histogram_fill(gsl_histogram *h, const double *x, size_t xstride, size_t n,
+                          const double *w, size_t wstride, double weight, size_t nthreads);
+void mygsl_histogram2d_fill(gsl_histogram2d *h, const double *x, size_t xstride,
+                            const double *y, size_t ystride, size_t n,
+                            const double *w, size_t wstride, double weight, size_t nthreads);
+int mygsl_histogram_check_nan(const double *x, size_t stride, size_t n);
+
 #endif
@@ -0,0 +1,57 @@
+/*
+  rb_gsl_parallel.h
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY
+*/
+
+#ifndef ___RB_GSL_PARALLEL_H___
+#define ___RB_GSL_PARALLEL_H___
+
+#include <stddef.h>
+#include <ruby.h>
+
+/* Upper bound on the number of threads of a parallel loop */
+#define RB_GSL_PARALLEL_MAX_THREADS 256
+
+/* Body of a parallel loop, called once for each tid in [0, nthreads) */
+typedef void (*rb_gsl_parallel_func)(size_t tid, size_t nthreads, void *data);
+
+/*
+  Runs f on nthreads native threads with the GVL released, and returns
+  when all of them have finished. f must not touch Ruby objects. A GSL
+  error raised in f is kept and raised as a Ruby exception afterwards.
+  If Ruby interrupts the call, rb_gsl_parallel_interrupted() turns true
+  in the workers, and the interrupt is raised once they have returned.
+*/
+void rb_gsl_parallel_run(size_t nthreads, rb_gsl_parallel_func f, void *data);
+
+/* True in a worker once the running loop has been interrupted; long loops poll it */
+int rb_gsl_parallel_interrupted(void);
+
+/*
+  Number of threads to use: the :threads entry of the option hash opts
+  (which may be nil), or else GSL.threads, at most
+  RB_GSL_PARALLEL_MAX_THREADS.
+*/
+size_t rb_gsl_parallel_threads(VALUE opts);
+
+/*
+  A positive size from the option hash opts: the entry key, or def if
+  it is absent. Raises ArgumentError for a value below 1.
+*/
+size_t rb_gsl_parallel_size_opt(VALUE opts, const char *key, size_t def);
+
+/* The k-th of nparts contiguous ranges [i0, i1) that split [0, n) evenly */
+void rb_gsl_parallel_range(size_t n, size_t nparts, size_t k, size_t *i0, size_t *i1);
+
+/* A Ruby object that frees p with f when it is collected, for a holder array */
+VALUE rb_gsl_parallel_hold(void *p, void (*f)(void*));
+
+/* Called by the GSL error handlers; returns 1 if the error was kept for a parallel loop */
+int rb_gsl_parallel_trap_error(const char *reason, const char *file, int line, int gsl_errno);
+
+#endif
@@ -0,0 +1,27 @@
+/*
+  rb_gsl_randist.h
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY
+*/
+
+#ifndef ___RB_GSL_RANDIST_H___
+#define ___RB_GSL_RANDIST_H___
+
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include "rb_gsl.h"
+
+/* One draw from a discrete sampler: GSL::Ran::Discrete, Discrete::Compact or Discrete::Dynamic */
+typedef size_t (*rb_gsl_ran_sampler_func)(const gsl_rng *r, const void *sampler);
+
+/*
+  Looks up the sampling function of obj. Returns 0 if obj is not a
+  discrete sampler, and raises if it cannot be sampled (all weights zero).
+*/
+int rb_gsl_ran_get_sampler(VALUE obj, rb_gsl_ran_sampler_func *f, const void **sampler);
+
+#endif
@@ -13,8 +13,42 @@
 #define ___RB_GSL_RNG_H___
 
 #include <gsl/gsl_rng.h>
+#include <gsl/gsl_qrng.h>
+#include <stdint.h>
 #include "rb_gsl.h"
 
 EXTERN VALUE cgsl_rng;
 
+/* Counter-based generators, rng_counter.c */
+extern const gsl_rng_type *rb_gsl_rng_philox4x32;
+extern const gsl_rng_type *rb_gsl_rng_threefry4x32;
+
+int rb_gsl_rng_counter_p(const gsl_rng *r);
+void rb_gsl_rng_counter_jump(gsl_rng *r, unsigned long long k);
+int rb_gsl_rng_counter_split(const gsl_rng *r, size_t n, size_t i, gsl_rng *child);
+unsigned long long rb_gsl_rng_counter_stream(const gsl_rng *r);
+void rb_gsl_rng_counter_uniform(gsl_rng *r, double *x, size_t stride, size_t n);
+void rb_gsl_rng_counter_streams(VALUE opts, size_t n, gsl_rng **r, VALUE *vr, VALUE holder);
+
+/* Binary state of Rng#dump, rng.c */
+void rb_gsl_rng_dump_to(VALUE str, const gsl_rng *r);
+gsl_rng* rb_gsl_rng_load_from(const char **p, const char *end);
+void rb_gsl_rng_dump_put_u32(VALUE str, size_t n);
+size_t rb_gsl_rng_dump_get_u32(const char **p, const char *end);
+
+/* Quasi-random sequences, qrng.c */
+enum {
+  RB_GSL_QRNG_SCRAMBLE_NONE,
+  RB_GSL_QRNG_SCRAMBLE_OWEN,      /* nested uniform scramble of the base 2 digits */
+  RB_GSL_QRNG_SCRAMBLE_SHIFT,     /* random digital shift in base 2 */
+  RB_GSL_QRNG_SCRAMBLE_ROTATION,  /* random shift modulo 1 (Cranley-Patterson) */
+};
+
+const gsl_qrng_type* rb_gsl_qrng_get_type(VALUE t);
+int rb_gsl_qrng_skip_ahead(gsl_qrng *q, unsigned long k);
+int rb_gsl_qrng_fast_skip(const gsl_qrng *q);
+int rb_gsl_qrng_scramble_type(VALUE name, const gsl_qrng *q);
+void rb_gsl_qrng_scramble_seed(gsl_rng *r, size_t d, uint32_t *seed);
+void rb_gsl_qrng_scramble_point(int type, const uint32_t *seed, size_t d, double *x);
+
 #endif
@@ -0,0 +1,41 @@
+/*
+  rb_gsl_workspace_pool.h
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY
+*/
+
+#ifndef ___RB_GSL_WORKSPACE_POOL_H___
+#define ___RB_GSL_WORKSPACE_POOL_H___
+
+#include <stddef.h>
+
+/* How to allocate, free and measure one kind of GSL workspace */
+typedef struct {
+  const char *name;
+  void* (*alloc)(size_t n);
+  void (*free)(void *w);
+  size_t (*size)(const void *w);
+} rb_gsl_workspace_type;
+
+extern const rb_gsl_workspace_type rb_gsl_workspace_eigen_symm;
+extern const rb_gsl_workspace_type rb_gsl_workspace_eigen_symmv;
+extern const rb_gsl_workspace_type rb_gsl_workspace_eigen_herm;
+extern const rb_gsl_workspace_type rb_gsl_workspace_eigen_hermv;
+extern const rb_gsl_workspace_type rb_gsl_workspace_eigen_nonsymm;
+extern const rb_gsl_workspace_type rb_gsl_workspace_eigen_nonsymmv;
+extern const rb_gsl_workspace_type rb_gsl_workspace_integration;
+extern const rb_gsl_workspace_type rb_gsl_workspace_vector;
+
+/*
+  Takes a workspace of size n from the pool of the calling thread, or
+  allocates a new one. Give it back with rb_gsl_workspace_put() instead of
+  freeing it.
+*/
+void* rb_gsl_workspace_get(const rb_gsl_workspace_type *T, size_t n);
+void rb_gsl_workspace_put(const rb_gsl_workspace_type *T, void *w);
+
+#endif
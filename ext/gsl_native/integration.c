@@ -13,6 +13,7 @@
 #include "include/rb_gsl_function.h"
 #include "include/rb_gsl_integration.h"
 #include "include/rb_gsl_common.h"
+#include "include/rb_gsl_workspace_pool.h"
 
 #ifndef CHECK_WORKSPACE
 #define CHECK_WORKSPACE(x) if(CLASS_OF(x)!=cgsl_integration_workspace) \
@@ -127,7 +128,7 @@ static int get_limit_key_workspace(int argc, VALUE *argv, int argstart,
     CHECK_FIXNUM(argv[argstart]);
     *key = FIX2INT(argv[argstart]);
     *limit = LIMIT_DEFAULT;
-    *w = gsl_integration_workspace_alloc(*limit);
+    *w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, *limit);
     flag = 1;
     break;
   case 2:
@@ -135,7 +136,7 @@ static int get_limit_key_workspace(int argc, VALUE *argv, int argstart,
       CHECK_FIXNUM(argv[argc-2]);
       *limit = FIX2INT(argv[argc-2]);
       *key = FIX2INT(argv[argc-1]);
-      *w = gsl_integration_workspace_alloc(*limit);
+      *w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, *limit);
       flag = 1;
     } else {
       CHECK_FIXNUM(argv[argc-2]);
@@ -149,7 +150,7 @@ static int get_limit_key_workspace(int argc, VALUE *argv, int argstart,
   case 0:
     *key = KEY_DEFAULT;
     *limit = LIMIT_DEFAULT;
-    *w = gsl_integration_workspace_alloc(*limit);
+    *w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, *limit);
     flag = 1;
     break;
   default:
@@ -176,7 +177,7 @@ static int get_limit_workspace(int argc, VALUE *argv, int argstart,
     break;
   case 0:
     *limit = LIMIT_DEFAULT;
-    *w = gsl_integration_workspace_alloc(*limit);
+    *w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, *limit);
     flag = 1;
     break;
   case 1:
@@ -185,7 +186,7 @@ static int get_limit_workspace(int argc, VALUE *argv, int argstart,
     case T_BIGNUM:
       CHECK_FIXNUM(argv[argstart]);
       *limit = FIX2INT(argv[argstart]);
-      *w = gsl_integration_workspace_alloc(*limit);
+      *w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, *limit);
       flag = 1;
       break;
     default:
@@ -216,13 +217,13 @@ static int get_epsabs_epsrel_limit_workspace(int argc, VALUE *argv, int argstart
   *limit = LIMIT_DEFAULT;
   switch (argc-itmp) {
   case 0:
-    *w = gsl_integration_workspace_alloc(*limit);
+    *w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, *limit);
     flag = 1;
     break;
   case 1:
     if (TYPE(argv[itmp]) == T_ARRAY) {
       get_epsabs_epsrel(argc, argv, itmp, epsabs, epsrel);
-      *w = gsl_integration_workspace_alloc(*limit);
+      *w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, *limit);
       flag = 1;
     } else {
       flag = get_limit_workspace(argc, argv, itmp, limit, w);
@@ -237,7 +238,7 @@ static int get_epsabs_epsrel_limit_workspace(int argc, VALUE *argv, int argstart
       break;
     case T_FLOAT:
       get_epsabs_epsrel(argc, argv, itmp, epsabs, epsrel);
-      *w = gsl_integration_workspace_alloc(*limit);
+      *w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, *limit);
       flag = 1;
       break;
     default:
@@ -305,13 +306,13 @@ static VALUE rb_gsl_integration_qag(int argc, VALUE *argv, VALUE obj)
       CHECK_FIXNUM(argv[2]);
       get_a_b(argc, argv, 1, &a, &b);
       key = FIX2INT(argv[2]);
-      w = gsl_integration_workspace_alloc(limit);
+      w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, limit);
       flag = 1;
     } else if (argc == 4) {
       CHECK_FIXNUM(argv[3]);
       get_a_b(argc, argv, 1, &a, &b);
       key = FIX2INT(argv[3]);
-      w = gsl_integration_workspace_alloc(limit);
+      w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, limit);
       flag = 1;
     } else {
       itmp = get_a_b_epsabs_epsrel(argc, argv, 1, &a, &b, &epsabs, &epsrel);
@@ -322,7 +323,7 @@ static VALUE rb_gsl_integration_qag(int argc, VALUE *argv, VALUE obj)
     if (argc == 2) {
       if (FIXNUM_P(argv[1])) {
         key = FIX2INT(argv[1]);
-        w = gsl_integration_workspace_alloc(limit);
+        w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, limit);
         flag = 1;
       } else if (rb_obj_is_kind_of(argv[1], cgsl_integration_workspace)) {
         Data_Get_Struct(argv[1], gsl_integration_workspace, w);
@@ -334,7 +335,7 @@ static VALUE rb_gsl_integration_qag(int argc, VALUE *argv, VALUE obj)
     } else if (argc == 3) {
       if (FIXNUM_P(argv[2])) {
         key = FIX2INT(argv[2]);
-        w = gsl_integration_workspace_alloc(limit);
+        w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, limit);
         flag = 1;
       } else if (rb_obj_is_kind_of(argv[2], cgsl_integration_workspace)) {
         Data_Get_Struct(argv[2], gsl_integration_workspace, w);
@@ -353,7 +354,7 @@ static VALUE rb_gsl_integration_qag(int argc, VALUE *argv, VALUE obj)
   status = gsl_integration_qag(F, a, b, epsabs, epsrel, limit, key, w,
                                &result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  if (flag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_integration, w);
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr),
                      INT2FIX(intervals), INT2FIX(status));
 }
@@ -383,7 +384,7 @@ static VALUE rb_gsl_integration_qags(int argc, VALUE *argv, VALUE obj)
   status = gsl_integration_qags(F, a, b, epsabs, epsrel, limit, w,
                                 &result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  if (flag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_integration, w);
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr),
                      INT2FIX(intervals), INT2FIX(status));
 }
@@ -422,7 +423,7 @@ static VALUE rb_gsl_integration_qagp(int argc, VALUE *argv, VALUE obj)
   status = gsl_integration_qagp(F, v->data, v->size, epsabs, epsrel, limit, w,
                                 &result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  if (flag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_integration, w);
   if (flag2 == 1) gsl_vector_free(v);
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr),
                      INT2FIX(intervals), INT2FIX(status));
@@ -453,7 +454,7 @@ static VALUE rb_gsl_integration_qagi(int argc, VALUE *argv, VALUE obj)
   status = gsl_integration_qagi(F, epsabs, epsrel, limit, w,
                                 &result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  if (flag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_integration, w);
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr),
                      INT2FIX(intervals), INT2FIX(status));
 }
@@ -486,7 +487,7 @@ static VALUE rb_gsl_integration_qagiu(int argc, VALUE *argv, VALUE obj)
   status = gsl_integration_qagiu(F, a, epsabs, epsrel, limit, w,
                                  &result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  if (flag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_integration, w);
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr),
                      INT2FIX(intervals), INT2FIX(status));
 }
@@ -520,7 +521,7 @@ static VALUE rb_gsl_integration_qagil(int argc, VALUE *argv, VALUE obj)
   status = gsl_integration_qagil(F, b, epsabs, epsrel, limit, w,
                                  &result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  if (flag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_integration, w);
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr),
                      INT2FIX(intervals), INT2FIX(status));
 }
@@ -552,7 +553,7 @@ static VALUE rb_gsl_integration_qawc(int argc, VALUE *argv, VALUE obj)
                                            &limit, &w);
   status = gsl_integration_qawc(F, a, b, c, epsabs, epsrel, limit, w, &result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  if (flag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_integration, w);
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr), INT2FIX(intervals),
                      INT2FIX(status));
 }
@@ -677,7 +678,7 @@ static VALUE rb_gsl_integration_qaws(int argc, VALUE *argv, VALUE obj)
                                            &limit, &w);
   status = gsl_integration_qaws(F, a, b, t, epsabs, epsrel, limit, w, &result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  if (flag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_integration, w);
   if (flagt == 1) gsl_integration_qaws_table_free(t);
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr), INT2FIX(intervals),
                      INT2FIX(status));
@@ -808,7 +809,7 @@ static VALUE rb_gsl_integration_qawo(int argc, VALUE *argv, VALUE obj)
                                            &limit, &w);
   status = gsl_integration_qawo(F, a, epsabs, epsrel, limit, w, t, &result, &abserr);
   intervals = w->size;
-  if (flag == 1) gsl_integration_workspace_free(w);
+  if (flag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_integration, w);
   if (flagt == 1) gsl_integration_qawo_table_free(t);
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr), INT2FIX(intervals),
                      INT2FIX(status));
@@ -866,15 +867,15 @@ static VALUE rb_gsl_integration_qawf(int argc, VALUE *argv, VALUE obj)
 
   switch (argc - 1 - itmp) {
   case 0:
-    w = gsl_integration_workspace_alloc(limit);
-    cw = gsl_integration_workspace_alloc(limit);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, limit);
+    cw = rb_gsl_workspace_get(&rb_gsl_workspace_integration, limit);
     flag = 1;
     break;
   case 1:
     CHECK_FIXNUM(vtmp[0]);
     limit = FIX2INT(vtmp[0]);
-    w = gsl_integration_workspace_alloc(limit);
-    cw = gsl_integration_workspace_alloc(limit);
+    w = rb_gsl_workspace_get(&rb_gsl_workspace_integration, limit);
+    cw = rb_gsl_workspace_get(&rb_gsl_workspace_integration, limit);
     flag = 1;
     break;
   case 2:
@@ -899,8 +900,8 @@ static VALUE rb_gsl_integration_qawf(int argc, VALUE *argv, VALUE obj)
   status = gsl_integration_qawf(F, a, epsabs, limit, w, cw, t, &result, &abserr);
   intervals = w->size;
   if (flag == 1) {
-    gsl_integration_workspace_free(w);
-    gsl_integration_workspace_free(cw);
+    rb_gsl_workspace_put(&rb_gsl_workspace_integration, w);
+    rb_gsl_workspace_put(&rb_gsl_workspace_integration, cw);
   }
   if (flagt == 1) gsl_integration_qawo_table_free(t);
   return rb_ary_new3(4, rb_float_new(result), rb_float_new(abserr),
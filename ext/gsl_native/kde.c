@@ -0,0 +1,843 @@
+/*
+  kde.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Kernel density estimates of one- and two-dimensional data: GSL::KDE.
+
+  The bandwidth h is the standard deviation of the kernel, so that the
+  Gaussian and the Epanechnikov kernels smooth about as much for the
+  same h. In two dimensions the kernel is the product of the kernels
+  along x and y, with bandwidths hx and hy.
+
+  KDE#grid bins the data linearly onto the grid nodes and convolves the
+  bin weights with the kernel sampled at the grid spacing, one row and
+  one column at a time, by radix-2 FFTs of the zero-padded lines: the
+  cost is O(n + m log m) for n points and m nodes. KDE#evaluate sums the
+  kernel exactly over the points within its support. It finds them in
+  the data sorted by columns as wide as the support (and by y within a
+  column), an index built on the first call. This only pays when the
+  support is narrow compared with the data: the Gaussian is cut at 8
+  bandwidths, and with Scott's bandwidth that window still holds about a
+  quarter of 10^7 normal points, so each query costs O(n) and m queries
+  O(nm). With approx: true, KDE#evaluate interpolates linearly in a grid
+  estimate of KDE_APPROX_NODES nodes per bandwidth instead, built once on
+  the first such call, for O(1) per query. The linear binning and the
+  interpolation each err by O((delta/h)^2) relative to the curvature of
+  the estimate, which with delta = h/16 comes to 1e-4 to 1e-3 of the
+  peak density; the grid is coarsened if it would exceed
+  KDE_APPROX_MAX_1D or KDE_APPROX_MAX_2D nodes per axis.
+*/
+
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_fft.h"
+#include "include/rb_gsl_parallel.h"
+#include <gsl/gsl_statistics.h>
+
+enum {
+  KDE_GAUSSIAN = 1, KDE_EPANECHNIKOV,
+};
+
+/* Half-widths of the kernels in bandwidths; the Gaussian is cut at 8 sd */
+#define KDE_GAUSSIAN_RADIUS 8.0
+#define KDE_EPANECHNIKOV_RADIUS 2.23606797749978969641
+
+/* Default grid sizes */
+#define KDE_GRID_1D 512
+#define KDE_GRID_2D 128
+
+/* Cross-validation: grid sizes and range of bandwidths, as factors of Scott's */
+#define KDE_CV_GRID_1D 1024
+#define KDE_CV_GRID_2D 256
+#define KDE_CV_MIN 0.1
+#define KDE_CV_MAX 2.0
+#define KDE_CV_SCAN 25
+#define KDE_CV_ITER 20
+
+/* Grid of the approximate evaluation: nodes per bandwidth, and at most per axis */
+#define KDE_APPROX_NODES 16.0
+#define KDE_APPROX_MAX_1D 1048576
+#define KDE_APPROX_MAX_2D 2048
+
+typedef struct {
+  double x, y, cell;
+} kde_point;
+
+#define KDE_POINT_STRIDE (sizeof(kde_point)/sizeof(double))
+
+typedef struct {
+  size_t m[2];         /* nodes along x and y; m[1] = 1 in 1-D */
+  double lo[2], delta[2];
+} kde_grid;
+
+typedef struct {
+  size_t dim, n;
+  int kernel;
+  double h[2];
+  double *x;           /* 1-D data, sorted once indexed */
+  kde_point *p;        /* 2-D data, sorted by cell and y once indexed */
+  double x0;           /* left edge of cell 0 */
+  int indexed;
+  double *f;           /* grid estimate for approx: true, on g */
+  kde_grid g;
+  int gridded;
+} mygsl_kde;
+
+/* Workspace of the convolutions, for grids of at most m[0] x m[1] nodes */
+typedef struct {
+  size_t dim, m[2], p[2], nthreads;
+  int axis;
+  double *f;
+  double *kfft[2];
+  double **buf;        /* one line per thread */
+} kde_conv;
+
+typedef struct {
+  const mygsl_kde *kde;
+  const double *qx, *qy;
+  double *out;
+  size_t m, nthreads;
+  int approx;
+} kde_eval_job;
+
+static VALUE cgsl_kde;
+
+static void mygsl_kde_free(mygsl_kde *kde)
+{
+  free(kde->x);
+  free(kde->p);
+  free(kde->f);
+  free(kde);
+}
+
+static void* kde_alloc(VALUE holder, size_t n, size_t size)
+{
+  void *p = ruby_xmalloc2(n, size);
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, free, p));
+  return p;
+}
+
+static void kde_run(size_t nthreads, rb_gsl_parallel_func f, void *data)
+{
+  if (nthreads <= 1) f(0, 1, data);
+  else rb_gsl_parallel_run(nthreads, f, data);
+}
+
+static int kde_get_kernel(VALUE v)
+{
+  const char *name;
+  if (NIL_P(v)) return KDE_GAUSSIAN;
+  name = SYMBOL_P(v) ? rb_id2name(SYM2ID(v)) : StringValuePtr(v);
+  if (strcmp(name, "gaussian") == 0) return KDE_GAUSSIAN;
+  if (strcmp(name, "epanechnikov") == 0) return KDE_EPANECHNIKOV;
+  rb_raise(rb_eArgError, "unknown kernel %s (gaussian or epanechnikov)", name);
+  return 0;
+}
+
+static double kde_radius(int kernel)
+{
+  return kernel == KDE_GAUSSIAN ? KDE_GAUSSIAN_RADIUS : KDE_EPANECHNIKOV_RADIUS;
+}
+
+/* Kernel of standard deviation h at u */
+static double kde_kernel(int kernel, double u, double h)
+{
+  double t;
+  if (kernel == KDE_GAUSSIAN) {
+    t = u/h;
+    if (fabs(t) >= KDE_GAUSSIAN_RADIUS) return 0.0;
+    return exp(-0.5*t*t)/(M_SQRT2*M_SQRTPI*h);
+  }
+  t = u/(KDE_EPANECHNIKOV_RADIUS*h);
+  if (fabs(t) >= 1.0) return 0.0;
+  return 0.75*(1.0 - t*t)/(KDE_EPANECHNIKOV_RADIUS*h);
+}
+
+/* Values along axis a, with their stride */
+static double* kde_axis(const mygsl_kde *kde, size_t a, size_t *stride)
+{
+  if (kde->dim == 1) {
+    *stride = 1;
+    return kde->x;
+  }
+  *stride = KDE_POINT_STRIDE;
+  return a == 0 ? &kde->p[0].x : &kde->p[0].y;
+}
+
+/*
+  Length of an Array, Vector, Matrix or NArray of data, and a copy of
+  its values to dst with the given stride
+*/
+static size_t kde_data_size(VALUE v)
+{
+  size_t stride, n;
+  if (TYPE(v) == T_ARRAY) return RARRAY_LEN(v);
+  if (VECTOR_COMPLEX_P(v))
+    rb_raise(rb_eTypeError, "wrong argument type %s", rb_class2name(CLASS_OF(v)));
+  get_vector_ptr(v, &stride, &n);
+  return n;
+}
+
+static void kde_copy_data(VALUE v, double *dst, size_t dstride, size_t n, int finite)
+{
+  double *ptr;
+  size_t i, stride, len;
+  if (TYPE(v) == T_ARRAY) {
+    for (i = 0; i < n; i++) dst[i*dstride] = NUM2DBL(rb_ary_entry(v, i));
+  } else {
+    ptr = get_vector_ptr(v, &stride, &len);
+    if (len < n) rb_raise(rb_eIndexError, "data changed size");
+    for (i = 0; i < n; i++) dst[i*dstride] = ptr[i*stride];
+  }
+  if (!finite) return;
+  for (i = 0; i < n; i++)
+    if (!gsl_finite(dst[i*dstride])) rb_raise(rb_eArgError, "data must be finite");
+}
+
+static int kde_double_cmp(const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static int kde_point_cmp(const void *a, const void *b)
+{
+  const kde_point *p = (const kde_point *) a, *q = (const kde_point *) b;
+  if (p->cell != q->cell) return p->cell < q->cell ? -1 : 1;
+  return p->y < q->y ? -1 : (p->y > q->y ? 1 : 0);
+}
+
+/***** Bandwidth rules *****/
+
+/*
+  Spread of the data along axis a: the standard deviation, or with
+  robust set the smaller of it and IQR/1.349
+*/
+static double kde_spread(const mygsl_kde *kde, size_t a, int robust, VALUE holder)
+{
+  double *data, *tmp, sd, iqr;
+  size_t stride, i;
+  data = kde_axis(kde, a, &stride);
+  sd = gsl_stats_sd(data, stride, kde->n);
+  if (robust) {
+    tmp = kde_alloc(holder, kde->n, sizeof(double));
+    for (i = 0; i < kde->n; i++) tmp[i] = data[i*stride];
+    qsort(tmp, kde->n, sizeof(double), kde_double_cmp);
+    iqr = gsl_stats_quantile_from_sorted_data(tmp, 1, kde->n, 0.75)
+      - gsl_stats_quantile_from_sorted_data(tmp, 1, kde->n, 0.25);
+    if (iqr > 0.0 && iqr/1.349 < sd) sd = iqr/1.349;
+  }
+  if (!(sd > 0.0))
+    rb_raise(rb_eArgError, "data have no spread along %s; give the bandwidth", a == 0 ? "x" : "y");
+  return sd;
+}
+
+/*
+  Normal reference rules: Scott's (4/(d+2))^(1/(d+4)) sd n^(-1/(d+4)),
+  and Silverman's, 0.9 min(sd, IQR/1.349) n^(-1/5) in 1-D and Scott's
+  with the robust spread in 2-D
+*/
+static void kde_rule(mygsl_kde *kde, int silverman, VALUE holder)
+{
+  double d = (double) kde->dim, c;
+  size_t a;
+  if (kde->n < 2) rb_raise(rb_eArgError, "two points at least are needed to choose the bandwidth");
+  if (silverman && kde->dim == 1) c = 0.9;
+  else c = pow(4.0/(d + 2.0), 1.0/(d + 4.0));
+  for (a = 0; a < kde->dim; a++)
+    kde->h[a] = c*kde_spread(kde, a, silverman, holder)*pow((double) kde->n, -1.0/(d + 4.0));
+}
+
+/***** Grid estimates *****/
+
+static void kde_grid_set(kde_grid *g, size_t a, size_t m, double lo, double hi)
+{
+  if (m < 2) rb_raise(rb_eArgError, "grid needs 2 nodes at least along each axis");
+  if (!(gsl_finite(lo) && gsl_finite(hi) && lo < hi))
+    rb_raise(rb_eArgError, "bad grid range [%g, %g]", lo, hi);
+  g->m[a] = m;
+  g->lo[a] = lo;
+  g->delta[a] = (hi - lo)/(double) (m - 1);
+}
+
+static int kde_bin_index(double t, size_t m, size_t *i, double *w)
+{
+  if (!(t >= 0.0 && t <= (double) (m - 1))) return 0;
+  *i = (size_t) t;
+  if (*i >= m - 1) *i = m - 2;
+  *w = t - (double) *i;
+  return 1;
+}
+
+/* Linear binning of the data onto g; points off the grid are dropped */
+static void kde_bin(const mygsl_kde *kde, const kde_grid *g, double *c)
+{
+  size_t k, i, j, m1 = g->m[1];
+  double wx, wy;
+  memset(c, 0, g->m[0]*m1*sizeof(double));
+  if (kde->dim == 1) {
+    for (k = 0; k < kde->n; k++) {
+      if (!kde_bin_index((kde->x[k] - g->lo[0])/g->delta[0], g->m[0], &i, &wx)) continue;
+      c[i] += 1.0 - wx;
+      c[i + 1] += wx;
+    }
+    return;
+  }
+  for (k = 0; k < kde->n; k++) {
+    if (!kde_bin_index((kde->p[k].x - g->lo[0])/g->delta[0], g->m[0], &i, &wx)) continue;
+    if (!kde_bin_index((kde->p[k].y - g->lo[1])/g->delta[1], m1, &j, &wy)) continue;
+    c[i*m1 + j] += (1.0 - wx)*(1.0 - wy);
+    c[i*m1 + j + 1] += (1.0 - wx)*wy;
+    c[(i + 1)*m1 + j] += wx*(1.0 - wy);
+    c[(i + 1)*m1 + j + 1] += wx*wy;
+  }
+}
+
+static size_t kde_pow2(size_t n)
+{
+  size_t p = 2;
+  while (p < n) {
+    if (p > SIZE_MAX/2) rb_raise(rb_eArgError, "grid too large");
+    p *= 2;
+  }
+  return p;
+}
+
+static void kde_conv_alloc(kde_conv *w, size_t dim, const size_t m[2], size_t nthreads, VALUE holder)
+{
+  size_t a, t, pmax[2] = {1, 1}, lines;
+  memset(w, 0, sizeof(kde_conv));
+  w->dim = dim;
+  w->m[0] = m[0];
+  w->m[1] = m[1];
+  /* the kernel reaches m - 1 nodes at most, so that lines of 2m - 1 never wrap */
+  for (a = 0; a < dim; a++) {
+    pmax[a] = kde_pow2(2*m[a] - 1);
+    w->kfft[a] = kde_alloc(holder, pmax[a], sizeof(double));
+  }
+  lines = dim == 1 ? 1 : GSL_MAX(m[0], m[1]);
+  if (nthreads > lines) nthreads = lines;
+  if (nthreads < 1) nthreads = 1;
+  w->nthreads = nthreads;
+  w->buf = (double **) kde_alloc(holder, nthreads, sizeof(double *));
+  for (t = 0; t < nthreads; t++) w->buf[t] = kde_alloc(holder, GSL_MAX(pmax[0], pmax[1]), sizeof(double));
+}
+
+/*
+  Transform of the kernel of bandwidth h sampled at spacing delta, on a
+  line of m nodes zero-padded to the returned length
+*/
+static size_t kde_kernel_fft(int kernel, double h, double delta, size_t m, double *kfft)
+{
+  double lim = kde_radius(kernel)*h/delta;
+  size_t l, p, j;
+  l = lim >= (double) (m - 1) ? m - 1 : (size_t) ceil(lim);
+  p = kde_pow2(m + l);
+  memset(kfft, 0, p*sizeof(double));
+  kfft[0] = kde_kernel(kernel, 0.0, h);
+  for (j = 1; j <= l; j++) kfft[j] = kfft[p - j] = kde_kernel(kernel, j*delta, h);
+  gsl_fft_real_radix2_transform(kfft, 1, p);
+  return p;
+}
+
+static void kde_conv_worker(size_t tid, size_t nthreads, void *data)
+{
+  kde_conv *w = (kde_conv *) data;
+  double *buf = w->buf[tid], *row;
+  size_t m0 = w->m[0], m1 = w->m[1], i, j, k;
+  if (w->axis == 1) {
+    for (i = tid; i < m0 && !rb_gsl_parallel_interrupted(); i += nthreads) {
+      row = w->f + i*m1;
+      for (k = 0; k < m1 && row[k] == 0.0; k++);
+      if (k == m1) continue;
+      memcpy(buf, row, m1*sizeof(double));
+      memset(buf + m1, 0, (w->p[1] - m1)*sizeof(double));
+      mygsl_fft_real_radix2_convolve(buf, w->kfft[1], w->p[1]);
+      memcpy(row, buf, m1*sizeof(double));
+    }
+    return;
+  }
+  for (j = tid; j < m1 && !rb_gsl_parallel_interrupted(); j += nthreads) {
+    for (k = 0; k < m0; k++) buf[k] = w->f[k*m1 + j];
+    memset(buf + m0, 0, (w->p[0] - m0)*sizeof(double));
+    mygsl_fft_real_radix2_convolve(buf, w->kfft[0], w->p[0]);
+    for (k = 0; k < m0; k++) w->f[k*m1 + j] = buf[k];
+  }
+}
+
+/* Estimate with bandwidths h on g, from the bin weights c, to f (which may be c) */
+static void kde_smooth(kde_conv *w, const mygsl_kde *kde, const double h[2],
+                       const kde_grid *g, const double *c, double *f)
+{
+  size_t a, k, mm = g->m[0]*g->m[1];
+  for (a = 0; a < kde->dim; a++)
+    w->p[a] = kde_kernel_fft(kde->kernel, h[a], g->delta[a], g->m[a], w->kfft[a]);
+  if (f != c) memcpy(f, c, mm*sizeof(double));
+  w->f = f;
+  if (kde->dim == 2) {
+    w->axis = 1;
+    kde_run(w->nthreads, kde_conv_worker, w);
+  }
+  w->axis = 0;
+  kde_run(kde->dim == 1 ? 1 : w->nthreads, kde_conv_worker, w);
+  for (k = 0; k < mm; k++) f[k] /= (double) kde->n;
+}
+
+/* Grid covering the data and the support of the kernels of bandwidths h */
+static void kde_grid_default(const mygsl_kde *kde, const double h[2], double reach,
+                             const size_t m[2], kde_grid *g)
+{
+  double *data, min, max, pad;
+  size_t a, stride;
+  g->m[1] = 1;
+  for (a = 0; a < kde->dim; a++) {
+    data = kde_axis(kde, a, &stride);
+    gsl_stats_minmax(&min, &max, data, stride, kde->n);
+    pad = reach*h[a];
+    kde_grid_set(g, a, m[a], min - pad, max + pad);
+  }
+}
+
+/***** Least-squares cross-validation *****/
+
+typedef struct {
+  mygsl_kde *kde;
+  kde_conv w;
+  kde_grid g;
+  double *c, *f, h0[2];
+} kde_cv;
+
+/*
+  CV(h) = int f^2 - (2/n) sum_i f_{-i}(x_i), where the leave-one-out
+  estimate is f_{-i}(x_i) = (n f(x_i) - K_h(0))/(n - 1); the integral
+  and sum_i f(x_i) are taken on the grid, the latter with the bin weights.
+*/
+static double kde_cv_score(kde_cv *cv, double s)
+{
+  mygsl_kde *kde = cv->kde;
+  double h[2] = {1.0, 1.0}, sq = 0.0, cf = 0.0, k0 = 1.0, cell = 1.0;
+  size_t a, k, mm = cv->g.m[0]*cv->g.m[1];
+  for (a = 0; a < kde->dim; a++) {
+    h[a] = s*cv->h0[a];
+    k0 *= kde_kernel(kde->kernel, 0.0, h[a]);
+    cell *= cv->g.delta[a];
+  }
+  kde_smooth(&cv->w, kde, h, &cv->g, cv->c, cv->f);
+  for (k = 0; k < mm; k++) {
+    sq += cv->f[k]*cv->f[k];
+    cf += cv->c[k]*cv->f[k];
+  }
+  return sq*cell - 2.0*(cf - k0)/(double) (kde->n - 1);
+}
+
+/*
+  Bandwidth minimizing CV(s h0) for h0 by Scott's rule: a scan of s on a
+  log scale, then a golden section search around the best value
+*/
+static void kde_cv_bandwidth(mygsl_kde *kde, size_t nthreads, VALUE holder)
+{
+  kde_cv cv;
+  size_t m[2], a, k, best = 0;
+  double lo, hi, s[KDE_CV_SCAN], score[KDE_CV_SCAN], reach;
+  double u, v, x1, x2, f1, f2, smin, fmin;
+  const double r = 0.61803398874989484820;  /* (sqrt(5) - 1)/2 */
+  kde_rule(kde, 0, holder);
+  memset(&cv, 0, sizeof(kde_cv));
+  cv.kde = kde;
+  for (a = 0; a < kde->dim; a++) cv.h0[a] = kde->h[a];
+  m[0] = m[1] = kde->dim == 1 ? KDE_CV_GRID_1D : KDE_CV_GRID_2D;
+  if (kde->dim == 1) m[1] = 1;
+  reach = KDE_CV_MAX*GSL_MIN(kde_radius(kde->kernel), 4.0);
+  kde_grid_default(kde, cv.h0, reach, m, &cv.g);
+  cv.c = kde_alloc(holder, m[0]*m[1], sizeof(double));
+  cv.f = kde_alloc(holder, m[0]*m[1], sizeof(double));
+  kde_conv_alloc(&cv.w, kde->dim, m, nthreads, holder);
+  kde_bin(kde, &cv.g, cv.c);
+  /* the binned estimate needs a few nodes per bandwidth */
+  lo = KDE_CV_MIN;
+  for (a = 0; a < kde->dim; a++) lo = GSL_MAX(lo, 2.0*cv.g.delta[a]/cv.h0[a]);
+  hi = KDE_CV_MAX;
+  if (lo >= hi) return;
+  for (k = 0; k < KDE_CV_SCAN; k++) {
+    s[k] = lo*pow(hi/lo, (double) k/(KDE_CV_SCAN - 1));
+    score[k] = kde_cv_score(&cv, s[k]);
+    if (score[k] < score[best]) best = k;
+  }
+  smin = s[best];
+  fmin = score[best];
+  u = log(s[best == 0 ? 0 : best - 1]);
+  v = log(s[best == KDE_CV_SCAN - 1 ? best : best + 1]);
+  x1 = v - r*(v - u);
+  x2 = u + r*(v - u);
+  f1 = kde_cv_score(&cv, exp(x1));
+  f2 = kde_cv_score(&cv, exp(x2));
+  for (k = 0; k < KDE_CV_ITER; k++) {
+    if (f1 < fmin) { fmin = f1; smin = exp(x1); }
+    if (f2 < fmin) { fmin = f2; smin = exp(x2); }
+    if (f1 < f2) {
+      v = x2;
+      x2 = x1;
+      f2 = f1;
+      x1 = v - r*(v - u);
+      f1 = kde_cv_score(&cv, exp(x1));
+    } else {
+      u = x1;
+      x1 = x2;
+      f1 = f2;
+      x2 = u + r*(v - u);
+      f2 = kde_cv_score(&cv, exp(x2));
+    }
+  }
+  if (f1 < fmin) { fmin = f1; smin = exp(x1); }
+  if (f2 < fmin) { fmin = f2; smin = exp(x2); }
+  for (a = 0; a < kde->dim; a++) kde->h[a] = smin*cv.h0[a];
+}
+
+static void kde_set_bandwidth(mygsl_kde *kde, VALUE v, size_t nthreads, VALUE holder)
+{
+  const char *name;
+  size_t a;
+  if (NIL_P(v) || SYMBOL_P(v) || TYPE(v) == T_STRING) {
+    name = NIL_P(v) ? "scott" : (SYMBOL_P(v) ? rb_id2name(SYM2ID(v)) : StringValuePtr(v));
+    if (strcmp(name, "scott") == 0) kde_rule(kde, 0, holder);
+    else if (strcmp(name, "silverman") == 0) kde_rule(kde, 1, holder);
+    else if (strcmp(name, "cv") == 0) kde_cv_bandwidth(kde, nthreads, holder);
+    else rb_raise(rb_eArgError, "unknown bandwidth rule %s (scott, silverman or cv)", name);
+    return;
+  }
+  if (TYPE(v) == T_ARRAY) {
+    if (RARRAY_LEN(v) != (long) kde->dim)
+      rb_raise(rb_eArgError, "%d bandwidths expected", (int) kde->dim);
+    for (a = 0; a < kde->dim; a++) kde->h[a] = NUM2DBL(rb_ary_entry(v, a));
+  } else {
+    kde->h[0] = kde->h[1] = NUM2DBL(v);
+  }
+  for (a = 0; a < kde->dim; a++)
+    if (!(gsl_finite(kde->h[a]) && kde->h[a] > 0.0))
+      rb_raise(rb_eArgError, "bandwidth must be positive");
+}
+
+/***** Pointwise estimates *****/
+
+static void kde_build_index(mygsl_kde *kde)
+{
+  double max, width;
+  size_t k;
+  if (kde->indexed) return;
+  if (kde->dim == 1) {
+    qsort(kde->x, kde->n, sizeof(double), kde_double_cmp);
+  } else {
+    gsl_stats_minmax(&kde->x0, &max, &kde->p[0].x, KDE_POINT_STRIDE, kde->n);
+    width = kde_radius(kde->kernel)*kde->h[0];
+    for (k = 0; k < kde->n; k++) kde->p[k].cell = floor((kde->p[k].x - kde->x0)/width);
+    qsort(kde->p, kde->n, sizeof(kde_point), kde_point_cmp);
+  }
+  kde->indexed = 1;
+}
+
+/* First data index at or after x (1-D), or after (cell, y) (2-D) */
+static size_t kde_lower_bound1(const double *x, size_t n, double q)
+{
+  size_t lo = 0, hi = n, mid;
+  while (lo < hi) {
+    mid = lo + (hi - lo)/2;
+    if (x[mid] < q) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+static size_t kde_lower_bound2(const kde_point *p, size_t n, double cell, double y)
+{
+  size_t lo = 0, hi = n, mid;
+  while (lo < hi) {
+    mid = lo + (hi - lo)/2;
+    if (p[mid].cell < cell || (p[mid].cell == cell && p[mid].y < y)) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+static double kde_eval1(const mygsl_kde *kde, double q)
+{
+  double h = kde->h[0], r = kde_radius(kde->kernel)*h, sum = 0.0;
+  size_t k;
+  if (gsl_isnan(q)) return GSL_NAN;
+  for (k = kde_lower_bound1(kde->x, kde->n, q - r); k < kde->n && kde->x[k] < q + r; k++)
+    sum += kde_kernel(kde->kernel, q - kde->x[k], h);
+  return sum/(double) kde->n;
+}
+
+static double kde_eval2(const mygsl_kde *kde, double qx, double qy)
+{
+  const kde_point *p = kde->p;
+  double rx = kde_radius(kde->kernel)*kde->h[0], ry = kde_radius(kde->kernel)*kde->h[1];
+  double cell, cc, sum = 0.0;
+  size_t k;
+  int d;
+  if (gsl_isnan(qx) || gsl_isnan(qy)) return GSL_NAN;
+  if (!(gsl_finite(qx) && gsl_finite(qy))) return 0.0;
+  cell = floor((qx - kde->x0)/rx);
+  for (d = -1; d <= 1; d++) {
+    cc = cell + d;
+    for (k = kde_lower_bound2(p, kde->n, cc, qy - ry);
+         k < kde->n && p[k].cell == cc && p[k].y < qy + ry; k++) {
+      if (fabs(p[k].x - qx) >= rx) continue;
+      sum += kde_kernel(kde->kernel, qx - p[k].x, kde->h[0])
+        *kde_kernel(kde->kernel, qy - p[k].y, kde->h[1]);
+    }
+  }
+  return sum/(double) kde->n;
+}
+
+/* Grid estimate of KDE_APPROX_NODES nodes per bandwidth over the support */
+static void kde_build_grid(mygsl_kde *kde, size_t nthreads)
+{
+  VALUE holder;
+  kde_conv w;
+  double *data, min, max, pad, nodes;
+  size_t a, stride, m[2] = {1, 1}, mmax;
+  if (kde->gridded) return;
+  holder = rb_ary_new();
+  mmax = kde->dim == 1 ? KDE_APPROX_MAX_1D : KDE_APPROX_MAX_2D;
+  for (a = 0; a < kde->dim; a++) {
+    data = kde_axis(kde, a, &stride);
+    gsl_stats_minmax(&min, &max, data, stride, kde->n);
+    pad = kde_radius(kde->kernel)*kde->h[a];
+    nodes = ceil((max - min + 2.0*pad)/kde->h[a]*KDE_APPROX_NODES) + 1.0;
+    m[a] = nodes > (double) mmax ? mmax : (size_t) nodes;
+  }
+  kde_grid_default(kde, kde->h, kde_radius(kde->kernel), m, &kde->g);
+  kde_conv_alloc(&w, kde->dim, m, nthreads, holder);
+  if (kde->f == NULL) kde->f = ALLOC_N(double, m[0]*m[1]);
+  kde_bin(kde, &kde->g, kde->f);
+  kde_smooth(&w, kde, kde->h, &kde->g, kde->f, kde->f);
+  kde->gridded = 1;
+  RB_GC_GUARD(holder);
+}
+
+/* Linear interpolation in the grid estimate; 0 off the grid */
+static double kde_eval_approx(const mygsl_kde *kde, double qx, double qy)
+{
+  const kde_grid *g = &kde->g;
+  size_t i, j, m1 = g->m[1];
+  double wx, wy;
+  const double *f = kde->f;
+  if (gsl_isnan(qx) || gsl_isnan(qy)) return GSL_NAN;
+  if (!kde_bin_index((qx - g->lo[0])/g->delta[0], g->m[0], &i, &wx)) return 0.0;
+  if (kde->dim == 1) return (1.0 - wx)*f[i] + wx*f[i + 1];
+  if (!kde_bin_index((qy - g->lo[1])/g->delta[1], m1, &j, &wy)) return 0.0;
+  return (1.0 - wx)*((1.0 - wy)*f[i*m1 + j] + wy*f[i*m1 + j + 1])
+    + wx*((1.0 - wy)*f[(i + 1)*m1 + j] + wy*f[(i + 1)*m1 + j + 1]);
+}
+
+static double kde_eval(const mygsl_kde *kde, int approx, double qx, double qy)
+{
+  if (approx) return kde_eval_approx(kde, qx, qy);
+  return kde->dim == 1 ? kde_eval1(kde, qx) : kde_eval2(kde, qx, qy);
+}
+
+static void kde_eval_worker(size_t tid, size_t nthreads, void *data)
+{
+  kde_eval_job *job = (kde_eval_job *) data;
+  size_t k, k0 = tid*job->m/nthreads, k1 = (tid + 1)*job->m/nthreads;
+  for (k = k0; k < k1; k++)
+    job->out[k] = kde_eval(job->kde, job->approx, job->qx[k], job->qy ? job->qy[k] : 0.0);
+}
+
+/***** Methods *****/
+
+static VALUE rb_gsl_kde_new(int argc, VALUE *argv, VALUE klass)
+{
+  VALUE opts = Qnil, obj, holder = rb_ary_new();
+  mygsl_kde *kde;
+  size_t ny;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc < 1 || argc > 2)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  kde = ALLOC(mygsl_kde);
+  memset(kde, 0, sizeof(mygsl_kde));
+  obj = Data_Wrap_Struct(klass, 0, mygsl_kde_free, kde);
+  kde->dim = (argc == 2 && !NIL_P(argv[1])) ? 2 : 1;
+  kde->kernel = kde_get_kernel(rb_gsl_hash_get(opts, "kernel"));
+  kde->n = kde_data_size(argv[0]);
+  if (kde->n == 0) rb_raise(rb_eArgError, "no data");
+  if (kde->dim == 1) {
+    kde->x = ALLOC_N(double, kde->n);
+    kde_copy_data(argv[0], kde->x, 1, kde->n, 1);
+  } else {
+    ny = kde_data_size(argv[1]);
+    if (ny != kde->n)
+      rb_raise(rb_eArgError, "x and y have different lengths (%d and %d)", (int) kde->n, (int) ny);
+    if (kde->n > SIZE_MAX/sizeof(kde_point)) rb_raise(rb_eNoMemError, "too many points");
+    kde->p = ALLOC_N(kde_point, kde->n);
+    kde_copy_data(argv[0], &kde->p[0].x, KDE_POINT_STRIDE, kde->n, 1);
+    kde_copy_data(argv[1], &kde->p[0].y, KDE_POINT_STRIDE, kde->n, 1);
+  }
+  kde_set_bandwidth(kde, rb_gsl_hash_get(opts, "bandwidth"), rb_gsl_parallel_threads(opts), holder);
+  RB_GC_GUARD(holder);
+  return obj;
+}
+
+static void kde_get_range(VALUE v, double *lo, double *hi)
+{
+  Check_Type(v, T_ARRAY);
+  if (RARRAY_LEN(v) != 2) rb_raise(rb_eArgError, "range must be [min, max]");
+  *lo = NUM2DBL(rb_ary_entry(v, 0));
+  *hi = NUM2DBL(rb_ary_entry(v, 1));
+}
+
+static VALUE rb_gsl_kde_grid(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE opts = Qnil, vm, vrange, holder = rb_ary_new(), vx, vy = Qnil, vf;
+  mygsl_kde *kde;
+  kde_grid g;
+  kde_conv w;
+  gsl_vector *x, *y = NULL, *fv;
+  gsl_matrix *fm;
+  size_t m[2], a, i;
+  double lo, hi, *f;
+  Data_Get_Struct(obj, mygsl_kde, kde);
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  vm = argc == 1 ? argv[0] : Qnil;
+  m[0] = m[1] = kde->dim == 1 ? KDE_GRID_1D : KDE_GRID_2D;
+  if (TYPE(vm) == T_ARRAY) {
+    if (kde->dim != 2 || RARRAY_LEN(vm) != 2) rb_raise(rb_eArgError, "one grid size per axis expected");
+    m[0] = NUM2ULONG(rb_ary_entry(vm, 0));
+    m[1] = NUM2ULONG(rb_ary_entry(vm, 1));
+  } else if (!NIL_P(vm)) {
+    m[0] = m[1] = NUM2ULONG(vm);
+  }
+  if (kde->dim == 1) m[1] = 1;
+  vrange = rb_gsl_hash_get(opts, "range");
+  if (NIL_P(vrange)) {
+    kde_grid_default(kde, kde->h, kde_radius(kde->kernel), m, &g);
+  } else {
+    g.m[1] = 1;
+    Check_Type(vrange, T_ARRAY);
+    for (a = 0; a < kde->dim; a++) {
+      kde_get_range(kde->dim == 1 ? vrange : rb_ary_entry(vrange, a), &lo, &hi);
+      kde_grid_set(&g, a, m[a], lo, hi);
+    }
+  }
+  if (m[0] > SIZE_MAX/4 || m[1] > SIZE_MAX/4 || m[0] > SIZE_MAX/2/m[1]) rb_raise(rb_eArgError, "grid too large");
+  kde_conv_alloc(&w, kde->dim, m, rb_gsl_parallel_threads(opts), holder);
+  x = gsl_vector_alloc(m[0]);
+  vx = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, x);
+  for (i = 0; i < m[0]; i++) gsl_vector_set(x, i, g.lo[0] + i*g.delta[0]);
+  if (kde->dim == 1) {
+    fv = gsl_vector_alloc(m[0]);
+    vf = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, fv);
+    f = fv->data;
+  } else {
+    y = gsl_vector_alloc(m[1]);
+    vy = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, y);
+    for (i = 0; i < m[1]; i++) gsl_vector_set(y, i, g.lo[1] + i*g.delta[1]);
+    fm = gsl_matrix_alloc(m[0], m[1]);
+    vf = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, fm);
+    f = fm->data;
+  }
+  kde_bin(kde, &g, f);
+  kde_smooth(&w, kde, kde->h, &g, f, f);
+  RB_GC_GUARD(holder);
+  if (kde->dim == 1) return rb_ary_new3(2, vx, vf);
+  return rb_ary_new3(3, vx, vy, vf);
+}
+
+static VALUE rb_gsl_kde_evaluate(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE opts = Qnil, holder = rb_ary_new(), vout;
+  mygsl_kde *kde;
+  kde_eval_job job;
+  gsl_vector *out;
+  size_t my, nthreads;
+  double *qx, *qy = NULL;
+  int approx;
+  Data_Get_Struct(obj, mygsl_kde, kde);
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != (int) kde->dim)
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for %d)", argc, (int) kde->dim);
+  nthreads = rb_gsl_parallel_threads(opts);
+  approx = RTEST(rb_gsl_hash_get(opts, "approx"));
+  if (approx) kde_build_grid(kde, nthreads);
+  else kde_build_index(kde);
+  if (rb_obj_is_kind_of(argv[0], rb_cNumeric))
+    return rb_float_new(kde_eval(kde, approx, NUM2DBL(argv[0]), kde->dim == 1 ? 0.0 : NUM2DBL(argv[1])));
+  memset(&job, 0, sizeof(kde_eval_job));
+  job.kde = kde;
+  job.approx = approx;
+  job.m = kde_data_size(argv[0]);
+  qx = kde_alloc(holder, GSL_MAX(job.m, 1), sizeof(double));
+  kde_copy_data(argv[0], qx, 1, job.m, 0);
+  if (kde->dim == 2) {
+    my = kde_data_size(argv[1]);
+    if (my != job.m)
+      rb_raise(rb_eArgError, "x and y have different lengths (%d and %d)", (int) job.m, (int) my);
+    qy = kde_alloc(holder, GSL_MAX(job.m, 1), sizeof(double));
+    kde_copy_data(argv[1], qy, 1, job.m, 0);
+  }
+  job.qx = qx;
+  job.qy = qy;
+  if (job.m == 0) rb_raise(rb_eArgError, "no points to evaluate at");
+  out = gsl_vector_alloc(job.m);
+  vout = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, out);
+  job.out = out->data;
+  if (nthreads > job.m) nthreads = job.m;
+  kde_run(nthreads, kde_eval_worker, &job);
+  RB_GC_GUARD(holder);
+  return vout;
+}
+
+static VALUE rb_gsl_kde_dim(VALUE obj)
+{
+  mygsl_kde *kde;
+  Data_Get_Struct(obj, mygsl_kde, kde);
+  return INT2FIX(kde->dim);
+}
+
+static VALUE rb_gsl_kde_size(VALUE obj)
+{
+  mygsl_kde *kde;
+  Data_Get_Struct(obj, mygsl_kde, kde);
+  return SIZET2NUM(kde->n);
+}
+
+static VALUE rb_gsl_kde_bandwidth(VALUE obj)
+{
+  mygsl_kde *kde;
+  Data_Get_Struct(obj, mygsl_kde, kde);
+  if (kde->dim == 1) return rb_float_new(kde->h[0]);
+  return rb_ary_new3(2, rb_float_new(kde->h[0]), rb_float_new(kde->h[1]));
+}
+
+static VALUE rb_gsl_kde_kernel(VALUE obj)
+{
+  mygsl_kde *kde;
+  Data_Get_Struct(obj, mygsl_kde, kde);
+  return ID2SYM(rb_intern(kde->kernel == KDE_GAUSSIAN ? "gaussian" : "epanechnikov"));
+}
+
+void Init_gsl_kde(VALUE module)
+{
+  cgsl_kde = rb_define_class_under(module, "KDE", cGSL_Object);
+
+  rb_define_singleton_method(cgsl_kde, "new", rb_gsl_kde_new, -1);
+  rb_define_singleton_method(cgsl_kde, "alloc", rb_gsl_kde_new, -1);
+
+  rb_define_method(cgsl_kde, "grid", rb_gsl_kde_grid, -1);
+  rb_define_method(cgsl_kde, "evaluate", rb_gsl_kde_evaluate, -1);
+  rb_define_alias(cgsl_kde, "pdf", "evaluate");
+  rb_define_alias(cgsl_kde, "[]", "evaluate");
+  rb_define_method(cgsl_kde, "dim", rb_gsl_kde_dim, 0);
+  rb_define_method(cgsl_kde, "size", rb_gsl_kde_size, 0);
+  rb_define_method(cgsl_kde, "bandwidth", rb_gsl_kde_bandwidth, 0);
+  rb_define_method(cgsl_kde, "kernel", rb_gsl_kde_kernel, 0);
+}
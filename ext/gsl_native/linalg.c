@@ -13,6 +13,7 @@
 #include "include/rb_gsl_array.h"
 #include "include/rb_gsl_common.h"
 #include "include/rb_gsl_linalg.h"
+#include "include/rb_gsl_workspace_pool.h"
 
 static VALUE cgsl_matrix_LU;
 static VALUE cgsl_matrix_QR;
@@ -2512,9 +2513,9 @@ static VALUE rb_gsl_linalg_SV_decomp(int argc, VALUE *argv, VALUE obj)
   U = make_matrix_clone(A);
   S = gsl_vector_alloc(A->size2);   /* see manual p 123 */
   V = gsl_matrix_alloc(A->size2, A->size2);
-  if (flag == 1) w = gsl_vector_alloc(A->size2);
+  if (flag == 1) w = rb_gsl_workspace_get(&rb_gsl_workspace_vector, A->size2);
   gsl_linalg_SV_decomp(U, V, S, w);
-  if (flag == 1) gsl_vector_free(w);
+  if (flag == 1) rb_gsl_workspace_put(&rb_gsl_workspace_vector, w);
   vu = Data_Wrap_Struct(cgsl_matrix_U, 0, gsl_matrix_free, U);
   vv = Data_Wrap_Struct(cgsl_matrix_V, 0, gsl_matrix_free, V);
   vs = Data_Wrap_Struct(cgsl_vector_S, 0, gsl_vector_free, S);
@@ -2541,9 +2542,9 @@ static VALUE rb_gsl_linalg_SV_decomp_mod(int argc, VALUE *argv, VALUE obj)
   S = gsl_vector_alloc(A->size2);   /* see manual p 123 */
   V = gsl_matrix_alloc(A->size2, A->size2);
   X = gsl_matrix_alloc(A->size2, A->size2);
-  w = gsl_vector_alloc(A->size2);
+  w = rb_gsl_workspace_get(&rb_gsl_workspace_vector, A->size2);
   gsl_linalg_SV_decomp_mod(U, X, V, S, w);
-  gsl_vector_free(w);
+  rb_gsl_workspace_put(&rb_gsl_workspace_vector, w);
   gsl_matrix_free(X);
   vu = Data_Wrap_Struct(cgsl_matrix_U, 0, gsl_matrix_free, U);
   vv = Data_Wrap_Struct(cgsl_matrix_V, 0, gsl_matrix_free, V);
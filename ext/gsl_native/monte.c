@@ -832,6 +832,8 @@ static VALUE rb_gsl_monte_vegas_runval(VALUE obj)
   return ary;
 }
 
+void Init_gsl_monte_parallel(VALUE module);
+
 void Init_gsl_monte(VALUE module)
 {
   VALUE mgsl_monte;
@@ -972,6 +974,8 @@ void Init_gsl_monte(VALUE module)
   rb_define_const(cgsl_monte_vegas, "MODE_IMPORTANCE", INT2FIX(GSL_VEGAS_MODE_IMPORTANCE));
   rb_define_const(cgsl_monte_vegas, "MODE_IMPORTANCE_ONLY", INT2FIX(GSL_VEGAS_MODE_IMPORTANCE_ONLY));
   rb_define_const(cgsl_monte_vegas, "MODE_STRATIFIED", INT2FIX(GSL_VEGAS_MODE_STRATIFIED));
+
+  Init_gsl_monte_parallel(mgsl_monte);
 }
 #ifdef CHECK_MONTE_FUNCTION
 #undef CHECK_MONTE_FUNCTION
@@ -0,0 +1,516 @@
+/*
+  monte_parallel.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Monte Carlo drivers on top of the GSL integrators:
+
+  GSL::Monte.qmc_integrate, randomized quasi-Monte Carlo: independent
+  scrambles of a Sobol, Niederreiter or Halton sequence, with the error
+  estimated from the spread of the replicates.
+
+  GSL::Monte.plain_integrate and GSL::Monte.vegas_integrate, PLAIN and
+  VEGAS with the calls split among independent substreams of a
+  counter-based generator.
+
+  The integrand is a GSL::Monte::Function (a Ruby block, evaluated point
+  by point), a GSL::Monte::Function::Native (a compiled C function,
+  evaluated on native threads) or any object responding to call, which
+  is given a whole GSL::Matrix of points, one per row, and returns their
+  values as a GSL::Vector or an Array. The results do not depend on the
+  number of threads.
+*/
+
+#include "include/rb_gsl.h"
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_rng.h"
+#include "include/rb_gsl_parallel.h"
+#include <gsl/gsl_monte_vegas.h>
+
+static VALUE cgsl_monte_function_class, cgsl_monte_function_native;
+
+enum {
+  MONTE_EVAL_NATIVE,
+  MONTE_EVAL_FUNCTION,
+  MONTE_EVAL_BATCH,
+};
+
+typedef struct {
+  int kind;
+  gsl_monte_function *F;   /* NATIVE and FUNCTION */
+  VALUE proc;              /* BATCH */
+  size_t dim;
+  const double *xl, *xu;
+  double vol;
+} monte_integrand;
+
+/* Running mean and sum of squared deviations */
+typedef struct {
+  double n, mean, m2;
+} monte_stats;
+
+static void monte_stats_add(monte_stats *s, const double *fx, size_t n)
+{
+  size_t i;
+  double d;
+  for (i = 0; i < n; i++) {
+    s->n += 1.0;
+    d = fx[i] - s->mean;
+    s->mean += d / s->n;
+    s->m2 += d * (fx[i] - s->mean);
+  }
+}
+
+static void monte_stats_merge(monte_stats *s, const monte_stats *t)
+{
+  double n, d;
+  if (t->n == 0.0) return;
+  n = s->n + t->n;
+  d = t->mean - s->mean;
+  s->mean += d * t->n / n;
+  s->m2 += t->m2 + d * d * s->n * t->n / n;
+  s->n = n;
+}
+
+static void monte_get_integrand(VALUE f, VALUE vxl, VALUE vxu, monte_integrand *g)
+{
+  gsl_vector *xl, *xu;
+  size_t i;
+  memset(g, 0, sizeof(monte_integrand));
+  CHECK_VECTOR(vxl);
+  CHECK_VECTOR(vxu);
+  Data_Get_Struct(vxl, gsl_vector, xl);
+  Data_Get_Struct(vxu, gsl_vector, xu);
+  if (xl->size != xu->size) rb_raise(rb_eArgError, "xl and xu have different sizes");
+  if (xl->stride != 1 || xu->stride != 1) rb_raise(rb_eArgError, "xl and xu must be contiguous");
+  if (rb_obj_is_kind_of(f, cgsl_monte_function_native)) {
+    g->kind = MONTE_EVAL_NATIVE;
+    Data_Get_Struct(f, gsl_monte_function, g->F);
+    if (g->F->dim != xl->size)
+      rb_raise(rb_eArgError, "integrand of dim %d for %d limits", (int) g->F->dim, (int) xl->size);
+  } else if (rb_obj_is_kind_of(f, cgsl_monte_function_class)) {
+    g->kind = MONTE_EVAL_FUNCTION;
+    Data_Get_Struct(f, gsl_monte_function, g->F);
+  } else if (rb_respond_to(f, RBGSL_ID_call)) {
+    g->kind = MONTE_EVAL_BATCH;
+    g->proc = f;
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Monte::Function or a callable expected)",
+             rb_class2name(CLASS_OF(f)));
+  }
+  g->dim = xl->size;
+  g->xl = xl->data;
+  g->xu = xu->data;
+  g->vol = 1.0;
+  for (i = 0; i < g->dim; i++) g->vol *= xu->data[i] - xl->data[i];
+}
+
+/* Maps the n points in x from the unit cube to the integration region, and evaluates them into fx */
+static void monte_eval(const monte_integrand *g, double *x, size_t n, double *fx)
+{
+  gsl_matrix *m;
+  gsl_vector *v;
+  VALUE vm, res;
+  size_t i, j;
+  for (i = 0; i < n; i++)
+    for (j = 0; j < g->dim; j++)
+      x[i * g->dim + j] = g->xl[j] + (g->xu[j] - g->xl[j]) * x[i * g->dim + j];
+  if (g->kind != MONTE_EVAL_BATCH) {
+    for (i = 0; i < n; i++) fx[i] = (*g->F->f)(x + i * g->dim, g->dim, g->F->params);
+    return;
+  }
+  m = gsl_matrix_alloc(n, g->dim);
+  memcpy(m->data, x, n * g->dim * sizeof(double));
+  vm = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+  res = rb_funcall(g->proc, RBGSL_ID_call, 1, vm);
+  if (VECTOR_P(res)) {
+    Data_Get_Vector(res, v);
+    if (v->size != n) rb_raise(rb_eRuntimeError, "integrand returned %d values for %d points", (int) v->size, (int) n);
+    for (i = 0; i < n; i++) fx[i] = gsl_vector_get(v, i);
+  } else {
+    Check_Type(res, T_ARRAY);
+    if ((size_t) RARRAY_LEN(res) != n)
+      rb_raise(rb_eRuntimeError, "integrand returned %d values for %d points", (int) RARRAY_LEN(res), (int) n);
+    for (i = 0; i < n; i++) fx[i] = NUM2DBL(rb_ary_entry(res, i));
+  }
+}
+
+static size_t monte_nthreads(const monte_integrand *g, VALUE opts, size_t nitems)
+{
+  size_t n;
+  if (g->kind != MONTE_EVAL_NATIVE) return 1;
+  n = rb_gsl_parallel_threads(opts);
+  return n < nitems ? n : nitems;
+}
+
+/*****/
+
+typedef struct {
+  const monte_integrand *g;
+  size_t nitems, batch;
+  double **buf, **fx;      /* one per thread */
+  monte_stats *stats;      /* one per item */
+  /* qmc */
+  gsl_qrng **q;            /* one per thread */
+  size_t npoints, nchunks;
+  int scramble;
+  const uint32_t *seed;    /* dim per replicate */
+  int *status;             /* one per thread */
+  /* plain */
+  gsl_rng **r;             /* one per item */
+  size_t ncalls;
+} monte_job;
+
+static void monte_qmc_worker(size_t tid, size_t nthreads, void *data)
+{
+  monte_job *job = (monte_job *) data;
+  const monte_integrand *g = job->g;
+  size_t k, rep, i, i0, i1, n, j;
+  for (k = tid; k < job->nitems; k += nthreads) {
+    rep = k / job->nchunks;
+    rb_gsl_parallel_range(job->npoints, job->nchunks, k % job->nchunks, &i0, &i1);
+    gsl_qrng_init(job->q[tid]);
+    job->status[tid] = rb_gsl_qrng_skip_ahead(job->q[tid], i0);
+    if (job->status[tid] != GSL_SUCCESS) return;
+    for (i = i0; i < i1 && !rb_gsl_parallel_interrupted(); i += n) {
+      n = GSL_MIN(job->batch, i1 - i);
+      for (j = 0; j < n; j++) {
+        job->status[tid] = gsl_qrng_get(job->q[tid], job->buf[tid] + j * g->dim);
+        if (job->status[tid] != GSL_SUCCESS) return;
+        rb_gsl_qrng_scramble_point(job->scramble, job->seed + rep * g->dim, g->dim,
+                                   job->buf[tid] + j * g->dim);
+      }
+      monte_eval(g, job->buf[tid], n, job->fx[tid]);
+      monte_stats_add(&job->stats[k], job->fx[tid], n);
+    }
+  }
+}
+
+static void monte_plain_worker(size_t tid, size_t nthreads, void *data)
+{
+  monte_job *job = (monte_job *) data;
+  const monte_integrand *g = job->g;
+  size_t k, i, i0, i1, n;
+  for (k = tid; k < job->nitems; k += nthreads) {
+    rb_gsl_parallel_range(job->ncalls, job->nitems, k, &i0, &i1);
+    for (i = i0; i < i1 && !rb_gsl_parallel_interrupted(); i += n) {
+      n = GSL_MIN(job->batch, i1 - i);
+      rb_gsl_rng_counter_uniform(job->r[k], job->buf[tid], 1, n * g->dim);
+      monte_eval(g, job->buf[tid], n, job->fx[tid]);
+      monte_stats_add(&job->stats[k], job->fx[tid], n);
+    }
+  }
+}
+
+static void monte_job_buffers(monte_job *job, size_t nthreads, VALUE holder)
+{
+  size_t t;
+  job->buf = ALLOC_N(double*, nthreads);
+  rb_ary_push(holder, rb_gsl_parallel_hold(job->buf, (void (*)(void*)) ruby_xfree));
+  job->fx = ALLOC_N(double*, nthreads);
+  rb_ary_push(holder, rb_gsl_parallel_hold(job->fx, (void (*)(void*)) ruby_xfree));
+  for (t = 0; t < nthreads; t++) {
+    job->buf[t] = ALLOC_N(double, job->batch * job->g->dim);
+    rb_ary_push(holder, rb_gsl_parallel_hold(job->buf[t], (void (*)(void*)) ruby_xfree));
+    job->fx[t] = ALLOC_N(double, job->batch);
+    rb_ary_push(holder, rb_gsl_parallel_hold(job->fx[t], (void (*)(void*)) ruby_xfree));
+  }
+  job->stats = ALLOC_N(monte_stats, job->nitems);
+  rb_ary_push(holder, rb_gsl_parallel_hold(job->stats, (void (*)(void*)) ruby_xfree));
+  memset(job->stats, 0, job->nitems * sizeof(monte_stats));
+}
+
+static void monte_run(monte_job *job, size_t nthreads, rb_gsl_parallel_func f)
+{
+  if (job->g->kind == MONTE_EVAL_NATIVE) rb_gsl_parallel_run(nthreads, f, job);
+  else (*f)(0, 1, job);
+}
+
+static void monte_get_args(int argc, VALUE *argv, VALUE *opts, monte_integrand *g, size_t *calls)
+{
+  *opts = Qnil;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) *opts = argv[--argc];
+  if (argc != 4) rb_raise(rb_eArgError, "wrong number of arguments (%d for 4)", argc);
+  monte_get_integrand(argv[0], argv[1], argv[2], g);
+  *calls = NUM2SIZET(argv[3]);
+  if (*calls == 0) rb_raise(rb_eArgError, "number of calls must be positive");
+}
+
+/*
+  Document-method: <i>GSL::Monte.qmc_integrate</i>
+    qmc_integrate(f, xl, xu, calls, qrng:, replicates:, scramble:, rng:, batch:, threads:)
+*/
+static VALUE rb_gsl_monte_qmc_integrate(int argc, VALUE *argv, VALUE module)
+{
+  monte_integrand g;
+  monte_job job;
+  monte_stats rep, all;
+  VALUE opts, holder, val;
+  const gsl_qrng_type *T;
+  gsl_qrng *q0;
+  gsl_rng *r;
+  uint32_t *seed;
+  size_t calls, nrep, nthreads, t, k, c;
+  double result, abserr;
+  monte_get_args(argc, argv, &opts, &g, &calls);
+  holder = rb_ary_new();
+  memset(&job, 0, sizeof(monte_job));
+  job.g = &g;
+  val = rb_gsl_hash_get(opts, "qrng");
+  T = NIL_P(val) ? gsl_qrng_sobol : rb_gsl_qrng_get_type(val);
+  nrep = rb_gsl_parallel_size_opt(opts, "replicates", 8);
+  if (nrep < 2) rb_raise(rb_eArgError, "at least 2 replicates are needed for an error estimate");
+  job.npoints = calls / nrep;
+  if (job.npoints == 0) rb_raise(rb_eArgError, "fewer calls than replicates");
+  job.batch = rb_gsl_parallel_size_opt(opts, "batch", 1024);
+  q0 = gsl_qrng_alloc(T, (unsigned int) g.dim);
+  rb_ary_push(holder, rb_gsl_parallel_hold(q0, (void (*)(void*)) gsl_qrng_free));
+  val = rb_gsl_hash_get(opts, "scramble");
+  if (NIL_P(val))
+    job.scramble = (T == gsl_qrng_halton || T == gsl_qrng_reversehalton)
+      ? RB_GSL_QRNG_SCRAMBLE_ROTATION : RB_GSL_QRNG_SCRAMBLE_OWEN;
+  else
+    job.scramble = rb_gsl_qrng_scramble_type(val, q0);
+  /* chunks of a replicate need skip-ahead; the other sequences are not split */
+  job.nchunks = rb_gsl_qrng_fast_skip(q0) ? 16 : 1;
+  if (job.nchunks > job.npoints) job.nchunks = job.npoints;
+  job.nitems = nrep * job.nchunks;
+  val = rb_gsl_hash_get(opts, "rng");
+  if (NIL_P(val)) {
+    r = gsl_rng_alloc(gsl_rng_default);
+    rb_ary_push(holder, rb_gsl_parallel_hold(r, (void (*)(void*)) gsl_rng_free));
+  } else {
+    CHECK_RNG(val);
+    Data_Get_Struct(val, gsl_rng, r);
+  }
+  seed = ALLOC_N(uint32_t, nrep * g.dim);
+  rb_ary_push(holder, rb_gsl_parallel_hold(seed, (void (*)(void*)) ruby_xfree));
+  for (k = 0; k < nrep; k++) rb_gsl_qrng_scramble_seed(r, g.dim, seed + k * g.dim);
+  job.seed = seed;
+  nthreads = monte_nthreads(&g, opts, job.nitems);
+  job.q = ALLOC_N(gsl_qrng*, nthreads);
+  rb_ary_push(holder, rb_gsl_parallel_hold(job.q, (void (*)(void*)) ruby_xfree));
+  job.status = ALLOCA_N(int, nthreads);
+  for (t = 0; t < nthreads; t++) {
+    job.q[t] = gsl_qrng_clone(q0);
+    rb_ary_push(holder, rb_gsl_parallel_hold(job.q[t], (void (*)(void*)) gsl_qrng_free));
+    job.status[t] = GSL_SUCCESS;
+  }
+  monte_job_buffers(&job, nthreads, holder);
+  monte_run(&job, nthreads, monte_qmc_worker);
+  for (t = 0; t < nthreads; t++)
+    if (job.status[t] != GSL_SUCCESS)
+      rb_raise(rb_eRangeError, "%d points per replicate go beyond the end of the %s sequence",
+               (int) job.npoints, gsl_qrng_name(q0));
+  /* the replicate estimates are the samples */
+  memset(&all, 0, sizeof(monte_stats));
+  for (k = 0; k < nrep; k++) {
+    memset(&rep, 0, sizeof(monte_stats));
+    for (c = 0; c < job.nchunks; c++) monte_stats_merge(&rep, &job.stats[k * job.nchunks + c]);
+    rep.mean *= g.vol;
+    monte_stats_add(&all, &rep.mean, 1);
+  }
+  result = all.mean;
+  abserr = sqrt(all.m2 / (all.n - 1) / all.n);
+  RB_GC_GUARD(holder);
+  return rb_ary_new3(2, rb_float_new(result), rb_float_new(abserr));
+}
+
+/*
+  Document-method: <i>GSL::Monte.plain_integrate</i>
+    plain_integrate(f, xl, xu, calls, streams:, rng:, seed:, batch:, threads:)
+*/
+static VALUE rb_gsl_monte_plain_integrate_parallel(int argc, VALUE *argv, VALUE module)
+{
+  monte_integrand g;
+  monte_job job;
+  monte_stats all;
+  VALUE opts, holder;
+  size_t calls, nthreads, k;
+  double result, abserr;
+  monte_get_args(argc, argv, &opts, &g, &calls);
+  holder = rb_ary_new();
+  memset(&job, 0, sizeof(monte_job));
+  job.g = &g;
+  job.ncalls = calls;
+  job.batch = rb_gsl_parallel_size_opt(opts, "batch", 1024);
+  job.nitems = rb_gsl_parallel_size_opt(opts, "streams", 64);
+  if (job.nitems > calls) job.nitems = calls;
+  job.r = ALLOC_N(gsl_rng*, job.nitems);
+  rb_ary_push(holder, rb_gsl_parallel_hold(job.r, (void (*)(void*)) ruby_xfree));
+  rb_gsl_rng_counter_streams(opts, job.nitems, job.r, NULL, holder);
+  nthreads = monte_nthreads(&g, opts, job.nitems);
+  monte_job_buffers(&job, nthreads, holder);
+  monte_run(&job, nthreads, monte_plain_worker);
+  memset(&all, 0, sizeof(monte_stats));
+  for (k = 0; k < job.nitems; k++) monte_stats_merge(&all, &job.stats[k]);
+  result = g.vol * all.mean;
+  abserr = (all.n > 1) ? g.vol * sqrt(all.m2 / (all.n - 1) / all.n) : 0.0;
+  RB_GC_GUARD(holder);
+  return rb_ary_new3(2, rb_float_new(result), rb_float_new(abserr));
+}
+
+typedef struct {
+  const monte_integrand *g;
+  gsl_monte_function F;
+  gsl_rng **r;
+  gsl_monte_vegas_state **s;
+  size_t nrep, ncalls;
+  double *result, *abserr;
+} monte_vegas_job;
+
+static void monte_vegas_worker(size_t tid, size_t nthreads, void *data)
+{
+  monte_vegas_job *job = (monte_vegas_job *) data;
+  size_t k, i0, i1;
+  for (k = tid; k < job->nrep && !rb_gsl_parallel_interrupted(); k += nthreads) {
+    rb_gsl_parallel_range(job->ncalls, job->nrep, k, &i0, &i1);
+    gsl_monte_vegas_integrate(&job->F, (double *) job->g->xl, (double *) job->g->xu, job->g->dim,
+                              i1 - i0, job->r[k], job->s[k], &job->result[k], &job->abserr[k]);
+  }
+}
+
+/*
+  Document-method: <i>GSL::Monte.vegas_integrate</i>
+    vegas_integrate(f, xl, xu, calls, replicas:, rng:, seed:, threads:)
+*/
+static VALUE rb_gsl_monte_vegas_integrate_parallel(int argc, VALUE *argv, VALUE module)
+{
+  monte_integrand g;
+  monte_vegas_job job;
+  monte_stats plain;
+  VALUE opts, holder;
+  size_t calls, nthreads, k;
+  double w, sumw = 0.0, sumwx = 0.0;
+  int weighted = 1;
+  monte_get_args(argc, argv, &opts, &g, &calls);
+  if (g.kind == MONTE_EVAL_BATCH)
+    rb_raise(rb_eTypeError, "VEGAS needs a GSL::Monte::Function or GSL::Monte::Function::Native");
+  holder = rb_ary_new();
+  memset(&job, 0, sizeof(monte_vegas_job));
+  job.g = &g;
+  job.F = *g.F;
+  job.F.dim = g.dim;
+  job.ncalls = calls;
+  job.nrep = rb_gsl_parallel_size_opt(opts, "replicas", 8);
+  if (job.nrep > calls) job.nrep = calls;
+  job.r = ALLOC_N(gsl_rng*, job.nrep);
+  rb_ary_push(holder, rb_gsl_parallel_hold(job.r, (void (*)(void*)) ruby_xfree));
+  rb_gsl_rng_counter_streams(opts, job.nrep, job.r, NULL, holder);
+  job.s = ALLOC_N(gsl_monte_vegas_state*, job.nrep);
+  rb_ary_push(holder, rb_gsl_parallel_hold(job.s, (void (*)(void*)) ruby_xfree));
+  for (k = 0; k < job.nrep; k++) {
+    job.s[k] = gsl_monte_vegas_alloc(g.dim);
+    rb_ary_push(holder, rb_gsl_parallel_hold(job.s[k], (void (*)(void*)) gsl_monte_vegas_free));
+    gsl_monte_vegas_init(job.s[k]);
+  }
+  job.result = ALLOC_N(double, job.nrep);
+  rb_ary_push(holder, rb_gsl_parallel_hold(job.result, (void (*)(void*)) ruby_xfree));
+  job.abserr = ALLOC_N(double, job.nrep);
+  rb_ary_push(holder, rb_gsl_parallel_hold(job.abserr, (void (*)(void*)) ruby_xfree));
+  nthreads = (g.kind == MONTE_EVAL_NATIVE) ? rb_gsl_parallel_threads(opts) : 1;
+  if (nthreads > job.nrep) nthreads = job.nrep;
+  if (g.kind == MONTE_EVAL_NATIVE) rb_gsl_parallel_run(nthreads, monte_vegas_worker, &job);
+  else monte_vegas_worker(0, 1, &job);
+  /* inverse variance weighting, or the plain mean if some replica has no error estimate */
+  memset(&plain, 0, sizeof(monte_stats));
+  for (k = 0; k < job.nrep; k++) {
+    monte_stats_add(&plain, &job.result[k], 1);
+    if (!(job.abserr[k] > 0.0) || !gsl_finite(job.abserr[k])) {
+      weighted = 0;
+      continue;
+    }
+    w = 1.0 / (job.abserr[k] * job.abserr[k]);
+    sumw += w;
+    sumwx += w * job.result[k];
+  }
+  RB_GC_GUARD(holder);
+  if (weighted)
+    return rb_ary_new3(2, rb_float_new(sumwx / sumw), rb_float_new(1.0 / sqrt(sumw)));
+  return rb_ary_new3(2, rb_float_new(plain.mean),
+                     rb_float_new(plain.n > 1 ? sqrt(plain.m2 / (plain.n - 1) / plain.n) : 0.0));
+}
+
+/*****/
+
+/*
+  Document-method: <i>GSL::Monte::Function::Native.new</i>
+    Native.new(address, dim, params = 0) wraps the C function
+    double f(double *x, size_t dim, void *params) at address, for example
+    a Fiddle::Pointer or Fiddle::Function of a compiled library.
+*/
+static VALUE rb_gsl_monte_function_native_new(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_monte_function *F;
+  VALUE addr, params = INT2FIX(0);
+  switch (argc) {
+  case 3:
+    params = argv[2];
+    /* no break */
+  case 2:
+    addr = argv[0];
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+    break;
+  }
+  if (!FIXNUM_P(addr) && TYPE(addr) != T_BIGNUM) addr = rb_funcall(addr, rb_intern("to_i"), 0);
+  if (!FIXNUM_P(params) && TYPE(params) != T_BIGNUM) params = rb_funcall(params, rb_intern("to_i"), 0);
+  if (NUM2ULL(addr) == 0) rb_raise(rb_eArgError, "null function address");
+  F = ALLOC(gsl_monte_function);
+  F->f = (double (*)(double*, size_t, void*)) (uintptr_t) NUM2ULL(addr);
+  F->dim = NUM2SIZET(argv[1]);
+  F->params = (void *) (uintptr_t) NUM2ULL(params);
+  return Data_Wrap_Struct(klass, 0, free, F);
+}
+
+static VALUE rb_gsl_monte_function_native_eval(VALUE obj, VALUE vx)
+{
+  gsl_monte_function *F;
+  gsl_vector *v;
+  double *x;
+  size_t i;
+  Data_Get_Struct(obj, gsl_monte_function, F);
+  CHECK_VECTOR(vx);
+  Data_Get_Vector(vx, v);
+  if (v->size != F->dim) rb_raise(rb_eArgError, "vector has %d elements for dim %d", (int) v->size, (int) F->dim);
+  x = ALLOCA_N(double, v->size);
+  for (i = 0; i < v->size; i++) x[i] = gsl_vector_get(v, i);
+  return rb_float_new((*F->f)(x, F->dim, F->params));
+}
+
+static VALUE rb_gsl_monte_function_native_dim(VALUE obj)
+{
+  gsl_monte_function *F;
+  Data_Get_Struct(obj, gsl_monte_function, F);
+  return SIZET2NUM(F->dim);
+}
+
+void Init_gsl_monte_parallel(VALUE module)
+{
+  cgsl_monte_function_class = rb_const_get(module, rb_intern("Function"));
+  cgsl_monte_function_native = rb_define_class_under(cgsl_monte_function_class, "Native",
+                                                     cgsl_monte_function_class);
+  rb_define_singleton_method(cgsl_monte_function_native, "new", rb_gsl_monte_function_native_new, -1);
+  rb_define_singleton_method(cgsl_monte_function_native, "alloc", rb_gsl_monte_function_native_new, -1);
+  rb_define_method(cgsl_monte_function_native, "eval", rb_gsl_monte_function_native_eval, 1);
+  rb_define_alias(cgsl_monte_function_native, "call", "eval");
+  rb_define_method(cgsl_monte_function_native, "dim", rb_gsl_monte_function_native_dim, 0);
+  /* the Ruby side of Function does not apply to a C function */
+  rb_undef_method(cgsl_monte_function_native, "proc");
+  rb_undef_method(cgsl_monte_function_native, "params");
+  rb_undef_method(cgsl_monte_function_native, "set");
+  rb_undef_method(cgsl_monte_function_native, "set_proc");
+  rb_undef_method(cgsl_monte_function_native, "set_params");
+
+  rb_define_module_function(module, "qmc_integrate", rb_gsl_monte_qmc_integrate, -1);
+  rb_define_module_function(module, "plain_integrate", rb_gsl_monte_plain_integrate_parallel, -1);
+  rb_define_module_function(module, "vegas_integrate", rb_gsl_monte_vegas_integrate_parallel, -1);
+}
@@ -32,6 +32,8 @@ void Init_ndlinear(VALUE module);
              rb_class2name(CLASS_OF(x)));
 #endif
 
+void Init_gsl_multifit_rls(VALUE module);
+
 static VALUE cgsl_multifit_workspace;
 static VALUE cgsl_multifit_function_fdf;
 
@@ -1909,6 +1911,8 @@ void Init_gsl_multifit(VALUE module)
   rb_define_module_function(mgsl_multifit, "linear_residuals", rb_gsl_multifit_linear_residuals, -1);
   rb_define_module_function(module, "multifit_linear_residuals", rb_gsl_multifit_linear_residuals, -1);
 
+  Init_gsl_multifit_rls(mgsl_multifit);
+
 #ifdef HAVE_NDLINEAR_GSL_MULTIFIT_NDLINEAR_H
   Init_ndlinear(mgsl_multifit);
 #endif
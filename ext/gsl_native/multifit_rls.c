@@ -0,0 +1,386 @@
+/*
+  multifit_rls.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Recursive (streaming) linear least squares.
+
+  The fit is kept in square-root form: an upper triangular R (p x p) and
+  z = Q^T y such that R^T R = X^T W X and R c = z, plus the residual sum of
+  squares. Each observation row is rotated into R by p Givens rotations, so
+  that an update costs O(p^2) and never forms the normal equations.
+  Exponential forgetting scales R, z and the residual by sqrt(lambda) before
+  each row, which weights the row k steps back by lambda^k.
+*/
+
+#include "include/rb_gsl_fit.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_array.h"
+#include <gsl/gsl_blas.h>
+
+static VALUE cgsl_multifit_rls;
+
+typedef struct {
+  size_t p;
+  double lambda;    /* forgetting factor, 0 < lambda <= 1 */
+  gsl_matrix *R;
+  gsl_vector *z;
+  gsl_vector *x;    /* work row */
+  double rss;       /* weighted residual sum of squares */
+  double nobs;      /* effective number of observations */
+  size_t count;     /* number of rows added */
+} mygsl_multifit_rls;
+
+static mygsl_multifit_rls* mygsl_multifit_rls_alloc(size_t p, double lambda)
+{
+  mygsl_multifit_rls *w = NULL;
+  w = ALLOC(mygsl_multifit_rls);
+  w->p = p;
+  w->lambda = lambda;
+  w->R = gsl_matrix_calloc(p, p);
+  w->z = gsl_vector_calloc(p);
+  w->x = gsl_vector_alloc(p);
+  w->rss = 0.0;
+  w->nobs = 0.0;
+  w->count = 0;
+  return w;
+}
+
+static void mygsl_multifit_rls_free(mygsl_multifit_rls *w)
+{
+  gsl_matrix_free(w->R);
+  gsl_vector_free(w->z);
+  gsl_vector_free(w->x);
+  free(w);
+}
+
+static void mygsl_multifit_rls_reset(mygsl_multifit_rls *w)
+{
+  gsl_matrix_set_zero(w->R);
+  gsl_vector_set_zero(w->z);
+  w->rss = 0.0;
+  w->nobs = 0.0;
+  w->count = 0;
+}
+
+/* Adds the observation y = x.c with weight wt */
+static void mygsl_multifit_rls_add(mygsl_multifit_rls *w, const gsl_vector *x,
+                                   double y, double wt)
+{
+  size_t p = w->p, i, j;
+  double sw, a, b, r, c, s, rij, xj, zi;
+  double *R = w->R->data, *xr = w->x->data;
+  size_t tda = w->R->tda;
+  if (wt < 0.0) rb_raise(rb_eArgError, "negative weight");
+  if (w->lambda != 1.0) {
+    sw = sqrt(w->lambda);
+    gsl_matrix_scale(w->R, sw);
+    gsl_vector_scale(w->z, sw);
+    w->rss *= w->lambda;
+    w->nobs *= w->lambda;
+  }
+  w->count++;
+  if (wt == 0.0) return;
+  w->nobs += 1.0;
+  sw = sqrt(wt);
+  for (j = 0; j < p; j++) xr[j] = sw * gsl_vector_get(x, j);
+  y *= sw;
+  for (i = 0; i < p; i++) {
+    b = xr[i];
+    if (b == 0.0) continue;
+    a = R[i * tda + i];
+    r = hypot(a, b);
+    c = a / r;
+    s = b / r;
+    R[i * tda + i] = r;
+    for (j = i + 1; j < p; j++) {
+      rij = R[i * tda + j];
+      xj = xr[j];
+      R[i * tda + j] = c * rij + s * xj;
+      xr[j] = c * xj - s * rij;
+    }
+    zi = w->z->data[i * w->z->stride];
+    w->z->data[i * w->z->stride] = c * zi + s * y;
+    y = c * y - s * zi;
+  }
+  w->rss += y * y;
+}
+
+static int mygsl_multifit_rls_check(const mygsl_multifit_rls *w)
+{
+  size_t i;
+  for (i = 0; i < w->p; i++)
+    if (gsl_matrix_get(w->R, i, i) == 0.0) return GSL_ESING;
+  return GSL_SUCCESS;
+}
+
+static void mygsl_multifit_rls_coefficients(const mygsl_multifit_rls *w, gsl_vector *c)
+{
+  gsl_vector_memcpy(c, w->z);
+  gsl_blas_dtrsv(CblasUpper, CblasNoTrans, CblasNonUnit, w->R, c);
+}
+
+/* cov = rss / (nobs - p) * (R^T R)^{-1}, as gsl_multifit_linear */
+static void mygsl_multifit_rls_covariance(const mygsl_multifit_rls *w, gsl_matrix *cov)
+{
+  size_t p = w->p, i, j;
+  gsl_matrix *Rinv = NULL;
+  double s2;
+  Rinv = gsl_matrix_calloc(p, p);
+  for (i = 0; i < p; i++) gsl_matrix_set(Rinv, i, i, 1.0);
+  gsl_blas_dtrsm(CblasLeft, CblasUpper, CblasNoTrans, CblasNonUnit, 1.0, w->R, Rinv);
+  gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, Rinv, Rinv, 0.0, cov);
+  s2 = w->nobs > p ? w->rss / (w->nobs - p) : 0.0;
+  gsl_matrix_scale(cov, s2);
+  /* exact symmetry */
+  for (i = 0; i < p; i++)
+    for (j = 0; j < i; j++) gsl_matrix_set(cov, i, j, gsl_matrix_get(cov, j, i));
+  gsl_matrix_free(Rinv);
+}
+
+/*****/
+
+static void rb_gsl_multifit_rls_check_solvable(mygsl_multifit_rls *w)
+{
+  if (mygsl_multifit_rls_check(w) != GSL_SUCCESS)
+    rb_raise(rb_eRuntimeError, "R is singular (too few or dependent observations)");
+}
+
+/*
+  GSL::MultiFit::RecursiveLinear.alloc(p, lambda = 1.0)
+  GSL::MultiFit::RecursiveLinear.new(p, forgetting: 1.0)
+*/
+static VALUE rb_gsl_multifit_rls_new(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_multifit_rls *w = NULL;
+  double lambda = 1.0;
+  VALUE val;
+  switch (argc) {
+  case 2:
+    if (TYPE(argv[1]) == T_HASH) {
+      if (!NIL_P(val = rb_gsl_hash_get(argv[1], "forgetting"))) lambda = NUM2DBL(val);
+    } else {
+      lambda = NUM2DBL(argv[1]);
+    }
+    /* no break */
+  case 1:
+    CHECK_FIXNUM(argv[0]);
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  }
+  if (FIX2INT(argv[0]) < 1) rb_raise(rb_eArgError, "number of parameters must be positive");
+  if (lambda <= 0.0 || lambda > 1.0) rb_raise(rb_eArgError, "forgetting factor must be in (0, 1]");
+  w = mygsl_multifit_rls_alloc(FIX2INT(argv[0]), lambda);
+  return Data_Wrap_Struct(klass, 0, mygsl_multifit_rls_free, w);
+}
+
+/*
+  RecursiveLinear#add(x, y, w = 1.0): one row x (Vector or Array) and its value y
+  RecursiveLinear#add(X, y, w = nil): the rows of the matrix X and the vector y,
+  with optional weights w
+*/
+static VALUE rb_gsl_multifit_rls_add(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_multifit_rls *w = NULL;
+  gsl_matrix *X = NULL;
+  gsl_vector *x = NULL, *y = NULL, *wt = NULL;
+  VALUE holder = Qnil;
+  double yi, wi;
+  size_t i;
+  if (argc != 2 && argc != 3) rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  Data_Get_Struct(obj, mygsl_multifit_rls, w);
+  if (MATRIX_P(argv[0])) {
+    Data_Get_Matrix(argv[0], X);
+    Data_Get_Vector(argv[1], y);
+    if (X->size2 != w->p) rb_raise(rb_eRangeError, "matrix has %d columns (%d expected)", (int) X->size2, (int) w->p);
+    if (y->size != X->size1) rb_raise(rb_eRangeError, "sizes of X and y differ");
+    if (argc == 3 && !NIL_P(argv[2])) {
+      Data_Get_Vector(argv[2], wt);
+      if (wt->size != X->size1) rb_raise(rb_eRangeError, "sizes of X and w differ");
+      /* the whole block is checked before the factor changes */
+      for (i = 0; i < wt->size; i++)
+        if (gsl_vector_get(wt, i) < 0.0) rb_raise(rb_eArgError, "negative weight");
+    }
+    for (i = 0; i < X->size1; i++) {
+      gsl_vector_view row = gsl_matrix_row(X, i);
+      mygsl_multifit_rls_add(w, &row.vector, gsl_vector_get(y, i), wt ? gsl_vector_get(wt, i) : 1.0);
+    }
+  } else {
+    yi = NUM2DBL(argv[1]);
+    wi = argc == 3 ? NUM2DBL(argv[2]) : 1.0;
+    if (wi < 0.0) rb_raise(rb_eArgError, "negative weight");
+    if (TYPE(argv[0]) == T_ARRAY) {
+      x = make_cvector_from_rarray(argv[0]);
+      holder = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, x);
+    } else {
+      Data_Get_Vector(argv[0], x);
+    }
+    if (x->size != w->p)
+      rb_raise(rb_eRangeError, "row has %d elements (%d expected)", (int) x->size, (int) w->p);
+    mygsl_multifit_rls_add(w, x, yi, wi);
+  }
+  RB_GC_GUARD(holder);
+  return obj;
+}
+
+static VALUE rb_gsl_multifit_rls_coefficients(VALUE obj)
+{
+  mygsl_multifit_rls *w = NULL;
+  gsl_vector *c = NULL;
+  Data_Get_Struct(obj, mygsl_multifit_rls, w);
+  rb_gsl_multifit_rls_check_solvable(w);
+  c = gsl_vector_alloc(w->p);
+  mygsl_multifit_rls_coefficients(w, c);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, c);
+}
+
+static VALUE rb_gsl_multifit_rls_covariance(VALUE obj)
+{
+  mygsl_multifit_rls *w = NULL;
+  gsl_matrix *cov = NULL;
+  Data_Get_Struct(obj, mygsl_multifit_rls, w);
+  rb_gsl_multifit_rls_check_solvable(w);
+  cov = gsl_matrix_alloc(w->p, w->p);
+  mygsl_multifit_rls_covariance(w, cov);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, cov);
+}
+
+/* RecursiveLinear#fit: [c, cov, chisq, status], as GSL::MultiFit.linear */
+static VALUE rb_gsl_multifit_rls_fit(VALUE obj)
+{
+  mygsl_multifit_rls *w = NULL;
+  gsl_vector *c = NULL;
+  gsl_matrix *cov = NULL;
+  Data_Get_Struct(obj, mygsl_multifit_rls, w);
+  rb_gsl_multifit_rls_check_solvable(w);
+  c = gsl_vector_alloc(w->p);
+  cov = gsl_matrix_alloc(w->p, w->p);
+  mygsl_multifit_rls_coefficients(w, c);
+  mygsl_multifit_rls_covariance(w, cov);
+  return rb_ary_new3(4, Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, c),
+                     Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, cov),
+                     rb_float_new(w->rss), INT2FIX(GSL_SUCCESS));
+}
+
+/* RecursiveLinear#predict(x): x.c for a row, or X c for a matrix */
+static VALUE rb_gsl_multifit_rls_predict(VALUE obj, VALUE vx)
+{
+  mygsl_multifit_rls *w = NULL;
+  gsl_vector *c = NULL, *x = NULL, *y = NULL;
+  gsl_matrix *X = NULL;
+  double r;
+  Data_Get_Struct(obj, mygsl_multifit_rls, w);
+  rb_gsl_multifit_rls_check_solvable(w);
+  c = gsl_vector_alloc(w->p);
+  mygsl_multifit_rls_coefficients(w, c);
+  if (MATRIX_P(vx)) {
+    Data_Get_Matrix(vx, X);
+    if (X->size2 != w->p) {
+      gsl_vector_free(c);
+      rb_raise(rb_eRangeError, "matrix has %d columns (%d expected)", (int) X->size2, (int) w->p);
+    }
+    y = gsl_vector_alloc(X->size1);
+    gsl_blas_dgemv(CblasNoTrans, 1.0, X, c, 0.0, y);
+    gsl_vector_free(c);
+    return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, y);
+  }
+  Data_Get_Vector(vx, x);
+  if (x->size != w->p) {
+    gsl_vector_free(c);
+    rb_raise(rb_eRangeError, "row has %d elements (%d expected)", (int) x->size, (int) w->p);
+  }
+  gsl_blas_ddot(x, c, &r);
+  gsl_vector_free(c);
+  return rb_float_new(r);
+}
+
+static VALUE rb_gsl_multifit_rls_R(VALUE obj)
+{
+  mygsl_multifit_rls *w = NULL;
+  Data_Get_Struct(obj, mygsl_multifit_rls, w);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, make_matrix_clone(w->R));
+}
+
+static VALUE rb_gsl_multifit_rls_chisq(VALUE obj)
+{
+  mygsl_multifit_rls *w = NULL;
+  Data_Get_Struct(obj, mygsl_multifit_rls, w);
+  return rb_float_new(w->rss);
+}
+
+static VALUE rb_gsl_multifit_rls_nobs(VALUE obj)
+{
+  mygsl_multifit_rls *w = NULL;
+  Data_Get_Struct(obj, mygsl_multifit_rls, w);
+  return rb_float_new(w->nobs);
+}
+
+static VALUE rb_gsl_multifit_rls_count(VALUE obj)
+{
+  mygsl_multifit_rls *w = NULL;
+  Data_Get_Struct(obj, mygsl_multifit_rls, w);
+  return INT2FIX(w->count);
+}
+
+static VALUE rb_gsl_multifit_rls_p(VALUE obj)
+{
+  mygsl_multifit_rls *w = NULL;
+  Data_Get_Struct(obj, mygsl_multifit_rls, w);
+  return INT2FIX(w->p);
+}
+
+static VALUE rb_gsl_multifit_rls_forgetting(VALUE obj)
+{
+  mygsl_multifit_rls *w = NULL;
+  Data_Get_Struct(obj, mygsl_multifit_rls, w);
+  return rb_float_new(w->lambda);
+}
+
+static VALUE rb_gsl_multifit_rls_set_forgetting(VALUE obj, VALUE val)
+{
+  mygsl_multifit_rls *w = NULL;
+  double lambda = NUM2DBL(val);
+  Data_Get_Struct(obj, mygsl_multifit_rls, w);
+  if (lambda <= 0.0 || lambda > 1.0) rb_raise(rb_eArgError, "forgetting factor must be in (0, 1]");
+  w->lambda = lambda;
+  return val;
+}
+
+static VALUE rb_gsl_multifit_rls_reset(VALUE obj)
+{
+  mygsl_multifit_rls *w = NULL;
+  Data_Get_Struct(obj, mygsl_multifit_rls, w);
+  mygsl_multifit_rls_reset(w);
+  return obj;
+}
+
+void Init_gsl_multifit_rls(VALUE module)
+{
+  cgsl_multifit_rls = rb_define_class_under(module, "RecursiveLinear", cGSL_Object);
+  rb_define_singleton_method(cgsl_multifit_rls, "alloc", rb_gsl_multifit_rls_new, -1);
+  rb_define_singleton_method(cgsl_multifit_rls, "new", rb_gsl_multifit_rls_new, -1);
+
+  rb_define_method(cgsl_multifit_rls, "add", rb_gsl_multifit_rls_add, -1);
+  rb_define_alias(cgsl_multifit_rls, "update", "add");
+  rb_define_method(cgsl_multifit_rls, "coefficients", rb_gsl_multifit_rls_coefficients, 0);
+  rb_define_alias(cgsl_multifit_rls, "c", "coefficients");
+  rb_define_method(cgsl_multifit_rls, "covariance", rb_gsl_multifit_rls_covariance, 0);
+  rb_define_alias(cgsl_multifit_rls, "cov", "covariance");
+  rb_define_method(cgsl_multifit_rls, "fit", rb_gsl_multifit_rls_fit, 0);
+  rb_define_method(cgsl_multifit_rls, "predict", rb_gsl_multifit_rls_predict, 1);
+  rb_define_method(cgsl_multifit_rls, "R", rb_gsl_multifit_rls_R, 0);
+  rb_define_method(cgsl_multifit_rls, "chisq", rb_gsl_multifit_rls_chisq, 0);
+  rb_define_method(cgsl_multifit_rls, "nobs", rb_gsl_multifit_rls_nobs, 0);
+  rb_define_method(cgsl_multifit_rls, "count", rb_gsl_multifit_rls_count, 0);
+  rb_define_method(cgsl_multifit_rls, "p", rb_gsl_multifit_rls_p, 0);
+  rb_define_method(cgsl_multifit_rls, "forgetting", rb_gsl_multifit_rls_forgetting, 0);
+  rb_define_method(cgsl_multifit_rls, "forgetting=", rb_gsl_multifit_rls_set_forgetting, 1);
+  rb_define_method(cgsl_multifit_rls, "reset", rb_gsl_multifit_rls_reset, 0);
+}
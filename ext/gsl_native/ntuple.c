@@ -425,6 +425,7 @@ static VALUE rb_gsl_ntuple_project2(VALUE obj, VALUE hh, VALUE vvfn, VALUE vsfn)
   return INT2FIX(status);
 }
 
+void Init_gsl_ntuple_columnar(VALUE cgsl_ntuple);
 void Init_gsl_ntuple(VALUE module)
 {
   cgsl_ntuple = rb_define_class_under(module, "Ntuple", cGSL_Object);
@@ -466,4 +467,6 @@ void Init_gsl_ntuple(VALUE module)
 
   rb_define_singleton_method(cgsl_ntuple, "project", rb_gsl_ntuple_project, 4);
   rb_define_method(cgsl_ntuple, "project", rb_gsl_ntuple_project2, 3);
+
+  Init_gsl_ntuple_columnar(cgsl_ntuple);
 }
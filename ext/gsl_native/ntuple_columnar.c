@@ -0,0 +1,1089 @@
+/*
+  ntuple_columnar.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Ntuple::Columnar, a column-oriented ntuple file read through
+  mmap, with native selections and multithreaded projection into
+  histograms.
+
+  File layout, version 1, in the byte order of the writer (flags bit 0
+  is set for big-endian):
+
+    ntc_header                  64 bytes
+    ntc_column[ncols]           48 bytes each
+    padding to data_offset      (multiple of 64)
+    chunk[nchunks]              chunk_bytes each
+    double stats[nchunks][ncols][2]   min and max, at stats_offset
+
+  A chunk holds chunk_rows rows (the last one is padded with zeros),
+  stored column after column: column j of a chunk starts at byte
+  ntc_column.offset of the chunk. The statistics are those of the
+  values actually written, and let a projection skip the chunks that a
+  range selection excludes.
+
+  Selections and values are either column ranges or expressions over
+  the columns, compiled here to a small stack program evaluated row by
+  row over the columns of a chunk converted to double.
+*/
+
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_histogram.h"
+#include "include/rb_gsl_parallel.h"
+#include <stdint.h>
+#include <ctype.h>
+#include <math.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define NTC_MAGIC "GSLNTCOL"
+#define NTC_VERSION 1
+#define NTC_NAME_MAX 32
+#define NTC_STACK 64
+#define NTC_NEST 256
+
+enum {
+  NTC_DOUBLE, NTC_FLOAT, NTC_INT32, NTC_INT64,
+};
+
+static const struct {
+  const char *name;
+  uint32_t size;
+} ntc_types[] = {
+  {"double", 8}, {"float", 4}, {"int32", 4}, {"int64", 8},
+};
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;
+  uint64_t nrows, chunk_rows, nchunks, ncols;
+  uint64_t stats_offset, data_offset;
+} ntc_header;
+
+typedef struct {
+  char name[NTC_NAME_MAX];
+  uint32_t type;
+  uint32_t size;
+  uint64_t offset;      /* of the column in a chunk */
+} ntc_column;
+
+typedef struct {
+  ntc_header hd;
+  ntc_column *cols;
+  size_t chunk_bytes;
+  char *buf;            /* the chunk being filled */
+  size_t nbuf;          /* rows in buf */
+  double *stats;
+  size_t stats_cap;     /* in chunks */
+  FILE *fp;
+} ntc_writer;
+
+typedef struct {
+  ntc_header hd;
+  const ntc_column *cols;
+  const double *stats;
+  size_t chunk_bytes;
+  char *map;
+  size_t size;
+  int mapped;
+} mygsl_ntuple_columnar;
+
+static VALUE cgsl_ntuple_columnar;
+static VALUE cgsl_ntuple_columnar_writer;
+
+static int ntc_big_endian(void)
+{
+  const unsigned int one = 1;
+  return *((const unsigned char *) &one) == 0;
+}
+
+static size_t ntc_align(size_t n, size_t a)
+{
+  return (n + a - 1) / a * a;
+}
+
+/* lays out the columns of a chunk and returns its size */
+static size_t ntc_layout(ntc_column *cols, size_t ncols, size_t chunk_rows)
+{
+  size_t j, off = 0;
+  for (j = 0; j < ncols; j++) {
+    cols[j].offset = off;
+    off += ntc_align(chunk_rows * cols[j].size, 8);
+  }
+  return off;
+}
+
+static double ntc_get(const char *p, uint32_t type, size_t i)
+{
+  switch (type) {
+  case NTC_FLOAT: return ((const float *) p)[i];
+  case NTC_INT32: return ((const int32_t *) p)[i];
+  case NTC_INT64: return (double) ((const int64_t *) p)[i];
+  default: return ((const double *) p)[i];
+  }
+}
+
+static void ntc_put(char *p, uint32_t type, size_t i, double x)
+{
+  switch (type) {
+  case NTC_FLOAT: ((float *) p)[i] = (float) x; break;
+  case NTC_INT32: ((int32_t *) p)[i] = (int32_t) x; break;
+  case NTC_INT64: ((int64_t *) p)[i] = (int64_t) x; break;
+  default: ((double *) p)[i] = x; break;
+  }
+}
+
+/*****/
+
+static void ntc_writer_free(ntc_writer *w)
+{
+  if (w->fp) fclose(w->fp);
+  free(w->cols);
+  free(w->buf);
+  free(w->stats);
+  free(w);
+}
+
+static void ntc_writer_check(ntc_writer *w)
+{
+  if (w->fp == NULL) rb_raise(rb_eIOError, "closed GSL::Ntuple::Columnar::Writer");
+}
+
+static void ntc_write(ntc_writer *w, const void *p, size_t n)
+{
+  if (n > 0 && fwrite(p, 1, n, w->fp) != n) rb_sys_fail("GSL::Ntuple::Columnar write");
+}
+
+static void ntc_writer_flush(ntc_writer *w)
+{
+  size_t j, i, ncols = w->hd.ncols;
+  double mn, mx, x, *s;
+  char *p;
+  if (w->nbuf == 0) return;
+  if (w->hd.nchunks == w->stats_cap) {
+    s = (double *) realloc(w->stats, 2 * w->stats_cap * ncols * 2 * sizeof(double));
+    if (s == NULL) rb_raise(rb_eNoMemError, "failed to allocate the chunk statistics");
+    w->stats = s;
+    w->stats_cap *= 2;
+  }
+  for (j = 0; j < ncols; j++) {
+    p = w->buf + w->cols[j].offset;
+    mn = GSL_POSINF;
+    mx = GSL_NEGINF;
+    for (i = 0; i < w->nbuf; i++) {
+      x = ntc_get(p, w->cols[j].type, i);
+      if (x < mn) mn = x;
+      if (x > mx) mx = x;
+    }
+    memset(p + w->nbuf * w->cols[j].size, 0, (w->hd.chunk_rows - w->nbuf) * w->cols[j].size);
+    w->stats[(w->hd.nchunks * ncols + j) * 2] = mn;
+    w->stats[(w->hd.nchunks * ncols + j) * 2 + 1] = mx;
+  }
+  ntc_write(w, w->buf, w->chunk_bytes);
+  w->hd.nchunks++;
+  w->nbuf = 0;
+}
+
+static void ntc_writer_row(ntc_writer *w, const double *x, size_t stride)
+{
+  size_t j;
+  for (j = 0; j < w->hd.ncols; j++)
+    ntc_put(w->buf + w->cols[j].offset, w->cols[j].type, w->nbuf, x[j * stride]);
+  w->hd.nrows++;
+  if (++w->nbuf == w->hd.chunk_rows) ntc_writer_flush(w);
+}
+
+static void ntc_check_name(const char *name)
+{
+  const char *p;
+  if (strlen(name) >= NTC_NAME_MAX)
+    rb_raise(rb_eArgError, "column name %s too long (at most %d characters)", name, NTC_NAME_MAX - 1);
+  if (!isalpha((unsigned char) name[0]) && name[0] != '_')
+    rb_raise(rb_eArgError, "bad column name \"%s\"", name);
+  for (p = name; *p; p++)
+    if (!isalnum((unsigned char) *p) && *p != '_') rb_raise(rb_eArgError, "bad column name \"%s\"", name);
+}
+
+static const char* ntc_str(VALUE v)
+{
+  return SYMBOL_P(v) ? rb_id2name(SYM2ID(v)) : StringValuePtr(v);
+}
+
+static uint32_t ntc_type(VALUE v)
+{
+  const char *name = ntc_str(v);
+  uint32_t t;
+  for (t = 0; t < sizeof(ntc_types) / sizeof(ntc_types[0]); t++)
+    if (strcmp(name, ntc_types[t].name) == 0) return t;
+  if (strcmp(name, "int") == 0) return NTC_INT32;
+  rb_raise(rb_eArgError, "unknown column type %s (double, float, int32 or int64 expected)", name);
+  return 0;
+}
+
+static VALUE rb_gsl_ntuple_columnar_writer_close(VALUE obj);
+
+/*
+  Document-method: <i>GSL::Ntuple::Columnar.create</i>
+    create(path, columns, chunk: 65536) with columns a Hash of name to
+    type or an Array of names of double columns.
+*/
+static VALUE rb_gsl_ntuple_columnar_create(int argc, VALUE *argv, VALUE klass)
+{
+  ntc_writer *w;
+  VALUE opts = Qnil, vw, names, name, type, chunk;
+  size_t j, ncols;
+  if (argc > 2 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 2)", argc);
+  if (TYPE(argv[1]) == T_HASH) names = rb_funcall(argv[1], rb_intern("keys"), 0);
+  else names = rb_Array(argv[1]);
+  ncols = RARRAY_LEN(names);
+  if (ncols == 0) rb_raise(rb_eArgError, "no columns");
+  w = (ntc_writer *) calloc(1, sizeof(ntc_writer));
+  if (w == NULL) rb_raise(rb_eNoMemError, "failed to allocate a writer");
+  vw = Data_Wrap_Struct(cgsl_ntuple_columnar_writer, 0, ntc_writer_free, w);
+  chunk = rb_gsl_hash_get(opts, "chunk");
+  memcpy(w->hd.magic, NTC_MAGIC, 8);
+  w->hd.version = NTC_VERSION;
+  w->hd.flags = ntc_big_endian();
+  w->hd.ncols = ncols;
+  w->hd.chunk_rows = NIL_P(chunk) ? 65536 : NUM2ULONG(chunk);
+  if (w->hd.chunk_rows < 1) rb_raise(rb_eArgError, "chunk must be positive");
+  w->cols = (ntc_column *) calloc(ncols, sizeof(ntc_column));
+  if (w->cols == NULL) rb_raise(rb_eNoMemError, "failed to allocate the columns");
+  for (j = 0; j < ncols; j++) {
+    name = rb_ary_entry(names, j);
+    type = TYPE(argv[1]) == T_HASH ? rb_hash_aref(argv[1], name) : Qnil;
+    ntc_check_name(ntc_str(name));
+    strcpy(w->cols[j].name, ntc_str(name));
+    w->cols[j].type = NIL_P(type) ? NTC_DOUBLE : ntc_type(type);
+    w->cols[j].size = ntc_types[w->cols[j].type].size;
+  }
+  w->chunk_bytes = ntc_layout(w->cols, ncols, w->hd.chunk_rows);
+  w->hd.data_offset = ntc_align(sizeof(ntc_header) + ncols * sizeof(ntc_column), 64);
+  w->buf = (char *) calloc(w->chunk_bytes, 1);
+  w->stats_cap = 16;
+  w->stats = (double *) malloc(w->stats_cap * ncols * 2 * sizeof(double));
+  if (w->buf == NULL || w->stats == NULL) rb_raise(rb_eNoMemError, "failed to allocate a chunk");
+  w->fp = fopen(StringValuePtr(argv[0]), "wb");
+  if (w->fp == NULL) rb_sys_fail(StringValuePtr(argv[0]));
+  ntc_write(w, &w->hd, sizeof(ntc_header));
+  ntc_write(w, w->cols, ncols * sizeof(ntc_column));
+  if (fseek(w->fp, (long) w->hd.data_offset, SEEK_SET) != 0) rb_sys_fail("GSL::Ntuple::Columnar seek");
+  if (rb_block_given_p()) return rb_ensure(rb_yield, vw, rb_gsl_ntuple_columnar_writer_close, vw);
+  return vw;
+}
+
+/*
+  Document-method: <i>GSL::Ntuple::Columnar::Writer#append</i>
+    append(row) with row an Array or Vector of ncols values, or a Matrix
+    with one row per event.
+*/
+static VALUE rb_gsl_ntuple_columnar_writer_append(VALUE obj, VALUE x)
+{
+  ntc_writer *w;
+  gsl_vector *v;
+  gsl_matrix *m;
+  double *row;
+  size_t i, ncols;
+  Data_Get_Struct(obj, ntc_writer, w);
+  ntc_writer_check(w);
+  ncols = w->hd.ncols;
+  if (MATRIX_P(x)) {
+    Data_Get_Matrix(x, m);
+    if (m->size2 != ncols) rb_raise(rb_eArgError, "%d columns for %d", (int) m->size2, (int) ncols);
+    for (i = 0; i < m->size1; i++) ntc_writer_row(w, m->data + i * m->tda, 1);
+  } else if (VECTOR_P(x)) {
+    Data_Get_Vector(x, v);
+    if (v->size != ncols) rb_raise(rb_eArgError, "%d values for %d columns", (int) v->size, (int) ncols);
+    ntc_writer_row(w, v->data, v->stride);
+  } else {
+    Check_Type(x, T_ARRAY);
+    if (RARRAY_LEN(x) != (long) ncols)
+      rb_raise(rb_eArgError, "%d values for %d columns", (int) RARRAY_LEN(x), (int) ncols);
+    row = ALLOCA_N(double, ncols);
+    for (i = 0; i < ncols; i++) row[i] = NUM2DBL(rb_ary_entry(x, i));
+    ntc_writer_row(w, row, 1);
+  }
+  return obj;
+}
+
+static VALUE rb_gsl_ntuple_columnar_writer_size(VALUE obj)
+{
+  ntc_writer *w;
+  Data_Get_Struct(obj, ntc_writer, w);
+  return ULL2NUM(w->hd.nrows);
+}
+
+static VALUE rb_gsl_ntuple_columnar_writer_close(VALUE obj)
+{
+  ntc_writer *w;
+  FILE *fp;
+  Data_Get_Struct(obj, ntc_writer, w);
+  if (w->fp == NULL) return Qnil;
+  ntc_writer_flush(w);
+  w->hd.stats_offset = w->hd.data_offset + w->hd.nchunks * w->chunk_bytes;
+  ntc_write(w, w->stats, w->hd.nchunks * w->hd.ncols * 2 * sizeof(double));
+  if (fseek(w->fp, 0, SEEK_SET) != 0) rb_sys_fail("GSL::Ntuple::Columnar seek");
+  ntc_write(w, &w->hd, sizeof(ntc_header));
+  fp = w->fp;
+  w->fp = NULL;
+  if (fclose(fp) != 0) rb_sys_fail("GSL::Ntuple::Columnar close");
+  return Qnil;
+}
+
+/*****/
+
+static void mygsl_ntuple_columnar_free(mygsl_ntuple_columnar *nt)
+{
+#ifdef HAVE_SYS_MMAN_H
+  if (nt->mapped) munmap(nt->map, nt->size);
+  else free(nt->map);
+#else
+  free(nt->map);
+#endif
+  free(nt);
+}
+
+static void ntc_map(mygsl_ntuple_columnar *nt, const char *path)
+{
+  FILE *fp;
+  long size;
+#ifdef HAVE_SYS_MMAN_H
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) rb_sys_fail(path);
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    rb_sys_fail(path);
+  }
+  nt->size = (size_t) st.st_size;
+  if (nt->size > 0) {
+    nt->map = (char *) mmap(NULL, nt->size, PROT_READ, MAP_SHARED, fd, 0);
+    if (nt->map != MAP_FAILED) {
+      nt->mapped = 1;
+      close(fd);
+      return;
+    }
+    nt->map = NULL;
+  }
+  close(fd);
+#endif
+  /* no mmap: read the whole file */
+  fp = fopen(path, "rb");
+  if (fp == NULL) rb_sys_fail(path);
+  fseek(fp, 0, SEEK_END);
+  size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  nt->size = size > 0 ? (size_t) size : 0;
+  nt->map = (char *) malloc(nt->size > 0 ? nt->size : 1);
+  if (nt->map == NULL || fread(nt->map, 1, nt->size, fp) != nt->size) {
+    fclose(fp);
+    rb_raise(rb_eIOError, "failed to read %s", path);
+  }
+  fclose(fp);
+}
+
+/* *c = a * b, or -1 if the product does not fit in 64 bits */
+static int ntc_mul(uint64_t a, uint64_t b, uint64_t *c)
+{
+  if (b != 0 && a > UINT64_MAX / b) return -1;
+  *c = a * b;
+  return 0;
+}
+
+static void ntc_validate(mygsl_ntuple_columnar *nt, const char *path)
+{
+  ntc_header *hd = &nt->hd;
+  ntc_column *cols;
+  uint64_t rows, data_bytes, stats_bytes;
+  size_t j, chunk_bytes = 0;
+  if (nt->size < sizeof(ntc_header)) rb_raise(rb_eArgError, "%s: not a columnar ntuple", path);
+  memcpy(hd, nt->map, sizeof(ntc_header));
+  if (memcmp(hd->magic, NTC_MAGIC, 8) != 0) rb_raise(rb_eArgError, "%s: not a columnar ntuple", path);
+  if (hd->version != NTC_VERSION)
+    rb_raise(rb_eArgError, "%s: unsupported version %d", path, (int) hd->version);
+  if ((int) (hd->flags & 1) != ntc_big_endian())
+    rb_raise(rb_eArgError, "%s: written on a host with the other byte order", path);
+  if (hd->ncols == 0 || hd->ncols > nt->size || hd->chunk_rows == 0 || hd->chunk_rows > nt->size
+      || hd->nchunks > nt->size || hd->stats_offset == 0
+      || hd->data_offset < sizeof(ntc_header) + hd->ncols * sizeof(ntc_column)
+      || hd->data_offset > nt->size || hd->data_offset % 8 != 0 || hd->stats_offset % 8 != 0)
+    rb_raise(rb_eArgError, "%s: bad header (not closed?)", path);
+  cols = (ntc_column *) (nt->map + sizeof(ntc_header));
+  for (j = 0; j < hd->ncols; j++) {
+    if (cols[j].type > NTC_INT64 || cols[j].size != ntc_types[cols[j].type].size
+        || cols[j].offset != chunk_bytes || memchr(cols[j].name, 0, NTC_NAME_MAX) == NULL)
+      rb_raise(rb_eArgError, "%s: bad column %d", path, (int) j);
+    chunk_bytes += ntc_align(hd->chunk_rows * cols[j].size, 8);
+  }
+  /* each factor is only bounded by the file size, so the products may wrap */
+  if (ntc_mul(hd->nchunks, hd->chunk_rows, &rows) || ntc_mul(hd->nchunks, chunk_bytes, &data_bytes)
+      || ntc_mul(hd->nchunks, hd->ncols * 2 * sizeof(double), &stats_bytes)
+      || hd->nrows > rows || data_bytes > nt->size || stats_bytes > nt->size
+      || hd->stats_offset != hd->data_offset + data_bytes
+      || hd->stats_offset + stats_bytes > nt->size)
+    rb_raise(rb_eArgError, "%s: truncated file", path);
+  nt->cols = cols;
+  nt->chunk_bytes = chunk_bytes;
+  nt->stats = (const double *) (nt->map + hd->stats_offset);
+}
+
+/*
+  Document-method: <i>GSL::Ntuple::Columnar.open</i>
+    Maps a file made by Columnar.create for reading.
+*/
+static VALUE rb_gsl_ntuple_columnar_open(VALUE klass, VALUE path)
+{
+  mygsl_ntuple_columnar *nt;
+  VALUE obj;
+  nt = (mygsl_ntuple_columnar *) calloc(1, sizeof(mygsl_ntuple_columnar));
+  if (nt == NULL) rb_raise(rb_eNoMemError, "failed to allocate an ntuple");
+  obj = Data_Wrap_Struct(klass, 0, mygsl_ntuple_columnar_free, nt);
+  ntc_map(nt, StringValuePtr(path));
+  ntc_validate(nt, StringValuePtr(path));
+  return obj;
+}
+
+static size_t ntc_column_index(const mygsl_ntuple_columnar *nt, const char *name, size_t len)
+{
+  size_t j;
+  for (j = 0; j < nt->hd.ncols; j++)
+    if (strlen(nt->cols[j].name) == len && strncmp(nt->cols[j].name, name, len) == 0) return j;
+  rb_raise(rb_eArgError, "no column %.*s", (int) len, name);
+  return 0;
+}
+
+static size_t ntc_chunk_rows(const mygsl_ntuple_columnar *nt, size_t k)
+{
+  size_t start = k * nt->hd.chunk_rows;
+  return nt->hd.nrows - start < nt->hd.chunk_rows ? nt->hd.nrows - start : nt->hd.chunk_rows;
+}
+
+static void ntc_load(const mygsl_ntuple_columnar *nt, size_t k, size_t j, double *x)
+{
+  const char *p = nt->map + nt->hd.data_offset + k * nt->chunk_bytes + nt->cols[j].offset;
+  size_t i, n = ntc_chunk_rows(nt, k);
+  if (nt->cols[j].type == NTC_DOUBLE) {
+    memcpy(x, p, n * sizeof(double));
+    return;
+  }
+  for (i = 0; i < n; i++) x[i] = ntc_get(p, nt->cols[j].type, i);
+}
+
+static VALUE rb_gsl_ntuple_columnar_size(VALUE obj)
+{
+  mygsl_ntuple_columnar *nt;
+  Data_Get_Struct(obj, mygsl_ntuple_columnar, nt);
+  return ULL2NUM(nt->hd.nrows);
+}
+
+static VALUE rb_gsl_ntuple_columnar_nchunks(VALUE obj)
+{
+  mygsl_ntuple_columnar *nt;
+  Data_Get_Struct(obj, mygsl_ntuple_columnar, nt);
+  return ULL2NUM(nt->hd.nchunks);
+}
+
+static VALUE rb_gsl_ntuple_columnar_chunk_size(VALUE obj)
+{
+  mygsl_ntuple_columnar *nt;
+  Data_Get_Struct(obj, mygsl_ntuple_columnar, nt);
+  return ULL2NUM(nt->hd.chunk_rows);
+}
+
+static VALUE rb_gsl_ntuple_columnar_columns(VALUE obj)
+{
+  mygsl_ntuple_columnar *nt;
+  VALUE ary;
+  size_t j;
+  Data_Get_Struct(obj, mygsl_ntuple_columnar, nt);
+  ary = rb_ary_new2(nt->hd.ncols);
+  for (j = 0; j < nt->hd.ncols; j++) rb_ary_store(ary, j, rb_str_new2(nt->cols[j].name));
+  return ary;
+}
+
+static VALUE rb_gsl_ntuple_columnar_types(VALUE obj)
+{
+  mygsl_ntuple_columnar *nt;
+  VALUE hash;
+  size_t j;
+  Data_Get_Struct(obj, mygsl_ntuple_columnar, nt);
+  hash = rb_hash_new();
+  for (j = 0; j < nt->hd.ncols; j++)
+    rb_hash_aset(hash, rb_str_new2(nt->cols[j].name), ID2SYM(rb_intern(ntc_types[nt->cols[j].type].name)));
+  return hash;
+}
+
+static VALUE rb_gsl_ntuple_columnar_column(VALUE obj, VALUE name)
+{
+  mygsl_ntuple_columnar *nt;
+  gsl_vector *v;
+  const char *s = ntc_str(name);
+  size_t j, k;
+  Data_Get_Struct(obj, mygsl_ntuple_columnar, nt);
+  j = ntc_column_index(nt, s, strlen(s));
+  if (nt->hd.nrows == 0) rb_raise(rb_eRuntimeError, "empty ntuple");
+  v = gsl_vector_alloc(nt->hd.nrows);
+  for (k = 0; k < nt->hd.nchunks; k++) ntc_load(nt, k, j, v->data + k * nt->hd.chunk_rows);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+/* the [min, max] of a column in each chunk */
+static VALUE rb_gsl_ntuple_columnar_stats(VALUE obj, VALUE name)
+{
+  mygsl_ntuple_columnar *nt;
+  gsl_matrix *m;
+  const char *s = ntc_str(name);
+  size_t j, k;
+  Data_Get_Struct(obj, mygsl_ntuple_columnar, nt);
+  j = ntc_column_index(nt, s, strlen(s));
+  if (nt->hd.nchunks == 0) rb_raise(rb_eRuntimeError, "empty ntuple");
+  m = gsl_matrix_alloc(nt->hd.nchunks, 2);
+  for (k = 0; k < nt->hd.nchunks; k++) {
+    gsl_matrix_set(m, k, 0, nt->stats[(k * nt->hd.ncols + j) * 2]);
+    gsl_matrix_set(m, k, 1, nt->stats[(k * nt->hd.ncols + j) * 2 + 1]);
+  }
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+}
+
+/*****/
+
+/* Expressions */
+
+enum {
+  NTC_OP_CONST, NTC_OP_COL, NTC_OP_NEG, NTC_OP_NOT,
+  NTC_OP_ADD, NTC_OP_SUB, NTC_OP_MUL, NTC_OP_DIV, NTC_OP_POW,
+  NTC_OP_LT, NTC_OP_LE, NTC_OP_GT, NTC_OP_GE, NTC_OP_EQ, NTC_OP_NE,
+  NTC_OP_AND, NTC_OP_OR,
+  NTC_OP_ABS, NTC_OP_SQRT, NTC_OP_EXP, NTC_OP_LOG, NTC_OP_LOG10,
+  NTC_OP_SIN, NTC_OP_COS, NTC_OP_TAN, NTC_OP_ATAN2, NTC_OP_HYPOT,
+  NTC_OP_MIN, NTC_OP_MAX,
+};
+
+static const struct {
+  const char *name;
+  int op, nargs;
+} ntc_funcs[] = {
+  {"abs", NTC_OP_ABS, 1}, {"sqrt", NTC_OP_SQRT, 1}, {"exp", NTC_OP_EXP, 1},
+  {"log", NTC_OP_LOG, 1}, {"log10", NTC_OP_LOG10, 1}, {"sin", NTC_OP_SIN, 1},
+  {"cos", NTC_OP_COS, 1}, {"tan", NTC_OP_TAN, 1}, {"atan2", NTC_OP_ATAN2, 2},
+  {"hypot", NTC_OP_HYPOT, 2}, {"pow", NTC_OP_POW, 2}, {"min", NTC_OP_MIN, 2},
+  {"max", NTC_OP_MAX, 2},
+};
+
+typedef struct {
+  int op;
+  size_t col;
+  double c;
+} ntc_op;
+
+typedef struct {
+  ntc_op *ops;
+  size_t n, cap;
+  int depth, maxdepth;
+} ntc_prog;
+
+typedef struct {
+  const mygsl_ntuple_columnar *nt;
+  const char *src, *p;
+  ntc_prog *prog;
+  unsigned char *used;
+  int nest;            /* recursion depth of the parser, up to NTC_NEST */
+} ntc_parser;
+
+static void ntc_prog_free(ntc_prog *prog)
+{
+  free(prog->ops);
+  free(prog);
+}
+
+static void ntc_emit(ntc_parser *ps, int op, size_t col, double c, int push)
+{
+  ntc_prog *prog = ps->prog;
+  ntc_op *ops;
+  if (prog->n == prog->cap) {
+    ops = (ntc_op *) realloc(prog->ops, 2 * prog->cap * sizeof(ntc_op));
+    if (ops == NULL) rb_raise(rb_eNoMemError, "failed to compile an expression");
+    prog->ops = ops;
+    prog->cap *= 2;
+  }
+  prog->ops[prog->n].op = op;
+  prog->ops[prog->n].col = col;
+  prog->ops[prog->n].c = c;
+  prog->n++;
+  prog->depth += push;
+  if (prog->depth > prog->maxdepth) prog->maxdepth = prog->depth;
+  if (prog->maxdepth > NTC_STACK) rb_raise(rb_eArgError, "expression too deep: %s", ps->src);
+}
+
+static void ntc_error(ntc_parser *ps, const char *what)
+{
+  rb_raise(rb_eArgError, "%s at offset %d of \"%s\"", what, (int) (ps->p - ps->src), ps->src);
+}
+
+static void ntc_skip(ntc_parser *ps)
+{
+  while (isspace((unsigned char) *ps->p)) ps->p++;
+}
+
+static int ntc_accept(ntc_parser *ps, const char *tok)
+{
+  size_t len = strlen(tok);
+  ntc_skip(ps);
+  if (strncmp(ps->p, tok, len) != 0) return 0;
+  /* do not take "<" from "<=", "*" from "**" or "=" alone */
+  if ((len == 1 && (tok[0] == '<' || tok[0] == '>' || tok[0] == '!') && ps->p[1] == '=')
+      || (len == 1 && tok[0] == '*' && ps->p[1] == '*'))
+    return 0;
+  ps->p += len;
+  return 1;
+}
+
+static void ntc_parse_or(ntc_parser *ps);
+
+static void ntc_parse_primary(ntc_parser *ps)
+{
+  const char *start;
+  char *end;
+  double c;
+  size_t len, f;
+  int nargs;
+  ntc_skip(ps);
+  if (ntc_accept(ps, "(")) {
+    ntc_parse_or(ps);
+    if (!ntc_accept(ps, ")")) ntc_error(ps, "missing )");
+    return;
+  }
+  if (isdigit((unsigned char) *ps->p) || *ps->p == '.') {
+    c = strtod(ps->p, &end);
+    if (end == ps->p) ntc_error(ps, "bad number");
+    ps->p = end;
+    ntc_emit(ps, NTC_OP_CONST, 0, c, 1);
+    return;
+  }
+  if (!isalpha((unsigned char) *ps->p) && *ps->p != '_') ntc_error(ps, "syntax error");
+  start = ps->p;
+  while (isalnum((unsigned char) *ps->p) || *ps->p == '_') ps->p++;
+  len = ps->p - start;
+  if (!ntc_accept(ps, "(")) {
+    f = ntc_column_index(ps->nt, start, len);
+    ps->used[f] = 1;
+    ntc_emit(ps, NTC_OP_COL, f, 0, 1);
+    return;
+  }
+  for (f = 0; f < sizeof(ntc_funcs) / sizeof(ntc_funcs[0]); f++)
+    if (strlen(ntc_funcs[f].name) == len && strncmp(ntc_funcs[f].name, start, len) == 0) break;
+  if (f == sizeof(ntc_funcs) / sizeof(ntc_funcs[0])) ntc_error(ps, "unknown function");
+  for (nargs = 0; ; ) {
+    ntc_parse_or(ps);
+    nargs++;
+    if (ntc_accept(ps, ")")) break;
+    if (!ntc_accept(ps, ",")) ntc_error(ps, "missing ) or ,");
+  }
+  if (nargs != ntc_funcs[f].nargs) ntc_error(ps, "wrong number of arguments");
+  ntc_emit(ps, ntc_funcs[f].op, 0, 0, 1 - nargs);
+}
+
+/* every recursion of the parser goes through here */
+static void ntc_parse_unary(ntc_parser *ps)
+{
+  if (++ps->nest > NTC_NEST) ntc_error(ps, "expression nested too deeply");
+  if (ntc_accept(ps, "-")) {
+    ntc_parse_unary(ps);
+    ntc_emit(ps, NTC_OP_NEG, 0, 0, 0);
+  } else if (ntc_accept(ps, "!")) {
+    ntc_parse_unary(ps);
+    ntc_emit(ps, NTC_OP_NOT, 0, 0, 0);
+  } else if (ntc_accept(ps, "+")) {
+    ntc_parse_unary(ps);
+  } else {
+    ntc_parse_primary(ps);
+    if (ntc_accept(ps, "**") || ntc_accept(ps, "^")) {
+      ntc_parse_unary(ps);
+      ntc_emit(ps, NTC_OP_POW, 0, 0, -1);
+    }
+  }
+  ps->nest--;
+}
+
+static void ntc_parse_mul(ntc_parser *ps)
+{
+  ntc_parse_unary(ps);
+  for (;;) {
+    if (ntc_accept(ps, "*")) { ntc_parse_unary(ps); ntc_emit(ps, NTC_OP_MUL, 0, 0, -1); }
+    else if (ntc_accept(ps, "/")) { ntc_parse_unary(ps); ntc_emit(ps, NTC_OP_DIV, 0, 0, -1); }
+    else break;
+  }
+}
+
+static void ntc_parse_add(ntc_parser *ps)
+{
+  ntc_parse_mul(ps);
+  for (;;) {
+    if (ntc_accept(ps, "+")) { ntc_parse_mul(ps); ntc_emit(ps, NTC_OP_ADD, 0, 0, -1); }
+    else if (ntc_accept(ps, "-")) { ntc_parse_mul(ps); ntc_emit(ps, NTC_OP_SUB, 0, 0, -1); }
+    else break;
+  }
+}
+
+static void ntc_parse_cmp(ntc_parser *ps)
+{
+  static const struct { const char *tok; int op; } cmps[] = {
+    {"<=", NTC_OP_LE}, {">=", NTC_OP_GE}, {"==", NTC_OP_EQ}, {"!=", NTC_OP_NE},
+    {"<", NTC_OP_LT}, {">", NTC_OP_GT},
+  };
+  size_t i;
+  ntc_parse_add(ps);
+  for (i = 0; i < sizeof(cmps) / sizeof(cmps[0]); i++) {
+    if (ntc_accept(ps, cmps[i].tok)) {
+      ntc_parse_add(ps);
+      ntc_emit(ps, cmps[i].op, 0, 0, -1);
+      return;
+    }
+  }
+}
+
+static void ntc_parse_and(ntc_parser *ps)
+{
+  ntc_parse_cmp(ps);
+  while (ntc_accept(ps, "&&")) {
+    ntc_parse_cmp(ps);
+    ntc_emit(ps, NTC_OP_AND, 0, 0, -1);
+  }
+}
+
+static void ntc_parse_or(ntc_parser *ps)
+{
+  ntc_parse_and(ps);
+  while (ntc_accept(ps, "||")) {
+    ntc_parse_and(ps);
+    ntc_emit(ps, NTC_OP_OR, 0, 0, -1);
+  }
+}
+
+/* compiles the expression (or column name) v; holder keeps the program */
+static ntc_prog* ntc_compile(const mygsl_ntuple_columnar *nt, VALUE v, unsigned char *used, VALUE holder)
+{
+  ntc_parser ps;
+  ntc_prog *prog;
+  prog = (ntc_prog *) calloc(1, sizeof(ntc_prog));
+  if (prog == NULL) rb_raise(rb_eNoMemError, "failed to compile an expression");
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, ntc_prog_free, prog));
+  prog->cap = 16;
+  prog->ops = (ntc_op *) malloc(prog->cap * sizeof(ntc_op));
+  if (prog->ops == NULL) rb_raise(rb_eNoMemError, "failed to compile an expression");
+  ps.nt = nt;
+  ps.src = ps.p = ntc_str(v);
+  ps.prog = prog;
+  ps.used = used;
+  ps.nest = 0;
+  ntc_parse_or(&ps);
+  ntc_skip(&ps);
+  if (*ps.p != '\0') ntc_error(&ps, "syntax error");
+  return prog;
+}
+
+static double ntc_eval(const ntc_prog *prog, double * const *col, size_t i)
+{
+  double st[NTC_STACK];
+  int sp = -1;
+  size_t k;
+  for (k = 0; k < prog->n; k++) {
+    const ntc_op *o = &prog->ops[k];
+    switch (o->op) {
+    case NTC_OP_CONST: st[++sp] = o->c; break;
+    case NTC_OP_COL: st[++sp] = col[o->col][i]; break;
+    case NTC_OP_NEG: st[sp] = -st[sp]; break;
+    case NTC_OP_NOT: st[sp] = st[sp] == 0; break;
+    case NTC_OP_ADD: sp--; st[sp] += st[sp + 1]; break;
+    case NTC_OP_SUB: sp--; st[sp] -= st[sp + 1]; break;
+    case NTC_OP_MUL: sp--; st[sp] *= st[sp + 1]; break;
+    case NTC_OP_DIV: sp--; st[sp] /= st[sp + 1]; break;
+    case NTC_OP_POW: sp--; st[sp] = pow(st[sp], st[sp + 1]); break;
+    case NTC_OP_LT: sp--; st[sp] = st[sp] < st[sp + 1]; break;
+    case NTC_OP_LE: sp--; st[sp] = st[sp] <= st[sp + 1]; break;
+    case NTC_OP_GT: sp--; st[sp] = st[sp] > st[sp + 1]; break;
+    case NTC_OP_GE: sp--; st[sp] = st[sp] >= st[sp + 1]; break;
+    case NTC_OP_EQ: sp--; st[sp] = st[sp] == st[sp + 1]; break;
+    case NTC_OP_NE: sp--; st[sp] = st[sp] != st[sp + 1]; break;
+    case NTC_OP_AND: sp--; st[sp] = st[sp] != 0 && st[sp + 1] != 0; break;
+    case NTC_OP_OR: sp--; st[sp] = st[sp] != 0 || st[sp + 1] != 0; break;
+    case NTC_OP_ABS: st[sp] = fabs(st[sp]); break;
+    case NTC_OP_SQRT: st[sp] = sqrt(st[sp]); break;
+    case NTC_OP_EXP: st[sp] = exp(st[sp]); break;
+    case NTC_OP_LOG: st[sp] = log(st[sp]); break;
+    case NTC_OP_LOG10: st[sp] = log10(st[sp]); break;
+    case NTC_OP_SIN: st[sp] = sin(st[sp]); break;
+    case NTC_OP_COS: st[sp] = cos(st[sp]); break;
+    case NTC_OP_TAN: st[sp] = tan(st[sp]); break;
+    case NTC_OP_ATAN2: sp--; st[sp] = atan2(st[sp], st[sp + 1]); break;
+    case NTC_OP_HYPOT: sp--; st[sp] = hypot(st[sp], st[sp + 1]); break;
+    case NTC_OP_MIN: sp--; st[sp] = GSL_MIN(st[sp], st[sp + 1]); break;
+    case NTC_OP_MAX: sp--; st[sp] = GSL_MAX(st[sp], st[sp + 1]); break;
+    }
+  }
+  return st[0];
+}
+
+/*****/
+
+/* Projection */
+
+typedef struct {
+  size_t col;
+  double lo, hi;
+  int hi_closed;
+} ntc_range;
+
+typedef struct {
+  const mygsl_ntuple_columnar *nt;
+  int ndim;                   /* 0 to count, 1 or 2 */
+  const ntc_prog *val[2], *sel, *wgt;
+  const ntc_range *ranges;
+  size_t nranges;
+  const unsigned char *used;
+  double **buf;               /* per thread: ncols column buffers, then x, y, w */
+  gsl_histogram **h1;
+  gsl_histogram2d **h2;
+  size_t *count;              /* per thread: selected rows */
+} ntc_job;
+
+static int ntc_chunk_excluded(const ntc_job *job, size_t k)
+{
+  const mygsl_ntuple_columnar *nt = job->nt;
+  const ntc_range *r;
+  double mn, mx;
+  size_t i;
+  for (i = 0; i < job->nranges; i++) {
+    r = &job->ranges[i];
+    mn = nt->stats[(k * nt->hd.ncols + r->col) * 2];
+    mx = nt->stats[(k * nt->hd.ncols + r->col) * 2 + 1];
+    if (mx < r->lo || mn > r->hi || (!r->hi_closed && mn >= r->hi)) return 1;
+  }
+  return 0;
+}
+
+static void ntc_project_worker(size_t tid, size_t nthreads, void *data)
+{
+  ntc_job *job = (ntc_job *) data;
+  const mygsl_ntuple_columnar *nt = job->nt;
+  size_t ncols = nt->hd.ncols;
+  double **col = job->buf + tid * (ncols + 3), *x = col[ncols], *y = col[ncols + 1], *w = col[ncols + 2];
+  double v;
+  size_t k, i, j, n, m;
+  const ntc_range *r;
+  for (k = tid; k < nt->hd.nchunks && !rb_gsl_parallel_interrupted(); k += nthreads) {
+    if (ntc_chunk_excluded(job, k)) continue;
+    n = ntc_chunk_rows(nt, k);
+    for (j = 0; j < ncols; j++) if (job->used[j]) ntc_load(nt, k, j, col[j]);
+    for (m = 0, i = 0; i < n; i++) {
+      for (j = 0; j < job->nranges; j++) {
+        r = &job->ranges[j];
+        v = col[r->col][i];
+        if (!(v >= r->lo && (r->hi_closed ? v <= r->hi : v < r->hi))) break;
+      }
+      if (j < job->nranges) continue;
+      if (job->sel) {
+        v = ntc_eval(job->sel, col, i);
+        if (!(v != 0) || v != v) continue;
+      }
+      if (job->ndim > 0) x[m] = ntc_eval(job->val[0], col, i);
+      if (job->ndim > 1) y[m] = ntc_eval(job->val[1], col, i);
+      if (job->wgt) w[m] = ntc_eval(job->wgt, col, i);
+      m++;
+    }
+    job->count[tid] += m;
+    if (job->ndim == 1)
+      mygsl_histogram_fill(job->h1[tid], x, 1, m, job->wgt ? w : NULL, 1, 1.0, 1);
+    else if (job->ndim == 2)
+      mygsl_histogram2d_fill(job->h2[tid], x, 1, y, 1, m, job->wgt ? w : NULL, 1, 1.0, 1);
+  }
+}
+
+static void* ntc_tmp_alloc(VALUE holder, size_t size)
+{
+  void *p = calloc(size > 0 ? size : 1, 1);
+  if (p == NULL) rb_raise(rb_eNoMemError, "failed to allocate %lu bytes", (unsigned long) size);
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, free, p));
+  return p;
+}
+
+static void ntc_get_ranges(ntc_job *job, VALUE where, unsigned char *used, VALUE holder)
+{
+  VALUE keys, key, v, beg, end;
+  ntc_range *r;
+  const char *s;
+  size_t i;
+  int excl;
+  if (NIL_P(where)) return;
+  Check_Type(where, T_HASH);
+  keys = rb_funcall(where, rb_intern("keys"), 0);
+  job->nranges = RARRAY_LEN(keys);
+  r = (ntc_range *) ntc_tmp_alloc(holder, job->nranges * sizeof(ntc_range));
+  for (i = 0; i < job->nranges; i++) {
+    key = rb_ary_entry(keys, i);
+    v = rb_hash_aref(where, key);
+    s = ntc_str(key);
+    r[i].col = ntc_column_index(job->nt, s, strlen(s));
+    used[r[i].col] = 1;
+    if (rb_obj_is_kind_of(v, rb_cRange)) {
+      rb_range_values(v, &beg, &end, &excl);
+      r[i].hi_closed = !excl;
+    } else {
+      Check_Type(v, T_ARRAY);
+      beg = rb_ary_entry(v, 0);
+      end = rb_ary_entry(v, 1);
+      r[i].hi_closed = 0;
+    }
+    r[i].lo = NIL_P(beg) ? GSL_NEGINF : NUM2DBL(beg);
+    r[i].hi = NIL_P(end) ? GSL_POSINF : NUM2DBL(end);
+    if (NIL_P(end)) r[i].hi_closed = 1;
+  }
+  job->ranges = r;
+}
+
+/*
+  Runs a selection over all the chunks. ndim is 0 to count the selected
+  rows, or the dimension of the histogram hh filled with values.
+*/
+static VALUE ntc_run(VALUE obj, int ndim, VALUE hh, VALUE value, VALUE opts)
+{
+  mygsl_ntuple_columnar *nt;
+  ntc_job job;
+  VALUE holder = rb_ary_new(), sel, wgt;
+  unsigned char *used;
+  size_t nthreads, t, j, i, ncols, count = 0;
+  gsl_histogram *h1 = NULL;
+  gsl_histogram2d *h2 = NULL;
+  Data_Get_Struct(obj, mygsl_ntuple_columnar, nt);
+  ncols = nt->hd.ncols;
+  memset(&job, 0, sizeof(ntc_job));
+  job.nt = nt;
+  job.ndim = ndim;
+  used = (unsigned char *) ntc_tmp_alloc(holder, ncols);
+  job.used = used;
+  if (ndim == 1) {
+    job.val[0] = ntc_compile(nt, value, used, holder);
+  } else if (ndim == 2) {
+    Check_Type(value, T_ARRAY);
+    if (RARRAY_LEN(value) != 2) rb_raise(rb_eArgError, "two values expected for a 2D histogram");
+    job.val[0] = ntc_compile(nt, rb_ary_entry(value, 0), used, holder);
+    job.val[1] = ntc_compile(nt, rb_ary_entry(value, 1), used, holder);
+  }
+  sel = rb_gsl_hash_get(opts, "select");
+  if (!NIL_P(sel)) job.sel = ntc_compile(nt, sel, used, holder);
+  wgt = rb_gsl_hash_get(opts, "weight");
+  if (!NIL_P(wgt)) job.wgt = ntc_compile(nt, wgt, used, holder);
+  ntc_get_ranges(&job, rb_gsl_hash_get(opts, "where"), used, holder);
+
+  nthreads = rb_gsl_parallel_threads(opts);
+  if (nthreads > nt->hd.nchunks) nthreads = nt->hd.nchunks;
+  if (nthreads < 1) nthreads = 1;
+  job.buf = (double **) ntc_tmp_alloc(holder, nthreads * (ncols + 3) * sizeof(double *));
+  for (t = 0; t < nthreads; t++) {
+    for (j = 0; j < ncols + 3; j++) {
+      if (j < ncols && !used[j]) continue;
+      job.buf[t * (ncols + 3) + j] = (double *) ntc_tmp_alloc(holder, nt->hd.chunk_rows * sizeof(double));
+    }
+  }
+  job.count = (size_t *) ntc_tmp_alloc(holder, nthreads * sizeof(size_t));
+  if (ndim == 1) {
+    Data_Get_Struct(hh, gsl_histogram, h1);
+    job.h1 = (gsl_histogram **) ntc_tmp_alloc(holder, nthreads * sizeof(gsl_histogram *));
+    job.h1[0] = h1;
+    for (t = 1; t < nthreads; t++) {
+      job.h1[t] = gsl_histogram_clone(h1);
+      rb_ary_push(holder, Data_Wrap_Struct(cgsl_histogram, 0, gsl_histogram_free, job.h1[t]));
+      gsl_histogram_reset(job.h1[t]);
+    }
+  } else if (ndim == 2) {
+    Data_Get_Struct(hh, gsl_histogram2d, h2);
+    job.h2 = (gsl_histogram2d **) ntc_tmp_alloc(holder, nthreads * sizeof(gsl_histogram2d *));
+    job.h2[0] = h2;
+    for (t = 1; t < nthreads; t++) {
+      job.h2[t] = gsl_histogram2d_clone(h2);
+      rb_ary_push(holder, Data_Wrap_Struct(cgsl_histogram2d, 0, gsl_histogram2d_free, job.h2[t]));
+      gsl_histogram2d_reset(job.h2[t]);
+    }
+  }
+  if (nt->hd.nchunks > 0) {
+    if (nthreads > 1) rb_gsl_parallel_run(nthreads, ntc_project_worker, &job);
+    else ntc_project_worker(0, 1, &job);
+  }
+  for (t = 0; t < nthreads; t++) {
+    count += job.count[t];
+    if (t == 0) continue;
+    if (ndim == 1) for (i = 0; i < h1->n; i++) h1->bin[i] += job.h1[t]->bin[i];
+    if (ndim == 2) for (i = 0; i < h2->nx * h2->ny; i++) h2->bin[i] += job.h2[t]->bin[i];
+  }
+  RB_GC_GUARD(holder);
+  RB_GC_GUARD(obj);
+  if (ndim == 0) return SIZET2NUM(count);
+  return hh;
+}
+
+/*
+  Document-method: <i>GSL::Ntuple::Columnar#project</i>
+    project(h, value, where: {col => range}, select: expr, weight: expr,
+    threads: n) fills the Histogram (value an expression) or Histogram2d
+    (value an Array of two expressions) h with the selected rows.
+*/
+static VALUE rb_gsl_ntuple_columnar_project(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE opts = Qnil;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 2)", argc);
+  if (HISTOGRAM2D_P(argv[0])) return ntc_run(obj, 2, argv[0], argv[1], opts);
+  CHECK_HISTOGRAM(argv[0]);
+  return ntc_run(obj, 1, argv[0], argv[1], opts);
+}
+
+/*
+  Document-method: <i>GSL::Ntuple::Columnar#count</i>
+    count(where: ..., select: ..., threads: n), the number of selected rows.
+*/
+static VALUE rb_gsl_ntuple_columnar_count(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE opts = Qnil;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 0) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0)", argc);
+  return ntc_run(obj, 0, Qnil, Qnil, opts);
+}
+
+void Init_gsl_ntuple_columnar(VALUE cgsl_ntuple)
+{
+  cgsl_ntuple_columnar = rb_define_class_under(cgsl_ntuple, "Columnar", cGSL_Object);
+  cgsl_ntuple_columnar_writer = rb_define_class_under(cgsl_ntuple_columnar, "Writer", cGSL_Object);
+
+  rb_define_singleton_method(cgsl_ntuple_columnar, "create", rb_gsl_ntuple_columnar_create, -1);
+  rb_define_singleton_method(cgsl_ntuple_columnar, "open", rb_gsl_ntuple_columnar_open, 1);
+
+  rb_define_method(cgsl_ntuple_columnar_writer, "append", rb_gsl_ntuple_columnar_writer_append, 1);
+  rb_define_alias(cgsl_ntuple_columnar_writer, "<<", "append");
+  rb_define_alias(cgsl_ntuple_columnar_writer, "write", "append");
+  rb_define_method(cgsl_ntuple_columnar_writer, "size", rb_gsl_ntuple_columnar_writer_size, 0);
+  rb_define_method(cgsl_ntuple_columnar_writer, "close", rb_gsl_ntuple_columnar_writer_close, 0);
+
+  rb_define_method(cgsl_ntuple_columnar, "size", rb_gsl_ntuple_columnar_size, 0);
+  rb_define_method(cgsl_ntuple_columnar, "nchunks", rb_gsl_ntuple_columnar_nchunks, 0);
+  rb_define_method(cgsl_ntuple_columnar, "chunk_size", rb_gsl_ntuple_columnar_chunk_size, 0);
+  rb_define_method(cgsl_ntuple_columnar, "columns", rb_gsl_ntuple_columnar_columns, 0);
+  rb_define_method(cgsl_ntuple_columnar, "types", rb_gsl_ntuple_columnar_types, 0);
+  rb_define_method(cgsl_ntuple_columnar, "column", rb_gsl_ntuple_columnar_column, 1);
+  rb_define_alias(cgsl_ntuple_columnar, "[]", "column");
+  rb_define_method(cgsl_ntuple_columnar, "stats", rb_gsl_ntuple_columnar_stats, 1);
+  rb_define_method(cgsl_ntuple_columnar, "project", rb_gsl_ntuple_columnar_project, -1);
+  rb_define_method(cgsl_ntuple_columnar, "count", rb_gsl_ntuple_columnar_count, -1);
+}
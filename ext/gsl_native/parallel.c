@@ -0,0 +1,242 @@
+/*
+  parallel.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Native threads for the bulk methods. The GVL is released for the whole
+  loop, so the workers may only use C data. GSL errors in the workers
+  cannot raise Ruby exceptions there: the error handlers hand them to
+  rb_gsl_parallel_trap_error(), which keeps the first one for the
+  calling thread to raise once the workers are joined.
+*/
+
+#include "include/rb_gsl.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_parallel.h"
+#include <gsl/gsl_errno.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#ifdef HAVE_RUBY_THREAD_H
+#include <ruby/thread.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+typedef struct {
+  rb_gsl_parallel_func f;
+  void *data;
+  size_t nthreads;
+  /* set by the unblocking function when Ruby interrupts the call */
+  volatile int interrupted;
+  /* first GSL error of the workers */
+  int gsl_errno;
+  const char *reason, *file;
+  int line;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_t lock;
+#endif
+} rb_gsl_parallel_job;
+
+typedef struct {
+  rb_gsl_parallel_job *job;
+  size_t tid;
+} rb_gsl_parallel_worker;
+
+static size_t rb_gsl_parallel_default = 0;
+
+#ifdef HAVE_PTHREAD_H
+static pthread_key_t rb_gsl_parallel_key;
+#define PARALLEL_CURRENT() ((rb_gsl_parallel_job *) pthread_getspecific(rb_gsl_parallel_key))
+#define PARALLEL_ENTER(job) pthread_setspecific(rb_gsl_parallel_key, (job))
+#define PARALLEL_LEAVE() pthread_setspecific(rb_gsl_parallel_key, NULL)
+#else
+static rb_gsl_parallel_job *rb_gsl_parallel_current = NULL;
+#define PARALLEL_CURRENT() (rb_gsl_parallel_current)
+#define PARALLEL_ENTER(job) (rb_gsl_parallel_current = (job))
+#define PARALLEL_LEAVE() (rb_gsl_parallel_current = NULL)
+#endif
+
+int rb_gsl_parallel_trap_error(const char *reason, const char *file, int line, int gsl_errno)
+{
+  rb_gsl_parallel_job *job = PARALLEL_CURRENT();
+  if (job == NULL) return 0;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock(&job->lock);
+#endif
+  if (job->gsl_errno == 0) {
+    job->gsl_errno = gsl_errno;
+    job->reason = reason;
+    job->file = file;
+    job->line = line;
+  }
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock(&job->lock);
+#endif
+  return 1;
+}
+
+int rb_gsl_parallel_interrupted(void)
+{
+  rb_gsl_parallel_job *job = PARALLEL_CURRENT();
+  return job != NULL && job->interrupted;
+}
+
+static void rb_gsl_parallel_ubf(void *p)
+{
+  ((rb_gsl_parallel_job *) p)->interrupted = 1;
+}
+
+static void* rb_gsl_parallel_worker_main(void *p)
+{
+  rb_gsl_parallel_worker *w = (rb_gsl_parallel_worker *) p;
+  PARALLEL_ENTER(w->job);
+  (*w->job->f)(w->tid, w->job->nthreads, w->job->data);
+  PARALLEL_LEAVE();
+  return NULL;
+}
+
+static void* rb_gsl_parallel_nogvl(void *p)
+{
+  rb_gsl_parallel_job *job = (rb_gsl_parallel_job *) p;
+  rb_gsl_parallel_worker *workers;
+  size_t i;
+#ifdef HAVE_PTHREAD_H
+  pthread_t *threads;
+  int *started;
+  workers = (rb_gsl_parallel_worker *) malloc(job->nthreads * sizeof(rb_gsl_parallel_worker));
+  threads = (pthread_t *) malloc(job->nthreads * sizeof(pthread_t));
+  started = (int *) calloc(job->nthreads, sizeof(int));
+  if (workers == NULL || threads == NULL || started == NULL) {
+    /* run serially */
+    rb_gsl_parallel_worker w;
+    free(workers); free(threads); free(started);
+    w.job = job;
+    for (i = 0; i < job->nthreads; i++) {
+      w.tid = i;
+      rb_gsl_parallel_worker_main(&w);
+    }
+    return NULL;
+  }
+  for (i = 0; i < job->nthreads; i++) {
+    workers[i].job = job;
+    workers[i].tid = i;
+  }
+  for (i = 1; i < job->nthreads; i++)
+    started[i] = (pthread_create(&threads[i], NULL, rb_gsl_parallel_worker_main, &workers[i]) == 0);
+  rb_gsl_parallel_worker_main(&workers[0]);
+  for (i = 1; i < job->nthreads; i++) {
+    if (started[i]) pthread_join(threads[i], NULL);
+    else rb_gsl_parallel_worker_main(&workers[i]);
+  }
+  free(workers); free(threads); free(started);
+#else
+  rb_gsl_parallel_worker w;
+  w.job = job;
+  for (i = 0; i < job->nthreads; i++) {
+    w.tid = i;
+    rb_gsl_parallel_worker_main(&w);
+  }
+#endif
+  return NULL;
+}
+
+void rb_gsl_parallel_run(size_t nthreads, rb_gsl_parallel_func f, void *data)
+{
+  rb_gsl_parallel_job job;
+  memset(&job, 0, sizeof(job));
+  job.f = f;
+  job.data = data;
+  job.nthreads = GSL_MAX(1, GSL_MIN(nthreads, RB_GSL_PARALLEL_MAX_THREADS));
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_init(&job.lock, NULL);
+#endif
+#ifdef HAVE_RUBY_THREAD_H
+  rb_thread_call_without_gvl(rb_gsl_parallel_nogvl, &job, rb_gsl_parallel_ubf, &job);
+#else
+  rb_gsl_parallel_nogvl(&job);
+#endif
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_destroy(&job.lock);
+#endif
+  if (job.interrupted) {
+    /* raises the pending Interrupt, or runs the trap handler */
+    rb_thread_check_ints();
+    rb_raise(rb_eInterrupt, "parallel loop interrupted");
+  }
+  if (job.gsl_errno) gsl_error(job.reason, job.file, job.line, job.gsl_errno);
+}
+
+static size_t rb_gsl_parallel_ncpu(void)
+{
+#if defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n > RB_GSL_PARALLEL_MAX_THREADS) return RB_GSL_PARALLEL_MAX_THREADS;
+  if (n > 0) return (size_t) n;
+#endif
+  return 1;
+}
+
+size_t rb_gsl_parallel_threads(VALUE opts)
+{
+  VALUE val = rb_gsl_hash_get(opts, "threads");
+  long n;
+  if (NIL_P(val)) return rb_gsl_parallel_default;
+  n = NUM2LONG(val);
+  if (n < 1) rb_raise(rb_eArgError, "number of threads must be positive (%ld given)", n);
+  if (n > RB_GSL_PARALLEL_MAX_THREADS) return RB_GSL_PARALLEL_MAX_THREADS;
+  return (size_t) n;
+}
+
+size_t rb_gsl_parallel_size_opt(VALUE opts, const char *key, size_t def)
+{
+  VALUE val = rb_gsl_hash_get(opts, key);
+  long n;
+  if (NIL_P(val)) return def;
+  n = NUM2LONG(val);
+  if (n < 1) rb_raise(rb_eArgError, "%s must be positive (%ld given)", key, n);
+  return (size_t) n;
+}
+
+void rb_gsl_parallel_range(size_t n, size_t nparts, size_t k, size_t *i0, size_t *i1)
+{
+  *i0 = n / nparts * k + (k < n % nparts ? k : n % nparts);
+  *i1 = *i0 + n / nparts + (k < n % nparts ? 1 : 0);
+}
+
+VALUE rb_gsl_parallel_hold(void *p, void (*f)(void*))
+{
+  return Data_Wrap_Struct(rb_cObject, 0, f, p);
+}
+
+/* GSL.threads, the default number of threads of the bulk methods */
+static VALUE rb_gsl_parallel_get_threads(VALUE module)
+{
+  return INT2FIX((int) rb_gsl_parallel_default);
+}
+
+static VALUE rb_gsl_parallel_set_threads(VALUE module, VALUE n)
+{
+  long nn = NUM2LONG(n);
+  if (nn < 1) rb_raise(rb_eArgError, "number of threads must be positive (%ld given)", nn);
+  if (nn > RB_GSL_PARALLEL_MAX_THREADS) nn = RB_GSL_PARALLEL_MAX_THREADS;
+  rb_gsl_parallel_default = (size_t) nn;
+  return n;
+}
+
+void Init_gsl_parallel(VALUE module)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_key_create(&rb_gsl_parallel_key, NULL);
+#endif
+  rb_gsl_parallel_default = rb_gsl_parallel_ncpu();
+  rb_define_module_function(module, "threads", rb_gsl_parallel_get_threads, 0);
+  rb_define_module_function(module, "threads=", rb_gsl_parallel_set_threads, 1);
+}
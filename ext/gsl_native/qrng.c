@@ -11,7 +11,10 @@
 
 #include "include/rb_gsl_rng.h"
 #include "include/rb_gsl_array.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_parallel.h"
 #include <gsl/gsl_qrng.h>
+#include <stdint.h>
 #ifdef HAVE_QRNGEXTRA_QRNGEXTRA_H
 #include <qrngextra/qrngextra.h>
 #endif
@@ -65,6 +68,196 @@ static const gsl_qrng_type* get_gsl_qrng_type(VALUE t)
   return T;
 }
 
+/*
+  A generator together with its randomization. The scrambles work on the
+  32 bit binary expansion of the coordinates, one seed per dimension.
+*/
+typedef struct {
+  gsl_qrng *q;
+  int scramble;
+  uint32_t *seed;
+} mygsl_qrng;
+
+static void mygsl_qrng_free(mygsl_qrng *g)
+{
+  gsl_qrng_free(g->q);
+  free(g->seed);
+  free(g);
+}
+
+static mygsl_qrng* mygsl_qrng_wrap(gsl_qrng *q)
+{
+  mygsl_qrng *g;
+  g = ALLOC(mygsl_qrng);
+  g->q = q;
+  g->scramble = RB_GSL_QRNG_SCRAMBLE_NONE;
+  g->seed = NULL;
+  return g;
+}
+
+static void mygsl_qrng_copy_scramble(mygsl_qrng *dest, const mygsl_qrng *src)
+{
+  free(dest->seed);
+  dest->seed = NULL;
+  dest->scramble = src->scramble;
+  if (src->seed) {
+    dest->seed = (uint32_t *) malloc(src->q->dimension * sizeof(uint32_t));
+    memcpy(dest->seed, src->seed, src->q->dimension * sizeof(uint32_t));
+  }
+}
+
+static uint32_t qrng_reverse_bits(uint32_t x)
+{
+  x = ((x >> 1) & 0x55555555U) | ((x & 0x55555555U) << 1);
+  x = ((x >> 2) & 0x33333333U) | ((x & 0x33333333U) << 2);
+  x = ((x >> 4) & 0x0F0F0F0FU) | ((x & 0x0F0F0F0FU) << 4);
+  x = ((x >> 8) & 0x00FF00FFU) | ((x & 0x00FF00FFU) << 8);
+  return (x >> 16) | (x << 16);
+}
+
+/*
+  Owen scrambling by hashing (Burley, "Practical Hash-based Owen
+  Scrambling", JCGT 9, 2020): on the reversed bits, each output bit of
+  the Laine-Karras permutation depends only on the input bits below it.
+*/
+static uint32_t qrng_owen_scramble(uint32_t x, uint32_t seed)
+{
+  x = qrng_reverse_bits(x);
+  x += seed;
+  x ^= x * 0x6c50b47cU;
+  x ^= x * 0xb82f1e52U;
+  x ^= x * 0xc7afe638U;
+  x ^= x * 0x8d22f6e6U;
+  return qrng_reverse_bits(x);
+}
+
+void rb_gsl_qrng_scramble_point(int type, const uint32_t *seed, size_t d, double *x)
+{
+  size_t i;
+  uint32_t u;
+  double y;
+  switch (type) {
+  case RB_GSL_QRNG_SCRAMBLE_OWEN:
+    for (i = 0; i < d; i++) {
+      u = (uint32_t) (x[i] * 4294967296.0);
+      x[i] = (qrng_owen_scramble(u, seed[i]) + 0.5) / 4294967296.0;
+    }
+    break;
+  case RB_GSL_QRNG_SCRAMBLE_SHIFT:
+    for (i = 0; i < d; i++) {
+      u = (uint32_t) (x[i] * 4294967296.0);
+      x[i] = ((u ^ seed[i]) + 0.5) / 4294967296.0;
+    }
+    break;
+  case RB_GSL_QRNG_SCRAMBLE_ROTATION:
+    for (i = 0; i < d; i++) {
+      y = x[i] + seed[i] / 4294967296.0;
+      x[i] = (y >= 1.0) ? y - 1.0 : y;
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+static int mygsl_qrng_get(const mygsl_qrng *g, gsl_qrng *q, double *x)
+{
+  int status = gsl_qrng_get(q, x);
+  rb_gsl_qrng_scramble_point(g->scramble, g->seed, q->dimension, x);
+  return status;
+}
+
+/*
+  Skip-ahead. The Sobol and Niederreiter generators of GSL are digital
+  sequences in Gray code order: after k points the state is the XOR of
+  the direction numbers selected by the bits of k ^ (k >> 1). The state
+  layouts below mirror those of GSL, and are only used when the state
+  size of the generator matches; other generators step through the
+  skipped points.
+*/
+#define QRNG_SOBOL_MAX_DIMENSION 40
+#define QRNG_SOBOL_BIT_COUNT 30
+#define QRNG_NIED2_MAX_DIMENSION 12
+#define QRNG_NIED2_NBITS 31
+
+typedef struct {
+  unsigned int sequence_count;
+  double last_denominator_inv;
+  int last_numerator_vec[QRNG_SOBOL_MAX_DIMENSION];
+  int v_direction[QRNG_SOBOL_BIT_COUNT][QRNG_SOBOL_MAX_DIMENSION];
+} qrng_sobol_state;
+
+typedef struct {
+  unsigned int sequence_count;
+  int cj[QRNG_NIED2_NBITS][QRNG_NIED2_MAX_DIMENSION];
+  int nextq[QRNG_NIED2_MAX_DIMENSION];
+} qrng_nied2_state;
+
+static int qrng_fast_skip(const gsl_qrng *q, int *type)
+{
+  if (q->type == gsl_qrng_sobol && gsl_qrng_size(q) == sizeof(qrng_sobol_state)) return (*type = 1);
+  if (q->type == gsl_qrng_niederreiter_2 && gsl_qrng_size(q) == sizeof(qrng_nied2_state)) return (*type = 2);
+  return (*type = 0);
+}
+
+/* Returns 1 if the generator skips ahead in O(log k) */
+int rb_gsl_qrng_fast_skip(const gsl_qrng *q)
+{
+  int type;
+  return qrng_fast_skip(q, &type) != 0;
+}
+
+int rb_gsl_qrng_skip_ahead(gsl_qrng *q, unsigned long k)
+{
+  int type;
+  unsigned long n, gray;
+  size_t i, b;
+  int x;
+  double *tmp;
+  if (k == 0) return GSL_SUCCESS;
+  qrng_fast_skip(q, &type);
+  if (type == 1) {
+    qrng_sobol_state *s = (qrng_sobol_state *) gsl_qrng_state(q);
+    n = s->sequence_count + k;
+    if (n < k || n >= (1UL << QRNG_SOBOL_BIT_COUNT))
+      GSL_ERROR("skip beyond the end of the sequence", GSL_EINVAL);
+    gray = n ^ (n >> 1);
+    for (i = 0; i < q->dimension; i++) {
+      for (b = 0, x = 0; b < QRNG_SOBOL_BIT_COUNT; b++)
+        if ((gray >> b) & 1) x ^= s->v_direction[b][i];
+      s->last_numerator_vec[i] = x;
+    }
+    s->sequence_count = (unsigned int) n;
+    return GSL_SUCCESS;
+  }
+  if (type == 2) {
+    qrng_nied2_state *s = (qrng_nied2_state *) gsl_qrng_state(q);
+    n = s->sequence_count + k;
+    if (n < k || n >= (1UL << QRNG_NIED2_NBITS))
+      GSL_ERROR("skip beyond the end of the sequence", GSL_EINVAL);
+    gray = n ^ (n >> 1);
+    for (i = 0; i < q->dimension; i++) {
+      for (b = 0, x = 0; b < QRNG_NIED2_NBITS; b++)
+        if ((gray >> b) & 1) x ^= s->cj[b][i];
+      s->nextq[i] = x;
+    }
+    s->sequence_count = (unsigned int) n;
+    return GSL_SUCCESS;
+  }
+  tmp = (double *) malloc(q->dimension * sizeof(double));
+  if (tmp == NULL) GSL_ERROR("failed to allocate space for a point", GSL_ENOMEM);
+  for (n = 0; n < k; n++) gsl_qrng_get(q, tmp);
+  free(tmp);
+  return GSL_SUCCESS;
+}
+
+static mygsl_qrng* get_qrng(VALUE obj)
+{
+  mygsl_qrng *g = NULL;
+  Data_Get_Struct(obj, mygsl_qrng, g);
+  return g;
+}
+
 static VALUE rb_gsl_qrng_new(VALUE klass, VALUE t, VALUE dd)
 {
   unsigned int d;
@@ -73,65 +266,228 @@ static VALUE rb_gsl_qrng_new(VALUE klass, VALUE t, VALUE dd)
   d = NUM2UINT(dd);
   T = get_gsl_qrng_type(t);
   q = gsl_qrng_alloc(T, d);
-  return Data_Wrap_Struct(klass, 0, gsl_qrng_free, q);
+  return Data_Wrap_Struct(klass, 0, mygsl_qrng_free, mygsl_qrng_wrap(q));
 }
 
 static VALUE rb_gsl_qrng_init(VALUE obj)
 {
-  gsl_qrng *q = NULL;
-  Data_Get_Struct(obj, gsl_qrng, q);
-  gsl_qrng_init(q);
+  gsl_qrng_init(get_qrng(obj)->q);
   return obj;
 }
 
 static VALUE rb_gsl_qrng_name(VALUE obj)
 {
-  gsl_qrng *q = NULL;
-  Data_Get_Struct(obj, gsl_qrng, q);
-  return rb_str_new2(gsl_qrng_name(q));
+  return rb_str_new2(gsl_qrng_name(get_qrng(obj)->q));
 }
 
 static VALUE rb_gsl_qrng_size(VALUE obj)
 {
-  gsl_qrng *q = NULL;
-  Data_Get_Struct(obj, gsl_qrng, q);
-  return INT2FIX(gsl_qrng_size(q));
+  return INT2FIX(gsl_qrng_size(get_qrng(obj)->q));
 }
 
 static VALUE rb_gsl_qrng_clone(VALUE obj)
 {
-  gsl_qrng *q = NULL, *q2 = NULL;
-  Data_Get_Struct(obj, gsl_qrng, q);
-  q2 = gsl_qrng_clone(q);
-  return Data_Wrap_Struct(CLASS_OF(obj), 0, gsl_qrng_free, q2);
+  mygsl_qrng *g, *g2;
+  g = get_qrng(obj);
+  g2 = mygsl_qrng_wrap(gsl_qrng_clone(g->q));
+  mygsl_qrng_copy_scramble(g2, g);
+  return Data_Wrap_Struct(CLASS_OF(obj), 0, mygsl_qrng_free, g2);
 }
 
 /* singleton */
 static VALUE rb_gsl_qrng_memcpy(VALUE obj, VALUE dest, VALUE src)
 {
-  gsl_qrng *q = NULL, *q2 = NULL;
-  Data_Get_Struct(dest, gsl_qrng, q);
-  Data_Get_Struct(src, gsl_qrng, q2);
-  gsl_qrng_memcpy(q, q2);
+  mygsl_qrng *g, *g2;
+  g = get_qrng(dest);
+  g2 = get_qrng(src);
+  gsl_qrng_memcpy(g->q, g2->q);
+  mygsl_qrng_copy_scramble(g, g2);
   return dest;
 }
 
 static VALUE rb_gsl_qrng_get(int argc, VALUE *argv, VALUE obj)
 {
-  gsl_qrng *q = NULL;
+  mygsl_qrng *g;
   gsl_vector *v;
-  Data_Get_Struct(obj, gsl_qrng, q);
+  g = get_qrng(obj);
   if (argc == 0) {
-    v = gsl_vector_alloc(q->dimension);
-    gsl_qrng_get(q, v->data);
+    v = gsl_vector_alloc(g->q->dimension);
+    mygsl_qrng_get(g, g->q, v->data);
     return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
   } else {
     if (!rb_obj_is_kind_of(argv[0], cgsl_vector)) {
       rb_raise(rb_eArgError, "wrong type argument (GSL_Vector required)");
     }
     Data_Get_Struct(argv[0], gsl_vector, v);
-    return INT2FIX(gsl_qrng_get(q, v->data));
+    return INT2FIX(mygsl_qrng_get(g, g->q, v->data));
+  }
+}
+
+/*
+  Document-method: <i>GSL::QRng#skip</i>
+    Skips the next k points.
+*/
+static VALUE rb_gsl_qrng_skip(VALUE obj, VALUE k)
+{
+  if (rb_funcall(k, rb_intern("<"), 1, INT2FIX(0)) == Qtrue)
+    rb_raise(rb_eArgError, "cannot skip backwards");
+  rb_gsl_qrng_skip_ahead(get_qrng(obj)->q, NUM2ULONG(k));
+  return obj;
+}
+
+typedef struct {
+  mygsl_qrng *g;
+  gsl_qrng **clones;
+  gsl_matrix *m;
+  int *status;
+} qrng_fill_job;
+
+static void qrng_fill_worker(size_t tid, size_t nthreads, void *data)
+{
+  qrng_fill_job *job = (qrng_fill_job *) data;
+  size_t i, i0, i1;
+  rb_gsl_parallel_range(job->m->size1, nthreads, tid, &i0, &i1);
+  if (i0 == i1) return;
+  job->status[tid] = rb_gsl_qrng_skip_ahead(job->clones[tid], i0);
+  if (job->status[tid] != GSL_SUCCESS) return;
+  for (i = i0; i < i1 && job->status[tid] == GSL_SUCCESS && !rb_gsl_parallel_interrupted(); i++)
+    job->status[tid] = mygsl_qrng_get(job->g, job->clones[tid], job->m->data + i * job->m->tda);
+}
+
+/*
+  Writes the next m->size1 points to the rows of m. The rows are split
+  among threads only for the generators that skip ahead in O(log k):
+  the others would step through all the rows before theirs, which costs
+  more than filling the matrix serially.
+*/
+static void qrng_fill_matrix(mygsl_qrng *g, gsl_matrix *m, size_t nthreads)
+{
+  qrng_fill_job job;
+  VALUE holder;
+  size_t i;
+  if (m->size2 != g->q->dimension)
+    rb_raise(rb_eArgError, "matrix has %d columns, the generator %d dimensions",
+             (int) m->size2, (int) g->q->dimension);
+  if (nthreads > m->size1) nthreads = m->size1;
+  if (!rb_gsl_qrng_fast_skip(g->q)) nthreads = 1;
+  if (nthreads <= 1) {
+    for (i = 0; i < m->size1; i++)
+      if (mygsl_qrng_get(g, g->q, m->data + i * m->tda) != GSL_SUCCESS)
+        rb_raise(rb_eRangeError, "%d points go beyond the end of the %s sequence",
+                 (int) m->size1, gsl_qrng_name(g->q));
+    return;
+  }
+  holder = rb_ary_new();
+  job.g = g;
+  job.m = m;
+  job.clones = ALLOCA_N(gsl_qrng*, nthreads);
+  job.status = ALLOCA_N(int, nthreads);
+  for (i = 0; i < nthreads; i++) {
+    job.clones[i] = gsl_qrng_clone(g->q);
+    rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, gsl_qrng_free, job.clones[i]));
+    job.status[i] = GSL_SUCCESS;
+  }
+  rb_gsl_parallel_run(nthreads, qrng_fill_worker, &job);
+  for (i = 0; i < nthreads; i++)
+    if (job.status[i] != GSL_SUCCESS)
+      rb_raise(rb_eRangeError, "%d points go beyond the end of the %s sequence",
+               (int) m->size1, gsl_qrng_name(g->q));
+  if (rb_gsl_qrng_skip_ahead(g->q, m->size1) != GSL_SUCCESS)
+    rb_raise(rb_eRangeError, "%d points go beyond the end of the %s sequence",
+             (int) m->size1, gsl_qrng_name(g->q));
+  RB_GC_GUARD(holder);
+}
+
+/*
+  Document-method: <i>GSL::QRng#get_matrix</i>
+    Returns the next n points as the rows of a new n x d matrix.
+*/
+static VALUE rb_gsl_qrng_get_matrix(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_qrng *g;
+  gsl_matrix *m;
+  VALUE opts = Qnil;
+  g = get_qrng(obj);
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1)", argc);
+  m = gsl_matrix_alloc(NUM2SIZET(argv[0]), g->q->dimension);
+  qrng_fill_matrix(g, m, rb_gsl_parallel_threads(opts));
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+}
+
+/*
+  Document-method: <i>GSL::QRng#fill!</i>
+    Overwrites the rows of a matrix with d columns with the next points.
+*/
+static VALUE rb_gsl_qrng_fill(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_matrix *m;
+  VALUE opts = Qnil;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1)", argc);
+  CHECK_MATRIX(argv[0]);
+  Data_Get_Matrix(argv[0], m);
+  qrng_fill_matrix(get_qrng(obj), m, rb_gsl_parallel_threads(opts));
+  return argv[0];
+}
+
+/* Scramble type by name (a Symbol or a String), checked against the generator q */
+int rb_gsl_qrng_scramble_type(VALUE val, const gsl_qrng *q)
+{
+  const char *name;
+  int type;
+  name = SYMBOL_P(val) ? rb_id2name(SYM2ID(val)) : StringValuePtr(val);
+  if (strcmp(name, "owen") == 0) type = RB_GSL_QRNG_SCRAMBLE_OWEN;
+  else if (strcmp(name, "shift") == 0) type = RB_GSL_QRNG_SCRAMBLE_SHIFT;
+  else if (strcmp(name, "rotation") == 0) type = RB_GSL_QRNG_SCRAMBLE_ROTATION;
+  else if (strcmp(name, "none") == 0) type = RB_GSL_QRNG_SCRAMBLE_NONE;
+  else rb_raise(rb_eArgError, "unknown scramble %s (owen, shift, rotation or none)", name);
+  if ((type == RB_GSL_QRNG_SCRAMBLE_OWEN || type == RB_GSL_QRNG_SCRAMBLE_SHIFT)
+      && (q->type == gsl_qrng_halton || q->type == gsl_qrng_reversehalton))
+    rb_raise(rb_eArgError, "%s is not a base 2 sequence, use the rotation scramble", gsl_qrng_name(q));
+  return type;
+}
+
+/* Draws the d seeds of a scramble from r */
+void rb_gsl_qrng_scramble_seed(gsl_rng *r, size_t d, uint32_t *seed)
+{
+  size_t i;
+  for (i = 0; i < d; i++) seed[i] = (uint32_t) (gsl_rng_uniform(r) * 4294967296.0);
+}
+
+const gsl_qrng_type* rb_gsl_qrng_get_type(VALUE t)
+{
+  return get_gsl_qrng_type(t);
+}
+
+/*
+  Document-method: <i>GSL::QRng#scramble!</i>
+    scramble!(rng, type = :owen) randomizes the sequence with seeds drawn from rng.
+*/
+static VALUE rb_gsl_qrng_scramble(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_qrng *g;
+  gsl_rng *r;
+  int type;
+  if (argc < 1 || argc > 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  CHECK_RNG(argv[0]);
+  Data_Get_Struct(argv[0], gsl_rng, r);
+  g = get_qrng(obj);
+  type = (argc == 2) ? rb_gsl_qrng_scramble_type(argv[1], g->q) : RB_GSL_QRNG_SCRAMBLE_OWEN;
+  free(g->seed);
+  g->seed = NULL;
+  g->scramble = type;
+  if (type != RB_GSL_QRNG_SCRAMBLE_NONE) {
+    g->seed = (uint32_t *) malloc(g->q->dimension * sizeof(uint32_t));
+    if (g->seed == NULL) rb_raise(rb_eNoMemError, "failed to allocate the scramble seeds");
+    rb_gsl_qrng_scramble_seed(r, g->q->dimension, g->seed);
   }
+  return obj;
+}
+
+static VALUE rb_gsl_qrng_scrambled(VALUE obj)
+{
+  return get_qrng(obj)->scramble == RB_GSL_QRNG_SCRAMBLE_NONE ? Qfalse : Qtrue;
 }
 
 void Init_gsl_qrng(VALUE module)
@@ -149,6 +505,11 @@ void Init_gsl_qrng(VALUE module)
   rb_define_singleton_method(cgsl_qrng, "memcpy", rb_gsl_qrng_memcpy, 2);
 
   rb_define_method(cgsl_qrng, "get", rb_gsl_qrng_get, -1);
+  rb_define_method(cgsl_qrng, "get_matrix", rb_gsl_qrng_get_matrix, -1);
+  rb_define_method(cgsl_qrng, "fill!", rb_gsl_qrng_fill, -1);
+  rb_define_method(cgsl_qrng, "skip", rb_gsl_qrng_skip, 1);
+  rb_define_method(cgsl_qrng, "scramble!", rb_gsl_qrng_scramble, -1);
+  rb_define_method(cgsl_qrng, "scrambled?", rb_gsl_qrng_scrambled, 0);
 
   rb_define_const(cgsl_qrng, "NIEDERREITER_2", INT2FIX(GSL_QRNG_NIEDERREITER_2));
   rb_define_const(cgsl_qrng, "SOBOL", INT2FIX(GSL_QRNG_SOBOL));
@@ -1260,15 +1260,6 @@ static VALUE rb_gsl_ran_discrete_new(VALUE klass, VALUE vv)
   return Data_Wrap_Struct(klass, 0, gsl_ran_discrete_free, g);
 }
 
-static VALUE rb_gsl_ran_discrete(VALUE obj, VALUE gg)
-{
-  gsl_rng *r = NULL;
-  gsl_ran_discrete_t *g = NULL;
-  Data_Get_Struct(obj, gsl_rng, r);
-  Data_Get_Struct(gg, gsl_ran_discrete_t, g);
-  return INT2FIX(gsl_ran_discrete(r, g));
-}
-
 static VALUE rb_gsl_ran_discrete_pdf(VALUE obj, VALUE k, VALUE gg)
 {
   gsl_ran_discrete_t *g = NULL;
@@ -1692,6 +1683,11 @@ static VALUE rb_gsl_ran_gamma_mt(int argc, VALUE *argv, VALUE obj)
   return rb_gsl_ran_eval2(argc, argv, obj, gsl_ran_gamma_mt);
 }
 
+void Init_gsl_ran_discrete(VALUE module);
+void Init_gsl_ran_mvnormal(VALUE module);
+void Init_gsl_ran_fill(VALUE module);
+void Init_gsl_ran_eval(VALUE module);
+
 void Init_gsl_ran(VALUE module)
 {
   VALUE mgsl_ran;
@@ -1872,7 +1868,6 @@ void Init_gsl_ran(VALUE module)
   cgsl_ran_discrete = rb_define_class_under(mgsl_ran, "Discrete", cGSL_Object);
   rb_define_singleton_method(cgsl_ran_discrete, "alloc", rb_gsl_ran_discrete_new, 1);
   rb_define_singleton_method(cgsl_ran_discrete, "preproc", rb_gsl_ran_discrete_new, 1);
-  rb_define_method(cgsl_rng, "discrete", rb_gsl_ran_discrete, 1);
   rb_define_module_function(mgsl_ran,  "discrete_pdf", rb_gsl_ran_discrete_pdf, 2);
 
   rb_define_method(cgsl_rng, "dirichlet", rb_gsl_ran_dirichlet, -1);
@@ -1887,4 +1882,9 @@ void Init_gsl_ran(VALUE module)
   rb_define_method(cgsl_rng, "gaussian_ziggurat", rb_gsl_ran_gaussian_ziggurat, -1);
   rb_define_module_function(mgsl_ran, "gamma_mt", rb_gsl_ran_gamma_mt, -1);
   rb_define_method(cgsl_rng, "gamma_mt", rb_gsl_ran_gamma_mt, -1);
+
+  Init_gsl_ran_discrete(mgsl_ran);
+  Init_gsl_ran_mvnormal(mgsl_ran);
+  Init_gsl_ran_fill(mgsl_ran);
+  Init_gsl_ran_eval(mgsl_ran);
 }
@@ -0,0 +1,476 @@
+/*
+  randist_discrete.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Discrete samplers besides GSL's own GSL::Ran::Discrete table:
+
+  GSL::Ran::Discrete::Compact is Walker's alias table built with Vose's
+  method, with 32 bit aliases and 32 bit fixed point thresholds. It takes
+  8 bytes per category against 16 for gsl_ran_discrete_t, and needs 12
+  more per category while it is built.
+
+  GSL::Ran::Discrete::Dynamic keeps the weights in a Fenwick tree, so that
+  a weight is changed and a variate drawn in O(log n). Rounding errors of
+  the incremental updates are removed by rebuilding the tree after every
+  n updates.
+*/
+
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_rng.h"
+#include "include/rb_gsl_randist.h"
+#include <stdint.h>
+
+static VALUE cgsl_ran_discrete_class, cgsl_ran_discrete_compact, cgsl_ran_discrete_dynamic;
+
+/* Uniform integer in [0, n) */
+static size_t discrete_uniform_index(const gsl_rng *r, size_t n)
+{
+  size_t k;
+  if (n - 1 <= gsl_rng_max(r) - gsl_rng_min(r)) return gsl_rng_uniform_int(r, n);
+  k = (size_t) (gsl_rng_uniform(r) * n);
+  return k < n ? k : n - 1;
+}
+
+/*****/
+
+typedef struct {
+  size_t K;
+  uint32_t *alias;
+  uint32_t *thr;      /* keep k if u < thr[k], u uniform 32 bit */
+} mygsl_ran_compact;
+
+static void mygsl_ran_compact_free(mygsl_ran_compact *c)
+{
+  free(c->alias);
+  free(c->thr);
+  free(c);
+}
+
+static mygsl_ran_compact* mygsl_ran_compact_alloc(size_t K, const double *w, size_t stride)
+{
+  mygsl_ran_compact *c;
+  double *q, sum = 0.0;
+  uint32_t *stack, s, l;
+  size_t i, nsmall = 0, nlarge = 0;
+  if (K == 0) GSL_ERROR_NULL("number of categories must be positive", GSL_EINVAL);
+  if (K > UINT32_MAX) GSL_ERROR_NULL("too many categories for a compact table", GSL_EINVAL);
+  for (i = 0; i < K; i++) {
+    if (!(w[i * stride] >= 0.0) || !gsl_finite(w[i * stride]))
+      GSL_ERROR_NULL("weights must be finite and non-negative", GSL_EDOM);
+    sum += w[i * stride];
+  }
+  if (sum <= 0.0) GSL_ERROR_NULL("sum of the weights must be positive", GSL_EDOM);
+  c = (mygsl_ran_compact *) malloc(sizeof(mygsl_ran_compact));
+  q = (double *) malloc(K * sizeof(double));
+  stack = (uint32_t *) malloc(K * sizeof(uint32_t));
+  if (c) {
+    c->alias = (uint32_t *) malloc(K * sizeof(uint32_t));
+    c->thr = (uint32_t *) malloc(K * sizeof(uint32_t));
+  }
+  if (c == NULL || q == NULL || stack == NULL || c->alias == NULL || c->thr == NULL) {
+    if (c) { free(c->alias); free(c->thr); free(c); }
+    free(q); free(stack);
+    GSL_ERROR_NULL("failed to allocate space for the alias table", GSL_ENOMEM);
+  }
+  c->K = K;
+  /* small categories are pushed from the front of stack, large ones from the back */
+  for (i = 0; i < K; i++) {
+    q[i] = w[i * stride] * K / sum;
+    if (q[i] < 1.0) stack[nsmall++] = (uint32_t) i;
+    else stack[K - 1 - nlarge++] = (uint32_t) i;
+  }
+  while (nsmall > 0 && nlarge > 0) {
+    s = stack[--nsmall];
+    l = stack[K - nlarge];
+    c->thr[s] = (uint32_t) (q[s] * 4294967296.0);
+    c->alias[s] = l;
+    q[l] = (q[l] + q[s]) - 1.0;
+    if (q[l] < 1.0) {
+      nlarge--;
+      stack[nsmall++] = l;
+    }
+  }
+  /* what is left has probability 1 up to rounding */
+  while (nsmall > 0) {
+    s = stack[--nsmall];
+    c->thr[s] = UINT32_MAX;
+    c->alias[s] = s;
+  }
+  while (nlarge > 0) {
+    l = stack[K - nlarge--];
+    c->thr[l] = UINT32_MAX;
+    c->alias[l] = l;
+  }
+  free(q);
+  free(stack);
+  return c;
+}
+
+static size_t mygsl_ran_compact_sample(const gsl_rng *r, const void *p)
+{
+  const mygsl_ran_compact *c = (const mygsl_ran_compact *) p;
+  size_t k = discrete_uniform_index(r, c->K);
+  uint32_t u = (uint32_t) (gsl_rng_uniform(r) * 4294967296.0);
+  return u < c->thr[k] ? k : c->alias[k];
+}
+
+/*****/
+
+typedef struct {
+  size_t n;
+  double *w;
+  double *tree;       /* 1-based Fenwick tree of w */
+  double total;
+  size_t top;         /* highest power of 2 <= n */
+  size_t nupdate;     /* updates since the last rebuild */
+  size_t npos;        /* number of positive weights */
+} mygsl_ran_dynamic;
+
+static void mygsl_ran_dynamic_free(mygsl_ran_dynamic *d)
+{
+  free(d->w);
+  free(d->tree);
+  free(d);
+}
+
+static void mygsl_ran_dynamic_rebuild(mygsl_ran_dynamic *d)
+{
+  size_t i, j;
+  d->total = 0.0;
+  d->tree[0] = 0.0;
+  d->npos = 0;
+  for (i = 1; i <= d->n; i++) {
+    d->tree[i] = d->w[i - 1];
+    d->total += d->w[i - 1];
+    if (d->w[i - 1] > 0.0) d->npos++;
+  }
+  for (i = 1; i <= d->n; i++) {
+    j = i + (i & (~i + 1));
+    if (j <= d->n) d->tree[j] += d->tree[i];
+  }
+  d->nupdate = 0;
+}
+
+static mygsl_ran_dynamic* mygsl_ran_dynamic_alloc(size_t n)
+{
+  mygsl_ran_dynamic *d;
+  if (n == 0) GSL_ERROR_NULL("number of categories must be positive", GSL_EINVAL);
+  d = (mygsl_ran_dynamic *) calloc(1, sizeof(mygsl_ran_dynamic));
+  if (d) {
+    d->w = (double *) calloc(n, sizeof(double));
+    d->tree = (double *) calloc(n + 1, sizeof(double));
+  }
+  if (d == NULL || d->w == NULL || d->tree == NULL) {
+    if (d) { free(d->w); free(d->tree); free(d); }
+    GSL_ERROR_NULL("failed to allocate space for the sampler", GSL_ENOMEM);
+  }
+  d->n = n;
+  for (d->top = 1; d->top <= n / 2; d->top *= 2);
+  return d;
+}
+
+static void mygsl_ran_dynamic_set(mygsl_ran_dynamic *d, size_t i, double x)
+{
+  double delta;
+  size_t j;
+  delta = x - d->w[i];
+  if (d->w[i] > 0.0) d->npos--;
+  if (x > 0.0) d->npos++;
+  d->w[i] = x;
+  for (j = i + 1; j <= d->n; j += j & (~j + 1)) d->tree[j] += delta;
+  d->total += delta;
+  if (++d->nupdate >= d->n) mygsl_ran_dynamic_rebuild(d);
+}
+
+static size_t mygsl_ran_dynamic_sample(const gsl_rng *r, const void *p)
+{
+  const mygsl_ran_dynamic *d = (const mygsl_ran_dynamic *) p;
+  double u = gsl_rng_uniform(r) * d->total;
+  size_t pos = 0, step, k;
+  /* pos ends as the number of leading categories with cumulative weight <= u */
+  for (step = d->top; step > 0; step /= 2) {
+    if (pos + step <= d->n && d->tree[pos + step] <= u) {
+      pos += step;
+      u -= d->tree[pos];
+    }
+  }
+  if (pos >= d->n) pos = d->n - 1;
+  if (d->w[pos] > 0.0) return pos;
+  /* rounding landed on a zero weight: take the nearest category that can occur */
+  for (k = pos; k > 0; k--) if (d->w[k - 1] > 0.0) return k - 1;
+  for (k = pos + 1; k < d->n; k++) if (d->w[k] > 0.0) return k;
+  return pos;
+}
+
+/*****/
+
+static size_t discrete_gsl_sample(const gsl_rng *r, const void *p)
+{
+  return gsl_ran_discrete(r, (const gsl_ran_discrete_t *) p);
+}
+
+int rb_gsl_ran_get_sampler(VALUE obj, rb_gsl_ran_sampler_func *f, const void **sampler)
+{
+  mygsl_ran_dynamic *d;
+  if (rb_obj_is_kind_of(obj, cgsl_ran_discrete_dynamic)) {
+    Data_Get_Struct(obj, mygsl_ran_dynamic, d);
+    if (d->npos == 0) rb_raise(rb_eRuntimeError, "all weights are zero");
+    *f = mygsl_ran_dynamic_sample;
+    *sampler = d;
+  } else if (rb_obj_is_kind_of(obj, cgsl_ran_discrete_compact)) {
+    *f = mygsl_ran_compact_sample;
+    *sampler = DATA_PTR(obj);
+  } else if (rb_obj_is_kind_of(obj, cgsl_ran_discrete_class)) {
+    *f = discrete_gsl_sample;
+    *sampler = DATA_PTR(obj);
+  } else {
+    return 0;
+  }
+  return 1;
+}
+
+static void discrete_get_sampler(VALUE obj, rb_gsl_ran_sampler_func *f, const void **sampler)
+{
+  if (!rb_gsl_ran_get_sampler(obj, f, sampler))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Ran::Discrete expected)",
+             rb_class2name(CLASS_OF(obj)));
+}
+
+/* One draw, n draws in a new Vector::Int, or draws into the given Vector::Int */
+static VALUE discrete_sample(gsl_rng *r, VALUE gg, int argc, VALUE *argv)
+{
+  rb_gsl_ran_sampler_func f;
+  const void *g;
+  gsl_vector_int *v;
+  VALUE vv;
+  size_t i;
+  discrete_get_sampler(gg, &f, &g);
+  switch (argc) {
+  case 0:
+    return INT2FIX((*f)(r, g));
+    break;
+  case 1:
+    if (VECTOR_INT_P(argv[0])) {
+      vv = argv[0];
+      Data_Get_Struct(vv, gsl_vector_int, v);
+    } else {
+      v = gsl_vector_int_alloc(NUM2SIZET(argv[0]));
+      vv = Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, v);
+    }
+    for (i = 0; i < v->size; i++) v->data[i * v->stride] = (int) (*f)(r, g);
+    return vv;
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc + 1);
+    break;
+  }
+  return Qnil;
+}
+
+/*
+  Document-method: <i>GSL::Rng#discrete</i>
+    Rng#discrete(g), Rng#discrete(g, n), Rng#discrete(g, vi)
+*/
+static VALUE rb_gsl_ran_discrete(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_rng *r = NULL;
+  if (argc < 1) rb_raise(rb_eArgError, "too few arguments (%d for 1 or 2)", argc);
+  Data_Get_Struct(obj, gsl_rng, r);
+  return discrete_sample(r, argv[0], argc - 1, argv + 1);
+}
+
+/*
+  Document-method: <i>GSL::Ran::Discrete#sample</i>
+    g.sample(rng), g.sample(rng, n), g.sample(rng, vi)
+*/
+static VALUE rb_gsl_ran_discrete_sample(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_rng *r = NULL;
+  if (argc < 1) rb_raise(rb_eArgError, "too few arguments (%d for 1 or 2)", argc);
+  CHECK_RNG(argv[0]);
+  Data_Get_Struct(argv[0], gsl_rng, r);
+  return discrete_sample(r, obj, argc - 1, argv + 1);
+}
+
+/*****/
+
+static VALUE rb_gsl_ran_compact_new(VALUE klass, VALUE vv)
+{
+  gsl_vector *v = NULL;
+  mygsl_ran_compact *c;
+  CHECK_VECTOR(vv);
+  Data_Get_Vector(vv, v);
+  c = mygsl_ran_compact_alloc(v->size, v->data, v->stride);
+  return Data_Wrap_Struct(klass, 0, mygsl_ran_compact_free, c);
+}
+
+static VALUE rb_gsl_ran_compact_size(VALUE obj)
+{
+  mygsl_ran_compact *c;
+  Data_Get_Struct(obj, mygsl_ran_compact, c);
+  return SIZET2NUM(c->K);
+}
+
+/*****/
+
+static size_t dynamic_index(const mygsl_ran_dynamic *d, VALUE i)
+{
+  long k = NUM2LONG(i);
+  if (k < 0) k += (long) d->n;
+  if (k < 0 || (size_t) k >= d->n) rb_raise(rb_eIndexError, "index %ld out of range", NUM2LONG(i));
+  return (size_t) k;
+}
+
+static double dynamic_weight(VALUE x)
+{
+  double w = NUM2DBL(x);
+  if (!(w >= 0.0) || !gsl_finite(w))
+    rb_raise(rb_eArgError, "weights must be finite and non-negative (%g given)", w);
+  return w;
+}
+
+/*
+  Document-method: <i>GSL::Ran::Discrete::Dynamic.new</i>
+    Dynamic.new(weights) from a Vector, Dynamic.new(n) with n zero weights.
+*/
+static VALUE rb_gsl_ran_dynamic_new(VALUE klass, VALUE vv)
+{
+  gsl_vector *v = NULL;
+  mygsl_ran_dynamic *d;
+  size_t i;
+  if (VECTOR_P(vv)) {
+    Data_Get_Vector(vv, v);
+    for (i = 0; i < v->size; i++)
+      if (!(gsl_vector_get(v, i) >= 0.0) || !gsl_finite(gsl_vector_get(v, i)))
+        rb_raise(rb_eArgError, "weights must be finite and non-negative");
+    d = mygsl_ran_dynamic_alloc(v->size);
+    for (i = 0; i < v->size; i++) d->w[i] = gsl_vector_get(v, i);
+    mygsl_ran_dynamic_rebuild(d);
+  } else {
+    d = mygsl_ran_dynamic_alloc(NUM2SIZET(vv));
+  }
+  return Data_Wrap_Struct(klass, 0, mygsl_ran_dynamic_free, d);
+}
+
+static VALUE rb_gsl_ran_dynamic_get(VALUE obj, VALUE i)
+{
+  mygsl_ran_dynamic *d;
+  Data_Get_Struct(obj, mygsl_ran_dynamic, d);
+  return rb_float_new(d->w[dynamic_index(d, i)]);
+}
+
+static VALUE rb_gsl_ran_dynamic_set(VALUE obj, VALUE i, VALUE x)
+{
+  mygsl_ran_dynamic *d;
+  Data_Get_Struct(obj, mygsl_ran_dynamic, d);
+  mygsl_ran_dynamic_set(d, dynamic_index(d, i), dynamic_weight(x));
+  return x;
+}
+
+/*
+  Document-method: <i>GSL::Ran::Discrete::Dynamic#update</i>
+    update(indices, weights) sets several weights at once; indices is a
+    Vector::Int or an Array, weights a Vector or an Array.
+*/
+static VALUE rb_gsl_ran_dynamic_update(VALUE obj, VALUE ii, VALUE ww)
+{
+  mygsl_ran_dynamic *d;
+  gsl_vector_int *vi = NULL;
+  gsl_vector *v = NULL;
+  size_t n, i, *k;
+  double *x;
+  VALUE holder = rb_ary_new();
+  Data_Get_Struct(obj, mygsl_ran_dynamic, d);
+  if (VECTOR_INT_P(ii)) {
+    Data_Get_Struct(ii, gsl_vector_int, vi);
+    n = vi->size;
+  } else {
+    Check_Type(ii, T_ARRAY);
+    n = RARRAY_LEN(ii);
+  }
+  if (VECTOR_P(ww)) {
+    Data_Get_Vector(ww, v);
+    if (v->size != n) rb_raise(rb_eArgError, "sizes differ (%d indices, %d weights)", (int) n, (int) v->size);
+  } else {
+    Check_Type(ww, T_ARRAY);
+    if ((size_t) RARRAY_LEN(ww) != n)
+      rb_raise(rb_eArgError, "sizes differ (%d indices, %d weights)", (int) n, (int) RARRAY_LEN(ww));
+  }
+  /* every pair is checked before the tree changes */
+  k = ALLOC_N(size_t, n > 0 ? n : 1);
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, RUBY_DEFAULT_FREE, k));
+  x = ALLOC_N(double, n > 0 ? n : 1);
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, RUBY_DEFAULT_FREE, x));
+  for (i = 0; i < n; i++) {
+    k[i] = dynamic_index(d, vi ? INT2FIX(gsl_vector_int_get(vi, i)) : rb_ary_entry(ii, i));
+    x[i] = dynamic_weight(v ? rb_float_new(gsl_vector_get(v, i)) : rb_ary_entry(ww, i));
+  }
+  for (i = 0; i < n; i++) mygsl_ran_dynamic_set(d, k[i], x[i]);
+  RB_GC_GUARD(holder);
+  return obj;
+}
+
+static VALUE rb_gsl_ran_dynamic_total(VALUE obj)
+{
+  mygsl_ran_dynamic *d;
+  Data_Get_Struct(obj, mygsl_ran_dynamic, d);
+  return rb_float_new(d->total);
+}
+
+static VALUE rb_gsl_ran_dynamic_size(VALUE obj)
+{
+  mygsl_ran_dynamic *d;
+  Data_Get_Struct(obj, mygsl_ran_dynamic, d);
+  return SIZET2NUM(d->n);
+}
+
+static VALUE rb_gsl_ran_dynamic_pdf(VALUE obj, VALUE i)
+{
+  mygsl_ran_dynamic *d;
+  Data_Get_Struct(obj, mygsl_ran_dynamic, d);
+  if (d->npos == 0) return rb_float_new(0.0);
+  return rb_float_new(d->w[dynamic_index(d, i)] / d->total);
+}
+
+static VALUE rb_gsl_ran_dynamic_to_v(VALUE obj)
+{
+  mygsl_ran_dynamic *d;
+  gsl_vector *v;
+  Data_Get_Struct(obj, mygsl_ran_dynamic, d);
+  v = gsl_vector_alloc(d->n);
+  memcpy(v->data, d->w, d->n * sizeof(double));
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+void Init_gsl_ran_discrete(VALUE module)
+{
+  cgsl_ran_discrete_class = rb_const_get(module, rb_intern("Discrete"));
+  rb_define_method(cgsl_rng, "discrete", rb_gsl_ran_discrete, -1);
+  rb_define_method(cgsl_ran_discrete_class, "sample", rb_gsl_ran_discrete_sample, -1);
+
+  cgsl_ran_discrete_compact = rb_define_class_under(cgsl_ran_discrete_class, "Compact", cGSL_Object);
+  rb_define_singleton_method(cgsl_ran_discrete_compact, "alloc", rb_gsl_ran_compact_new, 1);
+  rb_define_singleton_method(cgsl_ran_discrete_compact, "new", rb_gsl_ran_compact_new, 1);
+  rb_define_method(cgsl_ran_discrete_compact, "size", rb_gsl_ran_compact_size, 0);
+  rb_define_method(cgsl_ran_discrete_compact, "sample", rb_gsl_ran_discrete_sample, -1);
+
+  cgsl_ran_discrete_dynamic = rb_define_class_under(cgsl_ran_discrete_class, "Dynamic", cGSL_Object);
+  rb_define_singleton_method(cgsl_ran_discrete_dynamic, "alloc", rb_gsl_ran_dynamic_new, 1);
+  rb_define_singleton_method(cgsl_ran_discrete_dynamic, "new", rb_gsl_ran_dynamic_new, 1);
+  rb_define_method(cgsl_ran_discrete_dynamic, "[]", rb_gsl_ran_dynamic_get, 1);
+  rb_define_method(cgsl_ran_discrete_dynamic, "[]=", rb_gsl_ran_dynamic_set, 2);
+  rb_define_method(cgsl_ran_discrete_dynamic, "update", rb_gsl_ran_dynamic_update, 2);
+  rb_define_method(cgsl_ran_discrete_dynamic, "total", rb_gsl_ran_dynamic_total, 0);
+  rb_define_method(cgsl_ran_discrete_dynamic, "size", rb_gsl_ran_dynamic_size, 0);
+  rb_define_method(cgsl_ran_discrete_dynamic, "pdf", rb_gsl_ran_dynamic_pdf, 1);
+  rb_define_method(cgsl_ran_discrete_dynamic, "to_v", rb_gsl_ran_dynamic_to_v, 0);
+  rb_define_method(cgsl_ran_discrete_dynamic, "sample", rb_gsl_ran_discrete_sample, -1);
+}
@@ -0,0 +1,516 @@
+/*
+  randist_eval.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Ran.pdf(dist, x, *params) and its companions logpdf, cdf, logcdf,
+  sf, logsf and loglikelihood evaluate a distribution given by name over
+  a whole Vector, Vector::Int or Array in one tight loop, optionally
+  writing into an existing Vector (out:) and using several native
+  threads (threads:).
+
+  The parameters are those of the GSL function of the same name, e.g.
+  GSL::Ran.pdf(:gamma, x, a, b) is gsl_ran_gamma_pdf(x, a, b) and
+  GSL::Ran.cdf(:gamma, x, a, b) is gsl_cdf_gamma_P(x, a, b).
+
+  The Gaussian, gamma, beta, Poisson and binomial distributions have
+  their own loops with the constants hoisted out, and compute the log
+  density directly, so that it does not underflow far in the tails. The
+  Gaussian log cdf and log sf are computed from log erfc. The other
+  distributions call the GSL function for each element, and their log
+  variants are the logarithms of its values.
+*/
+
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_parallel.h"
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_cdf.h>
+#include <gsl/gsl_sf_erf.h>
+#include <gsl/gsl_sf_gamma.h>
+#include <limits.h>
+
+enum {
+  RAN_EVAL_D1, RAN_EVAL_D2, RAN_EVAL_D3,
+  RAN_EVAL_U1, RAN_EVAL_U_DU, RAN_EVAL_U_DD, RAN_EVAL_U_UUU,
+};
+
+/* loops of their own */
+enum {
+  RAN_EVAL_GENERIC, RAN_EVAL_GAUSSIAN, RAN_EVAL_GAMMA, RAN_EVAL_BETA,
+  RAN_EVAL_POISSON, RAN_EVAL_BINOMIAL,
+};
+
+enum {
+  RAN_EVAL_PDF, RAN_EVAL_LOGPDF, RAN_EVAL_CDF, RAN_EVAL_LOGCDF, RAN_EVAL_SF, RAN_EVAL_LOGSF,
+};
+
+typedef void (*ran_eval_func)(void);
+
+typedef struct {
+  const char *name;
+  int kind;
+  int nparam;
+  int nopt;          /* trailing parameters that default to 1.0 */
+  int special;
+  ran_eval_func pdf, P, Q;
+} ran_eval_entry;
+
+#define RAN_EVAL_F(f) ((ran_eval_func) (f))
+
+static const ran_eval_entry ran_eval_table[] = {
+  {"gaussian", RAN_EVAL_D2, 1, 1, RAN_EVAL_GAUSSIAN,
+   RAN_EVAL_F(gsl_ran_gaussian_pdf), RAN_EVAL_F(gsl_cdf_gaussian_P), RAN_EVAL_F(gsl_cdf_gaussian_Q)},
+  {"ugaussian", RAN_EVAL_D2, 0, 0, RAN_EVAL_GAUSSIAN,
+   RAN_EVAL_F(gsl_ran_gaussian_pdf), RAN_EVAL_F(gsl_cdf_gaussian_P), RAN_EVAL_F(gsl_cdf_gaussian_Q)},
+  {"gaussian_tail", RAN_EVAL_D3, 2, 1, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_gaussian_tail_pdf), NULL, NULL},
+  {"exponential", RAN_EVAL_D2, 1, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_exponential_pdf), RAN_EVAL_F(gsl_cdf_exponential_P), RAN_EVAL_F(gsl_cdf_exponential_Q)},
+  {"laplace", RAN_EVAL_D2, 1, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_laplace_pdf), RAN_EVAL_F(gsl_cdf_laplace_P), RAN_EVAL_F(gsl_cdf_laplace_Q)},
+  {"exppow", RAN_EVAL_D3, 2, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_exppow_pdf), RAN_EVAL_F(gsl_cdf_exppow_P), RAN_EVAL_F(gsl_cdf_exppow_Q)},
+  {"cauchy", RAN_EVAL_D2, 1, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_cauchy_pdf), RAN_EVAL_F(gsl_cdf_cauchy_P), RAN_EVAL_F(gsl_cdf_cauchy_Q)},
+  {"rayleigh", RAN_EVAL_D2, 1, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_rayleigh_pdf), RAN_EVAL_F(gsl_cdf_rayleigh_P), RAN_EVAL_F(gsl_cdf_rayleigh_Q)},
+  {"rayleigh_tail", RAN_EVAL_D3, 2, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_rayleigh_tail_pdf), NULL, NULL},
+  {"landau", RAN_EVAL_D1, 0, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_landau_pdf), NULL, NULL},
+  {"gamma", RAN_EVAL_D3, 2, 0, RAN_EVAL_GAMMA,
+   RAN_EVAL_F(gsl_ran_gamma_pdf), RAN_EVAL_F(gsl_cdf_gamma_P), RAN_EVAL_F(gsl_cdf_gamma_Q)},
+  {"flat", RAN_EVAL_D3, 2, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_flat_pdf), RAN_EVAL_F(gsl_cdf_flat_P), RAN_EVAL_F(gsl_cdf_flat_Q)},
+  {"lognormal", RAN_EVAL_D3, 2, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_lognormal_pdf), RAN_EVAL_F(gsl_cdf_lognormal_P), RAN_EVAL_F(gsl_cdf_lognormal_Q)},
+  {"chisq", RAN_EVAL_D2, 1, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_chisq_pdf), RAN_EVAL_F(gsl_cdf_chisq_P), RAN_EVAL_F(gsl_cdf_chisq_Q)},
+  {"fdist", RAN_EVAL_D3, 2, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_fdist_pdf), RAN_EVAL_F(gsl_cdf_fdist_P), RAN_EVAL_F(gsl_cdf_fdist_Q)},
+  {"tdist", RAN_EVAL_D2, 1, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_tdist_pdf), RAN_EVAL_F(gsl_cdf_tdist_P), RAN_EVAL_F(gsl_cdf_tdist_Q)},
+  {"beta", RAN_EVAL_D3, 2, 0, RAN_EVAL_BETA,
+   RAN_EVAL_F(gsl_ran_beta_pdf), RAN_EVAL_F(gsl_cdf_beta_P), RAN_EVAL_F(gsl_cdf_beta_Q)},
+  {"logistic", RAN_EVAL_D2, 1, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_logistic_pdf), RAN_EVAL_F(gsl_cdf_logistic_P), RAN_EVAL_F(gsl_cdf_logistic_Q)},
+  {"pareto", RAN_EVAL_D3, 2, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_pareto_pdf), RAN_EVAL_F(gsl_cdf_pareto_P), RAN_EVAL_F(gsl_cdf_pareto_Q)},
+  {"weibull", RAN_EVAL_D3, 2, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_weibull_pdf), RAN_EVAL_F(gsl_cdf_weibull_P), RAN_EVAL_F(gsl_cdf_weibull_Q)},
+  {"gumbel1", RAN_EVAL_D3, 2, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_gumbel1_pdf), RAN_EVAL_F(gsl_cdf_gumbel1_P), RAN_EVAL_F(gsl_cdf_gumbel1_Q)},
+  {"gumbel2", RAN_EVAL_D3, 2, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_gumbel2_pdf), RAN_EVAL_F(gsl_cdf_gumbel2_P), RAN_EVAL_F(gsl_cdf_gumbel2_Q)},
+  {"poisson", RAN_EVAL_U1, 1, 0, RAN_EVAL_POISSON,
+   RAN_EVAL_F(gsl_ran_poisson_pdf), RAN_EVAL_F(gsl_cdf_poisson_P), RAN_EVAL_F(gsl_cdf_poisson_Q)},
+  {"bernoulli", RAN_EVAL_U1, 1, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_bernoulli_pdf), NULL, NULL},
+  {"geometric", RAN_EVAL_U1, 1, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_geometric_pdf), RAN_EVAL_F(gsl_cdf_geometric_P), RAN_EVAL_F(gsl_cdf_geometric_Q)},
+  {"logarithmic", RAN_EVAL_U1, 1, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_logarithmic_pdf), NULL, NULL},
+  {"binomial", RAN_EVAL_U_DU, 2, 0, RAN_EVAL_BINOMIAL,
+   RAN_EVAL_F(gsl_ran_binomial_pdf), RAN_EVAL_F(gsl_cdf_binomial_P), RAN_EVAL_F(gsl_cdf_binomial_Q)},
+  {"pascal", RAN_EVAL_U_DU, 2, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_pascal_pdf), RAN_EVAL_F(gsl_cdf_pascal_P), RAN_EVAL_F(gsl_cdf_pascal_Q)},
+  {"negative_binomial", RAN_EVAL_U_DD, 2, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_negative_binomial_pdf), RAN_EVAL_F(gsl_cdf_negative_binomial_P),
+   RAN_EVAL_F(gsl_cdf_negative_binomial_Q)},
+  {"hypergeometric", RAN_EVAL_U_UUU, 3, 0, RAN_EVAL_GENERIC,
+   RAN_EVAL_F(gsl_ran_hypergeometric_pdf), RAN_EVAL_F(gsl_cdf_hypergeometric_P),
+   RAN_EVAL_F(gsl_cdf_hypergeometric_Q)},
+  {NULL, 0, 0, 0, 0, NULL, NULL, NULL}
+};
+
+static const ran_eval_entry* ran_eval_lookup(VALUE name)
+{
+  const ran_eval_entry *e;
+  const char *s;
+  if (SYMBOL_P(name)) s = rb_id2name(SYM2ID(name));
+  else s = StringValueCStr(name);
+  for (e = ran_eval_table; e->name; e++)
+    if (strcmp(e->name, s) == 0) return e;
+  rb_raise(rb_eArgError, "unknown distribution \"%s\"", s);
+  return NULL;
+}
+
+/* One evaluation over n elements, read while holding the GVL */
+typedef struct {
+  const ran_eval_entry *e;
+  int op;
+  double p[3];
+  const double *x;
+  size_t xstride;
+  double *y;            /* NULL for loglikelihood */
+  size_t ystride, n, nchunks;
+  double *sums;         /* loglikelihood, one per chunk */
+} ran_eval_args;
+
+#define RAN_EVAL_CHUNK 65536
+
+static const double ran_eval_ln_sqrt_2pi = 0.91893853320467274178032973640562;
+
+/*
+  A count k from x for the discrete distributions: returns 1 if x is a
+  non-negative integer within range. *k is also set for the cdfs,
+  which are taken at floor(x).
+*/
+static int ran_eval_count(double x, unsigned int *k)
+{
+  double f;
+  if (!(x >= 0.0)) { *k = 0; return 0; }
+  f = floor(x);
+  *k = f > (double) UINT_MAX ? UINT_MAX : (unsigned int) f;
+  return f == x && f <= (double) UINT_MAX;
+}
+
+/* The pdf, P or Q of a distribution without a loop of its own */
+static double ran_eval_generic(const ran_eval_entry *e, int op, const double *p, double x)
+{
+  ran_eval_func f;
+  unsigned int k;
+  int exact;
+  switch (op) {
+  case RAN_EVAL_PDF: case RAN_EVAL_LOGPDF: f = e->pdf; break;
+  case RAN_EVAL_CDF: case RAN_EVAL_LOGCDF: f = e->P; break;
+  default: f = e->Q; break;
+  }
+  switch (e->kind) {
+  case RAN_EVAL_D1:
+    return (*(double (*)(double)) f)(x);
+  case RAN_EVAL_D2:
+    return (*(double (*)(double, double)) f)(x, p[0]);
+  case RAN_EVAL_D3:
+    return (*(double (*)(double, double, double)) f)(x, p[0], p[1]);
+  default:
+    break;
+  }
+  /* discrete */
+  exact = ran_eval_count(x, &k);
+  if (op == RAN_EVAL_PDF || op == RAN_EVAL_LOGPDF) {
+    if (!exact) return 0.0;
+  } else if (!(x >= 0.0)) {
+    return (op == RAN_EVAL_CDF || op == RAN_EVAL_LOGCDF) ? 0.0 : 1.0;
+  }
+  switch (e->kind) {
+  case RAN_EVAL_U1:
+    return (*(double (*)(unsigned int, double)) f)(k, p[0]);
+  case RAN_EVAL_U_DU:
+    return (*(double (*)(unsigned int, double, unsigned int)) f)(k, p[0], (unsigned int) p[1]);
+  case RAN_EVAL_U_DD:
+    return (*(double (*)(unsigned int, double, double)) f)(k, p[0], p[1]);
+  default:
+    return (*(double (*)(unsigned int, unsigned int, unsigned int, unsigned int)) f)
+      (k, (unsigned int) p[0], (unsigned int) p[1], (unsigned int) p[2]);
+  }
+}
+
+/* log density of the distributions with a loop of their own */
+typedef struct {
+  double c0, c1, c2, c3;
+} ran_eval_consts;
+
+static void ran_eval_prepare_consts(const ran_eval_args *a, ran_eval_consts *c)
+{
+  const double *p = a->p;
+  memset(c, 0, sizeof(ran_eval_consts));
+  switch (a->e->special) {
+  case RAN_EVAL_GAUSSIAN:
+    /* 1/sigma, -log(sigma sqrt(2 pi)) */
+    c->c0 = 1.0 / p[0];
+    c->c1 = -log(fabs(p[0])) - ran_eval_ln_sqrt_2pi;
+    c->c2 = 1.0 / (p[0] * M_SQRT2);
+    break;
+  case RAN_EVAL_GAMMA:
+    /* a - 1, 1/b, -lgamma(a) - a log b */
+    c->c0 = p[0] - 1.0;
+    c->c1 = 1.0 / p[1];
+    c->c2 = -gsl_sf_lngamma(p[0]) - p[0] * log(p[1]);
+    break;
+  case RAN_EVAL_BETA:
+    /* a - 1, b - 1, -log B(a, b) */
+    c->c0 = p[0] - 1.0;
+    c->c1 = p[1] - 1.0;
+    c->c2 = -gsl_sf_lnbeta(p[0], p[1]);
+    break;
+  case RAN_EVAL_POISSON:
+    c->c0 = log(p[0]);
+    break;
+  case RAN_EVAL_BINOMIAL:
+    /* log p, log(1 - p), log n! */
+    c->c0 = log(p[0]);
+    c->c1 = log1p(-p[0]);
+    c->c2 = gsl_sf_lnfact((unsigned int) p[1]);
+    break;
+  }
+}
+
+/* log density at x; falls back to log(pdf) at the edges of the support */
+static double ran_eval_special_logpdf(const ran_eval_args *a, const ran_eval_consts *c, double x)
+{
+  const double *p = a->p;
+  double z;
+  unsigned int k, n;
+  switch (a->e->special) {
+  case RAN_EVAL_GAUSSIAN:
+    z = x * c->c0;
+    return c->c1 - 0.5 * z * z;
+  case RAN_EVAL_GAMMA:
+    if (x > 0.0) return c->c0 * log(x) - x * c->c1 + c->c2;
+    break;
+  case RAN_EVAL_BETA:
+    if (x > 0.0 && x < 1.0) return c->c0 * log(x) + c->c1 * log1p(-x) + c->c2;
+    break;
+  case RAN_EVAL_POISSON:
+    if (!ran_eval_count(x, &k)) return GSL_NEGINF;
+    if (p[0] > 0.0) return k * c->c0 - p[0] - gsl_sf_lnfact(k);
+    break;
+  case RAN_EVAL_BINOMIAL:
+    if (!ran_eval_count(x, &k)) return GSL_NEGINF;
+    n = (unsigned int) p[1];
+    if (k > n) return GSL_NEGINF;
+    if (p[0] > 0.0 && p[0] < 1.0)
+      return c->c2 - gsl_sf_lnfact(k) - gsl_sf_lnfact(n - k) + k * c->c0 + (n - k) * c->c1;
+    break;
+  }
+  return log(ran_eval_generic(a->e, RAN_EVAL_PDF, p, x));
+}
+
+#define RAN_EVAL_LOOP(expr) do {                                        \
+    for (i = i0; i < i1; i++) {                                         \
+      x = a->x[i * a->xstride];                                         \
+      a->y[i * a->ystride] = (expr);                                    \
+    }                                                                   \
+  } while (0)
+
+/* Elements i0 to i1 of a; does not use the Ruby API, so it can run without the GVL */
+static void ran_eval_run(const ran_eval_args *a, size_t i0, size_t i1)
+{
+  const ran_eval_entry *e = a->e;
+  ran_eval_consts c;
+  double x;
+  size_t i;
+  ran_eval_prepare_consts(a, &c);
+  if (e->special == RAN_EVAL_GAUSSIAN) {
+    switch (a->op) {
+    case RAN_EVAL_PDF:
+      RAN_EVAL_LOOP(exp(c.c1 - 0.5 * (x * c.c0) * (x * c.c0)));
+      return;
+    case RAN_EVAL_LOGPDF:
+      RAN_EVAL_LOOP(c.c1 - 0.5 * (x * c.c0) * (x * c.c0));
+      return;
+    case RAN_EVAL_CDF:
+      RAN_EVAL_LOOP(0.5 * erfc(-x * c.c2));
+      return;
+    case RAN_EVAL_SF:
+      RAN_EVAL_LOOP(0.5 * erfc(x * c.c2));
+      return;
+    case RAN_EVAL_LOGCDF:
+      RAN_EVAL_LOOP(gsl_sf_log_erfc(-x * c.c2) - M_LN2);
+      return;
+    case RAN_EVAL_LOGSF:
+      RAN_EVAL_LOOP(gsl_sf_log_erfc(x * c.c2) - M_LN2);
+      return;
+    }
+  }
+  if (e->special != RAN_EVAL_GENERIC && (a->op == RAN_EVAL_PDF || a->op == RAN_EVAL_LOGPDF)) {
+    if (a->op == RAN_EVAL_LOGPDF) RAN_EVAL_LOOP(ran_eval_special_logpdf(a, &c, x));
+    else RAN_EVAL_LOOP(exp(ran_eval_special_logpdf(a, &c, x)));
+    return;
+  }
+  switch (a->op) {
+  case RAN_EVAL_PDF: case RAN_EVAL_CDF: case RAN_EVAL_SF:
+    RAN_EVAL_LOOP(ran_eval_generic(e, a->op, a->p, x));
+    break;
+  default:
+    RAN_EVAL_LOOP(log(ran_eval_generic(e, a->op, a->p, x)));
+    break;
+  }
+}
+
+/* Sum of the log densities of elements i0 to i1 */
+static double ran_eval_loglik(const ran_eval_args *a, size_t i0, size_t i1)
+{
+  ran_eval_consts c;
+  double s = 0.0, x, z;
+  size_t i;
+  ran_eval_prepare_consts(a, &c);
+  if (a->e->special == RAN_EVAL_GAUSSIAN) {
+    for (i = i0; i < i1; i++) {
+      z = a->x[i * a->xstride] * c.c0;
+      s += z * z;
+    }
+    return (i1 - i0) * c.c1 - 0.5 * s;
+  }
+  for (i = i0; i < i1; i++) {
+    x = a->x[i * a->xstride];
+    s += (a->e->special != RAN_EVAL_GENERIC) ? ran_eval_special_logpdf(a, &c, x)
+      : log(ran_eval_generic(a->e, RAN_EVAL_PDF, a->p, x));
+  }
+  return s;
+}
+
+static void ran_eval_worker(size_t tid, size_t nthreads, void *data)
+{
+  ran_eval_args *a = (ran_eval_args *) data;
+  size_t k, i0, i1;
+  for (k = tid; k < a->nchunks && !rb_gsl_parallel_interrupted(); k += nthreads) {
+    i0 = k * RAN_EVAL_CHUNK;
+    i1 = GSL_MIN(i0 + RAN_EVAL_CHUNK, a->n);
+    if (a->y) ran_eval_run(a, i0, i1);
+    else a->sums[k] = ran_eval_loglik(a, i0, i1);
+  }
+}
+
+/*
+  The values x as contiguous or strided doubles. Vector::Int and Array
+  are copied into a Vector, kept alive by *holder.
+*/
+static void ran_eval_get_x(VALUE vx, ran_eval_args *a, VALUE *holder)
+{
+  gsl_vector *v;
+  gsl_vector_int *vi;
+  size_t i;
+  if (VECTOR_P(vx)) {
+    Data_Get_Vector(vx, v);
+  } else if (VECTOR_INT_P(vx)) {
+    Data_Get_Struct(vx, gsl_vector_int, vi);
+    v = gsl_vector_alloc(vi->size > 0 ? vi->size : 1);
+    *holder = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+    for (i = 0; i < vi->size; i++) v->data[i] = (double) gsl_vector_int_get(vi, i);
+    v->size = vi->size;
+  } else if (TYPE(vx) == T_ARRAY) {
+    v = gsl_vector_alloc(RARRAY_LEN(vx) > 0 ? RARRAY_LEN(vx) : 1);
+    *holder = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+    for (i = 0; i < (size_t) RARRAY_LEN(vx); i++) v->data[i] = NUM2DBL(rb_ary_entry(vx, i));
+    v->size = RARRAY_LEN(vx);
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (Vector, Vector::Int, Array or Numeric expected)",
+             rb_class2name(CLASS_OF(vx)));
+  }
+  a->x = v->data;
+  a->xstride = v->stride;
+  a->n = v->size;
+}
+
+static void ran_eval_get_params(ran_eval_args *a, int argc, VALUE *argv)
+{
+  const ran_eval_entry *e = a->e;
+  int k;
+  a->p[0] = a->p[1] = a->p[2] = 1.0;
+  if (argc > e->nparam || argc < e->nparam - e->nopt)
+    rb_raise(rb_eArgError, "wrong number of parameters for %s (%d for %d)", e->name, argc, e->nparam);
+  for (k = 0; k < argc; k++) a->p[k] = NUM2DBL(argv[k]);
+  switch (a->op) {
+  case RAN_EVAL_CDF: case RAN_EVAL_LOGCDF: case RAN_EVAL_SF: case RAN_EVAL_LOGSF:
+    if (e->P == NULL) rb_raise(rb_eArgError, "no cdf for %s", e->name);
+    break;
+  }
+}
+
+/* GSL::Ran.pdf(dist, x, *params, out: nil, threads: nil) and the like */
+static VALUE ran_eval(int argc, VALUE *argv, int op, int loglik)
+{
+  ran_eval_args a;
+  VALUE opts = Qnil, vout = Qnil, holder = Qnil;
+  gsl_vector *out;
+  size_t nthreads, k;
+  double s, x;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc < 2) rb_raise(rb_eArgError, "too few arguments (%d for >= 2)", argc);
+  memset(&a, 0, sizeof(ran_eval_args));
+  a.e = ran_eval_lookup(argv[0]);
+  a.op = op;
+  ran_eval_get_params(&a, argc - 2, argv + 2);
+  if (rb_obj_is_kind_of(argv[1], rb_cNumeric)) {
+    x = NUM2DBL(argv[1]);
+    a.x = &x;
+    a.y = &s;
+    a.n = 1;
+    if (loglik) return rb_float_new(ran_eval_loglik(&a, 0, 1));
+    ran_eval_run(&a, 0, 1);
+    return rb_float_new(s);
+  }
+  ran_eval_get_x(argv[1], &a, &holder);
+  a.nchunks = (a.n + RAN_EVAL_CHUNK - 1) / RAN_EVAL_CHUNK;
+  if (loglik) {
+    a.sums = ALLOCA_N(double, a.nchunks > 0 ? a.nchunks : 1);
+  } else {
+    vout = rb_gsl_hash_get(opts, "out");
+    if (NIL_P(vout)) {
+      if (a.n == 0) rb_raise(rb_eArgError, "empty input");
+      out = gsl_vector_alloc(a.n);
+      vout = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, out);
+    } else {
+      CHECK_VECTOR(vout);
+      Data_Get_Vector(vout, out);
+      if (out->size != a.n)
+        rb_raise(rb_eArgError, "out has %d elements for %d values", (int) out->size, (int) a.n);
+    }
+    a.y = out->data;
+    a.ystride = out->stride;
+  }
+  nthreads = rb_gsl_parallel_threads(opts);
+  if (nthreads > a.nchunks) nthreads = a.nchunks;
+  if (nthreads > 1) rb_gsl_parallel_run(nthreads, ran_eval_worker, &a);
+  else if (a.nchunks > 0) ran_eval_worker(0, 1, &a);
+  RB_GC_GUARD(holder);
+  if (!loglik) return vout;
+  /* chunk sums in order, the same for any number of threads */
+  for (s = 0.0, k = 0; k < a.nchunks; k++) s += a.sums[k];
+  return rb_float_new(s);
+}
+
+static VALUE rb_gsl_ran_eval_pdf(int argc, VALUE *argv, VALUE module)
+{
+  return ran_eval(argc, argv, RAN_EVAL_PDF, 0);
+}
+
+static VALUE rb_gsl_ran_eval_logpdf(int argc, VALUE *argv, VALUE module)
+{
+  return ran_eval(argc, argv, RAN_EVAL_LOGPDF, 0);
+}
+
+static VALUE rb_gsl_ran_eval_cdf(int argc, VALUE *argv, VALUE module)
+{
+  return ran_eval(argc, argv, RAN_EVAL_CDF, 0);
+}
+
+static VALUE rb_gsl_ran_eval_logcdf(int argc, VALUE *argv, VALUE module)
+{
+  return ran_eval(argc, argv, RAN_EVAL_LOGCDF, 0);
+}
+
+static VALUE rb_gsl_ran_eval_sf(int argc, VALUE *argv, VALUE module)
+{
+  return ran_eval(argc, argv, RAN_EVAL_SF, 0);
+}
+
+static VALUE rb_gsl_ran_eval_logsf(int argc, VALUE *argv, VALUE module)
+{
+  return ran_eval(argc, argv, RAN_EVAL_LOGSF, 0);
+}
+
+static VALUE rb_gsl_ran_eval_loglikelihood(int argc, VALUE *argv, VALUE module)
+{
+  return ran_eval(argc, argv, RAN_EVAL_LOGPDF, 1);
+}
+
+void Init_gsl_ran_eval(VALUE module)
+{
+  rb_define_module_function(module, "pdf", rb_gsl_ran_eval_pdf, -1);
+  rb_define_module_function(module, "logpdf", rb_gsl_ran_eval_logpdf, -1);
+  rb_define_module_function(module, "cdf", rb_gsl_ran_eval_cdf, -1);
+  rb_define_module_function(module, "logcdf", rb_gsl_ran_eval_logcdf, -1);
+  rb_define_module_function(module, "sf", rb_gsl_ran_eval_sf, -1);
+  rb_define_module_function(module, "logsf", rb_gsl_ran_eval_logsf, -1);
+  rb_define_module_function(module, "loglikelihood", rb_gsl_ran_eval_loglikelihood, -1);
+}
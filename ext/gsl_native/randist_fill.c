@@ -0,0 +1,669 @@
+/*
+  randist_fill.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Rng#fill!(target, dist, *params) writes variates of the distribution
+  dist straight into an existing Vector, Matrix, Vector::Int, Matrix::Int
+  or NArray. Scalar distributions fill every element; multivariate ones
+  fill one draw per matrix row.
+*/
+
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_rng.h"
+#include "include/rb_gsl_with_narray.h"
+#include "include/rb_gsl_parallel.h"
+#include "include/rb_gsl_randist.h"
+#include <gsl/gsl_randist.h>
+
+enum {
+  RAN_FILL_D0, RAN_FILL_D1, RAN_FILL_D2, RAN_FILL_D3,
+  RAN_FILL_U1, RAN_FILL_U_DU, RAN_FILL_U_DD, RAN_FILL_U_UUU,
+  RAN_FILL_UNIFORM, RAN_FILL_FLAT, RAN_FILL_DISCRETE,
+  /* one draw per row */
+  RAN_FILL_BIVARIATE_GAUSSIAN, RAN_FILL_DIR_2D, RAN_FILL_DIR_2D_TRIG,
+  RAN_FILL_DIR_3D, RAN_FILL_DIR_ND, RAN_FILL_DIRICHLET, RAN_FILL_MULTINOMIAL,
+};
+
+typedef void (*ran_fill_func)(void);
+
+typedef struct {
+  const char *name;
+  int kind;
+  int nparam;
+  int nopt;          /* trailing parameters that default to 1.0 */
+  ran_fill_func f;
+} ran_fill_entry;
+
+static const ran_fill_entry ran_fill_table[] = {
+  /* the Ziggurat method is used for all the Gaussian fills */
+  {"gaussian", RAN_FILL_D1, 1, 1, (ran_fill_func) gsl_ran_gaussian_ziggurat},
+  {"ugaussian", RAN_FILL_D1, 1, 1, (ran_fill_func) gsl_ran_gaussian_ziggurat},
+  {"gaussian_ziggurat", RAN_FILL_D1, 1, 1, (ran_fill_func) gsl_ran_gaussian_ziggurat},
+  {"gaussian_ratio_method", RAN_FILL_D1, 1, 1, (ran_fill_func) gsl_ran_gaussian_ratio_method},
+  {"ugaussian_ratio_method", RAN_FILL_D1, 1, 1, (ran_fill_func) gsl_ran_gaussian_ratio_method},
+  {"gaussian_tail", RAN_FILL_D2, 2, 1, (ran_fill_func) gsl_ran_gaussian_tail},
+  {"ugaussian_tail", RAN_FILL_D2, 2, 1, (ran_fill_func) gsl_ran_gaussian_tail},
+  {"exponential", RAN_FILL_D1, 1, 0, (ran_fill_func) gsl_ran_exponential},
+  {"laplace", RAN_FILL_D1, 1, 0, (ran_fill_func) gsl_ran_laplace},
+  {"exppow", RAN_FILL_D2, 2, 0, (ran_fill_func) gsl_ran_exppow},
+  {"cauchy", RAN_FILL_D1, 1, 0, (ran_fill_func) gsl_ran_cauchy},
+  {"rayleigh", RAN_FILL_D1, 1, 0, (ran_fill_func) gsl_ran_rayleigh},
+  {"rayleigh_tail", RAN_FILL_D2, 2, 0, (ran_fill_func) gsl_ran_rayleigh_tail},
+  {"landau", RAN_FILL_D0, 0, 0, (ran_fill_func) gsl_ran_landau},
+  {"levy", RAN_FILL_D2, 2, 0, (ran_fill_func) gsl_ran_levy},
+  {"levy_skew", RAN_FILL_D3, 3, 0, (ran_fill_func) gsl_ran_levy_skew},
+  {"gamma", RAN_FILL_D2, 2, 0, (ran_fill_func) gsl_ran_gamma},
+  {"flat", RAN_FILL_FLAT, 2, 0, NULL},
+  {"lognormal", RAN_FILL_D2, 2, 0, (ran_fill_func) gsl_ran_lognormal},
+  {"chisq", RAN_FILL_D1, 1, 0, (ran_fill_func) gsl_ran_chisq},
+  {"fdist", RAN_FILL_D2, 2, 0, (ran_fill_func) gsl_ran_fdist},
+  {"tdist", RAN_FILL_D1, 1, 0, (ran_fill_func) gsl_ran_tdist},
+  {"beta", RAN_FILL_D2, 2, 0, (ran_fill_func) gsl_ran_beta},
+  {"logistic", RAN_FILL_D1, 1, 0, (ran_fill_func) gsl_ran_logistic},
+  {"pareto", RAN_FILL_D2, 2, 0, (ran_fill_func) gsl_ran_pareto},
+  {"weibull", RAN_FILL_D2, 2, 0, (ran_fill_func) gsl_ran_weibull},
+  {"gumbel1", RAN_FILL_D2, 2, 0, (ran_fill_func) gsl_ran_gumbel1},
+  {"gumbel2", RAN_FILL_D2, 2, 0, (ran_fill_func) gsl_ran_gumbel2},
+  {"uniform", RAN_FILL_UNIFORM, 0, 0, NULL},
+  {"uniform_pos", RAN_FILL_D0, 0, 0, (ran_fill_func) gsl_rng_uniform_pos},
+  {"poisson", RAN_FILL_U1, 1, 0, (ran_fill_func) gsl_ran_poisson},
+  {"bernoulli", RAN_FILL_U1, 1, 0, (ran_fill_func) gsl_ran_bernoulli},
+  {"geometric", RAN_FILL_U1, 1, 0, (ran_fill_func) gsl_ran_geometric},
+  {"logarithmic", RAN_FILL_U1, 1, 0, (ran_fill_func) gsl_ran_logarithmic},
+  {"binomial", RAN_FILL_U_DU, 2, 0, (ran_fill_func) gsl_ran_binomial},
+  {"binomial_tpe", RAN_FILL_U_DU, 2, 0, (ran_fill_func) gsl_ran_binomial_tpe},
+  {"pascal", RAN_FILL_U_DU, 2, 0, (ran_fill_func) gsl_ran_pascal},
+  {"negative_binomial", RAN_FILL_U_DD, 2, 0, (ran_fill_func) gsl_ran_negative_binomial},
+  {"hypergeometric", RAN_FILL_U_UUU, 3, 0, (ran_fill_func) gsl_ran_hypergeometric},
+  {"discrete", RAN_FILL_DISCRETE, 1, 0, NULL},
+  {"bivariate_gaussian", RAN_FILL_BIVARIATE_GAUSSIAN, 3, 0, NULL},
+  {"dir_2d", RAN_FILL_DIR_2D, 0, 0, NULL},
+  {"dir_2d_trig_method", RAN_FILL_DIR_2D_TRIG, 0, 0, NULL},
+  {"dir_3d", RAN_FILL_DIR_3D, 0, 0, NULL},
+  {"dir_nd", RAN_FILL_DIR_ND, 0, 0, NULL},
+  {"dirichlet", RAN_FILL_DIRICHLET, 1, 0, NULL},
+  {"multinomial", RAN_FILL_MULTINOMIAL, 2, 0, NULL},
+  {NULL, 0, 0, 0, NULL}
+};
+
+/*
+  Rows of n2 elements, row i at offset i*tda. Exactly one of d and ip is
+  set. flat is 1 when the elements are contiguous and may be regrouped
+  into rows of any width.
+*/
+typedef struct {
+  double *d;
+  int *ip;
+  size_t n1, n2, tda;
+  int flat;
+} ran_fill_target;
+
+static void ran_fill_get_target(VALUE obj, ran_fill_target *t)
+{
+  gsl_vector *v;
+  gsl_matrix *m;
+  gsl_vector_int *vi;
+  gsl_matrix_int *mi;
+  memset(t, 0, sizeof(ran_fill_target));
+  if (VECTOR_P(obj) || VECTOR_INT_P(obj)) {
+    if (VECTOR_P(obj)) {
+      Data_Get_Vector(obj, v);
+      t->d = v->data; t->n1 = v->size; t->tda = v->stride;
+    } else {
+      Data_Get_Struct(obj, gsl_vector_int, vi);
+      t->ip = vi->data; t->n1 = vi->size; t->tda = vi->stride;
+    }
+    t->n2 = 1;
+    if (t->tda == 1) {
+      t->n2 = t->n1; t->n1 = 1; t->tda = t->n2;
+      t->flat = 1;
+    }
+  } else if (MATRIX_P(obj)) {
+    Data_Get_Matrix(obj, m);
+    t->d = m->data; t->n1 = m->size1; t->n2 = m->size2; t->tda = m->tda;
+  } else if (MATRIX_INT_P(obj)) {
+    Data_Get_Struct(obj, gsl_matrix_int, mi);
+    t->ip = mi->data; t->n1 = mi->size1; t->n2 = mi->size2; t->tda = mi->tda;
+#ifdef HAVE_NARRAY_H
+  } else if (NA_IsNArray(obj)) {
+    struct NARRAY *na;
+    GetNArray(obj, na);
+    if (na->type == NA_DFLOAT) t->d = (double *) na->ptr;
+    else if (na->type == NA_LINT) t->ip = (int *) na->ptr;
+    else rb_raise(rb_eTypeError, "NArray of float or int expected");
+    if (na->rank >= 2) {
+      t->n2 = na->shape[0]; t->n1 = na->total / na->shape[0]; t->tda = t->n2;
+    } else {
+      t->n1 = 1; t->n2 = na->total; t->tda = t->n2;
+      t->flat = 1;
+    }
+#endif
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (Vector, Matrix or NArray expected)",
+             rb_class2name(CLASS_OF(obj)));
+  }
+}
+
+/* Makes the rows of t w elements wide, one draw of a w-variate distribution per row */
+static void ran_fill_rows(ran_fill_target *t, size_t w)
+{
+  size_t total;
+  if (t->flat) {
+    total = t->n1 * t->n2;
+    if (w == 0 || total % w != 0)
+      rb_raise(rb_eArgError, "length %d is not a multiple of the dimension %d",
+               (int) total, (int) w);
+    t->n1 = total / w; t->n2 = w; t->tda = w;
+  } else if (t->n2 != w) {
+    rb_raise(rb_eArgError, "rows must have %d elements (%d given)", (int) w, (int) t->n2);
+  }
+}
+
+static const ran_fill_entry* ran_fill_lookup(VALUE name)
+{
+  const ran_fill_entry *e;
+  const char *s;
+  if (SYMBOL_P(name)) s = rb_id2name(SYM2ID(name));
+  else s = StringValueCStr(name);
+  for (e = ran_fill_table; e->name; e++)
+    if (strcmp(e->name, s) == 0) return e;
+  rb_raise(rb_eArgError, "unknown distribution \"%s\"", s);
+  return NULL;
+}
+
+/* Parameters of one fill, read while holding the GVL */
+typedef struct {
+  const ran_fill_entry *e;
+  double p[3];
+  unsigned int N;
+  const gsl_vector *alpha;
+  rb_gsl_ran_sampler_func sample;
+  const void *g;
+} ran_fill_args;
+
+/* An unsigned int parameter, given as a Ruby number or read into a double */
+static unsigned int ran_fill_uint(const ran_fill_entry *e, double x)
+{
+  if (!(x >= 0.0 && x <= (double) UINT_MAX))
+    rb_raise(rb_eArgError, "%s: parameter %g out of range [0, %u]", e->name, x, UINT_MAX);
+  return (unsigned int) x;
+}
+
+static void ran_fill_prepare(ran_fill_args *a, ran_fill_target *t, const ran_fill_entry *e,
+                             int argc, VALUE *argv)
+{
+  gsl_vector *v;
+  int k;
+  memset(a, 0, sizeof(ran_fill_args));
+  a->e = e;
+  a->p[0] = a->p[1] = a->p[2] = 1.0;
+  if (argc > e->nparam || argc < e->nparam - e->nopt)
+    rb_raise(rb_eArgError, "wrong number of parameters for %s (%d for %d)",
+             e->name, argc, e->nparam);
+  switch (e->kind) {
+  case RAN_FILL_DISCRETE:
+    if (!rb_gsl_ran_get_sampler(argv[0], &a->sample, &a->g))
+      rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Ran::Discrete expected)",
+               rb_class2name(CLASS_OF(argv[0])));
+    break;
+  case RAN_FILL_DIRICHLET:
+  case RAN_FILL_MULTINOMIAL:
+    k = (e->kind == RAN_FILL_DIRICHLET) ? 0 : 1;
+    CHECK_VECTOR(argv[k]);
+    Data_Get_Vector(argv[k], v);
+    if (v->stride != 1) rb_raise(rb_eArgError, "%s must be contiguous", k ? "p" : "alpha");
+    a->alpha = v;
+    if (k) a->N = ran_fill_uint(e, NUM2DBL(argv[0]));
+    break;
+  default:
+    for (k = 0; k < argc; k++) a->p[k] = NUM2DBL(argv[k]);
+    break;
+  }
+  switch (e->kind) {
+  case RAN_FILL_U_DU:
+    ran_fill_uint(e, a->p[1]);
+    break;
+  case RAN_FILL_U_UUU:
+    for (k = 0; k < 3; k++) ran_fill_uint(e, a->p[k]);
+    break;
+  case RAN_FILL_MULTINOMIAL:
+    /* the counts go up to N */
+    if (t->ip && a->N > INT_MAX)
+      rb_raise(rb_eArgError, "%s: N = %u does not fit in an int array", e->name, a->N);
+    break;
+  }
+  switch (e->kind) {
+  case RAN_FILL_U1: case RAN_FILL_U_DU: case RAN_FILL_U_DD: case RAN_FILL_U_UUU:
+  case RAN_FILL_DISCRETE: case RAN_FILL_MULTINOMIAL:
+    break;
+  default:
+    if (t->ip) rb_raise(rb_eTypeError, "%s fills float arrays only", e->name);
+    break;
+  }
+  switch (e->kind) {
+  case RAN_FILL_BIVARIATE_GAUSSIAN: case RAN_FILL_DIR_2D: case RAN_FILL_DIR_2D_TRIG:
+    ran_fill_rows(t, 2);
+    break;
+  case RAN_FILL_DIR_3D:
+    ran_fill_rows(t, 3);
+    break;
+  case RAN_FILL_DIR_ND:
+    if (t->flat) ran_fill_rows(t, t->n1 * t->n2);
+    break;
+  case RAN_FILL_DIRICHLET: case RAN_FILL_MULTINOMIAL:
+    ran_fill_rows(t, a->alpha->size);
+    break;
+  }
+}
+
+#define RAN_FILL_D(expr) do {                                 \
+    for (i = 0; i < t->n1; i++) {                             \
+      row = t->d + i * t->tda;                                \
+      for (j = 0; j < t->n2; j++) row[j] = (expr);            \
+    }                                                         \
+  } while (0)
+
+#define RAN_FILL_U(expr) do {                                 \
+    for (i = 0; i < t->n1; i++) {                             \
+      if (t->ip) {                                            \
+        irow = t->ip + i * t->tda;                            \
+        for (j = 0; j < t->n2; j++) irow[j] = (int) (expr);   \
+      } else {                                                \
+        row = t->d + i * t->tda;                              \
+        for (j = 0; j < t->n2; j++) row[j] = (double) (expr); \
+      }                                                       \
+    }                                                         \
+  } while (0)
+
+/* The fill itself; does not use the Ruby API, so it can run without the GVL */
+static void ran_fill_run(const gsl_rng *r, const ran_fill_target *t, const ran_fill_args *a)
+{
+  const ran_fill_entry *e = a->e;
+  const double *p = a->p;
+  double *row, lo, hi;
+  int *irow;
+  size_t i, j, K;
+  unsigned int *ubuf;
+  switch (e->kind) {
+  case RAN_FILL_D0:
+    RAN_FILL_D((*(double (*)(const gsl_rng*)) e->f)(r));
+    break;
+  case RAN_FILL_D1:
+    RAN_FILL_D((*(double (*)(const gsl_rng*, double)) e->f)(r, p[0]));
+    break;
+  case RAN_FILL_D2:
+    RAN_FILL_D((*(double (*)(const gsl_rng*, double, double)) e->f)(r, p[0], p[1]));
+    break;
+  case RAN_FILL_D3:
+    RAN_FILL_D((*(double (*)(const gsl_rng*, double, double, double)) e->f)(r, p[0], p[1], p[2]));
+    break;
+  case RAN_FILL_UNIFORM:
+  case RAN_FILL_FLAT:
+    if (rb_gsl_rng_counter_p(r)) {
+      if (t->n2 == 1) rb_gsl_rng_counter_uniform((gsl_rng *) r, t->d, t->tda, t->n1);
+      else for (i = 0; i < t->n1; i++) rb_gsl_rng_counter_uniform((gsl_rng *) r, t->d + i * t->tda, 1, t->n2);
+    } else {
+      RAN_FILL_D(gsl_rng_uniform(r));
+    }
+    if (e->kind == RAN_FILL_FLAT) {
+      /* same arithmetic as gsl_ran_flat */
+      lo = p[0]; hi = p[1];
+      for (i = 0; i < t->n1; i++) {
+        row = t->d + i * t->tda;
+        for (j = 0; j < t->n2; j++) row[j] = lo * (1 - row[j]) + hi * row[j];
+      }
+    }
+    break;
+  case RAN_FILL_U1:
+    RAN_FILL_U((*(unsigned int (*)(const gsl_rng*, double)) e->f)(r, p[0]));
+    break;
+  case RAN_FILL_U_DU:
+    RAN_FILL_U((*(unsigned int (*)(const gsl_rng*, double, unsigned int)) e->f)(r, p[0], (unsigned int) p[1]));
+    break;
+  case RAN_FILL_U_DD:
+    RAN_FILL_U((*(unsigned int (*)(const gsl_rng*, double, double)) e->f)(r, p[0], p[1]));
+    break;
+  case RAN_FILL_U_UUU:
+    RAN_FILL_U((*(unsigned int (*)(const gsl_rng*, unsigned int, unsigned int, unsigned int)) e->f)
+               (r, (unsigned int) p[0], (unsigned int) p[1], (unsigned int) p[2]));
+    break;
+  case RAN_FILL_DISCRETE:
+    RAN_FILL_U((*a->sample)(r, a->g));
+    break;
+  case RAN_FILL_BIVARIATE_GAUSSIAN:
+    for (i = 0; i < t->n1; i++) {
+      row = t->d + i * t->tda;
+      gsl_ran_bivariate_gaussian(r, p[0], p[1], p[2], row, row + 1);
+    }
+    break;
+  case RAN_FILL_DIR_2D:
+    for (i = 0; i < t->n1; i++) {
+      row = t->d + i * t->tda;
+      gsl_ran_dir_2d(r, row, row + 1);
+    }
+    break;
+  case RAN_FILL_DIR_2D_TRIG:
+    for (i = 0; i < t->n1; i++) {
+      row = t->d + i * t->tda;
+      gsl_ran_dir_2d_trig_method(r, row, row + 1);
+    }
+    break;
+  case RAN_FILL_DIR_3D:
+    for (i = 0; i < t->n1; i++) {
+      row = t->d + i * t->tda;
+      gsl_ran_dir_3d(r, row, row + 1, row + 2);
+    }
+    break;
+  case RAN_FILL_DIR_ND:
+    for (i = 0; i < t->n1; i++) gsl_ran_dir_nd(r, t->n2, t->d + i * t->tda);
+    break;
+  case RAN_FILL_DIRICHLET:
+    for (i = 0; i < t->n1; i++)
+      gsl_ran_dirichlet(r, a->alpha->size, a->alpha->data, t->d + i * t->tda);
+    break;
+  case RAN_FILL_MULTINOMIAL:
+    /* plain malloc: this may run without the GVL */
+    K = a->alpha->size;
+    ubuf = (unsigned int *) malloc(K * sizeof(unsigned int));
+    if (ubuf == NULL) GSL_ERROR_VOID("failed to allocate space for a multinomial draw", GSL_ENOMEM);
+    for (i = 0; i < t->n1; i++) {
+      gsl_ran_multinomial(r, K, a->N, a->alpha->data, ubuf);
+      if (t->ip) {
+        irow = t->ip + i * t->tda;
+        for (j = 0; j < K; j++) irow[j] = (int) ubuf[j];   /* ubuf[j] <= N <= INT_MAX */
+      } else {
+        row = t->d + i * t->tda;
+        for (j = 0; j < K; j++) row[j] = (double) ubuf[j];
+      }
+    }
+    free(ubuf);
+    break;
+  }
+}
+
+/*
+  The k-th of nchunks contiguous pieces of t. A single row of scalar
+  variates is cut between elements, anything else between rows.
+*/
+static void ran_fill_chunk(const ran_fill_target *t, const ran_fill_args *a,
+                           size_t nchunks, size_t k, ran_fill_target *sub)
+{
+  size_t n, lo, hi;
+  *sub = *t;
+  if (t->n1 == 1 && a->e->kind < RAN_FILL_BIVARIATE_GAUSSIAN) {
+    n = t->n2;
+    lo = n * k / nchunks; hi = n * (k + 1) / nchunks;
+    if (t->d) sub->d = t->d + lo;
+    else sub->ip = t->ip + lo;
+    sub->n2 = hi - lo;
+    sub->tda = sub->n2;
+  } else {
+    n = t->n1;
+    lo = n * k / nchunks; hi = n * (k + 1) / nchunks;
+    if (t->d) sub->d = t->d + lo * t->tda;
+    else sub->ip = t->ip + lo * t->tda;
+    sub->n1 = hi - lo;
+  }
+}
+
+/*
+  Document-method: <i>GSL::Rng#fill!</i>
+    Fills an existing Vector, Matrix or NArray with variates of the
+    distribution given by name, and returns it.
+*/
+static VALUE rb_gsl_ran_fill(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_rng *r = NULL;
+  ran_fill_target t;
+  ran_fill_args a;
+  switch (TYPE(obj)) {
+  case T_MODULE: case T_CLASS: case T_OBJECT:
+    if (argc < 3) rb_raise(rb_eArgError, "too few arguments (%d for >= 3)", argc);
+    CHECK_RNG(argv[0]);
+    Data_Get_Struct(argv[0], gsl_rng, r);
+    argc--; argv++;
+    break;
+  default:
+    if (argc < 2) rb_raise(rb_eArgError, "too few arguments (%d for >= 2)", argc);
+    Data_Get_Struct(obj, gsl_rng, r);
+    break;
+  }
+  ran_fill_get_target(argv[0], &t);
+  ran_fill_prepare(&a, &t, ran_fill_lookup(argv[1]), argc - 2, argv + 2);
+  ran_fill_run(r, &t, &a);
+  return argv[0];
+}
+
+/*****/
+
+/*
+  GSL::Rng::Pool, a fixed set of generators for filling arrays on
+  several threads. A fill cuts the array into as many chunks as the pool
+  has generators and chunk i always uses generator i; threads only decide
+  who computes which chunks. The result depends on the pool seed and
+  size, not on the number of threads.
+*/
+typedef struct {
+  size_t n;
+  gsl_rng **r;
+  VALUE rngs;   /* Array of the GSL::Rng objects owning r */
+} mygsl_rng_pool;
+
+static VALUE cgsl_rng_pool;
+
+static void mygsl_rng_pool_mark(mygsl_rng_pool *p)
+{
+  rb_gc_mark(p->rngs);
+}
+
+static void mygsl_rng_pool_free(mygsl_rng_pool *p)
+{
+  free(p->r);
+  free(p);
+}
+
+/* splitmix64, to derive the seeds of generators that cannot split */
+static unsigned long long mygsl_rng_pool_mix(unsigned long long x)
+{
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+/* a pool over the Array rngs of GSL::Rng objects */
+static VALUE rb_gsl_rng_pool_wrap(VALUE klass, VALUE rngs)
+{
+  mygsl_rng_pool *p;
+  long n = RARRAY_LEN(rngs), i;
+  p = ALLOC(mygsl_rng_pool);
+  p->n = n;
+  p->r = (gsl_rng **) malloc(n * sizeof(gsl_rng *));
+  if (p->r == NULL) {
+    xfree(p);
+    rb_raise(rb_eNoMemError, "failed to allocate a pool of %ld generators", n);
+  }
+  for (i = 0; i < n; i++) Data_Get_Struct(rb_ary_entry(rngs, i), gsl_rng, p->r[i]);
+  p->rngs = rngs;
+  return Data_Wrap_Struct(klass, mygsl_rng_pool_mark, mygsl_rng_pool_free, p);
+}
+
+static VALUE rb_gsl_rng_pool_new(int argc, VALUE *argv, VALUE klass)
+{
+  VALUE base, rngs, rng, type;
+  long n, i;
+  unsigned long seed = 0;
+  gsl_rng *r;
+  switch (argc) {
+  case 3:
+    type = argv[2];
+    seed = NUM2ULONG(argv[1]);
+    break;
+  case 2:
+    type = rb_str_new2("philox4x32");
+    seed = NUM2ULONG(argv[1]);
+    break;
+  case 1:
+    type = rb_str_new2("philox4x32");
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1-3)", argc);
+    break;
+  }
+  n = NUM2LONG(argv[0]);
+  if (n < 1) rb_raise(rb_eArgError, "pool size must be positive (%ld given)", n);
+  base = rb_funcall(cgsl_rng, rb_intern("alloc"), 1, type);
+  Data_Get_Struct(base, gsl_rng, r);
+  gsl_rng_set(r, seed);
+  if (rb_gsl_rng_counter_p(r)) {
+    rngs = rb_funcall(base, rb_intern("split"), 1, LONG2NUM(n));
+  } else {
+    rngs = rb_ary_new2(n);
+    for (i = 0; i < n; i++) {
+      rng = rb_funcall(cgsl_rng, rb_intern("alloc"), 1, type);
+      Data_Get_Struct(rng, gsl_rng, r);
+      gsl_rng_set(r, (unsigned long) mygsl_rng_pool_mix((unsigned long long) seed + (unsigned long long) i));
+      rb_ary_store(rngs, i, rng);
+    }
+  }
+  return rb_gsl_rng_pool_wrap(klass, rngs);
+}
+
+static VALUE rb_gsl_rng_pool_size(VALUE obj)
+{
+  mygsl_rng_pool *p;
+  Data_Get_Struct(obj, mygsl_rng_pool, p);
+  return INT2FIX((int) p->n);
+}
+
+static VALUE rb_gsl_rng_pool_get(VALUE obj, VALUE i)
+{
+  mygsl_rng_pool *p;
+  Data_Get_Struct(obj, mygsl_rng_pool, p);
+  return rb_ary_entry(p->rngs, NUM2LONG(i));
+}
+
+static VALUE rb_gsl_rng_pool_to_a(VALUE obj)
+{
+  mygsl_rng_pool *p;
+  Data_Get_Struct(obj, mygsl_rng_pool, p);
+  return rb_ary_dup(p->rngs);
+}
+
+/*
+  Pool#dump is "GSLP", a version byte, the number of generators as a
+  little-endian uint32, and the Rng#dump of each generator in order.
+*/
+static VALUE rb_gsl_rng_pool_dump(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_rng_pool *p;
+  VALUE str;
+  size_t i;
+  Data_Get_Struct(obj, mygsl_rng_pool, p);
+  str = rb_str_buf_new(9 + p->n * (16 + gsl_rng_size(p->r[0])));
+  rb_str_buf_cat(str, "GSLP\001", 5);
+  rb_gsl_rng_dump_put_u32(str, p->n);
+  for (i = 0; i < p->n; i++) rb_gsl_rng_dump_to(str, p->r[i]);
+  return str;
+}
+
+static VALUE rb_gsl_rng_pool_load(VALUE klass, VALUE str)
+{
+  const char *p, *end;
+  VALUE rngs;
+  size_t n, i;
+  StringValue(str);
+  p = RSTRING_PTR(str);
+  end = p + RSTRING_LEN(str);
+  if (end - p < 5 || memcmp(p, "GSLP", 4) != 0) rb_raise(rb_eArgError, "not a GSL::Rng::Pool dump");
+  if (p[4] != 1) rb_raise(rb_eArgError, "unsupported GSL::Rng::Pool dump version %d", (int) p[4]);
+  p += 5;
+  n = rb_gsl_rng_dump_get_u32(&p, end);
+  if (n < 1) rb_raise(rb_eArgError, "empty GSL::Rng::Pool dump");
+  rngs = rb_ary_new2(n);
+  for (i = 0; i < n; i++)
+    rb_ary_store(rngs, i, Data_Wrap_Struct(cgsl_rng, 0, gsl_rng_free, rb_gsl_rng_load_from(&p, end)));
+  if (p != end) rb_raise(rb_eArgError, "trailing bytes after the GSL::Rng::Pool dump");
+  return rb_gsl_rng_pool_wrap(klass, rngs);
+}
+
+typedef struct {
+  mygsl_rng_pool *pool;
+  const ran_fill_target *t;
+  const ran_fill_args *a;
+} ran_fill_job;
+
+/* variates per block between two checks for an interrupt */
+#define RAN_FILL_BLOCK 65536
+
+/*
+  Each generator fills its piece in blocks, cut as ran_fill_chunk cuts
+  the target, so that the variates come out in the same order.
+*/
+static void ran_fill_worker(size_t tid, size_t nthreads, void *data)
+{
+  ran_fill_job *job = (ran_fill_job *) data;
+  ran_fill_target sub, blk;
+  size_t k, b, nb;
+  for (k = tid; k < job->pool->n; k += nthreads) {
+    ran_fill_chunk(job->t, job->a, job->pool->n, k, &sub);
+    nb = (sub.n1 * sub.n2 + RAN_FILL_BLOCK - 1) / RAN_FILL_BLOCK;
+    if (!(sub.n1 == 1 && job->a->e->kind < RAN_FILL_BIVARIATE_GAUSSIAN) && nb > sub.n1) nb = sub.n1;
+    for (b = 0; b < nb && !rb_gsl_parallel_interrupted(); b++) {
+      ran_fill_chunk(&sub, job->a, nb, b, &blk);
+      ran_fill_run(job->pool->r[k], &blk, job->a);
+    }
+  }
+}
+
+/*
+  Document-method: <i>GSL::Rng::Pool#fill!</i>
+    Pool#fill!(a, dist, *params, threads: n) is Rng#fill! on n threads.
+*/
+static VALUE rb_gsl_rng_pool_fill(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_rng_pool *p;
+  ran_fill_target t;
+  ran_fill_args a;
+  ran_fill_job job;
+  VALUE opts = Qnil;
+  size_t nthreads;
+  Data_Get_Struct(obj, mygsl_rng_pool, p);
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc < 2) rb_raise(rb_eArgError, "too few arguments (%d for >= 2)", argc);
+  ran_fill_get_target(argv[0], &t);
+  ran_fill_prepare(&a, &t, ran_fill_lookup(argv[1]), argc - 2, argv + 2);
+  nthreads = rb_gsl_parallel_threads(opts);
+  if (nthreads > p->n) nthreads = p->n;
+  job.pool = p;
+  job.t = &t;
+  job.a = &a;
+  rb_gsl_parallel_run(nthreads, ran_fill_worker, &job);
+  return argv[0];
+}
+
+void Init_gsl_ran_fill(VALUE module)
+{
+  rb_define_method(cgsl_rng, "fill!", rb_gsl_ran_fill, -1);
+  rb_define_module_function(module, "fill!", rb_gsl_ran_fill, -1);
+
+  cgsl_rng_pool = rb_define_class_under(cgsl_rng, "Pool", cGSL_Object);
+  rb_define_singleton_method(cgsl_rng_pool, "alloc", rb_gsl_rng_pool_new, -1);
+  rb_define_singleton_method(cgsl_rng_pool, "new", rb_gsl_rng_pool_new, -1);
+  rb_define_method(cgsl_rng_pool, "size", rb_gsl_rng_pool_size, 0);
+  rb_define_method(cgsl_rng_pool, "[]", rb_gsl_rng_pool_get, 1);
+  rb_define_method(cgsl_rng_pool, "to_a", rb_gsl_rng_pool_to_a, 0);
+  rb_define_method(cgsl_rng_pool, "fill!", rb_gsl_rng_pool_fill, -1);
+  rb_define_method(cgsl_rng_pool, "dump", rb_gsl_rng_pool_dump, -1);
+  rb_define_method(cgsl_rng_pool, "_dump", rb_gsl_rng_pool_dump, -1);
+  rb_define_singleton_method(cgsl_rng_pool, "load", rb_gsl_rng_pool_load, 1);
+  rb_define_singleton_method(cgsl_rng_pool, "_load", rb_gsl_rng_pool_load, 1);
+}
@@ -0,0 +1,342 @@
+/*
+  randist_mvnormal.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::Ran::MVNormal, the multivariate normal distribution N(mu, Sigma)
+  with the Cholesky factor Sigma = L L^T computed once.
+
+  n draws are the rows of Z L^T + mu for an n x d matrix Z of standard
+  normal variates, one triangular matrix multiply. The log densities of
+  n points are found from the rows of (X - mu) L^-T, one triangular
+  solve. Sigma + alpha v v^T is factored from L in O(d^2) operations
+  with the rank-1 update and downdate of the Cholesky factor.
+*/
+
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_rng.h"
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_randist.h>
+
+static VALUE cgsl_ran_mvnormal;
+
+typedef struct {
+  size_t d;
+  gsl_vector *mu;
+  gsl_matrix *L;      /* lower triangle, zeros above */
+  gsl_matrix *work;   /* d x d, for the downdates */
+  double logdet;      /* log det L = (log det Sigma) / 2 */
+} mygsl_ran_mvnormal;
+
+static void mygsl_ran_mvnormal_free(mygsl_ran_mvnormal *p)
+{
+  if (p->mu) gsl_vector_free(p->mu);
+  if (p->L) gsl_matrix_free(p->L);
+  if (p->work) gsl_matrix_free(p->work);
+  free(p);
+}
+
+static void mvnormal_logdet(mygsl_ran_mvnormal *p)
+{
+  size_t i;
+  p->logdet = 0.0;
+  for (i = 0; i < p->d; i++) p->logdet += log(gsl_matrix_get(p->L, i, i));
+}
+
+static void mvnormal_zero_upper(gsl_matrix *L)
+{
+  size_t i, j;
+  for (i = 0; i < L->size1; i++)
+    for (j = i + 1; j < L->size2; j++) gsl_matrix_set(L, i, j, 0.0);
+}
+
+/*
+  Rank-1 update (sign = 1) or downdate (sign = -1) of the lower Cholesky
+  factor L: L L^T + sign x x^T. x is overwritten. Returns GSL_EDOM,
+  leaving L partly updated, if the downdated matrix is not positive
+  definite.
+*/
+static int mvnormal_cholesky_update(gsl_matrix *L, double *x, int sign)
+{
+  size_t n = L->size1, i, k;
+  double lkk, r2, r, c, s, lik;
+  for (k = 0; k < n; k++) {
+    lkk = gsl_matrix_get(L, k, k);
+    r2 = lkk * lkk + sign * x[k] * x[k];
+    if (!(r2 > 0.0)) return GSL_EDOM;
+    r = sqrt(r2);
+    c = r / lkk;
+    s = x[k] / lkk;
+    gsl_matrix_set(L, k, k, r);
+    for (i = k + 1; i < n; i++) {
+      lik = (gsl_matrix_get(L, i, k) + sign * s * x[i]) / c;
+      gsl_matrix_set(L, i, k, lik);
+      x[i] = c * x[i] - s * lik;
+    }
+  }
+  return GSL_SUCCESS;
+}
+
+static mygsl_ran_mvnormal* mvnormal_get(VALUE obj)
+{
+  mygsl_ran_mvnormal *p;
+  Data_Get_Struct(obj, mygsl_ran_mvnormal, p);
+  return p;
+}
+
+static gsl_vector* mvnormal_get_vector(VALUE vv, size_t d, const char *name)
+{
+  gsl_vector *v;
+  CHECK_VECTOR(vv);
+  Data_Get_Vector(vv, v);
+  if (v->size != d) rb_raise(rb_eArgError, "%s has size %d, expected %d", name, (int) v->size, (int) d);
+  return v;
+}
+
+/*
+  MVNormal.new(mu, sigma), or MVNormal.new(mu, cholesky: l) with the
+  lower triangular factor l of sigma.
+*/
+static VALUE rb_gsl_ran_mvnormal_new(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_ran_mvnormal *p;
+  gsl_vector *mu;
+  gsl_matrix *m;
+  VALUE opts = Qnil, obj, vl = Qnil;
+  size_t i;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  vl = rb_gsl_hash_get(opts, "cholesky");
+  if (argc != (NIL_P(vl) ? 2 : 1))
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for %d)", argc, NIL_P(vl) ? 2 : 1);
+  CHECK_VECTOR(argv[0]);
+  Data_Get_Vector(argv[0], mu);
+  if (mu->size == 0) rb_raise(rb_eArgError, "empty mean");
+  if (NIL_P(vl)) vl = argv[1];
+  CHECK_MATRIX(vl);
+  Data_Get_Matrix(vl, m);
+  if (m->size1 != mu->size || m->size2 != mu->size)
+    rb_raise(rb_eArgError, "matrix is %dx%d, expected %dx%d", (int) m->size1, (int) m->size2,
+             (int) mu->size, (int) mu->size);
+  p = ALLOC(mygsl_ran_mvnormal);
+  memset(p, 0, sizeof(mygsl_ran_mvnormal));
+  obj = Data_Wrap_Struct(klass, 0, mygsl_ran_mvnormal_free, p);
+  p->d = mu->size;
+  p->mu = gsl_vector_alloc(p->d);
+  gsl_vector_memcpy(p->mu, mu);
+  p->L = gsl_matrix_alloc(p->d, p->d);
+  p->work = gsl_matrix_alloc(p->d, p->d);
+  gsl_matrix_memcpy(p->L, m);
+  if (NIL_P(rb_gsl_hash_get(opts, "cholesky"))) gsl_linalg_cholesky_decomp(p->L);
+  mvnormal_zero_upper(p->L);
+  for (i = 0; i < p->d; i++)
+    if (!(gsl_matrix_get(p->L, i, i) > 0.0))
+      rb_raise(rb_eArgError, "the Cholesky factor must have a positive diagonal");
+  mvnormal_logdet(p);
+  return obj;
+}
+
+/*
+  Fills the rows of m with draws: m = Z L^T + mu. The normal variates
+  are drawn row by row, so the i-th row is the i-th single draw.
+*/
+static void mvnormal_fill(const mygsl_ran_mvnormal *p, const gsl_rng *r, gsl_matrix *m)
+{
+  size_t i, j;
+  for (i = 0; i < m->size1; i++)
+    for (j = 0; j < p->d; j++) gsl_matrix_set(m, i, j, gsl_ran_gaussian_ziggurat(r, 1.0));
+  gsl_blas_dtrmm(CblasRight, CblasLower, CblasTrans, CblasNonUnit, 1.0, p->L, m);
+  for (i = 0; i < m->size1; i++) {
+    gsl_vector_view row = gsl_matrix_row(m, i);
+    gsl_vector_add(&row.vector, p->mu);
+  }
+}
+
+/*
+  sample(rng) returns a Vector, sample(rng, n) a Matrix with n draws as
+  rows, and sample(rng, m) fills the rows of the Matrix m.
+*/
+static VALUE rb_gsl_ran_mvnormal_sample(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_ran_mvnormal *p = mvnormal_get(obj);
+  gsl_rng *r;
+  gsl_matrix *m;
+  gsl_vector *v;
+  long n;
+  if (argc < 1 || argc > 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  CHECK_RNG(argv[0]);
+  Data_Get_Struct(argv[0], gsl_rng, r);
+  if (argc == 1) {
+    gsl_matrix_view mv;
+    v = gsl_vector_alloc(p->d);
+    mv = gsl_matrix_view_vector(v, 1, p->d);
+    mvnormal_fill(p, r, &mv.matrix);
+    return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+  }
+  if (MATRIX_P(argv[1])) {
+    Data_Get_Matrix(argv[1], m);
+    if (m->size2 != p->d)
+      rb_raise(rb_eArgError, "matrix has %d columns, expected %d", (int) m->size2, (int) p->d);
+    mvnormal_fill(p, r, m);
+    return argv[1];
+  }
+  n = NUM2LONG(argv[1]);
+  if (n < 0) rb_raise(rb_eArgError, "negative number of draws (%ld given)", n);
+  if (n == 0) rb_raise(rb_eArgError, "number of draws must be positive");
+  m = gsl_matrix_alloc((size_t) n, p->d);
+  obj = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+  mvnormal_fill(p, r, m);
+  return obj;
+}
+
+/* log densities of the rows of x, into lp */
+static void mvnormal_logpdf(const mygsl_ran_mvnormal *p, const gsl_matrix *x, double *lp)
+{
+  gsl_matrix *z = gsl_matrix_alloc(x->size1, p->d);
+  double c = -p->logdet - 0.5 * p->d * log(2.0 * M_PI), s;
+  size_t i, j;
+  for (i = 0; i < x->size1; i++)
+    for (j = 0; j < p->d; j++)
+      gsl_matrix_set(z, i, j, gsl_matrix_get(x, i, j) - gsl_vector_get(p->mu, j));
+  /* rows of (x - mu) L^-T, i.e. the solutions of L z = x - mu */
+  gsl_blas_dtrsm(CblasRight, CblasLower, CblasTrans, CblasNonUnit, 1.0, p->L, z);
+  for (i = 0; i < x->size1; i++) {
+    s = 0.0;
+    for (j = 0; j < p->d; j++) s += gsl_matrix_get(z, i, j) * gsl_matrix_get(z, i, j);
+    lp[i] = c - 0.5 * s;
+  }
+  gsl_matrix_free(z);
+}
+
+/* Float for a Vector, Vector of the rows for a Matrix */
+static VALUE mvnormal_density(VALUE obj, VALUE vx, int take_exp)
+{
+  mygsl_ran_mvnormal *p = mvnormal_get(obj);
+  gsl_matrix *x;
+  gsl_vector *v, *res;
+  double lp;
+  size_t i;
+  if (MATRIX_P(vx)) {
+    Data_Get_Matrix(vx, x);
+    if (x->size2 != p->d)
+      rb_raise(rb_eArgError, "matrix has %d columns, expected %d", (int) x->size2, (int) p->d);
+    res = gsl_vector_alloc(x->size1);
+    mvnormal_logpdf(p, x, res->data);
+    if (take_exp) for (i = 0; i < res->size; i++) res->data[i] = exp(res->data[i]);
+    return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, res);
+  }
+  v = mvnormal_get_vector(vx, p->d, "point");
+  x = gsl_matrix_alloc(1, p->d);
+  for (i = 0; i < p->d; i++) gsl_matrix_set(x, 0, i, gsl_vector_get(v, i));
+  mvnormal_logpdf(p, x, &lp);
+  gsl_matrix_free(x);
+  return rb_float_new(take_exp ? exp(lp) : lp);
+}
+
+static VALUE rb_gsl_ran_mvnormal_logpdf(VALUE obj, VALUE vx)
+{
+  return mvnormal_density(obj, vx, 0);
+}
+
+static VALUE rb_gsl_ran_mvnormal_pdf(VALUE obj, VALUE vx)
+{
+  return mvnormal_density(obj, vx, 1);
+}
+
+/*
+  update!(v, alpha = 1.0): the covariance becomes sigma + alpha v v^T.
+  A downdate (alpha < 0) that would leave sigma not positive definite
+  raises and keeps the distribution unchanged.
+*/
+static VALUE rb_gsl_ran_mvnormal_update(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_ran_mvnormal *p = mvnormal_get(obj);
+  gsl_vector *v;
+  double alpha = 1.0, *x;
+  size_t i;
+  int status;
+  if (argc < 1 || argc > 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  v = mvnormal_get_vector(argv[0], p->d, "vector");
+  if (argc == 2) alpha = NUM2DBL(argv[1]);
+  if (alpha == 0.0) return obj;
+  x = ALLOCA_N(double, p->d);
+  for (i = 0; i < p->d; i++) x[i] = sqrt(fabs(alpha)) * gsl_vector_get(v, i);
+  if (alpha > 0.0) {
+    mvnormal_cholesky_update(p->L, x, 1);
+  } else {
+    gsl_matrix_memcpy(p->work, p->L);
+    status = mvnormal_cholesky_update(p->work, x, -1);
+    if (status != GSL_SUCCESS)
+      rb_raise(rb_eRuntimeError, "downdated covariance is not positive definite");
+    gsl_matrix_memcpy(p->L, p->work);
+  }
+  mvnormal_logdet(p);
+  return obj;
+}
+
+static VALUE rb_gsl_ran_mvnormal_set_mean(VALUE obj, VALUE vmu)
+{
+  mygsl_ran_mvnormal *p = mvnormal_get(obj);
+  gsl_vector_memcpy(p->mu, mvnormal_get_vector(vmu, p->d, "mean"));
+  return vmu;
+}
+
+static VALUE rb_gsl_ran_mvnormal_mean(VALUE obj)
+{
+  mygsl_ran_mvnormal *p = mvnormal_get(obj);
+  gsl_vector *v = gsl_vector_alloc(p->d);
+  gsl_vector_memcpy(v, p->mu);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+static VALUE rb_gsl_ran_mvnormal_cholesky(VALUE obj)
+{
+  mygsl_ran_mvnormal *p = mvnormal_get(obj);
+  gsl_matrix *m = gsl_matrix_alloc(p->d, p->d);
+  gsl_matrix_memcpy(m, p->L);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+}
+
+static VALUE rb_gsl_ran_mvnormal_covariance(VALUE obj)
+{
+  mygsl_ran_mvnormal *p = mvnormal_get(obj);
+  gsl_matrix *m = gsl_matrix_alloc(p->d, p->d);
+  gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, p->L, p->L, 0.0, m);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+}
+
+static VALUE rb_gsl_ran_mvnormal_dim(VALUE obj)
+{
+  return SIZET2NUM(mvnormal_get(obj)->d);
+}
+
+static VALUE rb_gsl_ran_mvnormal_log_det(VALUE obj)
+{
+  return rb_float_new(2.0 * mvnormal_get(obj)->logdet);
+}
+
+void Init_gsl_ran_mvnormal(VALUE module)
+{
+  cgsl_ran_mvnormal = rb_define_class_under(module, "MVNormal", cGSL_Object);
+  rb_define_singleton_method(cgsl_ran_mvnormal, "alloc", rb_gsl_ran_mvnormal_new, -1);
+  rb_define_singleton_method(cgsl_ran_mvnormal, "new", rb_gsl_ran_mvnormal_new, -1);
+  rb_define_method(cgsl_ran_mvnormal, "sample", rb_gsl_ran_mvnormal_sample, -1);
+  rb_define_method(cgsl_ran_mvnormal, "logpdf", rb_gsl_ran_mvnormal_logpdf, 1);
+  rb_define_alias(cgsl_ran_mvnormal, "log_pdf", "logpdf");
+  rb_define_method(cgsl_ran_mvnormal, "pdf", rb_gsl_ran_mvnormal_pdf, 1);
+  rb_define_method(cgsl_ran_mvnormal, "update!", rb_gsl_ran_mvnormal_update, -1);
+  rb_define_method(cgsl_ran_mvnormal, "mean", rb_gsl_ran_mvnormal_mean, 0);
+  rb_define_method(cgsl_ran_mvnormal, "mean=", rb_gsl_ran_mvnormal_set_mean, 1);
+  rb_define_method(cgsl_ran_mvnormal, "covariance", rb_gsl_ran_mvnormal_covariance, 0);
+  rb_define_method(cgsl_ran_mvnormal, "cholesky", rb_gsl_ran_mvnormal_cholesky, 0);
+  rb_define_method(cgsl_ran_mvnormal, "log_det", rb_gsl_ran_mvnormal_log_det, 0);
+  rb_define_method(cgsl_ran_mvnormal, "dim", rb_gsl_ran_mvnormal_dim, 0);
+  rb_define_alias(cgsl_ran_mvnormal, "size", "dim");
+}
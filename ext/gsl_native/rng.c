@@ -52,6 +52,8 @@ enum rb_gsl_rng_generator {
   GSL_RNGEXTRA_RNG1, GSL_RNGEXTRA_RNG2,
   /* GSL-1.9 */
   GSL_RNG_KNUTHRAN2002,
+  /* counter-based, rng_counter.c */
+  GSL_RNG_PHILOX4X32, GSL_RNG_THREEFRY4X32,
 };
 
 static const gsl_rng_type* get_gsl_rng_type(VALUE t);
@@ -207,6 +209,10 @@ static const gsl_rng_type* get_gsl_rng_type_name(char *name)
     rb_raise(rb_eNotImpError, "Install the rngextra package found at <http://www.network-theory.co.uk/download/rngextra/>.");
 #endif
   else if (str_tail_grep(name, "knuthran2002") == 0) return gsl_rng_knuthran2002;
+  else if (str_tail_grep(name, "philox4x32") == 0) return rb_gsl_rng_philox4x32;
+  else if (str_tail_grep(name, "philox") == 0) return rb_gsl_rng_philox4x32;
+  else if (str_tail_grep(name, "threefry4x32") == 0) return rb_gsl_rng_threefry4x32;
+  else if (str_tail_grep(name, "threefry") == 0) return rb_gsl_rng_threefry4x32;
   else
     rb_raise(rb_eArgError, "unknown generator type \"%s\"", name);
 }
@@ -288,6 +294,8 @@ static const gsl_rng_type* get_gsl_rng_type_int(int itype)
     break;
 #endif
   case GSL_RNG_KNUTHRAN2002: T = gsl_rng_knuthran2002; break;
+  case GSL_RNG_PHILOX4X32: T = rb_gsl_rng_philox4x32; break;
+  case GSL_RNG_THREEFRY4X32: T = rb_gsl_rng_threefry4x32; break;
   default:
     rb_raise(rb_eTypeError, "wrong generator type");
   }
@@ -364,6 +372,8 @@ static void rb_gsl_rng_define_const_type(VALUE module)
   rb_define_const(cgsl_rng, "RNGEXTRA_RNG2", INT2FIX(GSL_RNGEXTRA_RNG2));
   rb_define_const(module, "RNGEXTRA_RNG1", INT2FIX(GSL_RNGEXTRA_RNG1));
   rb_define_const(module, "RNGEXTRA_RNG2", INT2FIX(GSL_RNGEXTRA_RNG2));
+  rb_define_const(cgsl_rng, "PHILOX4X32", INT2FIX(GSL_RNG_PHILOX4X32));
+  rb_define_const(cgsl_rng, "THREEFRY4X32", INT2FIX(GSL_RNG_THREEFRY4X32));
 
 }
 
@@ -495,6 +505,8 @@ static VALUE rb_gsl_rng_types_setup(VALUE obj)
   t0 = gsl_rng_types_setup();
   ary = rb_ary_new();
   for (t = t0; *t != 0; t++) rb_ary_push(ary, rb_str_new2((*t)->name));
+  rb_ary_push(ary, rb_str_new2(rb_gsl_rng_philox4x32->name));
+  rb_ary_push(ary, rb_str_new2(rb_gsl_rng_threefry4x32->name));
   return ary;
 }
 
@@ -555,6 +567,145 @@ static VALUE rb_gsl_rng_memcpy(VALUE obj, VALUE dst, VALUE org)
   return dst;
 }
 
+/*
+  Binary state format of Rng#dump, version 1:
+
+    "GSLR"                 magic
+    uint8   version
+    uint8   flags          bit 0: the state was written on a big-endian host
+    uint8   sizeof(long)
+    uint8   n              length of the type name
+    char    name[n]        gsl_rng_name, without terminator
+    uint32  size           little-endian, gsl_rng_size
+    char    state[size]    gsl_rng_state, as gsl_rng_fwrite writes it
+
+  The state is GSL's own memory layout, so a dump can be loaded on any
+  host with the same byte order and size of long.
+*/
+#define RB_GSL_RNG_DUMP_MAGIC "GSLR"
+#define RB_GSL_RNG_DUMP_VERSION 1
+
+static int rb_gsl_rng_big_endian(void)
+{
+  const unsigned int one = 1;
+  return *((const unsigned char *) &one) == 0;
+}
+
+void rb_gsl_rng_dump_put_u32(VALUE str, size_t n)
+{
+  unsigned char b[4];
+  b[0] = (unsigned char) (n & 0xff);
+  b[1] = (unsigned char) ((n >> 8) & 0xff);
+  b[2] = (unsigned char) ((n >> 16) & 0xff);
+  b[3] = (unsigned char) ((n >> 24) & 0xff);
+  rb_str_buf_cat(str, (const char *) b, 4);
+}
+
+size_t rb_gsl_rng_dump_get_u32(const char **p, const char *end)
+{
+  const unsigned char *b = (const unsigned char *) *p;
+  if (end - *p < 4) rb_raise(rb_eArgError, "truncated GSL::Rng dump");
+  *p += 4;
+  return (size_t) b[0] | ((size_t) b[1] << 8) | ((size_t) b[2] << 16) | ((size_t) b[3] << 24);
+}
+
+void rb_gsl_rng_dump_to(VALUE str, const gsl_rng *r)
+{
+  unsigned char head[8];
+  const char *name = gsl_rng_name(r);
+  size_t len = strlen(name);
+  memcpy(head, RB_GSL_RNG_DUMP_MAGIC, 4);
+  head[4] = RB_GSL_RNG_DUMP_VERSION;
+  head[5] = (unsigned char) rb_gsl_rng_big_endian();
+  head[6] = (unsigned char) sizeof(long);
+  head[7] = (unsigned char) len;
+  rb_str_buf_cat(str, (const char *) head, 8);
+  rb_str_buf_cat(str, name, len);
+  rb_gsl_rng_dump_put_u32(str, gsl_rng_size(r));
+  rb_str_buf_cat(str, (const char *) gsl_rng_state(r), gsl_rng_size(r));
+}
+
+static const gsl_rng_type* rb_gsl_rng_type_exact(const char *name, size_t len)
+{
+  const gsl_rng_type **t;
+  const gsl_rng_type *counter[2];
+  size_t i;
+  for (t = gsl_rng_types_setup(); *t != 0; t++)
+    if (strlen((*t)->name) == len && strncmp((*t)->name, name, len) == 0) return *t;
+  counter[0] = rb_gsl_rng_philox4x32;
+  counter[1] = rb_gsl_rng_threefry4x32;
+  for (i = 0; i < 2; i++)
+    if (strlen(counter[i]->name) == len && strncmp(counter[i]->name, name, len) == 0) return counter[i];
+  return NULL;
+}
+
+/* Reads one generator at *p and advances *p past it. Everything is
+   checked before the generator is allocated. */
+gsl_rng* rb_gsl_rng_load_from(const char **p, const char *end)
+{
+  const unsigned char *head = (const unsigned char *) *p;
+  const gsl_rng_type *T;
+  const char *name;
+  size_t len, size;
+  gsl_rng *r;
+  if (end - *p < 8 || memcmp(head, RB_GSL_RNG_DUMP_MAGIC, 4) != 0)
+    rb_raise(rb_eArgError, "not a GSL::Rng dump");
+  if (head[4] != RB_GSL_RNG_DUMP_VERSION)
+    rb_raise(rb_eArgError, "unsupported GSL::Rng dump version %d", (int) head[4]);
+  if (head[5] != rb_gsl_rng_big_endian() || head[6] != sizeof(long))
+    rb_raise(rb_eArgError, "GSL::Rng dump from a host with a different byte order or size of long");
+  len = head[7];
+  *p += 8;
+  if ((size_t) (end - *p) < len) rb_raise(rb_eArgError, "truncated GSL::Rng dump");
+  name = *p;
+  *p += len;
+  T = rb_gsl_rng_type_exact(name, len);
+  if (T == NULL) rb_raise(rb_eArgError, "unknown generator type %.*s", (int) len, name);
+  size = rb_gsl_rng_dump_get_u32(p, end);
+  if (size != T->size)
+    rb_raise(rb_eArgError, "%s state has %d bytes (%d expected)", T->name, (int) size, (int) T->size);
+  if ((size_t) (end - *p) < size) rb_raise(rb_eArgError, "truncated GSL::Rng dump");
+  r = gsl_rng_alloc(T);
+  memcpy(gsl_rng_state(r), *p, size);
+  *p += size;
+  return r;
+}
+
+/*
+  Document-method: <i>GSL::Rng#dump</i>
+    Returns the type and state of the generator as a binary String.
+*/
+static VALUE rb_gsl_rng_dump(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_rng *r = NULL;
+  VALUE str;
+  Data_Get_Struct(obj, gsl_rng, r);
+  str = rb_str_buf_new(16 + gsl_rng_size(r));
+  rb_gsl_rng_dump_to(str, r);
+  return str;
+}
+
+/*
+  Document-method: <i>GSL::Rng.load</i>
+    Creates a generator from a String made by GSL::Rng#dump.
+*/
+static VALUE rb_gsl_rng_load(VALUE klass, VALUE str)
+{
+  const char *p, *end;
+  gsl_rng *r;
+  StringValue(str);
+  p = RSTRING_PTR(str);
+  end = p + RSTRING_LEN(str);
+  r = rb_gsl_rng_load_from(&p, end);
+  if (p != end) {
+    gsl_rng_free(r);
+    rb_raise(rb_eArgError, "trailing bytes after the GSL::Rng dump");
+  }
+  return Data_Wrap_Struct(klass, 0, gsl_rng_free, r);
+}
+
+void Init_gsl_rng_counter(VALUE module);
+
 void Init_gsl_rng(VALUE module)
 {
   cgsl_rng = rb_define_class_under(module, "Rng", cGSL_Object);
@@ -592,4 +743,11 @@ void Init_gsl_rng(VALUE module)
   rb_define_method(cgsl_rng, "fwrite", rb_gsl_rng_fwrite, 1);
   rb_define_method(cgsl_rng, "fread", rb_gsl_rng_fread, 1);
   rb_define_singleton_method(cgsl_rng, "memcpy", rb_gsl_rng_memcpy, 2);
+
+  rb_define_method(cgsl_rng, "dump", rb_gsl_rng_dump, -1);
+  rb_define_method(cgsl_rng, "_dump", rb_gsl_rng_dump, -1);
+  rb_define_singleton_method(cgsl_rng, "load", rb_gsl_rng_load, 1);
+  rb_define_singleton_method(cgsl_rng, "_load", rb_gsl_rng_load, 1);
+
+  Init_gsl_rng_counter(module);
 }
@@ -0,0 +1,323 @@
+/*
+  rng_counter.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Counter-based generators Philox4x32-10 and Threefry4x32-20
+  (Salmon, Moraes, Dror and Shaw, "Parallel random numbers: as easy as
+  1, 2, 3", SC11). The n-th output block is a keyed bijection of the
+  128 bit counter (block, stream), so the generator can jump to any
+  position in O(1), and streams with distinct stream ids never overlap.
+
+  The seed gives the key. The counter holds the 64 bit block number in
+  words 0-1 and the 64 bit stream id in words 2-3. A generator owns the
+  stream ids (stream, stream + span]; split(n) deals them out in n equal
+  contiguous ranges, so the children of any sequence of splits are
+  disjoint from each other and from their ancestors.
+*/
+
+#include "include/rb_gsl_rng.h"
+#include <stdint.h>
+
+typedef struct {
+  uint32_t key[4];
+  uint64_t block;      /* next block to compute */
+  uint64_t stream;
+  uint64_t span;       /* stream ids (stream, stream + span] are free for split */
+  uint32_t out[4];
+  unsigned int idx;    /* next word of out, 4 if none left */
+} rb_gsl_rng_counter_state;
+
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+
+static void philox4x32_10(const uint32_t *ctr, const uint32_t *key, uint32_t *out)
+{
+  uint32_t x0 = ctr[0], x1 = ctr[1], x2 = ctr[2], x3 = ctr[3];
+  uint32_t k0 = key[0], k1 = key[1];
+  uint64_t p0, p1;
+  int r;
+  for (r = 0; r < 10; r++) {
+    p0 = (uint64_t) PHILOX_M0 * x0;
+    p1 = (uint64_t) PHILOX_M1 * x2;
+    x0 = (uint32_t) (p1 >> 32) ^ x1 ^ k0;
+    x2 = (uint32_t) (p0 >> 32) ^ x3 ^ k1;
+    x1 = (uint32_t) p1;
+    x3 = (uint32_t) p0;
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+  out[0] = x0; out[1] = x1; out[2] = x2; out[3] = x3;
+}
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static const int threefry4x32_rot[8][2] = {
+  {10, 26}, {11, 21}, {13, 27}, {23, 5}, {6, 20}, {17, 11}, {25, 10}, {18, 20}
+};
+
+static void threefry4x32_20(const uint32_t *ctr, const uint32_t *key, uint32_t *out)
+{
+  uint32_t ks[5], x[4];
+  int r, i, s;
+  ks[4] = 0x1BD11BDAU;
+  for (i = 0; i < 4; i++) {
+    ks[i] = key[i];
+    ks[4] ^= key[i];
+    x[i] = ctr[i] + key[i];
+  }
+  for (r = 0; r < 20; r++) {
+    if (r % 2 == 0) {
+      x[0] += x[1]; x[1] = ROTL32(x[1], threefry4x32_rot[r % 8][0]); x[1] ^= x[0];
+      x[2] += x[3]; x[3] = ROTL32(x[3], threefry4x32_rot[r % 8][1]); x[3] ^= x[2];
+    } else {
+      x[0] += x[3]; x[3] = ROTL32(x[3], threefry4x32_rot[r % 8][0]); x[3] ^= x[0];
+      x[2] += x[1]; x[1] = ROTL32(x[1], threefry4x32_rot[r % 8][1]); x[1] ^= x[2];
+    }
+    if (r % 4 == 3) {
+      s = (r + 1) / 4;
+      for (i = 0; i < 4; i++) x[i] += ks[(s + i) % 5];
+      x[3] += (uint32_t) s;
+    }
+  }
+  for (i = 0; i < 4; i++) out[i] = x[i];
+}
+
+static void counter_fill(rb_gsl_rng_counter_state *s,
+                         void (*cipher)(const uint32_t*, const uint32_t*, uint32_t*))
+{
+  uint32_t ctr[4];
+  ctr[0] = (uint32_t) s->block;
+  ctr[1] = (uint32_t) (s->block >> 32);
+  ctr[2] = (uint32_t) s->stream;
+  ctr[3] = (uint32_t) (s->stream >> 32);
+  (*cipher)(ctr, s->key, s->out);
+  s->block++;
+  s->idx = 0;
+}
+
+static void counter_set(void *vstate, unsigned long int seed)
+{
+  rb_gsl_rng_counter_state *s = (rb_gsl_rng_counter_state *) vstate;
+  memset(s, 0, sizeof(rb_gsl_rng_counter_state));
+  s->key[0] = (uint32_t) (seed & 0xffffffffUL);
+  s->key[1] = (uint32_t) ((seed >> 16) >> 16);
+  s->span = UINT64_MAX;
+  s->idx = 4;
+}
+
+static unsigned long int philox4x32_get(void *vstate)
+{
+  rb_gsl_rng_counter_state *s = (rb_gsl_rng_counter_state *) vstate;
+  if (s->idx == 4) counter_fill(s, philox4x32_10);
+  return s->out[s->idx++];
+}
+
+static double philox4x32_get_double(void *vstate)
+{
+  return philox4x32_get(vstate) / 4294967296.0;
+}
+
+static unsigned long int threefry4x32_get(void *vstate)
+{
+  rb_gsl_rng_counter_state *s = (rb_gsl_rng_counter_state *) vstate;
+  if (s->idx == 4) counter_fill(s, threefry4x32_20);
+  return s->out[s->idx++];
+}
+
+static double threefry4x32_get_double(void *vstate)
+{
+  return threefry4x32_get(vstate) / 4294967296.0;
+}
+
+static const gsl_rng_type philox4x32_type = {
+  "philox4x32", 0xffffffffUL, 0, sizeof(rb_gsl_rng_counter_state),
+  &counter_set, &philox4x32_get, &philox4x32_get_double
+};
+
+static const gsl_rng_type threefry4x32_type = {
+  "threefry4x32", 0xffffffffUL, 0, sizeof(rb_gsl_rng_counter_state),
+  &counter_set, &threefry4x32_get, &threefry4x32_get_double
+};
+
+const gsl_rng_type *rb_gsl_rng_philox4x32 = &philox4x32_type;
+const gsl_rng_type *rb_gsl_rng_threefry4x32 = &threefry4x32_type;
+
+/*****/
+
+int rb_gsl_rng_counter_p(const gsl_rng *r)
+{
+  return r->type == &philox4x32_type || r->type == &threefry4x32_type;
+}
+
+/* Skips the next k outputs of r in O(1) */
+void rb_gsl_rng_counter_jump(gsl_rng *r, unsigned long long k)
+{
+  rb_gsl_rng_counter_state *s = (rb_gsl_rng_counter_state *) r->state;
+  uint64_t pos;
+  pos = (s->idx == 4) ? s->block * 4 : (s->block - 1) * 4 + s->idx;
+  pos += k;
+  s->block = pos / 4;
+  s->idx = 4;
+  if (pos % 4 != 0) {
+    counter_fill(s, r->type == &philox4x32_type ? philox4x32_10 : threefry4x32_20);
+    s->idx = (unsigned int) (pos % 4);
+  }
+}
+
+/*
+  Sets child, a generator of the same type as r, to the i-th of n
+  substreams of r, positioned at its start.
+*/
+int rb_gsl_rng_counter_split(const gsl_rng *r, size_t n, size_t i, gsl_rng *child)
+{
+  const rb_gsl_rng_counter_state *s = (const rb_gsl_rng_counter_state *) r->state;
+  rb_gsl_rng_counter_state *c = (rb_gsl_rng_counter_state *) child->state;
+  uint64_t w;
+  if (child->type != r->type) GSL_ERROR("generators must be of the same type", GSL_EINVAL);
+  if (n == 0 || i >= n) GSL_ERROR("substream index out of range", GSL_EINVAL);
+  w = s->span / n;
+  if (w == 0) GSL_ERROR("no substreams left to split", GSL_EINVAL);
+  memcpy(c->key, s->key, sizeof(s->key));
+  c->stream = s->stream + 1 + (uint64_t) i * w;
+  c->span = w - 1;
+  c->block = 0;
+  c->idx = 4;
+  return GSL_SUCCESS;
+}
+
+/*
+  Writes the next n values of gsl_rng_uniform(r) to x[0], x[stride], ...
+  A whole block of four outputs is converted at a time.
+*/
+void rb_gsl_rng_counter_uniform(gsl_rng *r, double *x, size_t stride, size_t n)
+{
+  rb_gsl_rng_counter_state *s = (rb_gsl_rng_counter_state *) r->state;
+  void (*cipher)(const uint32_t*, const uint32_t*, uint32_t*);
+  size_t i = 0, k;
+  cipher = (r->type == &philox4x32_type) ? philox4x32_10 : threefry4x32_20;
+  while (i < n && s->idx < 4) x[stride * i++] = s->out[s->idx++] / 4294967296.0;
+  for (; i + 4 <= n; i += 4) {
+    counter_fill(s, cipher);
+    for (k = 0; k < 4; k++) x[stride * (i + k)] = s->out[k] / 4294967296.0;
+    s->idx = 4;
+  }
+  if (i < n) {
+    counter_fill(s, cipher);
+    while (i < n) x[stride * i++] = s->out[s->idx++] / 4294967296.0;
+  }
+}
+
+unsigned long long rb_gsl_rng_counter_stream(const gsl_rng *r)
+{
+  return ((const rb_gsl_rng_counter_state *) r->state)->stream;
+}
+
+/*****/
+
+static gsl_rng* get_counter_rng(VALUE obj)
+{
+  gsl_rng *r = NULL;
+  CHECK_RNG(obj);
+  Data_Get_Struct(obj, gsl_rng, r);
+  if (!rb_gsl_rng_counter_p(r))
+    rb_raise(rb_eTypeError, "%s is not a counter-based generator (philox4x32 or threefry4x32 expected)",
+             gsl_rng_name(r));
+  return r;
+}
+
+/*
+  Substream generators for the parallel drivers: sets r[0, n) to the
+  children of the counter-based generator given as :rng in opts, or of
+  philox4x32 seeded with :seed. Each child is owned by a GSL::Rng, so
+  that Ruby code may keep it; the objects are pushed to holder and, if
+  vr is not NULL, stored in vr[0, n).
+*/
+void rb_gsl_rng_counter_streams(VALUE opts, size_t n, gsl_rng **r, VALUE *vr, VALUE holder)
+{
+  gsl_rng *base;
+  VALUE vbase = rb_gsl_hash_get(opts, "rng"), vseed = rb_gsl_hash_get(opts, "seed"), obj;
+  size_t k;
+  if (NIL_P(vbase)) {
+    base = gsl_rng_alloc(rb_gsl_rng_philox4x32);
+    rb_ary_push(holder, Data_Wrap_Struct(cgsl_rng, 0, gsl_rng_free, base));
+    gsl_rng_set(base, NIL_P(vseed) ? 0 : NUM2ULONG(vseed));
+  } else {
+    base = get_counter_rng(vbase);
+  }
+  for (k = 0; k < n; k++) {
+    r[k] = gsl_rng_alloc(base->type);
+    obj = Data_Wrap_Struct(cgsl_rng, 0, gsl_rng_free, r[k]);
+    rb_ary_push(holder, obj);
+    if (vr) vr[k] = obj;
+    if (rb_gsl_rng_counter_split(base, n, k, r[k]) != GSL_SUCCESS)
+      rb_raise(rb_eRangeError, "no substreams left to split into %d", (int) n);
+  }
+}
+
+/*
+  Document-method: <i>GSL::Rng#split</i>
+    Returns an array of n generators on disjoint substreams of the receiver.
+*/
+static VALUE rb_gsl_rng_split(VALUE obj, VALUE nn)
+{
+  gsl_rng *r, *child;
+  long n, i;
+  VALUE ary;
+  r = get_counter_rng(obj);
+  n = NUM2LONG(nn);
+  if (n <= 0) rb_raise(rb_eArgError, "number of substreams must be positive");
+  if (((const rb_gsl_rng_counter_state *) r->state)->span / (uint64_t) n == 0)
+    rb_raise(rb_eRangeError, "no substreams left to split into %ld", n);
+  ary = rb_ary_new2(n);
+  for (i = 0; i < n; i++) {
+    child = gsl_rng_alloc(r->type);
+    rb_gsl_rng_counter_split(r, n, i, child);
+    rb_ary_store(ary, i, Data_Wrap_Struct(CLASS_OF(obj), 0, gsl_rng_free, child));
+  }
+  return ary;
+}
+
+/*
+  Document-method: <i>GSL::Rng#jump</i>
+    Skips k outputs (1 by default) without generating them.
+*/
+static VALUE rb_gsl_rng_jump(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_rng *r;
+  r = get_counter_rng(obj);
+  switch (argc) {
+  case 0:
+    rb_gsl_rng_counter_jump(r, 1);
+    break;
+  case 1:
+    if (rb_funcall(argv[0], rb_intern("<"), 1, INT2FIX(0)) == Qtrue)
+      rb_raise(rb_eArgError, "cannot jump backwards");
+    rb_gsl_rng_counter_jump(r, NUM2ULL(argv[0]));
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+    break;
+  }
+  return obj;
+}
+
+static VALUE rb_gsl_rng_stream(VALUE obj)
+{
+  return ULL2NUM(rb_gsl_rng_counter_stream(get_counter_rng(obj)));
+}
+
+void Init_gsl_rng_counter(VALUE module)
+{
+  rb_define_method(cgsl_rng, "split", rb_gsl_rng_split, 1);
+  rb_define_method(cgsl_rng, "jump", rb_gsl_rng_jump, -1);
+  rb_define_method(cgsl_rng, "stream", rb_gsl_rng_stream, 0);
+}
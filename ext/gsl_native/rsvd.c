@@ -0,0 +1,629 @@
+/*
+  rsvd.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Truncated SVD by randomized range finding (Halko, Martinsson and Tropp,
+  SIAM Review 53, 217 (2011)), and principal component analysis built on it.
+
+  GSL::PCA can also be fitted in a single pass over row blocks: it keeps the
+  sketch Y = C Omega of the covariance C (n x l memory only) and recovers the
+  leading eigenpairs by the stabilized Nystrom approximation of Tropp et al.,
+  SIAM J. Matrix Anal. Appl. 38, 1454 (2017).
+*/
+
+#include "include/rb_gsl.h"
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_rng.h"
+#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_randist.h>
+
+static VALUE cgsl_matrix_U, cgsl_matrix_V, cgsl_vector_S;
+static VALUE cgsl_pca;
+
+/* Orthonormalizes the columns of Y in place (Gram-Schmidt, twice).
+   Numerically dependent columns are set to zero. */
+static void mygsl_matrix_orthonormalize(gsl_matrix *Y)
+{
+  size_t j, pass;
+  double nrm0, nrm;
+  gsl_vector *h = gsl_vector_alloc(Y->size2);
+  for (j = 0; j < Y->size2; j++) {
+    gsl_vector_view y = gsl_matrix_column(Y, j);
+    nrm0 = gsl_blas_dnrm2(&y.vector);
+    if (j > 0) {
+      gsl_matrix_view Q = gsl_matrix_submatrix(Y, 0, 0, Y->size1, j);
+      gsl_vector_view hj = gsl_vector_subvector(h, 0, j);
+      for (pass = 0; pass < 2; pass++) {
+        gsl_blas_dgemv(CblasTrans, 1.0, &Q.matrix, &y.vector, 0.0, &hj.vector);
+        gsl_blas_dgemv(CblasNoTrans, -1.0, &Q.matrix, &hj.vector, 1.0, &y.vector);
+      }
+    }
+    nrm = gsl_blas_dnrm2(&y.vector);
+    if (nrm <= 10.0 * GSL_DBL_EPSILON * nrm0 || nrm == 0.0) gsl_vector_set_zero(&y.vector);
+    else gsl_vector_scale(&y.vector, 1.0 / nrm);
+  }
+  gsl_vector_free(h);
+}
+
+static void mygsl_matrix_set_gaussian(gsl_matrix *m, const gsl_rng *r)
+{
+  size_t i, j;
+  for (i = 0; i < m->size1; i++)
+    for (j = 0; j < m->size2; j++) gsl_matrix_set(m, i, j, gsl_ran_gaussian(r, 1.0));
+}
+
+/*
+  Products with A - 1 mu^T, the rows of A less mu (if not NULL), without
+  forming it: Y = (A - 1 mu^T) X, and Z = (A - 1 mu^T)^T Y. h has the
+  length of the columns of X and Y.
+*/
+static void mygsl_rsvd_mul(const gsl_matrix *A, const gsl_vector *mu, const gsl_matrix *X,
+                           gsl_matrix *Y, gsl_vector *h)
+{
+  size_t i;
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, A, X, 0.0, Y);
+  if (mu == NULL) return;
+  gsl_blas_dgemv(CblasTrans, 1.0, X, mu, 0.0, h);
+  for (i = 0; i < Y->size1; i++) {
+    gsl_vector_view y = gsl_matrix_row(Y, i);
+    gsl_vector_sub(&y.vector, h);
+  }
+}
+
+static void mygsl_rsvd_mul_trans(const gsl_matrix *A, const gsl_vector *mu, const gsl_matrix *Y,
+                                 gsl_matrix *Z, gsl_vector *h)
+{
+  size_t i;
+  gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, A, Y, 0.0, Z);
+  if (mu == NULL) return;
+  gsl_vector_set_zero(h);
+  for (i = 0; i < Y->size1; i++) {
+    gsl_vector_const_view y = gsl_matrix_const_row(Y, i);
+    gsl_vector_add(h, &y.vector);
+  }
+  gsl_blas_dger(-1.0, mu, h, Z);
+}
+
+/*
+  Rank-k approximation A - 1 mu^T ~ U diag(S) V^T of the m x n matrix A
+  with the rows centered on mu (or A itself if mu is NULL), with l = k + p
+  random samples (p: oversampling) and q power iterations.
+  U is m x k, V is n x k, S has length k, with k <= min(m, n).
+*/
+static int mygsl_linalg_rsvd_centered(const gsl_matrix *A, const gsl_vector *mu,
+                                      size_t k, size_t p, size_t q, const gsl_rng *r,
+                                      gsl_matrix *U, gsl_matrix *V, gsl_vector *S)
+{
+  size_t m = A->size1, n = A->size2, l, i;
+  gsl_matrix *Omega = NULL, *Y = NULL, *Z = NULL, *Vb = NULL;
+  gsl_vector *s = NULL, *work = NULL, *h = NULL;
+  l = GSL_MIN(k + p, GSL_MIN(m, n));
+  Omega = gsl_matrix_alloc(n, l);
+  Y = gsl_matrix_alloc(m, l);
+  Z = gsl_matrix_alloc(n, l);
+  h = gsl_vector_alloc(l);
+  mygsl_matrix_set_gaussian(Omega, r);
+  mygsl_rsvd_mul(A, mu, Omega, Y, h);
+  mygsl_matrix_orthonormalize(Y);
+  for (i = 0; i < q; i++) {
+    mygsl_rsvd_mul_trans(A, mu, Y, Z, h);
+    mygsl_matrix_orthonormalize(Z);
+    mygsl_rsvd_mul(A, mu, Z, Y, h);
+    mygsl_matrix_orthonormalize(Y);
+  }
+  /* Z = (Q^T A)^T = Ub diag(s) Vb^T, so A ~ (Q Vb) diag(s) Ub^T */
+  mygsl_rsvd_mul_trans(A, mu, Y, Z, h);
+  Vb = gsl_matrix_alloc(l, l);
+  s = gsl_vector_alloc(l);
+  work = gsl_vector_alloc(l);
+  gsl_linalg_SV_decomp(Z, Vb, s, work);
+  {
+    gsl_matrix_view Vbk = gsl_matrix_submatrix(Vb, 0, 0, l, k);
+    gsl_matrix_view Zk = gsl_matrix_submatrix(Z, 0, 0, n, k);
+    gsl_vector_view sk = gsl_vector_subvector(s, 0, k);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, Y, &Vbk.matrix, 0.0, U);
+    gsl_matrix_memcpy(V, &Zk.matrix);
+    gsl_vector_memcpy(S, &sk.vector);
+  }
+  gsl_vector_free(h);
+  gsl_vector_free(work);
+  gsl_vector_free(s);
+  gsl_matrix_free(Vb);
+  gsl_matrix_free(Z);
+  gsl_matrix_free(Y);
+  gsl_matrix_free(Omega);
+  return GSL_SUCCESS;
+}
+
+/*
+  Rank-k approximation A ~ U diag(S) V^T of the m x n matrix A, with l = k + p
+  random samples (p: oversampling) and q power iterations.
+  U is m x k, V is n x k, S has length k, with k <= min(m, n).
+*/
+int mygsl_linalg_rsvd(const gsl_matrix *A, size_t k, size_t p, size_t q, const gsl_rng *r,
+                      gsl_matrix *U, gsl_matrix *V, gsl_vector *S)
+{
+  return mygsl_linalg_rsvd_centered(A, NULL, k, p, q, r, U, V, S);
+}
+
+static void rb_gsl_rsvd_options(VALUE opts, size_t *p, size_t *q, gsl_rng **r)
+{
+  VALUE val;
+  if (!NIL_P(opts)) Check_Type(opts, T_HASH);
+  if (!NIL_P(val = rb_gsl_hash_get(opts, "oversample"))) *p = NUM2ULONG(val);
+  if (!NIL_P(val = rb_gsl_hash_get(opts, "power_iter"))) *q = NUM2ULONG(val);
+  if (!NIL_P(val = rb_gsl_hash_get(opts, "rng"))) {
+    CHECK_RNG(val);
+    Data_Get_Struct(val, gsl_rng, *r);
+  }
+}
+
+/*
+  GSL::Linalg::SV.rdecomp(A, k, opts = {}), GSL::Matrix#SV_rdecomp(k, opts = {})
+  opts: :oversample (10), :power_iter (2), :rng
+*/
+static VALUE rb_gsl_linalg_SV_rdecomp(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_matrix *A = NULL, *U = NULL, *V = NULL;
+  gsl_vector *S = NULL;
+  gsl_rng *r = NULL, *rtmp = NULL;
+  size_t k, p = 10, q = 2;
+  VALUE opts = Qnil;
+  switch (TYPE(obj)) {
+  case T_MODULE:  case T_CLASS:  case T_OBJECT:
+    if (argc < 2 || argc > 3) rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+    CHECK_MATRIX(argv[0]);
+    Data_Get_Struct(argv[0], gsl_matrix, A);
+    k = FIX2INT(argv[1]);
+    if (argc == 3) opts = argv[2];
+    break;
+  default:
+    if (argc < 1 || argc > 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+    Data_Get_Struct(obj, gsl_matrix, A);
+    k = FIX2INT(argv[0]);
+    if (argc == 2) opts = argv[1];
+    break;
+  }
+  if (k < 1 || k > GSL_MIN(A->size1, A->size2))
+    rb_raise(rb_eArgError, "rank %d out of range (1..%d)", (int) k,
+             (int) GSL_MIN(A->size1, A->size2));
+  rb_gsl_rsvd_options(opts, &p, &q, &r);
+  if (r == NULL) r = rtmp = gsl_rng_alloc(gsl_rng_mt19937);
+  U = gsl_matrix_alloc(A->size1, k);
+  V = gsl_matrix_alloc(A->size2, k);
+  S = gsl_vector_alloc(k);
+  mygsl_linalg_rsvd(A, k, p, q, r, U, V, S);
+  if (rtmp) gsl_rng_free(rtmp);
+  return rb_ary_new3(3, Data_Wrap_Struct(cgsl_matrix_U, 0, gsl_matrix_free, U),
+                     Data_Wrap_Struct(cgsl_matrix_V, 0, gsl_matrix_free, V),
+                     Data_Wrap_Struct(cgsl_vector_S, 0, gsl_vector_free, S));
+}
+
+/*****/
+
+typedef struct {
+  size_t k, p, q;
+  int q_given;          /* power_iter was set, which a single pass cannot honour */
+  size_t n, l, nsamples;
+  gsl_rng *r;
+  /* streaming state */
+  gsl_matrix *Omega;    /* n x l, orthonormal test matrix */
+  gsl_matrix *Y;        /* n x l, sketch of the (shifted) scatter matrix */
+  gsl_vector *shift;    /* first row seen, for numerical stability */
+  gsl_vector *sum, *sumsq;  /* column sums of the shifted rows */
+  /* results */
+  gsl_vector *mean;
+  gsl_matrix *components;   /* n x k, principal axes as columns */
+  gsl_vector *variance;     /* k */
+  double total_variance;
+} mygsl_pca;
+
+static void mygsl_pca_reset(mygsl_pca *pca)
+{
+  if (pca->Omega) gsl_matrix_free(pca->Omega);
+  if (pca->Y) gsl_matrix_free(pca->Y);
+  if (pca->shift) gsl_vector_free(pca->shift);
+  if (pca->sum) gsl_vector_free(pca->sum);
+  if (pca->sumsq) gsl_vector_free(pca->sumsq);
+  pca->Omega = pca->Y = NULL;
+  pca->shift = pca->sum = pca->sumsq = NULL;
+  pca->nsamples = 0;
+}
+
+static void mygsl_pca_clear_results(mygsl_pca *pca)
+{
+  if (pca->mean) gsl_vector_free(pca->mean);
+  if (pca->components) gsl_matrix_free(pca->components);
+  if (pca->variance) gsl_vector_free(pca->variance);
+  pca->mean = pca->variance = NULL;
+  pca->components = NULL;
+  pca->total_variance = 0.0;
+}
+
+static void mygsl_pca_free(mygsl_pca *pca)
+{
+  mygsl_pca_reset(pca);
+  mygsl_pca_clear_results(pca);
+  gsl_rng_free(pca->r);
+  free(pca);
+}
+
+static void mygsl_pca_check_fitted(mygsl_pca *pca)
+{
+  if (pca->components == NULL) rb_raise(rb_eRuntimeError, "PCA is not fitted yet");
+}
+
+/* Batch fit: randomized SVD of the data, centered implicitly in the products */
+static void mygsl_pca_fit(mygsl_pca *pca, const gsl_matrix *X)
+{
+  size_t i, j, N = X->size1, n = X->size2, k = pca->k;
+  gsl_matrix *U = NULL;
+  gsl_vector *S = NULL;
+  double x, ss = 0.0;
+  if (k > GSL_MIN(N, n))
+    rb_raise(rb_eArgError, "%d components requested for a %d x %d matrix", (int) k, (int) N, (int) n);
+  mygsl_pca_reset(pca);
+  mygsl_pca_clear_results(pca);
+  pca->n = n;
+  pca->nsamples = N;
+  pca->mean = gsl_vector_calloc(n);
+  for (i = 0; i < N; i++)
+    for (j = 0; j < n; j++) pca->mean->data[j] += gsl_matrix_get(X, i, j);
+  gsl_vector_scale(pca->mean, 1.0 / N);
+  for (i = 0; i < N; i++) {
+    for (j = 0; j < n; j++) {
+      x = gsl_matrix_get(X, i, j) - gsl_vector_get(pca->mean, j);
+      ss += x * x;
+    }
+  }
+  U = gsl_matrix_alloc(N, k);
+  S = gsl_vector_alloc(k);
+  pca->components = gsl_matrix_alloc(n, k);
+  pca->variance = gsl_vector_alloc(k);
+  mygsl_linalg_rsvd_centered(X, pca->mean, k, pca->p, pca->q, pca->r, U, pca->components, S);
+  for (i = 0; i < k; i++)
+    gsl_vector_set(pca->variance, i, gsl_pow_2(gsl_vector_get(S, i)) / GSL_MAX(N - 1, 1));
+  pca->total_variance = ss / GSL_MAX(N - 1, 1);
+  gsl_vector_free(S);
+  gsl_matrix_free(U);
+}
+
+/* Streaming fit: accumulates a row block into the sketch */
+static void mygsl_pca_update(mygsl_pca *pca, const gsl_matrix *B)
+{
+  size_t i, j, b = B->size1, n = B->size2;
+  gsl_matrix *Bc = NULL, *T = NULL;
+  double x;
+  if (pca->q_given)
+    rb_raise(rb_eArgError, "power_iter needs several passes over the data, use fit");
+  if (b == 0) return;
+  if (pca->Y == NULL) {
+    if (pca->k > n) rb_raise(rb_eArgError, "%d components requested for %d columns", (int) pca->k, (int) n);
+    mygsl_pca_clear_results(pca);
+    pca->n = n;
+    pca->l = GSL_MIN(pca->k + pca->p, n);
+    pca->Omega = gsl_matrix_alloc(n, pca->l);
+    mygsl_matrix_set_gaussian(pca->Omega, pca->r);
+    mygsl_matrix_orthonormalize(pca->Omega);
+    pca->Y = gsl_matrix_calloc(n, pca->l);
+    pca->shift = gsl_vector_alloc(n);
+    for (j = 0; j < n; j++) gsl_vector_set(pca->shift, j, gsl_matrix_get(B, 0, j));
+    pca->sum = gsl_vector_calloc(n);
+    pca->sumsq = gsl_vector_calloc(n);
+  } else if (n != pca->n) {
+    rb_raise(rb_eRangeError, "row block has %d columns (%d expected)", (int) n, (int) pca->n);
+  }
+  Bc = gsl_matrix_alloc(b, n);
+  for (i = 0; i < b; i++) {
+    for (j = 0; j < n; j++) {
+      x = gsl_matrix_get(B, i, j) - gsl_vector_get(pca->shift, j);
+      gsl_matrix_set(Bc, i, j, x);
+      pca->sum->data[j] += x;
+      pca->sumsq->data[j] += x * x;
+    }
+  }
+  T = gsl_matrix_alloc(b, pca->l);
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, Bc, pca->Omega, 0.0, T);
+  gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, Bc, T, 1.0, pca->Y);
+  pca->nsamples += b;
+  gsl_matrix_free(T);
+  gsl_matrix_free(Bc);
+}
+
+/* Leading eigenpairs of the covariance from its sketch (Nystrom) */
+static void mygsl_pca_finish(mygsl_pca *pca)
+{
+  size_t n = pca->n, l = pca->l, k = pca->k, N = pca->nsamples, i, j;
+  gsl_matrix *Yc = NULL, *B = NULL, *Ve = NULL;
+  gsl_vector *mu = NULL, *muO = NULL, *s = NULL, *work = NULL;
+  double nu, lambda, scale, total = 0.0;
+  if (pca->Y == NULL) rb_raise(rb_eRuntimeError, "no data");
+  if (N < 2) rb_raise(rb_eRuntimeError, "at least two samples are needed");
+  mu = gsl_vector_alloc(n);
+  gsl_vector_memcpy(mu, pca->sum);
+  gsl_vector_scale(mu, 1.0 / N);
+  /* C Omega = (Y - N mu (mu^T Omega)) / (N - 1) */
+  muO = gsl_vector_alloc(l);
+  gsl_blas_dgemv(CblasTrans, 1.0, pca->Omega, mu, 0.0, muO);
+  Yc = make_matrix_clone(pca->Y);
+  gsl_blas_dger(-(double) N, mu, muO, Yc);
+  scale = 1.0 / (N - 1);
+  gsl_matrix_scale(Yc, scale);
+  for (j = 0; j < n; j++)
+    total += (gsl_vector_get(pca->sumsq, j) - N * gsl_pow_2(gsl_vector_get(mu, j))) * scale;
+  /* shift by nu for a stable Cholesky factorization */
+  {
+    gsl_vector_view yv = gsl_vector_view_array(Yc->data, n * l);
+    nu = sqrt((double) n) * GSL_DBL_EPSILON * gsl_blas_dnrm2(&yv.vector);
+  }
+  if (nu == 0.0) nu = GSL_DBL_MIN;
+  gsl_matrix_scale(pca->Omega, nu);
+  gsl_matrix_add(Yc, pca->Omega);
+  gsl_matrix_scale(pca->Omega, 1.0 / nu);
+  B = gsl_matrix_alloc(l, l);
+  gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, pca->Omega, Yc, 0.0, B);
+  for (i = 0; i < l; i++) {
+    for (j = 0; j < i; j++) {
+      double b = 0.5 * (gsl_matrix_get(B, i, j) + gsl_matrix_get(B, j, i));
+      gsl_matrix_set(B, i, j, b);
+      gsl_matrix_set(B, j, i, b);
+    }
+  }
+  gsl_linalg_cholesky_decomp(B);
+  /* E = Yc L^{-T} */
+  gsl_blas_dtrsm(CblasRight, CblasLower, CblasTrans, CblasNonUnit, 1.0, B, Yc);
+  Ve = gsl_matrix_alloc(l, l);
+  s = gsl_vector_alloc(l);
+  work = gsl_vector_alloc(l);
+  gsl_linalg_SV_decomp(Yc, Ve, s, work);
+  mygsl_pca_clear_results(pca);
+  pca->components = gsl_matrix_alloc(n, k);
+  pca->variance = gsl_vector_alloc(k);
+  pca->mean = gsl_vector_alloc(n);
+  {
+    gsl_matrix_view Ek = gsl_matrix_submatrix(Yc, 0, 0, n, k);
+    gsl_matrix_memcpy(pca->components, &Ek.matrix);
+  }
+  for (i = 0; i < k; i++) {
+    lambda = gsl_pow_2(gsl_vector_get(s, i)) - nu;
+    gsl_vector_set(pca->variance, i, GSL_MAX(lambda, 0.0));
+  }
+  gsl_vector_memcpy(pca->mean, pca->shift);
+  gsl_vector_add(pca->mean, mu);
+  pca->total_variance = GSL_MAX(total, 0.0);
+  gsl_vector_free(work);
+  gsl_vector_free(s);
+  gsl_matrix_free(Ve);
+  gsl_matrix_free(B);
+  gsl_matrix_free(Yc);
+  gsl_vector_free(muO);
+  gsl_vector_free(mu);
+}
+
+/*
+  GSL::PCA.new(k, opts = {})
+  opts: :oversample (10), :power_iter (2, fit only), :seed
+*/
+static VALUE rb_gsl_pca_new(int argc, VALUE *argv, VALUE klass)
+{
+  mygsl_pca *pca = NULL;
+  VALUE opts = Qnil, val;
+  gsl_rng *r = NULL;
+  switch (argc) {
+  case 2:
+    opts = argv[1];
+    /* no break */
+  case 1:
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  }
+  pca = ALLOC(mygsl_pca);
+  memset(pca, 0, sizeof(mygsl_pca));
+  pca->k = FIX2INT(argv[0]);
+  pca->p = 10;
+  pca->q = 2;
+  if (pca->k < 1) {
+    free(pca);
+    rb_raise(rb_eArgError, "number of components must be positive");
+  }
+  rb_gsl_rsvd_options(opts, &pca->p, &pca->q, &r);
+  pca->q_given = !NIL_P(rb_gsl_hash_get(opts, "power_iter"));
+  pca->r = gsl_rng_alloc(gsl_rng_mt19937);
+  if (r) gsl_rng_memcpy(pca->r, r);
+  if (!NIL_P(val = rb_gsl_hash_get(opts, "seed"))) gsl_rng_set(pca->r, NUM2ULONG(val));
+  return Data_Wrap_Struct(klass, 0, mygsl_pca_free, pca);
+}
+
+static VALUE rb_gsl_pca_fit(VALUE obj, VALUE mm)
+{
+  mygsl_pca *pca = NULL;
+  gsl_matrix *X = NULL;
+  Data_Get_Struct(obj, mygsl_pca, pca);
+  CHECK_MATRIX(mm);
+  Data_Get_Matrix(mm, X);
+  mygsl_pca_fit(pca, X);
+  return obj;
+}
+
+/* PCA#update(block), accumulates a row block (Matrix or Vector) */
+static VALUE rb_gsl_pca_update(VALUE obj, VALUE mm)
+{
+  mygsl_pca *pca = NULL;
+  gsl_matrix *B = NULL;
+  gsl_vector *v = NULL;
+  Data_Get_Struct(obj, mygsl_pca, pca);
+  if (VECTOR_P(mm)) {
+    Data_Get_Vector(mm, v);
+    B = gsl_matrix_alloc(1, v->size);
+    gsl_matrix_set_row(B, 0, v);
+    mygsl_pca_update(pca, B);
+    gsl_matrix_free(B);
+  } else {
+    CHECK_MATRIX(mm);
+    Data_Get_Matrix(mm, B);
+    mygsl_pca_update(pca, B);
+  }
+  return obj;
+}
+
+static VALUE rb_gsl_pca_finish(VALUE obj)
+{
+  mygsl_pca *pca = NULL;
+  Data_Get_Struct(obj, mygsl_pca, pca);
+  mygsl_pca_finish(pca);
+  return obj;
+}
+
+static VALUE rb_gsl_pca_stream_i(RB_BLOCK_CALL_FUNC_ARGLIST(block, obj))
+{
+  return rb_gsl_pca_update(obj, block);
+}
+
+/* PCA#fit_stream(enum), one pass over the row blocks yielded by enum.each */
+static VALUE rb_gsl_pca_fit_stream(VALUE obj, VALUE en)
+{
+  mygsl_pca *pca = NULL;
+  Data_Get_Struct(obj, mygsl_pca, pca);
+  mygsl_pca_reset(pca);
+  rb_block_call(en, rb_intern("each"), 0, NULL, rb_gsl_pca_stream_i, obj);
+  mygsl_pca_finish(pca);
+  return obj;
+}
+
+static VALUE rb_gsl_pca_components(VALUE obj)
+{
+  mygsl_pca *pca = NULL;
+  Data_Get_Struct(obj, mygsl_pca, pca);
+  mygsl_pca_check_fitted(pca);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, make_matrix_clone(pca->components));
+}
+
+static VALUE rb_gsl_pca_explained_variance(VALUE obj)
+{
+  mygsl_pca *pca = NULL;
+  Data_Get_Struct(obj, mygsl_pca, pca);
+  mygsl_pca_check_fitted(pca);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, make_vector_clone(pca->variance));
+}
+
+static VALUE rb_gsl_pca_explained_variance_ratio(VALUE obj)
+{
+  mygsl_pca *pca = NULL;
+  gsl_vector *v = NULL;
+  Data_Get_Struct(obj, mygsl_pca, pca);
+  mygsl_pca_check_fitted(pca);
+  v = make_vector_clone(pca->variance);
+  if (pca->total_variance > 0.0) gsl_vector_scale(v, 1.0 / pca->total_variance);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+static VALUE rb_gsl_pca_total_variance(VALUE obj)
+{
+  mygsl_pca *pca = NULL;
+  Data_Get_Struct(obj, mygsl_pca, pca);
+  mygsl_pca_check_fitted(pca);
+  return rb_float_new(pca->total_variance);
+}
+
+static VALUE rb_gsl_pca_mean(VALUE obj)
+{
+  mygsl_pca *pca = NULL;
+  Data_Get_Struct(obj, mygsl_pca, pca);
+  mygsl_pca_check_fitted(pca);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, make_vector_clone(pca->mean));
+}
+
+static VALUE rb_gsl_pca_nsamples(VALUE obj)
+{
+  mygsl_pca *pca = NULL;
+  Data_Get_Struct(obj, mygsl_pca, pca);
+  return INT2FIX(pca->nsamples);
+}
+
+static VALUE rb_gsl_pca_k(VALUE obj)
+{
+  mygsl_pca *pca = NULL;
+  Data_Get_Struct(obj, mygsl_pca, pca);
+  return INT2FIX(pca->k);
+}
+
+/* PCA#transform(X): scores (X - mean) * components, N x k */
+static VALUE rb_gsl_pca_transform(VALUE obj, VALUE mm)
+{
+  mygsl_pca *pca = NULL;
+  gsl_matrix *X = NULL, *Xc = NULL, *Z = NULL;
+  size_t i;
+  Data_Get_Struct(obj, mygsl_pca, pca);
+  mygsl_pca_check_fitted(pca);
+  CHECK_MATRIX(mm);
+  Data_Get_Matrix(mm, X);
+  if (X->size2 != pca->n) rb_raise(rb_eRangeError, "matrix has %d columns (%d expected)", (int) X->size2, (int) pca->n);
+  Xc = make_matrix_clone(X);
+  for (i = 0; i < Xc->size1; i++) {
+    gsl_vector_view row = gsl_matrix_row(Xc, i);
+    gsl_vector_sub(&row.vector, pca->mean);
+  }
+  Z = gsl_matrix_alloc(X->size1, pca->k);
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, Xc, pca->components, 0.0, Z);
+  gsl_matrix_free(Xc);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, Z);
+}
+
+/* PCA#inverse_transform(Z): Z * components^T + mean */
+static VALUE rb_gsl_pca_inverse_transform(VALUE obj, VALUE mm)
+{
+  mygsl_pca *pca = NULL;
+  gsl_matrix *Z = NULL, *X = NULL;
+  size_t i;
+  Data_Get_Struct(obj, mygsl_pca, pca);
+  mygsl_pca_check_fitted(pca);
+  CHECK_MATRIX(mm);
+  Data_Get_Matrix(mm, Z);
+  if (Z->size2 != pca->k) rb_raise(rb_eRangeError, "matrix has %d columns (%d expected)", (int) Z->size2, (int) pca->k);
+  X = gsl_matrix_alloc(Z->size1, pca->n);
+  gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, Z, pca->components, 0.0, X);
+  for (i = 0; i < X->size1; i++) {
+    gsl_vector_view row = gsl_matrix_row(X, i);
+    gsl_vector_add(&row.vector, pca->mean);
+  }
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, X);
+}
+
+void Init_gsl_rsvd(VALUE module)
+{
+  VALUE mgsl_linalg_SV;
+  mgsl_linalg_SV = rb_path2class("GSL::Linalg::SV");
+  cgsl_matrix_U = rb_const_get(mgsl_linalg_SV, rb_intern("UMatrix"));
+  cgsl_matrix_V = rb_const_get(mgsl_linalg_SV, rb_intern("VMatrix"));
+  cgsl_vector_S = rb_const_get(mgsl_linalg_SV, rb_intern("SingularValues"));
+
+  rb_define_module_function(mgsl_linalg_SV, "rdecomp", rb_gsl_linalg_SV_rdecomp, -1);
+  rb_define_method(cgsl_matrix, "SV_rdecomp", rb_gsl_linalg_SV_rdecomp, -1);
+  rb_define_alias(cgsl_matrix, "rsvd", "SV_rdecomp");
+
+  cgsl_pca = rb_define_class_under(module, "PCA", cGSL_Object);
+  rb_define_singleton_method(cgsl_pca, "alloc", rb_gsl_pca_new, -1);
+  rb_define_singleton_method(cgsl_pca, "new", rb_gsl_pca_new, -1);
+  rb_define_method(cgsl_pca, "fit", rb_gsl_pca_fit, 1);
+  rb_define_method(cgsl_pca, "update", rb_gsl_pca_update, 1);
+  rb_define_alias(cgsl_pca, "<<", "update");
+  rb_define_method(cgsl_pca, "finish", rb_gsl_pca_finish, 0);
+  rb_define_method(cgsl_pca, "fit_stream", rb_gsl_pca_fit_stream, 1);
+  rb_define_method(cgsl_pca, "components", rb_gsl_pca_components, 0);
+  rb_define_method(cgsl_pca, "explained_variance", rb_gsl_pca_explained_variance, 0);
+  rb_define_method(cgsl_pca, "explained_variance_ratio", rb_gsl_pca_explained_variance_ratio, 0);
+  rb_define_method(cgsl_pca, "total_variance", rb_gsl_pca_total_variance, 0);
+  rb_define_method(cgsl_pca, "mean", rb_gsl_pca_mean, 0);
+  rb_define_method(cgsl_pca, "nsamples", rb_gsl_pca_nsamples, 0);
+  rb_define_method(cgsl_pca, "k", rb_gsl_pca_k, 0);
+  rb_define_method(cgsl_pca, "transform", rb_gsl_pca_transform, 1);
+  rb_define_method(cgsl_pca, "inverse_transform", rb_gsl_pca_inverse_transform, 1);
+}
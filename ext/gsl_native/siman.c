@@ -88,6 +88,7 @@ static siman_Efunc* siman_Efunc_alloc()
   siman_Efunc *se = NULL;
   se = ALLOC(siman_Efunc);
   se->siman_Efunc_t = rb_gsl_siman_Efunc_t;
+  se->proc = Qnil;
   return se;
 }
 
@@ -140,6 +141,13 @@ static VALUE rb_gsl_siman_Efunc_set(int argc, VALUE *argv, VALUE obj)
   return obj;
 }
 
+static VALUE rb_gsl_siman_Efunc_proc(VALUE obj)
+{
+  siman_Efunc *se = NULL;
+  Data_Get_Struct(obj, siman_Efunc, se);
+  return se->proc;
+}
+
 /***** siman_copy *****/
 static void rb_gsl_siman_copy_t(void *source, void *dest);
 static void* rb_gsl_siman_copy_construct_t(void *data);
@@ -261,6 +269,7 @@ static siman_step* siman_step_alloc()
   siman_step *se = NULL;
   se = ALLOC(siman_step);
   se->siman_step_t = rb_gsl_siman_step_t;
+  se->proc = Qnil;
   return se;
 }
 
@@ -313,6 +322,13 @@ static VALUE rb_gsl_siman_step_set(int argc, VALUE *argv, VALUE obj)
   return obj;
 }
 
+static VALUE rb_gsl_siman_step_proc(VALUE obj)
+{
+  siman_step *se = NULL;
+  Data_Get_Struct(obj, siman_step, se);
+  return se->proc;
+}
+
 /***** siman_metric *****/
 typedef struct ___siman_metric {
   double (*siman_metric_t)(void *, void *);
@@ -647,6 +663,8 @@ static VALUE rb_gsl_siman_solver_solve(VALUE obj, VALUE rng,
   return obj;
 }
 
+void Init_gsl_siman_parallel(VALUE module);
+
 void Init_gsl_siman(VALUE module)
 {
   VALUE mgsl_siman;
@@ -664,6 +682,7 @@ void Init_gsl_siman(VALUE module)
   rb_define_singleton_method(cgsl_siman_Efunc, "alloc", rb_gsl_siman_Efunc_new, -1);
   rb_define_method(cgsl_siman_Efunc, "set", rb_gsl_siman_Efunc_set, -1);
   rb_define_alias(cgsl_siman_Efunc, "set_proc", "set");
+  rb_define_method(cgsl_siman_Efunc, "proc", rb_gsl_siman_Efunc_proc, 0);
 
   /***** Print *****/
   rb_define_singleton_method(cgsl_siman_print, "alloc", rb_gsl_siman_print_new, -1);
@@ -673,6 +692,7 @@ void Init_gsl_siman(VALUE module)
   rb_define_singleton_method(cgsl_siman_step, "alloc", rb_gsl_siman_step_new, -1);
   rb_define_method(cgsl_siman_step, "set", rb_gsl_siman_step_set, -1);
   rb_define_alias(cgsl_siman_step, "set_proc", "set");
+  rb_define_method(cgsl_siman_step, "proc", rb_gsl_siman_step_proc, 0);
 
   rb_define_singleton_method(cgsl_siman_metric, "alloc", rb_gsl_siman_metric_new, -1);
   rb_define_method(cgsl_siman_metric, "set", rb_gsl_siman_metric_set, -1);
@@ -710,4 +730,6 @@ void Init_gsl_siman(VALUE module)
 
   rb_define_singleton_method(cgsl_siman_solver, "solve", rb_gsl_siman_solver_solve, 7);
   rb_define_singleton_method(mgsl_siman, "solve", rb_gsl_siman_solver_solve, 7);
+
+  Init_gsl_siman_parallel(mgsl_siman);
 }
@@ -0,0 +1,654 @@
+/*
+  siman_parallel.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Many-replica simulated annealing:
+
+  GSL::Siman.multi_solve runs independent chains on the temperature
+  schedule of a GSL::Siman::Params, like gsl_siman_solve.
+
+  GSL::Siman.parallel_tempering (replica exchange) keeps one replica at
+  each temperature of a ladder and swaps the states of neighbouring
+  temperatures with the Metropolis criterion every few sweeps.
+
+  The states are vectors of doubles. The energy is a GSL::Siman::Efunc
+  (a Ruby block, called for each state), a GSL::Siman::Efunc::Native (a
+  compiled C function) or any object responding to call, which is given
+  the proposals of all the replicas as the rows of a GSL::Matrix and
+  returns their energies. The step is a GSL::Siman::Step or Proc, a
+  GSL::Siman::Step::Native, or one of the built-in moves :uniform,
+  :gaussian, :coordinate, :swap and :flip.
+
+  Each replica draws from its own substream of a counter-based
+  generator. When both the energy and the step are native the replicas
+  run on native threads without the GVL; otherwise they advance in lock
+  step, so that a batched energy is called once per sweep. Both ways give
+  the same results.
+*/
+
+#include "include/rb_gsl.h"
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_rng.h"
+#include "include/rb_gsl_parallel.h"
+#include <gsl/gsl_siman.h>
+#include <gsl/gsl_randist.h>
+
+static VALUE cgsl_siman_Efunc_class, cgsl_siman_step_class, cgsl_siman_params_class;
+static VALUE cgsl_siman_Efunc_native, cgsl_siman_step_native;
+
+/* double E(const double *x, size_t n, void *params) */
+typedef struct {
+  double (*f)(const double *x, size_t n, void *params);
+  void *params;
+} siman_native_efunc;
+
+/* void step(const gsl_rng *r, double *x, size_t n, double step_size, void *params) */
+typedef struct {
+  void (*f)(const gsl_rng *r, double *x, size_t n, double step_size, void *params);
+  void *params;
+} siman_native_step;
+
+enum {
+  SIMAN_EVAL_NATIVE,
+  SIMAN_EVAL_EFUNC,
+  SIMAN_EVAL_BATCH,
+};
+
+enum {
+  SIMAN_STEP_NATIVE,
+  SIMAN_STEP_PROC,
+  SIMAN_STEP_UNIFORM,
+  SIMAN_STEP_GAUSSIAN,
+  SIMAN_STEP_COORDINATE,
+  SIMAN_STEP_SWAP,
+  SIMAN_STEP_FLIP,
+};
+
+typedef struct {
+  size_t nrep, n;
+  int ekind, skind;
+  const siman_native_efunc *efunc;
+  const siman_native_step *step;
+  VALUE eproc, sproc;
+  gsl_rng **r;              /* one per replica, and one for the exchanges */
+  VALUE *vr;                /* the GSL::Rng objects owning them */
+  double *x, *y, *best;     /* nrep x n */
+  double *E, *Ey, *bestE;
+  double *T, *step_size;
+  double k;
+  unsigned long *accepted, *tried;
+  /* annealing schedule */
+  double t_initial, t_min, mu_t;
+  size_t iters;
+  /* sweeps of a tempering segment */
+  size_t nsweeps;
+} siman_job;
+
+static void* siman_alloc(size_t size, VALUE holder)
+{
+  void *p = ruby_xmalloc(size > 0 ? size : 1);
+  memset(p, 0, size);
+  rb_ary_push(holder, rb_gsl_parallel_hold(p, (void (*)(void*)) ruby_xfree));
+  return p;
+}
+
+static VALUE siman_matrix_new(const double *x, size_t n1, size_t n2)
+{
+  gsl_matrix *m = gsl_matrix_alloc(n1, n2);
+  memcpy(m->data, x, n1 * n2 * sizeof(double));
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+}
+
+static VALUE siman_vector_new(const double *x, size_t n)
+{
+  gsl_vector *v = gsl_vector_alloc(n);
+  memcpy(v->data, x, n * sizeof(double));
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+}
+
+/*****/
+
+static void siman_builtin_step(const siman_job *job, size_t i, double *y)
+{
+  gsl_rng *r = job->r[i];
+  double s = job->step_size[i], tmp;
+  size_t j, a, b;
+  switch (job->skind) {
+  case SIMAN_STEP_NATIVE:
+    (*job->step->f)(r, y, job->n, s, job->step->params);
+    break;
+  case SIMAN_STEP_UNIFORM:
+    for (j = 0; j < job->n; j++) y[j] += s * (2.0 * gsl_rng_uniform(r) - 1.0);
+    break;
+  case SIMAN_STEP_GAUSSIAN:
+    for (j = 0; j < job->n; j++) y[j] += gsl_ran_gaussian(r, s);
+    break;
+  case SIMAN_STEP_COORDINATE:
+    j = gsl_rng_uniform_int(r, job->n);
+    y[j] += s * (2.0 * gsl_rng_uniform(r) - 1.0);
+    break;
+  case SIMAN_STEP_SWAP:
+    if (job->n < 2) break;
+    a = gsl_rng_uniform_int(r, job->n);
+    b = gsl_rng_uniform_int(r, job->n - 1);
+    if (b >= a) b++;
+    tmp = y[a]; y[a] = y[b]; y[b] = tmp;
+    break;
+  case SIMAN_STEP_FLIP:
+    j = gsl_rng_uniform_int(r, job->n);
+    y[j] = 1.0 - y[j];
+    break;
+  }
+}
+
+static void siman_metropolis(siman_job *job, size_t i, double ey)
+{
+  double *x = job->x + i * job->n;
+  job->tried[i]++;
+  if (!(ey < job->E[i])
+      && !(gsl_rng_uniform(job->r[i]) < exp(-(ey - job->E[i]) / (job->k * job->T[i]))))
+    return;
+  memcpy(x, job->y + i * job->n, job->n * sizeof(double));
+  job->E[i] = ey;
+  job->accepted[i]++;
+  if (ey < job->bestE[i]) {
+    job->bestE[i] = ey;
+    memcpy(job->best + i * job->n, x, job->n * sizeof(double));
+  }
+}
+
+/* Sweeps of replica i with native energy and step, without the GVL */
+static void siman_native_sweeps(siman_job *job, size_t i, size_t nsweeps)
+{
+  double *y = job->y + i * job->n;
+  size_t s;
+  for (s = 0; s < nsweeps; s++) {
+    memcpy(y, job->x + i * job->n, job->n * sizeof(double));
+    siman_builtin_step(job, i, y);
+    siman_metropolis(job, i, (*job->efunc->f)(y, job->n, job->efunc->params));
+  }
+}
+
+/* Energies of all the proposals */
+static void siman_eval(siman_job *job)
+{
+  gsl_matrix *m;
+  gsl_vector *v;
+  VALUE res;
+  size_t i;
+  switch (job->ekind) {
+  case SIMAN_EVAL_NATIVE:
+    for (i = 0; i < job->nrep; i++)
+      job->Ey[i] = (*job->efunc->f)(job->y + i * job->n, job->n, job->efunc->params);
+    break;
+  case SIMAN_EVAL_EFUNC:
+    for (i = 0; i < job->nrep; i++)
+      job->Ey[i] = NUM2DBL(rb_funcall(job->eproc, RBGSL_ID_call, 1,
+                                      siman_vector_new(job->y + i * job->n, job->n)));
+    break;
+  case SIMAN_EVAL_BATCH:
+    m = gsl_matrix_alloc(job->nrep, job->n);
+    memcpy(m->data, job->y, job->nrep * job->n * sizeof(double));
+    res = rb_funcall(job->eproc, RBGSL_ID_call, 1, Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m));
+    if (VECTOR_P(res)) {
+      Data_Get_Vector(res, v);
+      if (v->size != job->nrep)
+        rb_raise(rb_eRuntimeError, "energy returned %d values for %d states", (int) v->size, (int) job->nrep);
+      for (i = 0; i < job->nrep; i++) job->Ey[i] = gsl_vector_get(v, i);
+    } else {
+      Check_Type(res, T_ARRAY);
+      if ((size_t) RARRAY_LEN(res) != job->nrep)
+        rb_raise(rb_eRuntimeError, "energy returned %d values for %d states", (int) RARRAY_LEN(res), (int) job->nrep);
+      for (i = 0; i < job->nrep; i++) job->Ey[i] = NUM2DBL(rb_ary_entry(res, i));
+    }
+    break;
+  }
+}
+
+/* Sweeps of all the replicas in lock step, with the GVL */
+static void siman_lockstep_sweeps(siman_job *job, size_t nsweeps)
+{
+  gsl_vector *v;
+  VALUE vy;
+  size_t s, i;
+  for (s = 0; s < nsweeps; s++) {
+    memcpy(job->y, job->x, job->nrep * job->n * sizeof(double));
+    for (i = 0; i < job->nrep; i++) {
+      if (job->skind == SIMAN_STEP_PROC) {
+        /* the proc gets a vector of its own, which it may keep */
+        vy = siman_vector_new(job->y + i * job->n, job->n);
+        rb_funcall(job->sproc, RBGSL_ID_call, 3, job->vr[i], vy, rb_float_new(job->step_size[i]));
+        Data_Get_Vector(vy, v);
+        memcpy(job->y + i * job->n, v->data, job->n * sizeof(double));
+      } else {
+        siman_builtin_step(job, i, job->y + i * job->n);
+      }
+    }
+    siman_eval(job);
+    for (i = 0; i < job->nrep; i++) siman_metropolis(job, i, job->Ey[i]);
+  }
+}
+
+static int siman_native_p(const siman_job *job)
+{
+  return job->ekind == SIMAN_EVAL_NATIVE && job->skind != SIMAN_STEP_PROC;
+}
+
+/*****/
+
+static void siman_get_efunc(VALUE f, siman_job *job)
+{
+  if (rb_obj_is_kind_of(f, cgsl_siman_Efunc_native)) {
+    job->ekind = SIMAN_EVAL_NATIVE;
+    Data_Get_Struct(f, siman_native_efunc, job->efunc);
+  } else if (rb_obj_is_kind_of(f, cgsl_siman_Efunc_class)) {
+    job->ekind = SIMAN_EVAL_EFUNC;
+    job->eproc = rb_funcall(f, rb_intern("proc"), 0);
+    if (NIL_P(job->eproc)) rb_raise(rb_eArgError, "GSL::Siman::Efunc without a block");
+  } else if (rb_respond_to(f, RBGSL_ID_call)) {
+    job->ekind = SIMAN_EVAL_BATCH;
+    job->eproc = f;
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Siman::Efunc or a callable expected)",
+             rb_class2name(CLASS_OF(f)));
+  }
+}
+
+static void siman_get_step(VALUE s, siman_job *job)
+{
+  const char *name;
+  if (SYMBOL_P(s) || TYPE(s) == T_STRING) {
+    name = SYMBOL_P(s) ? rb_id2name(SYM2ID(s)) : StringValuePtr(s);
+    if (strcmp(name, "uniform") == 0) job->skind = SIMAN_STEP_UNIFORM;
+    else if (strcmp(name, "gaussian") == 0) job->skind = SIMAN_STEP_GAUSSIAN;
+    else if (strcmp(name, "coordinate") == 0) job->skind = SIMAN_STEP_COORDINATE;
+    else if (strcmp(name, "swap") == 0) job->skind = SIMAN_STEP_SWAP;
+    else if (strcmp(name, "flip") == 0) job->skind = SIMAN_STEP_FLIP;
+    else rb_raise(rb_eArgError, "unknown step %s (uniform, gaussian, coordinate, swap or flip)", name);
+  } else if (rb_obj_is_kind_of(s, cgsl_siman_step_native)) {
+    job->skind = SIMAN_STEP_NATIVE;
+    Data_Get_Struct(s, siman_native_step, job->step);
+  } else if (rb_obj_is_kind_of(s, cgsl_siman_step_class)) {
+    job->skind = SIMAN_STEP_PROC;
+    job->sproc = rb_funcall(s, rb_intern("proc"), 0);
+    if (NIL_P(job->sproc)) rb_raise(rb_eArgError, "GSL::Siman::Step without a block");
+  } else if (rb_respond_to(s, RBGSL_ID_call)) {
+    job->skind = SIMAN_STEP_PROC;
+    job->sproc = s;
+  } else {
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Siman::Step, a callable or a Symbol expected)",
+             rb_class2name(CLASS_OF(s)));
+  }
+}
+
+/* Number of replicas: the rows of x0 if it is a Matrix, else nrep */
+static size_t siman_nrep(VALUE x0, size_t nrep)
+{
+  gsl_matrix *m;
+  if (MATRIX_P(x0)) {
+    Data_Get_Struct(x0, gsl_matrix, m);
+    return m->size1;
+  }
+  return nrep;
+}
+
+/*
+  Sets up the replicas at x0 and evaluates their energies. job->nrep,
+  the energy and the step must be set.
+*/
+static void siman_job_init(siman_job *job, VALUE x0, VALUE opts, VALUE holder)
+{
+  gsl_vector *v = NULL;
+  gsl_matrix *m = NULL;
+  size_t i, j;
+  if (MATRIX_P(x0)) {
+    Data_Get_Struct(x0, gsl_matrix, m);
+    if (m->size1 != job->nrep)
+      rb_raise(rb_eArgError, "x0 has %d rows for %d replicas", (int) m->size1, (int) job->nrep);
+    job->n = m->size2;
+  } else {
+    CHECK_VECTOR(x0);
+    Data_Get_Vector(x0, v);
+    job->n = v->size;
+  }
+  if (job->n == 0) rb_raise(rb_eArgError, "empty state");
+  job->r = (gsl_rng **) siman_alloc((job->nrep + 1) * sizeof(gsl_rng*), holder);
+  job->vr = (VALUE *) siman_alloc((job->nrep + 1) * sizeof(VALUE), holder);
+  rb_gsl_rng_counter_streams(opts, job->nrep + 1, job->r, job->vr, holder);
+  job->x = (double *) siman_alloc(job->nrep * job->n * sizeof(double), holder);
+  job->y = (double *) siman_alloc(job->nrep * job->n * sizeof(double), holder);
+  job->best = (double *) siman_alloc(job->nrep * job->n * sizeof(double), holder);
+  job->E = (double *) siman_alloc(job->nrep * sizeof(double), holder);
+  job->Ey = (double *) siman_alloc(job->nrep * sizeof(double), holder);
+  job->bestE = (double *) siman_alloc(job->nrep * sizeof(double), holder);
+  job->T = (double *) siman_alloc(job->nrep * sizeof(double), holder);
+  job->step_size = (double *) siman_alloc(job->nrep * sizeof(double), holder);
+  job->accepted = (unsigned long *) siman_alloc(job->nrep * sizeof(unsigned long), holder);
+  job->tried = (unsigned long *) siman_alloc(job->nrep * sizeof(unsigned long), holder);
+  for (i = 0; i < job->nrep; i++)
+    for (j = 0; j < job->n; j++)
+      job->x[i * job->n + j] = MATRIX_P(x0) ? gsl_matrix_get(m, i, j) : gsl_vector_get(v, j);
+  memcpy(job->y, job->x, job->nrep * job->n * sizeof(double));
+  siman_eval(job);
+  memcpy(job->E, job->Ey, job->nrep * sizeof(double));
+  memcpy(job->bestE, job->Ey, job->nrep * sizeof(double));
+  memcpy(job->best, job->x, job->nrep * job->n * sizeof(double));
+}
+
+static VALUE siman_result(const siman_job *job)
+{
+  VALUE hash = rb_hash_new();
+  gsl_vector *acc;
+  size_t i, ib = 0;
+  for (i = 1; i < job->nrep; i++)
+    if (job->bestE[i] < job->bestE[ib]) ib = i;
+  acc = gsl_vector_alloc(job->nrep);
+  for (i = 0; i < job->nrep; i++)
+    gsl_vector_set(acc, i, job->tried[i] ? (double) job->accepted[i] / (double) job->tried[i] : 0.0);
+  rb_hash_aset(hash, ID2SYM(rb_intern("x")), siman_vector_new(job->best + ib * job->n, job->n));
+  rb_hash_aset(hash, ID2SYM(rb_intern("energy")), rb_float_new(job->bestE[ib]));
+  rb_hash_aset(hash, ID2SYM(rb_intern("best_x")), siman_matrix_new(job->best, job->nrep, job->n));
+  rb_hash_aset(hash, ID2SYM(rb_intern("best_energy")), siman_vector_new(job->bestE, job->nrep));
+  rb_hash_aset(hash, ID2SYM(rb_intern("last_x")), siman_matrix_new(job->x, job->nrep, job->n));
+  rb_hash_aset(hash, ID2SYM(rb_intern("last_energy")), siman_vector_new(job->E, job->nrep));
+  rb_hash_aset(hash, ID2SYM(rb_intern("acceptance")), Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, acc));
+  return hash;
+}
+
+/***** multi-chain annealing *****/
+
+static void siman_anneal_worker(size_t tid, size_t nthreads, void *data)
+{
+  siman_job *job = (siman_job *) data;
+  size_t i;
+  for (i = tid; i < job->nrep; i += nthreads) {
+    for (job->T[i] = job->t_initial; job->T[i] >= job->t_min && !rb_gsl_parallel_interrupted();
+         job->T[i] /= job->mu_t)
+      siman_native_sweeps(job, i, job->iters);
+  }
+}
+
+/*
+  Document-method: <i>GSL::Siman.multi_solve</i>
+    multi_solve(x0, efunc, step, params, chains:, rng:, seed:, threads:)
+*/
+static VALUE rb_gsl_siman_multi_solve(int argc, VALUE *argv, VALUE module)
+{
+  siman_job job;
+  gsl_siman_params_t *params;
+  VALUE opts = Qnil, holder, hash;
+  size_t nthreads, i;
+  double T;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 4) rb_raise(rb_eArgError, "wrong number of arguments (%d for 4)", argc);
+  if (!rb_obj_is_kind_of(argv[3], cgsl_siman_params_class))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Siman::Params expected)",
+             rb_class2name(CLASS_OF(argv[3])));
+  Data_Get_Struct(argv[3], gsl_siman_params_t, params);
+  if (!(params->t_initial > 0.0) || !(params->t_min > 0.0) || !(params->mu_t > 1.0))
+    rb_raise(rb_eArgError, "the schedule needs t_initial > 0, t_min > 0 and mu_t > 1");
+  if (params->iters_fixed_T < 1) rb_raise(rb_eArgError, "iters_fixed_T must be positive");
+  holder = rb_ary_new();
+  memset(&job, 0, sizeof(siman_job));
+  siman_get_efunc(argv[1], &job);
+  siman_get_step(argv[2], &job);
+  job.nrep = siman_nrep(argv[0], rb_gsl_parallel_size_opt(opts, "chains", 8));
+  job.k = params->k;
+  job.t_initial = params->t_initial;
+  job.t_min = params->t_min;
+  job.mu_t = params->mu_t;
+  job.iters = (size_t) params->iters_fixed_T;
+  siman_job_init(&job, argv[0], opts, holder);
+  for (i = 0; i < job.nrep; i++) job.step_size[i] = params->step_size;
+  if (siman_native_p(&job)) {
+    nthreads = rb_gsl_parallel_threads(opts);
+    if (nthreads > job.nrep) nthreads = job.nrep;
+    rb_gsl_parallel_run(nthreads, siman_anneal_worker, &job);
+  } else {
+    for (T = job.t_initial; T >= job.t_min; T /= job.mu_t) {
+      for (i = 0; i < job.nrep; i++) job.T[i] = T;
+      siman_lockstep_sweeps(&job, job.iters);
+    }
+  }
+  hash = siman_result(&job);
+  RB_GC_GUARD(holder);
+  return hash;
+}
+
+/***** parallel tempering *****/
+
+static void siman_tempering_worker(size_t tid, size_t nthreads, void *data)
+{
+  siman_job *job = (siman_job *) data;
+  size_t i;
+  for (i = tid; i < job->nrep && !rb_gsl_parallel_interrupted(); i += nthreads)
+    siman_native_sweeps(job, i, job->nsweeps);
+}
+
+/* Per-replica values from a scalar, an Array or a Vector */
+static void siman_get_ladder(VALUE val, double *x, size_t n, const char *key)
+{
+  gsl_vector *v;
+  size_t i;
+  if (VECTOR_P(val)) {
+    Data_Get_Vector(val, v);
+    if (v->size != n) rb_raise(rb_eArgError, "%s has %d values for %d replicas", key, (int) v->size, (int) n);
+    for (i = 0; i < n; i++) x[i] = gsl_vector_get(v, i);
+  } else if (TYPE(val) == T_ARRAY) {
+    if ((size_t) RARRAY_LEN(val) != n)
+      rb_raise(rb_eArgError, "%s has %d values for %d replicas", key, (int) RARRAY_LEN(val), (int) n);
+    for (i = 0; i < n; i++) x[i] = NUM2DBL(rb_ary_entry(val, i));
+  } else {
+    for (i = 0; i < n; i++) x[i] = NUM2DBL(val);
+  }
+}
+
+static size_t siman_ladder_size(VALUE val)
+{
+  gsl_vector *v;
+  if (VECTOR_P(val)) {
+    Data_Get_Vector(val, v);
+    return v->size;
+  }
+  Check_Type(val, T_ARRAY);
+  return (size_t) RARRAY_LEN(val);
+}
+
+static double siman_dbl_opt(VALUE opts, const char *key, double def)
+{
+  VALUE val = rb_gsl_hash_get(opts, key);
+  return NIL_P(val) ? def : NUM2DBL(val);
+}
+
+/*
+  Document-method: <i>GSL::Siman.parallel_tempering</i>
+    parallel_tempering(x0, efunc, step, temperatures:, t_min:, t_max:, replicas:,
+                       sweeps:, exchange:, step_size:, k:, rng:, seed:, threads:)
+*/
+static VALUE rb_gsl_siman_parallel_tempering(int argc, VALUE *argv, VALUE module)
+{
+  siman_job job;
+  VALUE opts = Qnil, holder, hash, vtemp, val;
+  gsl_vector *xacc;
+  unsigned long *xtried, *xaccepted;
+  size_t nthreads = 1, nsweeps, nexchange, done, round, i;
+  double t_min, t_max, d, tmp, *row;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 3) rb_raise(rb_eArgError, "wrong number of arguments (%d for 3)", argc);
+  holder = rb_ary_new();
+  memset(&job, 0, sizeof(siman_job));
+  siman_get_efunc(argv[1], &job);
+  siman_get_step(argv[2], &job);
+  vtemp = rb_gsl_hash_get(opts, "temperatures");
+  job.nrep = siman_nrep(argv[0], NIL_P(vtemp) ? rb_gsl_parallel_size_opt(opts, "replicas", 8) : siman_ladder_size(vtemp));
+  job.k = siman_dbl_opt(opts, "k", 1.0);
+  nsweeps = rb_gsl_parallel_size_opt(opts, "sweeps", 1000);
+  nexchange = rb_gsl_parallel_size_opt(opts, "exchange", 10);
+  siman_job_init(&job, argv[0], opts, holder);
+  if (NIL_P(vtemp)) {
+    /* geometric ladder */
+    t_min = siman_dbl_opt(opts, "t_min", 1.0);
+    t_max = siman_dbl_opt(opts, "t_max", 100.0);
+    if (!(t_min > 0.0) || !(t_max >= t_min))
+      rb_raise(rb_eArgError, "the ladder needs 0 < t_min <= t_max");
+    for (i = 0; i < job.nrep; i++)
+      job.T[i] = job.nrep > 1 ? t_min * pow(t_max / t_min, (double) i / (double) (job.nrep - 1)) : t_min;
+  } else {
+    siman_get_ladder(vtemp, job.T, job.nrep, "temperatures");
+    for (i = 0; i < job.nrep; i++)
+      if (!(job.T[i] > 0.0)) rb_raise(rb_eArgError, "temperatures must be positive");
+  }
+  val = rb_gsl_hash_get(opts, "step_size");
+  siman_get_ladder(NIL_P(val) ? rb_float_new(1.0) : val, job.step_size, job.nrep, "step_size");
+  xtried = (unsigned long *) siman_alloc(job.nrep * sizeof(unsigned long), holder);
+  xaccepted = (unsigned long *) siman_alloc(job.nrep * sizeof(unsigned long), holder);
+  row = (double *) siman_alloc(job.n * sizeof(double), holder);
+  if (siman_native_p(&job)) {
+    nthreads = rb_gsl_parallel_threads(opts);
+    if (nthreads > job.nrep) nthreads = job.nrep;
+  }
+  for (done = 0, round = 0; done < nsweeps; done += job.nsweeps, round++) {
+    job.nsweeps = GSL_MIN(nexchange, nsweeps - done);
+    if (siman_native_p(&job)) rb_gsl_parallel_run(nthreads, siman_tempering_worker, &job);
+    else siman_lockstep_sweeps(&job, job.nsweeps);
+    /* exchanges between the even or the odd neighbours, alternately */
+    for (i = round % 2; i + 1 < job.nrep; i += 2) {
+      xtried[i]++;
+      d = (1.0 / job.T[i] - 1.0 / job.T[i + 1]) * (job.E[i] - job.E[i + 1]) / job.k;
+      if (!(d >= 0.0) && !(gsl_rng_uniform(job.r[job.nrep]) < exp(d))) continue;
+      xaccepted[i]++;
+      memcpy(row, job.x + i * job.n, job.n * sizeof(double));
+      memcpy(job.x + i * job.n, job.x + (i + 1) * job.n, job.n * sizeof(double));
+      memcpy(job.x + (i + 1) * job.n, row, job.n * sizeof(double));
+      tmp = job.E[i]; job.E[i] = job.E[i + 1]; job.E[i + 1] = tmp;
+    }
+  }
+  hash = siman_result(&job);
+  rb_hash_aset(hash, ID2SYM(rb_intern("temperatures")), siman_vector_new(job.T, job.nrep));
+  xacc = gsl_vector_alloc(job.nrep > 1 ? job.nrep - 1 : 1);
+  gsl_vector_set_zero(xacc);
+  for (i = 0; i + 1 < job.nrep; i++)
+    gsl_vector_set(xacc, i, xtried[i] ? (double) xaccepted[i] / (double) xtried[i] : 0.0);
+  rb_hash_aset(hash, ID2SYM(rb_intern("exchange_acceptance")), Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, xacc));
+  RB_GC_GUARD(holder);
+  return hash;
+}
+
+/***** native energies and steps *****/
+
+static void* siman_native_address(VALUE addr)
+{
+  if (!FIXNUM_P(addr) && TYPE(addr) != T_BIGNUM) addr = rb_funcall(addr, rb_intern("to_i"), 0);
+  return (void *) (uintptr_t) NUM2ULL(addr);
+}
+
+static void siman_native_args(int argc, VALUE *argv, void **f, void **params)
+{
+  switch (argc) {
+  case 2:
+    *params = siman_native_address(argv[1]);
+    /* no break */
+  case 1:
+    *f = siman_native_address(argv[0]);
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+    break;
+  }
+  if (*f == NULL) rb_raise(rb_eArgError, "null function address");
+}
+
+/*
+  Document-method: <i>GSL::Siman::Efunc::Native.new</i>
+    Native.new(address, params = 0) wraps the C function
+    double E(const double *x, size_t n, void *params) at address.
+*/
+static VALUE rb_gsl_siman_Efunc_native_new(int argc, VALUE *argv, VALUE klass)
+{
+  siman_native_efunc *F;
+  void *f = NULL, *params = NULL;
+  siman_native_args(argc, argv, &f, &params);
+  F = ALLOC(siman_native_efunc);
+  F->f = (double (*)(const double*, size_t, void*)) (uintptr_t) f;
+  F->params = params;
+  return Data_Wrap_Struct(klass, 0, free, F);
+}
+
+static VALUE rb_gsl_siman_Efunc_native_call(VALUE obj, VALUE vx)
+{
+  siman_native_efunc *F;
+  gsl_vector *v;
+  double *x;
+  size_t i;
+  Data_Get_Struct(obj, siman_native_efunc, F);
+  CHECK_VECTOR(vx);
+  Data_Get_Vector(vx, v);
+  x = ALLOCA_N(double, v->size);
+  for (i = 0; i < v->size; i++) x[i] = gsl_vector_get(v, i);
+  return rb_float_new((*F->f)(x, v->size, F->params));
+}
+
+/*
+  Document-method: <i>GSL::Siman::Step::Native.new</i>
+    Native.new(address, params = 0) wraps the C function
+    void step(const gsl_rng *r, double *x, size_t n, double step_size, void *params)
+    at address, which changes x in place.
+*/
+static VALUE rb_gsl_siman_step_native_new(int argc, VALUE *argv, VALUE klass)
+{
+  siman_native_step *S;
+  void *f = NULL, *params = NULL;
+  siman_native_args(argc, argv, &f, &params);
+  S = ALLOC(siman_native_step);
+  S->f = (void (*)(const gsl_rng*, double*, size_t, double, void*)) (uintptr_t) f;
+  S->params = params;
+  return Data_Wrap_Struct(klass, 0, free, S);
+}
+
+static VALUE rb_gsl_siman_step_native_call(VALUE obj, VALUE rng, VALUE vx, VALUE step_size)
+{
+  siman_native_step *S;
+  gsl_rng *r;
+  gsl_vector *v;
+  double *x;
+  size_t i;
+  Data_Get_Struct(obj, siman_native_step, S);
+  CHECK_RNG(rng);
+  Data_Get_Struct(rng, gsl_rng, r);
+  CHECK_VECTOR(vx);
+  Data_Get_Vector(vx, v);
+  x = ALLOCA_N(double, v->size);
+  for (i = 0; i < v->size; i++) x[i] = gsl_vector_get(v, i);
+  (*S->f)(r, x, v->size, NUM2DBL(step_size), S->params);
+  for (i = 0; i < v->size; i++) gsl_vector_set(v, i, x[i]);
+  return vx;
+}
+
+void Init_gsl_siman_parallel(VALUE module)
+{
+  cgsl_siman_Efunc_class = rb_const_get(module, rb_intern("Efunc"));
+  cgsl_siman_step_class = rb_const_get(module, rb_intern("Step"));
+  cgsl_siman_params_class = rb_const_get(module, rb_intern("Params"));
+
+  cgsl_siman_Efunc_native = rb_define_class_under(cgsl_siman_Efunc_class, "Native", cGSL_Object);
+  rb_define_singleton_method(cgsl_siman_Efunc_native, "new", rb_gsl_siman_Efunc_native_new, -1);
+  rb_define_singleton_method(cgsl_siman_Efunc_native, "alloc", rb_gsl_siman_Efunc_native_new, -1);
+  rb_define_method(cgsl_siman_Efunc_native, "call", rb_gsl_siman_Efunc_native_call, 1);
+  rb_define_alias(cgsl_siman_Efunc_native, "eval", "call");
+
+  cgsl_siman_step_native = rb_define_class_under(cgsl_siman_step_class, "Native", cGSL_Object);
+  rb_define_singleton_method(cgsl_siman_step_native, "new", rb_gsl_siman_step_native_new, -1);
+  rb_define_singleton_method(cgsl_siman_step_native, "alloc", rb_gsl_siman_step_native_new, -1);
+  rb_define_method(cgsl_siman_step_native, "call", rb_gsl_siman_step_native_call, 3);
+
+  rb_define_module_function(module, "multi_solve", rb_gsl_siman_multi_solve, -1);
+  rb_define_module_function(module, "parallel_tempering", rb_gsl_siman_parallel_tempering, -1);
+}
@@ -0,0 +1,1201 @@
+/*
+  sketch.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Streaming quantile sketches: GSL::Sketch::TDigest, GSL::Sketch::KLL
+  and GSL::Sketch::DDSketch. Each takes values one by one or in bulk,
+  answers quantile and cdf queries in bounded memory, can be merged
+  with another sketch of the same kind (the sketches of several workers
+  give the sketch of the union of their data) and dumped to a string.
+
+  The sketches share the mygsl_sketch header, which holds the total
+  weight and the exact extremes, and a table of functions through which
+  the methods of GSL::Sketch reach the kind-specific code.
+
+  Dumps are "GSLS", the kind, the version and two zero bytes, followed
+  by little-endian 64-bit fields, so they can be read on any host.
+*/
+
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_common.h"
+#include <stdint.h>
+#include <float.h>
+
+#define SKETCH_VERSION 1
+
+enum {
+  SKETCH_TDIGEST = 1, SKETCH_KLL, SKETCH_DDSKETCH,
+};
+
+typedef struct {
+  const unsigned char *p, *end;
+} sketch_reader;
+
+typedef struct mygsl_sketch_type mygsl_sketch_type;
+
+typedef struct {
+  const mygsl_sketch_type *type;
+  double count, min, max;
+} mygsl_sketch;
+
+struct mygsl_sketch_type {
+  int id;
+  const char *name;
+  int weighted;
+  void (*add)(mygsl_sketch *s, double x, double w);
+  void (*prepare)(mygsl_sketch *s);     /* before queries and dumps */
+  double (*quantile)(mygsl_sketch *s, double p);
+  double (*cdf)(mygsl_sketch *s, double x);
+  void (*merge)(mygsl_sketch *s, mygsl_sketch *t);
+  mygsl_sketch* (*clone)(mygsl_sketch *s);
+  void (*reset)(mygsl_sketch *s);
+  void (*free)(void *s);
+  void (*dump)(mygsl_sketch *s, VALUE str);
+  mygsl_sketch* (*load_alloc)(sketch_reader *r);
+  void (*load_data)(mygsl_sketch *s, sketch_reader *r);
+};
+
+static VALUE cgsl_sketch;
+
+static void* sketch_realloc(void *p, size_t n, size_t size)
+{
+  void *q;
+  if (size > 0 && n > SIZE_MAX / size) rb_raise(rb_eNoMemError, "sketch too large");
+  q = realloc(p, n * size > 0 ? n * size : 1);
+  if (q == NULL) rb_raise(rb_eNoMemError, "failed to allocate a sketch");
+  return q;
+}
+
+static void sketch_put_u64(VALUE str, uint64_t v)
+{
+  unsigned char b[8];
+  int i;
+  for (i = 0; i < 8; i++) b[i] = (unsigned char) (v >> (8 * i));
+  rb_str_buf_cat(str, (const char *) b, 8);
+}
+
+static void sketch_put_f64(VALUE str, double x)
+{
+  uint64_t v;
+  memcpy(&v, &x, 8);
+  sketch_put_u64(str, v);
+}
+
+static void sketch_need(sketch_reader *r, size_t n)
+{
+  if ((size_t) (r->end - r->p) < n) rb_raise(rb_eArgError, "truncated sketch dump");
+}
+
+static uint64_t sketch_get_u64(sketch_reader *r)
+{
+  uint64_t v = 0;
+  int i;
+  sketch_need(r, 8);
+  for (i = 7; i >= 0; i--) v = (v << 8) | r->p[i];
+  r->p += 8;
+  return v;
+}
+
+static double sketch_get_f64(sketch_reader *r)
+{
+  uint64_t v = sketch_get_u64(r);
+  double x;
+  memcpy(&x, &v, 8);
+  return x;
+}
+
+/* a count of items of the given size, checked against the bytes left */
+static size_t sketch_get_count(sketch_reader *r, size_t size)
+{
+  uint64_t n = sketch_get_u64(r);
+  if (n > (uint64_t) (r->end - r->p) / size) rb_raise(rb_eArgError, "truncated sketch dump");
+  return (size_t) n;
+}
+
+/*****/
+
+/* t-digest, merging variant with the k1 (arcsine) scale function */
+
+typedef struct {
+  double mean, w;
+} td_centroid;
+
+typedef struct {
+  mygsl_sketch head;
+  double delta;
+  td_centroid *c, *buf;
+  size_t nc, nbuf, bufcap;
+} mygsl_tdigest;
+
+static int td_cmp(const void *a, const void *b)
+{
+  double x = ((const td_centroid *) a)->mean, y = ((const td_centroid *) b)->mean;
+  return x < y ? -1 : x > y;
+}
+
+/* the largest q a centroid starting at q0 may reach */
+static double td_q_limit(double delta, double q0)
+{
+  double k;
+  if (q0 > 1) q0 = 1;
+  k = delta / (2 * M_PI) * asin(2 * q0 - 1) + 1;
+  if (k >= delta / 4) return 1;
+  return (sin(2 * M_PI * k / delta) + 1) / 2;
+}
+
+static void td_compress(mygsl_tdigest *t)
+{
+  td_centroid *a;
+  size_t m = t->nc + t->nbuf, i, out;
+  double total = 0, wsofar = 0, qlimit, proposed;
+  if (t->nbuf == 0) return;
+  a = (td_centroid *) sketch_realloc(NULL, m, sizeof(td_centroid));
+  memcpy(a, t->c, t->nc * sizeof(td_centroid));
+  memcpy(a + t->nc, t->buf, t->nbuf * sizeof(td_centroid));
+  qsort(a, m, sizeof(td_centroid), td_cmp);
+  for (i = 0; i < m; i++) total += a[i].w;
+  qlimit = td_q_limit(t->delta, 0);
+  for (out = 0, i = 1; i < m; i++) {
+    proposed = a[out].w + a[i].w;
+    if ((wsofar + proposed) / total <= qlimit) {
+      a[out].mean += (a[i].mean - a[out].mean) * a[i].w / proposed;
+      a[out].w = proposed;
+    } else {
+      wsofar += a[out].w;
+      qlimit = td_q_limit(t->delta, wsofar / total);
+      a[++out] = a[i];
+    }
+  }
+  free(t->c);
+  t->c = a;
+  t->nc = out + 1;
+  t->nbuf = 0;
+}
+
+static void td_reserve(mygsl_tdigest *t, size_t n)
+{
+  if (n <= t->bufcap) return;
+  t->buf = (td_centroid *) sketch_realloc(t->buf, n, sizeof(td_centroid));
+  t->bufcap = n;
+}
+
+static void td_free(void *s)
+{
+  mygsl_tdigest *t = (mygsl_tdigest *) s;
+  free(t->c);
+  free(t->buf);
+  free(t);
+}
+
+static const mygsl_sketch_type td_type;
+
+static mygsl_tdigest* td_alloc(double delta)
+{
+  mygsl_tdigest *t;
+  if (!(delta >= 10 && delta <= 1e6)) rb_raise(rb_eArgError, "compression must be in [10, 1e6]");
+  t = (mygsl_tdigest *) calloc(1, sizeof(mygsl_tdigest));
+  if (t == NULL) rb_raise(rb_eNoMemError, "failed to allocate a t-digest");
+  t->head.type = &td_type;
+  t->head.min = t->head.max = GSL_NAN;
+  t->delta = delta;
+  t->bufcap = (size_t) (5 * delta);
+  t->buf = (td_centroid *) malloc(t->bufcap * sizeof(td_centroid));
+  if (t->buf == NULL) {
+    free(t);
+    rb_raise(rb_eNoMemError, "failed to allocate a t-digest");
+  }
+  return t;
+}
+
+static void td_add(mygsl_sketch *s, double x, double w)
+{
+  mygsl_tdigest *t = (mygsl_tdigest *) s;
+  if (t->nbuf == t->bufcap) td_compress(t);
+  t->buf[t->nbuf].mean = x;
+  t->buf[t->nbuf].w = w;
+  t->nbuf++;
+}
+
+static void td_prepare(mygsl_sketch *s)
+{
+  td_compress((mygsl_tdigest *) s);
+}
+
+/*
+  Interpolates between the centroid means, each centroid standing for
+  half its weight on either side of its mean, and between the extremes
+  and the outer centroids.
+*/
+static double td_quantile(mygsl_sketch *s, double p)
+{
+  mygsl_tdigest *t = (mygsl_tdigest *) s;
+  const td_centroid *c = t->c;
+  size_t n = t->nc, i;
+  double index = p * s->count, wsofar, dw, z1, x;
+  if (n == 0) return GSL_NAN;
+  if (index <= c[0].w / 2) return s->min + index / (c[0].w / 2) * (c[0].mean - s->min);
+  wsofar = c[0].w / 2;
+  for (i = 0; i + 1 < n; i++) {
+    dw = (c[i].w + c[i + 1].w) / 2;
+    if (wsofar + dw > index) {
+      z1 = index - wsofar;
+      return (c[i].mean * (dw - z1) + c[i + 1].mean * z1) / dw;
+    }
+    wsofar += dw;
+  }
+  z1 = index - wsofar;
+  x = c[n - 1].mean + z1 / (c[n - 1].w / 2) * (s->max - c[n - 1].mean);
+  return x > s->max ? s->max : x;
+}
+
+static double td_cdf(mygsl_sketch *s, double x)
+{
+  mygsl_tdigest *t = (mygsl_tdigest *) s;
+  const td_centroid *c = t->c;
+  size_t n = t->nc, i;
+  double wsofar, dw;
+  if (n == 0) return GSL_NAN;
+  if (x < s->min) return 0;
+  if (x >= s->max) return 1;
+  if (x < c[0].mean) return c[0].w / 2 * (x - s->min) / (c[0].mean - s->min) / s->count;
+  wsofar = c[0].w / 2;
+  for (i = 0; i + 1 < n; i++) {
+    dw = (c[i].w + c[i + 1].w) / 2;
+    if (x < c[i + 1].mean)
+      return (wsofar + dw * (x - c[i].mean) / (c[i + 1].mean - c[i].mean)) / s->count;
+    wsofar += dw;
+  }
+  return (wsofar + c[n - 1].w / 2 * (x - c[n - 1].mean) / (s->max - c[n - 1].mean)) / s->count;
+}
+
+static void td_merge(mygsl_sketch *s, mygsl_sketch *o)
+{
+  mygsl_tdigest *t = (mygsl_tdigest *) s, *u = (mygsl_tdigest *) o;
+  size_t nc = u->nc, nb = u->nbuf, i;
+  td_reserve(t, t->nbuf + nc + nb);
+  for (i = 0; i < nc; i++) t->buf[t->nbuf++] = u->c[i];
+  for (i = 0; i < nb; i++) t->buf[t->nbuf++] = u->buf[i];
+  td_compress(t);
+}
+
+static mygsl_sketch* td_clone(mygsl_sketch *s)
+{
+  mygsl_tdigest *t = (mygsl_tdigest *) s, *u;
+  td_compress(t);
+  u = td_alloc(t->delta);
+  u->c = (td_centroid *) malloc((t->nc > 0 ? t->nc : 1) * sizeof(td_centroid));
+  if (u->c == NULL) {
+    td_free(u);
+    rb_raise(rb_eNoMemError, "failed to allocate a t-digest");
+  }
+  memcpy(u->c, t->c, t->nc * sizeof(td_centroid));
+  u->nc = t->nc;
+  return (mygsl_sketch *) u;
+}
+
+static void td_reset(mygsl_sketch *s)
+{
+  mygsl_tdigest *t = (mygsl_tdigest *) s;
+  t->nc = t->nbuf = 0;
+}
+
+static void td_dump(mygsl_sketch *s, VALUE str)
+{
+  mygsl_tdigest *t = (mygsl_tdigest *) s;
+  size_t i;
+  sketch_put_f64(str, t->delta);
+  sketch_put_u64(str, t->nc);
+  for (i = 0; i < t->nc; i++) {
+    sketch_put_f64(str, t->c[i].mean);
+    sketch_put_f64(str, t->c[i].w);
+  }
+}
+
+static mygsl_sketch* td_load_alloc(sketch_reader *r)
+{
+  return (mygsl_sketch *) td_alloc(sketch_get_f64(r));
+}
+
+static void td_load_data(mygsl_sketch *s, sketch_reader *r)
+{
+  mygsl_tdigest *t = (mygsl_tdigest *) s;
+  size_t n = sketch_get_count(r, 16), i;
+  td_reserve(t, n);
+  for (i = 0; i < n; i++) {
+    t->buf[i].mean = sketch_get_f64(r);
+    t->buf[i].w = sketch_get_f64(r);
+    if (!gsl_finite(t->buf[i].mean) || !(t->buf[i].w > 0) || !gsl_finite(t->buf[i].w))
+      rb_raise(rb_eArgError, "bad centroid in t-digest dump");
+  }
+  t->nbuf = n;
+  td_compress(t);
+}
+
+static const mygsl_sketch_type td_type = {
+  SKETCH_TDIGEST, "GSL::Sketch::TDigest", 1,
+  td_add, td_prepare, td_quantile, td_cdf, td_merge, td_clone, td_reset, td_free,
+  td_dump, td_load_alloc, td_load_data,
+};
+
+/*****/
+
+/* KLL: a stack of compactors, level h holding items of weight 2^h */
+
+typedef struct {
+  double *x;
+  size_t n, cap;
+} kll_level;
+
+typedef struct {
+  double x, cum;
+} kll_item;
+
+typedef struct {
+  mygsl_sketch head;
+  size_t k, nlevels, size, capacity;
+  kll_level *levels;
+  uint64_t rng;
+  kll_item *view;       /* sorted items with cumulated weights */
+  size_t nview;
+  int dirty;
+} mygsl_kll;
+
+static size_t kll_level_capacity(const mygsl_kll *s, size_t h)
+{
+  double c = ceil(s->k * pow(2.0 / 3.0, (double) (s->nlevels - 1 - h)));
+  return c < 2 ? 2 : (size_t) c;
+}
+
+static void kll_add_level(mygsl_kll *s)
+{
+  size_t h;
+  s->levels = (kll_level *) sketch_realloc(s->levels, s->nlevels + 1, sizeof(kll_level));
+  memset(&s->levels[s->nlevels], 0, sizeof(kll_level));
+  s->nlevels++;
+  for (s->capacity = 0, h = 0; h < s->nlevels; h++) s->capacity += kll_level_capacity(s, h);
+}
+
+static void kll_push(kll_level *l, double x)
+{
+  if (l->n == l->cap) {
+    l->x = (double *) sketch_realloc(l->x, l->cap > 0 ? 2 * l->cap : 8, sizeof(double));
+    l->cap = l->cap > 0 ? 2 * l->cap : 8;
+  }
+  l->x[l->n++] = x;
+}
+
+/* xorshift64*, for the coin deciding which half of a level moves up */
+static int kll_coin(mygsl_kll *s)
+{
+  s->rng ^= s->rng >> 12;
+  s->rng ^= s->rng << 25;
+  s->rng ^= s->rng >> 27;
+  return (int) ((s->rng * 0x2545F4914F6CDD1DULL) >> 63);
+}
+
+/* sorts level h and moves every other item of it to level h + 1 */
+static void kll_compact(mygsl_kll *s, size_t h)
+{
+  kll_level *l;
+  size_t i, odd, n;
+  if (h + 1 == s->nlevels) kll_add_level(s);
+  l = &s->levels[h];
+  n = l->n;
+  gsl_sort(l->x, 1, n);
+  odd = n & 1;
+  for (i = odd + kll_coin(s); i < n; i += 2) kll_push(&s->levels[h + 1], s->levels[h].x[i]);
+  l = &s->levels[h];
+  l->n = odd;
+  s->size -= (n - odd) / 2;
+}
+
+static void kll_compress(mygsl_kll *s)
+{
+  size_t h;
+  while (s->size >= s->capacity) {
+    for (h = 0; h < s->nlevels; h++) {
+      if (s->levels[h].n >= kll_level_capacity(s, h)) {
+        kll_compact(s, h);
+        break;
+      }
+    }
+    if (h == s->nlevels) break;
+  }
+}
+
+static void kll_free(void *p)
+{
+  mygsl_kll *s = (mygsl_kll *) p;
+  size_t h;
+  for (h = 0; h < s->nlevels; h++) free(s->levels[h].x);
+  free(s->levels);
+  free(s->view);
+  free(s);
+}
+
+static const mygsl_sketch_type kll_type;
+
+static mygsl_kll* kll_alloc(size_t k, uint64_t seed)
+{
+  mygsl_kll *s;
+  if (k < 8 || k > 65536) rb_raise(rb_eArgError, "k must be in [8, 65536]");
+  s = (mygsl_kll *) calloc(1, sizeof(mygsl_kll));
+  if (s == NULL) rb_raise(rb_eNoMemError, "failed to allocate a KLL sketch");
+  s->head.type = &kll_type;
+  s->head.min = s->head.max = GSL_NAN;
+  s->k = k;
+  s->rng = seed != 0 ? seed : 0x9E3779B97F4A7C15ULL;
+  s->dirty = 1;
+  return s;
+}
+
+static void kll_add(mygsl_sketch *p, double x, double w)
+{
+  mygsl_kll *s = (mygsl_kll *) p;
+  if (s->nlevels == 0) kll_add_level(s);
+  kll_push(&s->levels[0], x);
+  s->size++;
+  s->dirty = 1;
+  if (s->size >= s->capacity) kll_compress(s);
+}
+
+static int kll_item_cmp(const void *a, const void *b)
+{
+  double x = ((const kll_item *) a)->x, y = ((const kll_item *) b)->x;
+  return x < y ? -1 : x > y;
+}
+
+static void kll_prepare(mygsl_sketch *p)
+{
+  mygsl_kll *s = (mygsl_kll *) p;
+  size_t h, i, m = 0;
+  double cum = 0;
+  if (!s->dirty) return;
+  s->view = (kll_item *) sketch_realloc(s->view, s->size, sizeof(kll_item));
+  for (h = 0; h < s->nlevels; h++) {
+    for (i = 0; i < s->levels[h].n; i++, m++) {
+      s->view[m].x = s->levels[h].x[i];
+      s->view[m].cum = ldexp(1.0, (int) h);
+    }
+  }
+  qsort(s->view, m, sizeof(kll_item), kll_item_cmp);
+  for (i = 0; i < m; i++) {
+    cum += s->view[i].cum;
+    s->view[i].cum = cum;
+  }
+  s->nview = m;
+  s->dirty = 0;
+}
+
+/* the smallest item whose cumulated weight reaches p of the total */
+static double kll_quantile(mygsl_sketch *p, double q)
+{
+  mygsl_kll *s = (mygsl_kll *) p;
+  double target = q * p->count;
+  size_t lo = 0, hi, mid;
+  if (s->nview == 0) return GSL_NAN;
+  if (q <= 0) return p->min;
+  if (q >= 1) return p->max;
+  hi = s->nview - 1;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (s->view[mid].cum >= target) hi = mid;
+    else lo = mid + 1;
+  }
+  return s->view[lo].x;
+}
+
+static double kll_cdf(mygsl_sketch *p, double x)
+{
+  mygsl_kll *s = (mygsl_kll *) p;
+  size_t lo = 0, hi = s->nview, mid;
+  if (s->nview == 0) return GSL_NAN;
+  if (x < p->min) return 0;
+  if (x >= p->max) return 1;
+  /* number of items <= x */
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (s->view[mid].x <= x) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo > 0 ? s->view[lo - 1].cum / p->count : 0;
+}
+
+static void kll_merge(mygsl_sketch *p, mygsl_sketch *o)
+{
+  mygsl_kll *s = (mygsl_kll *) p, *t = (mygsl_kll *) o;
+  size_t h, i, n, nlevels = t->nlevels;
+  if (s->k != t->k) rb_raise(rb_eArgError, "KLL sketches with different k (%d and %d)", (int) s->k, (int) t->k);
+  while (s->nlevels < nlevels) kll_add_level(s);
+  for (h = 0; h < nlevels; h++) {
+    n = t->levels[h].n;
+    for (i = 0; i < n; i++) kll_push(&s->levels[h], t->levels[h].x[i]);
+    s->size += n;
+  }
+  s->dirty = 1;
+  kll_compress(s);
+}
+
+static mygsl_sketch* kll_clone(mygsl_sketch *p)
+{
+  mygsl_kll *s = (mygsl_kll *) p, *t;
+  VALUE holder;
+  t = kll_alloc(s->k, s->rng);
+  holder = Data_Wrap_Struct(rb_cObject, 0, kll_free, t);
+  kll_merge((mygsl_sketch *) t, p);
+  DATA_PTR(holder) = NULL;
+  return (mygsl_sketch *) t;
+}
+
+static void kll_reset(mygsl_sketch *p)
+{
+  mygsl_kll *s = (mygsl_kll *) p;
+  size_t h;
+  for (h = 0; h < s->nlevels; h++) s->levels[h].n = 0;
+  s->size = 0;
+  s->dirty = 1;
+}
+
+static void kll_dump(mygsl_sketch *p, VALUE str)
+{
+  mygsl_kll *s = (mygsl_kll *) p;
+  size_t h, i;
+  sketch_put_u64(str, s->k);
+  sketch_put_u64(str, s->rng);
+  sketch_put_u64(str, s->nlevels);
+  for (h = 0; h < s->nlevels; h++) {
+    sketch_put_u64(str, s->levels[h].n);
+    for (i = 0; i < s->levels[h].n; i++) sketch_put_f64(str, s->levels[h].x[i]);
+  }
+}
+
+static mygsl_sketch* kll_load_alloc(sketch_reader *r)
+{
+  uint64_t k = sketch_get_u64(r), seed = sketch_get_u64(r);
+  return (mygsl_sketch *) kll_alloc(k > 65536 ? 0 : (size_t) k, seed);
+}
+
+static void kll_load_data(mygsl_sketch *p, sketch_reader *r)
+{
+  mygsl_kll *s = (mygsl_kll *) p;
+  size_t nlevels = sketch_get_count(r, 8), h, i, n;
+  double weight = 0;
+  if (nlevels > 64) rb_raise(rb_eArgError, "bad KLL dump");
+  while (s->nlevels < nlevels) kll_add_level(s);
+  for (h = 0; h < nlevels; h++) {
+    n = sketch_get_count(r, 8);
+    for (i = 0; i < n; i++) kll_push(&s->levels[h], sketch_get_f64(r));
+    s->size += n;
+    weight += ldexp((double) n, (int) h);
+  }
+  if (weight != p->count) rb_raise(rb_eArgError, "bad KLL dump");
+  kll_compress(s);
+}
+
+static const mygsl_sketch_type kll_type = {
+  SKETCH_KLL, "GSL::Sketch::KLL", 0,
+  kll_add, kll_prepare, kll_quantile, kll_cdf, kll_merge, kll_clone, kll_reset, kll_free,
+  kll_dump, kll_load_alloc, kll_load_data,
+};
+
+/*****/
+
+/*
+  DDSketch: counts in buckets (gamma^(i-1), gamma^i] of the magnitudes,
+  with gamma = (1 + alpha)/(1 - alpha), so that the middle of a bucket
+  is within a relative error alpha of any value in it. A store keeps at
+  most max_buckets buckets; beyond that its lowest buckets are folded
+  together, which loses accuracy only for the values nearest to zero.
+*/
+
+typedef struct {
+  double *c;
+  int64_t lo;           /* key of c[0] */
+  size_t n;
+} dd_store;
+
+typedef struct {
+  mygsl_sketch head;
+  double alpha, gamma, log_gamma, min_indexable;
+  size_t maxn;
+  dd_store pos, neg;
+  double zero;
+} mygsl_ddsketch;
+
+static void dd_store_add(dd_store *s, int64_t key, double w, size_t maxn)
+{
+  int64_t hi, nlo, nhi, k;
+  double *c;
+  size_t i;
+  if (s->n > 0) {
+    hi = s->lo + (int64_t) s->n - 1;
+    if (key >= s->lo && key <= hi) {
+      s->c[key - s->lo] += w;
+      return;
+    }
+    nlo = key < s->lo ? key : s->lo;
+    nhi = key > hi ? key : hi;
+  } else {
+    nlo = nhi = key;
+  }
+  if (nhi - nlo + 1 > (int64_t) maxn) nlo = nhi - (int64_t) maxn + 1;
+  c = (double *) calloc((size_t) (nhi - nlo + 1), sizeof(double));
+  if (c == NULL) rb_raise(rb_eNoMemError, "failed to allocate a DDSketch store");
+  for (i = 0; i < s->n; i++) {
+    k = s->lo + (int64_t) i;
+    c[(k < nlo ? nlo : k) - nlo] += s->c[i];
+  }
+  free(s->c);
+  s->c = c;
+  s->lo = nlo;
+  s->n = (size_t) (nhi - nlo + 1);
+  c[(key < nlo ? nlo : key) - nlo] += w;
+}
+
+static double dd_store_total(const dd_store *s)
+{
+  double sum = 0;
+  size_t i;
+  for (i = 0; i < s->n; i++) sum += s->c[i];
+  return sum;
+}
+
+static int64_t dd_key(const mygsl_ddsketch *d, double x)
+{
+  return (int64_t) ceil(log(x) / d->log_gamma);
+}
+
+static double dd_value(const mygsl_ddsketch *d, int64_t key)
+{
+  return 2 * exp((double) key * d->log_gamma) / (d->gamma + 1);
+}
+
+static void dd_free(void *p)
+{
+  mygsl_ddsketch *d = (mygsl_ddsketch *) p;
+  free(d->pos.c);
+  free(d->neg.c);
+  free(d);
+}
+
+static const mygsl_sketch_type dd_type;
+
+static mygsl_ddsketch* dd_alloc(double alpha, size_t maxn)
+{
+  mygsl_ddsketch *d;
+  if (!(alpha > 0 && alpha < 1)) rb_raise(rb_eArgError, "relative accuracy must be in (0, 1)");
+  if (maxn < 1 || maxn > (1 << 24)) rb_raise(rb_eArgError, "max_buckets must be in [1, 2**24]");
+  d = (mygsl_ddsketch *) calloc(1, sizeof(mygsl_ddsketch));
+  if (d == NULL) rb_raise(rb_eNoMemError, "failed to allocate a DDSketch");
+  d->head.type = &dd_type;
+  d->head.min = d->head.max = GSL_NAN;
+  d->alpha = alpha;
+  d->gamma = (1 + alpha) / (1 - alpha);
+  d->log_gamma = log1p(2 * alpha / (1 - alpha));
+  d->min_indexable = DBL_MIN * d->gamma;
+  d->maxn = maxn;
+  return d;
+}
+
+static void dd_add(mygsl_sketch *p, double x, double w)
+{
+  mygsl_ddsketch *d = (mygsl_ddsketch *) p;
+  if (x > d->min_indexable) dd_store_add(&d->pos, dd_key(d, x), w, d->maxn);
+  else if (x < -d->min_indexable) dd_store_add(&d->neg, dd_key(d, -x), w, d->maxn);
+  else d->zero += w;
+}
+
+static void dd_prepare(mygsl_sketch *p)
+{
+}
+
+static double dd_clamp(const mygsl_sketch *p, double x)
+{
+  return x < p->min ? p->min : (x > p->max ? p->max : x);
+}
+
+static double dd_quantile(mygsl_sketch *p, double q)
+{
+  mygsl_ddsketch *d = (mygsl_ddsketch *) p;
+  double rank, cum = 0;
+  size_t i;
+  if (p->count == 0) return GSL_NAN;
+  if (q <= 0) return p->min;
+  if (q >= 1) return p->max;
+  rank = q * p->count;
+  for (i = d->neg.n; i-- > 0; ) {
+    cum += d->neg.c[i];
+    if (cum >= rank) return dd_clamp(p, -dd_value(d, d->neg.lo + (int64_t) i));
+  }
+  cum += d->zero;
+  if (cum >= rank) return dd_clamp(p, 0);
+  for (i = 0; i < d->pos.n; i++) {
+    cum += d->pos.c[i];
+    if (cum >= rank) return dd_clamp(p, dd_value(d, d->pos.lo + (int64_t) i));
+  }
+  return p->max;
+}
+
+static double dd_cdf(mygsl_sketch *p, double x)
+{
+  mygsl_ddsketch *d = (mygsl_ddsketch *) p;
+  double cum = 0;
+  int64_t key;
+  size_t i;
+  if (p->count == 0) return GSL_NAN;
+  if (x < p->min) return 0;
+  if (x >= p->max) return 1;
+  if (x < -d->min_indexable) {
+    key = dd_key(d, -x);
+    for (i = 0; i < d->neg.n; i++)
+      if (d->neg.lo + (int64_t) i >= key) cum += d->neg.c[i];
+  } else {
+    cum = dd_store_total(&d->neg) + d->zero;
+    if (x > d->min_indexable) {
+      key = dd_key(d, x);
+      for (i = 0; i < d->pos.n && d->pos.lo + (int64_t) i <= key; i++) cum += d->pos.c[i];
+    }
+  }
+  return cum / p->count;
+}
+
+static void dd_merge_store(dd_store *s, const dd_store *t, size_t maxn)
+{
+  size_t i, n = t->n;
+  if (s == t) {
+    for (i = 0; i < n; i++) s->c[i] *= 2;
+    return;
+  }
+  if (n == 0) return;
+  dd_store_add(s, t->lo, 0, maxn);
+  dd_store_add(s, t->lo + (int64_t) n - 1, 0, maxn);
+  for (i = 0; i < n; i++) dd_store_add(s, t->lo + (int64_t) i, t->c[i], maxn);
+}
+
+static void dd_merge(mygsl_sketch *p, mygsl_sketch *o)
+{
+  mygsl_ddsketch *d = (mygsl_ddsketch *) p, *e = (mygsl_ddsketch *) o;
+  if (d->alpha != e->alpha)
+    rb_raise(rb_eArgError, "DDSketches with different relative accuracy (%g and %g)", d->alpha, e->alpha);
+  dd_merge_store(&d->pos, &e->pos, d->maxn);
+  dd_merge_store(&d->neg, &e->neg, d->maxn);
+  d->zero += e->zero;
+}
+
+static mygsl_sketch* dd_clone(mygsl_sketch *p)
+{
+  mygsl_ddsketch *d = (mygsl_ddsketch *) p, *e;
+  VALUE holder;
+  e = dd_alloc(d->alpha, d->maxn);
+  holder = Data_Wrap_Struct(rb_cObject, 0, dd_free, e);
+  dd_merge((mygsl_sketch *) e, p);
+  DATA_PTR(holder) = NULL;
+  return (mygsl_sketch *) e;
+}
+
+static void dd_reset(mygsl_sketch *p)
+{
+  mygsl_ddsketch *d = (mygsl_ddsketch *) p;
+  free(d->pos.c);
+  free(d->neg.c);
+  memset(&d->pos, 0, sizeof(dd_store));
+  memset(&d->neg, 0, sizeof(dd_store));
+  d->zero = 0;
+}
+
+static void dd_dump_store(const dd_store *s, VALUE str)
+{
+  size_t i;
+  sketch_put_u64(str, (uint64_t) s->lo);
+  sketch_put_u64(str, s->n);
+  for (i = 0; i < s->n; i++) sketch_put_f64(str, s->c[i]);
+}
+
+static void dd_dump(mygsl_sketch *p, VALUE str)
+{
+  mygsl_ddsketch *d = (mygsl_ddsketch *) p;
+  sketch_put_f64(str, d->alpha);
+  sketch_put_u64(str, d->maxn);
+  sketch_put_f64(str, d->zero);
+  dd_dump_store(&d->pos, str);
+  dd_dump_store(&d->neg, str);
+}
+
+static mygsl_sketch* dd_load_alloc(sketch_reader *r)
+{
+  double alpha = sketch_get_f64(r);
+  uint64_t maxn = sketch_get_u64(r);
+  return (mygsl_sketch *) dd_alloc(alpha, maxn > (1 << 24) ? 0 : (size_t) maxn);
+}
+
+static void dd_load_store(mygsl_ddsketch *d, dd_store *s, sketch_reader *r)
+{
+  int64_t lo = (int64_t) sketch_get_u64(r);
+  size_t n = sketch_get_count(r, 8), i;
+  double c;
+  if (n > d->maxn || lo < -(INT64_C(1) << 40) || lo > (INT64_C(1) << 40))
+    rb_raise(rb_eArgError, "bad DDSketch dump");
+  for (i = 0; i < n; i++) {
+    c = sketch_get_f64(r);
+    if (!(c >= 0) || !gsl_finite(c)) rb_raise(rb_eArgError, "bad DDSketch dump");
+    dd_store_add(s, lo + (int64_t) i, c, d->maxn);
+  }
+}
+
+static void dd_load_data(mygsl_sketch *p, sketch_reader *r)
+{
+  mygsl_ddsketch *d = (mygsl_ddsketch *) p;
+  d->zero = sketch_get_f64(r);
+  if (!(d->zero >= 0) || !gsl_finite(d->zero)) rb_raise(rb_eArgError, "bad DDSketch dump");
+  dd_load_store(d, &d->pos, r);
+  dd_load_store(d, &d->neg, r);
+}
+
+static const mygsl_sketch_type dd_type = {
+  SKETCH_DDSKETCH, "GSL::Sketch::DDSketch", 1,
+  dd_add, dd_prepare, dd_quantile, dd_cdf, dd_merge, dd_clone, dd_reset, dd_free,
+  dd_dump, dd_load_alloc, dd_load_data,
+};
+
+/*****/
+
+static mygsl_sketch* get_sketch(VALUE obj)
+{
+  mygsl_sketch *s;
+  if (!rb_obj_is_kind_of(obj, cgsl_sketch))
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::Sketch expected)", rb_class2name(CLASS_OF(obj)));
+  Data_Get_Struct(obj, mygsl_sketch, s);
+  return s;
+}
+
+static VALUE sketch_wrap(VALUE klass, mygsl_sketch *s)
+{
+  return Data_Wrap_Struct(klass, 0, s->type->free, s);
+}
+
+/* GSL::Sketch::TDigest.new(compression = 100) */
+static VALUE rb_gsl_sketch_tdigest_new(int argc, VALUE *argv, VALUE klass)
+{
+  double delta = 100;
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 1) delta = NUM2DBL(argv[0]);
+  return sketch_wrap(klass, (mygsl_sketch *) td_alloc(delta));
+}
+
+/* GSL::Sketch::KLL.new(k = 200, seed: nil) */
+static VALUE rb_gsl_sketch_kll_new(int argc, VALUE *argv, VALUE klass)
+{
+  VALUE opts = Qnil, seed;
+  size_t k = 200;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 1) k = NUM2ULONG(argv[0]);
+  seed = rb_gsl_hash_get(opts, "seed");
+  return sketch_wrap(klass, (mygsl_sketch *) kll_alloc(k, NIL_P(seed) ? 0 : NUM2ULL(seed)));
+}
+
+/* GSL::Sketch::DDSketch.new(relative_accuracy = 0.01, max_buckets: 2048) */
+static VALUE rb_gsl_sketch_ddsketch_new(int argc, VALUE *argv, VALUE klass)
+{
+  VALUE opts = Qnil, maxn;
+  double alpha = 0.01;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 1) alpha = NUM2DBL(argv[0]);
+  maxn = rb_gsl_hash_get(opts, "max_buckets");
+  return sketch_wrap(klass, (mygsl_sketch *) dd_alloc(alpha, NIL_P(maxn) ? 2048 : NUM2ULONG(maxn)));
+}
+
+static void sketch_add1(mygsl_sketch *s, double x, double w)
+{
+  if (!gsl_finite(x) || !(w > 0) || !gsl_finite(w)) return;
+  if (s->count == 0 || x < s->min) s->min = x;
+  if (s->count == 0 || x > s->max) s->max = x;
+  s->count += w;
+  s->type->add(s, x, w);
+}
+
+/*
+  Sketch#add(x, weight = 1)
+
+  x is a number or an Array, Vector, Vector::Int or NArray of values;
+  weight a number or a Vector of weights. NaN and infinite values, and
+  values with a weight that is not positive, are skipped.
+*/
+static VALUE rb_gsl_sketch_add(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_sketch *s = get_sketch(obj);
+  gsl_vector *v, *vw = NULL;
+  gsl_vector_int *vi;
+  const double *ptr;
+  size_t i, n, stride;
+  double weight = 1;
+  if (argc < 1 || argc > 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  if (argc == 2) {
+    if (VECTOR_P(argv[1])) Data_Get_Vector(argv[1], vw);
+    else weight = NUM2DBL(argv[1]);
+    if (!s->type->weighted && (vw || weight != 1))
+      rb_raise(rb_eArgError, "%s takes no weights", s->type->name);
+  }
+  if (TYPE(argv[0]) == T_ARRAY) {
+    n = RARRAY_LEN(argv[0]);
+    if (vw && vw->size != n) rb_raise(rb_eArgError, "%d weights for %d values", (int) vw->size, (int) n);
+    for (i = 0; i < n; i++)
+      sketch_add1(s, NUM2DBL(rb_ary_entry(argv[0], i)), vw ? gsl_vector_get(vw, i) : weight);
+    return obj;
+  }
+  if (VECTOR_INT_P(argv[0])) {
+    Data_Get_Struct(argv[0], gsl_vector_int, vi);
+    if (vw && vw->size != vi->size)
+      rb_raise(rb_eArgError, "%d weights for %d values", (int) vw->size, (int) vi->size);
+    for (i = 0; i < vi->size; i++)
+      sketch_add1(s, (double) gsl_vector_int_get(vi, i), vw ? gsl_vector_get(vw, i) : weight);
+    return obj;
+  }
+  if (VECTOR_P(argv[0])) {
+    Data_Get_Struct(argv[0], gsl_vector, v);
+    ptr = v->data;
+    stride = v->stride;
+    n = v->size;
+#ifdef HAVE_NARRAY_H
+  } else if (NA_IsNArray(argv[0])) {
+    ptr = get_vector_ptr(argv[0], &stride, &n);
+#endif
+  } else {
+    if (vw) rb_raise(rb_eTypeError, "a vector of weights needs a vector of values");
+    sketch_add1(s, NUM2DBL(argv[0]), weight);
+    return obj;
+  }
+  if (vw && vw->size != n) rb_raise(rb_eArgError, "%d weights for %d values", (int) vw->size, (int) n);
+  for (i = 0; i < n; i++) sketch_add1(s, ptr[i * stride], vw ? vw->data[i * vw->stride] : weight);
+  return obj;
+}
+
+static VALUE rb_gsl_sketch_push(VALUE obj, VALUE x)
+{
+  return rb_gsl_sketch_add(1, &x, obj);
+}
+
+static double sketch_query(mygsl_sketch *s, int quantile, double x)
+{
+  if (!quantile) return s->type->cdf(s, x);
+  if (!(x >= 0 && x <= 1)) rb_raise(rb_eArgError, "probability %g out of [0, 1]", x);
+  return s->type->quantile(s, x);
+}
+
+/* quantiles or cdf values, for a number, an Array or a Vector */
+static VALUE sketch_map(VALUE obj, VALUE x, int quantile)
+{
+  mygsl_sketch *s = get_sketch(obj);
+  gsl_vector *v, *vnew;
+  VALUE ary;
+  size_t i;
+  s->type->prepare(s);
+  if (VECTOR_P(x)) {
+    Data_Get_Vector(x, v);
+    vnew = gsl_vector_alloc(v->size);
+    for (i = 0; i < v->size; i++) gsl_vector_set(vnew, i, sketch_query(s, quantile, gsl_vector_get(v, i)));
+    return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vnew);
+  }
+  if (TYPE(x) == T_ARRAY) {
+    ary = rb_ary_new2(RARRAY_LEN(x));
+    for (i = 0; i < (size_t) RARRAY_LEN(x); i++)
+      rb_ary_store(ary, i, rb_float_new(sketch_query(s, quantile, NUM2DBL(rb_ary_entry(x, i)))));
+    return ary;
+  }
+  return rb_float_new(sketch_query(s, quantile, NUM2DBL(x)));
+}
+
+static VALUE rb_gsl_sketch_quantile(VALUE obj, VALUE p)
+{
+  return sketch_map(obj, p, 1);
+}
+
+static VALUE rb_gsl_sketch_median(VALUE obj)
+{
+  return sketch_map(obj, rb_float_new(0.5), 1);
+}
+
+static VALUE rb_gsl_sketch_cdf(VALUE obj, VALUE x)
+{
+  return sketch_map(obj, x, 0);
+}
+
+static VALUE rb_gsl_sketch_count(VALUE obj)
+{
+  return rb_float_new(get_sketch(obj)->count);
+}
+
+static VALUE rb_gsl_sketch_min(VALUE obj)
+{
+  return rb_float_new(get_sketch(obj)->min);
+}
+
+static VALUE rb_gsl_sketch_max(VALUE obj)
+{
+  return rb_float_new(get_sketch(obj)->max);
+}
+
+static VALUE rb_gsl_sketch_empty(VALUE obj)
+{
+  return get_sketch(obj)->count == 0 ? Qtrue : Qfalse;
+}
+
+static VALUE rb_gsl_sketch_merge_bang(VALUE obj, VALUE other)
+{
+  mygsl_sketch *s = get_sketch(obj), *t = get_sketch(other);
+  double count = t->count, min = t->min, max = t->max;
+  if (s->type != t->type)
+    rb_raise(rb_eTypeError, "cannot merge %s into %s", t->type->name, s->type->name);
+  if (count == 0) return obj;
+  s->type->merge(s, t);
+  if (s->count == 0 || min < s->min) s->min = min;
+  if (s->count == 0 || max > s->max) s->max = max;
+  s->count += count;
+  return obj;
+}
+
+static VALUE rb_gsl_sketch_clone(VALUE obj)
+{
+  mygsl_sketch *s = get_sketch(obj), *t;
+  t = s->type->clone(s);
+  t->count = s->count;
+  t->min = s->min;
+  t->max = s->max;
+  return sketch_wrap(CLASS_OF(obj), t);
+}
+
+static VALUE rb_gsl_sketch_merge(VALUE obj, VALUE other)
+{
+  return rb_gsl_sketch_merge_bang(rb_gsl_sketch_clone(obj), other);
+}
+
+static VALUE rb_gsl_sketch_reset(VALUE obj)
+{
+  mygsl_sketch *s = get_sketch(obj);
+  s->type->reset(s);
+  s->count = 0;
+  s->min = s->max = GSL_NAN;
+  return obj;
+}
+
+static VALUE rb_gsl_sketch_dump(int argc, VALUE *argv, VALUE obj)
+{
+  mygsl_sketch *s = get_sketch(obj);
+  VALUE str;
+  char head[8] = {'G', 'S', 'L', 'S', 0, SKETCH_VERSION, 0, 0};
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  s->type->prepare(s);
+  head[4] = (char) s->type->id;
+  str = rb_str_buf_new(64);
+  rb_str_buf_cat(str, head, 8);
+  sketch_put_f64(str, s->count);
+  sketch_put_f64(str, s->min);
+  sketch_put_f64(str, s->max);
+  s->type->dump(s, str);
+  return str;
+}
+
+static VALUE sketch_load(VALUE klass, const mygsl_sketch_type *type, VALUE str)
+{
+  sketch_reader r;
+  mygsl_sketch *s;
+  double count, min, max;
+  VALUE obj;
+  StringValue(str);
+  r.p = (const unsigned char *) RSTRING_PTR(str);
+  r.end = r.p + RSTRING_LEN(str);
+  sketch_need(&r, 8);
+  if (memcmp(r.p, "GSLS", 4) != 0 || r.p[4] != type->id)
+    rb_raise(rb_eArgError, "not a %s dump", type->name);
+  if (r.p[5] != SKETCH_VERSION) rb_raise(rb_eArgError, "unsupported %s dump version %d", type->name, r.p[5]);
+  r.p += 8;
+  count = sketch_get_f64(&r);
+  min = sketch_get_f64(&r);
+  max = sketch_get_f64(&r);
+  if (!(count >= 0) || !gsl_finite(count)) rb_raise(rb_eArgError, "bad %s dump", type->name);
+  s = type->load_alloc(&r);
+  obj = sketch_wrap(klass, s);
+  s->count = count;
+  s->min = min;
+  s->max = max;
+  type->load_data(s, &r);
+  if (r.p != r.end) rb_raise(rb_eArgError, "trailing bytes in %s dump", type->name);
+  return obj;
+}
+
+static VALUE rb_gsl_sketch_tdigest_load(VALUE klass, VALUE str)
+{
+  return sketch_load(klass, &td_type, str);
+}
+
+static VALUE rb_gsl_sketch_kll_load(VALUE klass, VALUE str)
+{
+  return sketch_load(klass, &kll_type, str);
+}
+
+static VALUE rb_gsl_sketch_ddsketch_load(VALUE klass, VALUE str)
+{
+  return sketch_load(klass, &dd_type, str);
+}
+
+/* the number of centroids, items or buckets kept */
+static VALUE rb_gsl_sketch_size(VALUE obj)
+{
+  mygsl_sketch *s = get_sketch(obj);
+  s->type->prepare(s);
+  switch (s->type->id) {
+  case SKETCH_TDIGEST: return SIZET2NUM(((mygsl_tdigest *) s)->nc);
+  case SKETCH_KLL: return SIZET2NUM(((mygsl_kll *) s)->size);
+  default: return SIZET2NUM(((mygsl_ddsketch *) s)->pos.n + ((mygsl_ddsketch *) s)->neg.n);
+  }
+}
+
+void Init_gsl_sketch(VALUE module)
+{
+  VALUE ctdigest, ckll, cddsketch;
+
+  cgsl_sketch = rb_define_class_under(module, "Sketch", cGSL_Object);
+  ctdigest = rb_define_class_under(cgsl_sketch, "TDigest", cgsl_sketch);
+  ckll = rb_define_class_under(cgsl_sketch, "KLL", cgsl_sketch);
+  cddsketch = rb_define_class_under(cgsl_sketch, "DDSketch", cgsl_sketch);
+
+  rb_define_singleton_method(ctdigest, "new", rb_gsl_sketch_tdigest_new, -1);
+  rb_define_singleton_method(ctdigest, "alloc", rb_gsl_sketch_tdigest_new, -1);
+  rb_define_singleton_method(ctdigest, "load", rb_gsl_sketch_tdigest_load, 1);
+  rb_define_singleton_method(ctdigest, "_load", rb_gsl_sketch_tdigest_load, 1);
+  rb_define_singleton_method(ckll, "new", rb_gsl_sketch_kll_new, -1);
+  rb_define_singleton_method(ckll, "alloc", rb_gsl_sketch_kll_new, -1);
+  rb_define_singleton_method(ckll, "load", rb_gsl_sketch_kll_load, 1);
+  rb_define_singleton_method(ckll, "_load", rb_gsl_sketch_kll_load, 1);
+  rb_define_singleton_method(cddsketch, "new", rb_gsl_sketch_ddsketch_new, -1);
+  rb_define_singleton_method(cddsketch, "alloc", rb_gsl_sketch_ddsketch_new, -1);
+  rb_define_singleton_method(cddsketch, "load", rb_gsl_sketch_ddsketch_load, 1);
+  rb_define_singleton_method(cddsketch, "_load", rb_gsl_sketch_ddsketch_load, 1);
+
+  rb_define_method(cgsl_sketch, "add", rb_gsl_sketch_add, -1);
+  rb_define_method(cgsl_sketch, "<<", rb_gsl_sketch_push, 1);
+  rb_define_method(cgsl_sketch, "quantile", rb_gsl_sketch_quantile, 1);
+  rb_define_method(cgsl_sketch, "median", rb_gsl_sketch_median, 0);
+  rb_define_method(cgsl_sketch, "cdf", rb_gsl_sketch_cdf, 1);
+  rb_define_method(cgsl_sketch, "count", rb_gsl_sketch_count, 0);
+  rb_define_method(cgsl_sketch, "min", rb_gsl_sketch_min, 0);
+  rb_define_method(cgsl_sketch, "max", rb_gsl_sketch_max, 0);
+  rb_define_method(cgsl_sketch, "empty?", rb_gsl_sketch_empty, 0);
+  rb_define_method(cgsl_sketch, "size", rb_gsl_sketch_size, 0);
+  rb_define_method(cgsl_sketch, "merge!", rb_gsl_sketch_merge_bang, 1);
+  rb_define_method(cgsl_sketch, "merge", rb_gsl_sketch_merge, 1);
+  rb_define_alias(cgsl_sketch, "+", "merge");
+  rb_define_method(cgsl_sketch, "clone", rb_gsl_sketch_clone, 0);
+  rb_define_alias(cgsl_sketch, "duplicate", "clone");
+  rb_define_method(cgsl_sketch, "reset", rb_gsl_sketch_reset, 0);
+  rb_define_method(cgsl_sketch, "dump", rb_gsl_sketch_dump, -1);
+  rb_define_method(cgsl_sketch, "_dump", rb_gsl_sketch_dump, -1);
+}
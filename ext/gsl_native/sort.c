@@ -12,6 +12,9 @@
 #include "include/rb_gsl_array.h"
 #include <gsl/gsl_heapsort.h>
 #include <gsl/gsl_sort.h>
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_parallel.h"
+#include <stdint.h>
 
 EXTERN ID RBGSL_ID_call;
 EXTERN VALUE cgsl_complex;
@@ -185,6 +188,909 @@ static VALUE rb_gsl_sort_index_narray(VALUE obj)
 }
 #endif
 
+/*****/
+
+/*
+  Radix and merge sorts of Vector and Vector::Int. The values are sorted
+  as unsigned 64-bit keys: the bits of a double with the sign bit set
+  (positive) or all bits flipped (negative), an int with its sign bit
+  flipped, so that the keys compare like the values. NaNs go to the ends,
+  by their sign bit, and -0 comes before 0. Both sorts are stable and
+  can carry an array of indices along, which gives argsort.
+
+  The radix sort runs 11-bit LSD passes, skipping the passes whose digit
+  is the same for all keys. Each thread counts and then scatters its own
+  slice of the keys, at offsets ordered by digit then thread. The merge
+  sort sorts one run per thread and merges pairs of runs in parallel.
+*/
+
+#define SORT_RADIX_BITS 11
+#define SORT_RADIX (1 << SORT_RADIX_BITS)
+#define SORT_RADIX_PASSES 6
+#define SORT_INSERTION 32
+/* below this size the sorts run on one thread */
+#define SORT_PARALLEL_MIN 65536
+
+static uint64_t sort_key_double(double x)
+{
+  uint64_t u;
+  memcpy(&u, &x, 8);
+  return (u >> 63) ? ~u : u | (UINT64_C(1) << 63);
+}
+
+static double sort_unkey_double(uint64_t u)
+{
+  double x;
+  u = (u >> 63) ? u & ~(UINT64_C(1) << 63) : ~u;
+  memcpy(&x, &u, 8);
+  return x;
+}
+
+static uint64_t sort_key_int(int x)
+{
+  return (uint64_t) (int64_t) x ^ (UINT64_C(1) << 63);
+}
+
+static int sort_unkey_int(uint64_t u)
+{
+  return (int) (int64_t) (u ^ (UINT64_C(1) << 63));
+}
+
+typedef struct {
+  uint64_t *key[2];
+  size_t *idx[2];       /* NULL without indices */
+  size_t n;
+  int cur, shift;
+  size_t *count;        /* SORT_RADIX counters per thread */
+  size_t *bounds;       /* merge sort: runs */
+  size_t nruns;
+} sort_job;
+
+static void sort_run(size_t nthreads, rb_gsl_parallel_func f, sort_job *job)
+{
+  if (nthreads > 1) rb_gsl_parallel_run(nthreads, f, job);
+  else f(0, 1, job);
+}
+
+static void sort_radix_count(size_t tid, size_t nthreads, void *data)
+{
+  sort_job *job = (sort_job *) data;
+  size_t start = job->n * tid / nthreads, end = job->n * (tid + 1) / nthreads, i;
+  size_t *c = job->count + tid * SORT_RADIX;
+  const uint64_t *k = job->key[job->cur];
+  memset(c, 0, SORT_RADIX * sizeof(size_t));
+  for (i = start; i < end; i++) c[(k[i] >> job->shift) & (SORT_RADIX - 1)]++;
+}
+
+static void sort_radix_scatter(size_t tid, size_t nthreads, void *data)
+{
+  sort_job *job = (sort_job *) data;
+  size_t start = job->n * tid / nthreads, end = job->n * (tid + 1) / nthreads, i, p;
+  size_t *c = job->count + tid * SORT_RADIX;
+  const uint64_t *k = job->key[job->cur];
+  uint64_t *dst = job->key[!job->cur];
+  const size_t *isrc = job->idx[job->cur];
+  size_t *idst = job->idx[!job->cur];
+  for (i = start; i < end; i++) {
+    p = c[(k[i] >> job->shift) & (SORT_RADIX - 1)]++;
+    dst[p] = k[i];
+    if (isrc) idst[p] = isrc[i];
+  }
+}
+
+static void sort_radix(sort_job *job, size_t nthreads)
+{
+  size_t pass, d, t, pos, tmp, d0, same;
+  for (pass = 0; pass < SORT_RADIX_PASSES; pass++) {
+    job->shift = (int) (pass * SORT_RADIX_BITS);
+    sort_run(nthreads, sort_radix_count, job);
+    d0 = (job->key[job->cur][0] >> job->shift) & (SORT_RADIX - 1);
+    for (same = 0, t = 0; t < nthreads; t++) same += job->count[t * SORT_RADIX + d0];
+    if (same == job->n) continue;
+    for (pos = 0, d = 0; d < SORT_RADIX; d++) {
+      for (t = 0; t < nthreads; t++) {
+        tmp = job->count[t * SORT_RADIX + d];
+        job->count[t * SORT_RADIX + d] = pos;
+        pos += tmp;
+      }
+    }
+    sort_run(nthreads, sort_radix_scatter, job);
+    job->cur = !job->cur;
+  }
+}
+
+/* merges [lo, mid) and [mid, hi) of src into dst, left first on ties */
+static void sort_merge_runs(const uint64_t *src, const size_t *isrc, uint64_t *dst, size_t *idst,
+                            size_t lo, size_t mid, size_t hi)
+{
+  size_t i = lo, j = mid, k = lo;
+  while (i < mid && j < hi) {
+    if (src[j] < src[i]) {
+      if (isrc) idst[k] = isrc[j];
+      dst[k++] = src[j++];
+    } else {
+      if (isrc) idst[k] = isrc[i];
+      dst[k++] = src[i++];
+    }
+  }
+  for (; i < mid; i++, k++) {
+    if (isrc) idst[k] = isrc[i];
+    dst[k] = src[i];
+  }
+  for (; j < hi; j++, k++) {
+    if (isrc) idst[k] = isrc[j];
+    dst[k] = src[j];
+  }
+}
+
+/* sorts [lo, hi) of the current buffer, using the other one as scratch */
+static void sort_merge_local(sort_job *job, size_t lo, size_t hi)
+{
+  uint64_t *a = job->key[job->cur], *b = job->key[!job->cur], *s, *d, *tk, key;
+  size_t *ia = job->idx[job->cur], *ib = job->idx[!job->cur], *is, *id, *ti, i, j, w, l, ix = 0;
+  for (l = lo; l < hi; l += SORT_INSERTION) {
+    for (i = l + 1; i < l + SORT_INSERTION && i < hi; i++) {
+      key = a[i];
+      if (ia) ix = ia[i];
+      for (j = i; j > l && a[j - 1] > key; j--) {
+        a[j] = a[j - 1];
+        if (ia) ia[j] = ia[j - 1];
+      }
+      a[j] = key;
+      if (ia) ia[j] = ix;
+    }
+  }
+  s = a; is = ia; d = b; id = ib;
+  for (w = SORT_INSERTION; w < hi - lo; w *= 2) {
+    for (l = lo; l < hi; l += 2 * w)
+      sort_merge_runs(s, is, d, id, l, GSL_MIN(l + w, hi), GSL_MIN(l + 2 * w, hi));
+    tk = s; s = d; d = tk;
+    ti = is; is = id; id = ti;
+  }
+  if (s != a) {
+    memcpy(a + lo, s + lo, (hi - lo) * sizeof(uint64_t));
+    if (ia) memcpy(ia + lo, is + lo, (hi - lo) * sizeof(size_t));
+  }
+}
+
+static void sort_merge_first(size_t tid, size_t nthreads, void *data)
+{
+  sort_job *job = (sort_job *) data;
+  sort_merge_local(job, job->bounds[tid], job->bounds[tid + 1]);
+}
+
+/* one round: run pair tid of the current buffer, merged into the other */
+static void sort_merge_round(size_t tid, size_t nthreads, void *data)
+{
+  sort_job *job = (sort_job *) data;
+  size_t lo = job->bounds[2 * tid], mid, hi;
+  if (2 * tid + 2 <= job->nruns) {
+    mid = job->bounds[2 * tid + 1];
+    hi = job->bounds[2 * tid + 2];
+  } else {
+    mid = hi = job->bounds[2 * tid + 1];
+  }
+  sort_merge_runs(job->key[job->cur], job->idx[job->cur], job->key[!job->cur], job->idx[!job->cur],
+                  lo, mid, hi);
+}
+
+static void sort_merge(sort_job *job, size_t nthreads)
+{
+  size_t t, npairs;
+  for (t = 0; t <= nthreads; t++) job->bounds[t] = job->n * t / nthreads;
+  job->nruns = nthreads;
+  sort_run(nthreads, sort_merge_first, job);
+  while (job->nruns > 1) {
+    npairs = (job->nruns + 1) / 2;
+    sort_run(npairs, sort_merge_round, job);
+    for (t = 0; t < npairs; t++) job->bounds[t + 1] = job->bounds[GSL_MIN(2 * t + 2, job->nruns)];
+    job->nruns = npairs;
+    job->cur = !job->cur;
+  }
+}
+
+static void* sort_tmp_alloc(VALUE holder, size_t n, size_t size)
+{
+  void *p;
+  if (size > 0 && n > SIZE_MAX / size) rb_raise(rb_eNoMemError, "array too large to sort");
+  p = malloc(n * size > 0 ? n * size : 1);
+  if (p == NULL) rb_raise(rb_eNoMemError, "failed to allocate %lu bytes for sorting", (unsigned long) (n * size));
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, free, p));
+  return p;
+}
+
+/*
+  Sorts the n keys, permuting idx the same way if it is not NULL. The
+  result is left in key and idx.
+*/
+static void sort_keys(uint64_t *key, size_t *idx, size_t n, int merge, size_t nthreads, VALUE holder)
+{
+  sort_job job;
+  if (n < 2) return;
+  if (n < SORT_PARALLEL_MIN) nthreads = 1;
+  if (n < 1024) merge = 1;
+  memset(&job, 0, sizeof(sort_job));
+  job.n = n;
+  job.key[0] = key;
+  job.key[1] = (uint64_t *) sort_tmp_alloc(holder, n, sizeof(uint64_t));
+  job.idx[0] = idx;
+  job.idx[1] = idx ? (size_t *) sort_tmp_alloc(holder, n, sizeof(size_t)) : NULL;
+  if (merge) {
+    job.bounds = (size_t *) sort_tmp_alloc(holder, nthreads + 1, sizeof(size_t));
+    sort_merge(&job, nthreads);
+  } else {
+    job.count = (size_t *) sort_tmp_alloc(holder, nthreads * SORT_RADIX, sizeof(size_t));
+    sort_radix(&job, nthreads);
+  }
+  if (job.cur) {
+    memcpy(key, job.key[1], n * sizeof(uint64_t));
+    if (idx) memcpy(idx, job.idx[1], n * sizeof(size_t));
+  }
+}
+
+static void sort_check_vector(VALUE v)
+{
+  if (!VECTOR_P(v) && !VECTOR_INT_P(v))
+    rb_raise(rb_eTypeError, "wrong argument type %s (Vector or Vector::Int expected)",
+             rb_class2name(CLASS_OF(v)));
+}
+
+static size_t sort_vector_size(VALUE v)
+{
+  gsl_vector *x;
+  gsl_vector_int *xi;
+  if (VECTOR_INT_P(v)) {
+    Data_Get_Struct(v, gsl_vector_int, xi);
+    return xi->size;
+  }
+  Data_Get_Vector(v, x);
+  return x->size;
+}
+
+/* the bytes spanned by the elements of v, [*lo, *hi) */
+static void sort_vector_extent(VALUE v, const char **lo, const char **hi)
+{
+  gsl_vector *x;
+  gsl_vector_int *xi;
+  if (VECTOR_INT_P(v)) {
+    Data_Get_Struct(v, gsl_vector_int, xi);
+    *lo = (const char *) xi->data;
+    *hi = *lo + (xi->size > 0 ? ((xi->size - 1) * xi->stride + 1) * sizeof(int) : 0);
+  } else {
+    Data_Get_Vector(v, x);
+    *lo = (const char *) x->data;
+    *hi = *lo + (x->size > 0 ? ((x->size - 1) * x->stride + 1) * sizeof(double) : 0);
+  }
+}
+
+/*
+  0 if argv[i] shares no element with argv[0..i-1], 1 if it is the same
+  vector as one of them (as the same object, or a view of the same
+  elements); raises if it overlaps one in any other way.
+*/
+static int sort_vector_aliased(VALUE *argv, int i)
+{
+  const char *lo, *hi, *lo2, *hi2;
+  int j;
+  sort_vector_extent(argv[i], &lo, &hi);
+  for (j = 0; j < i; j++) {
+    if (argv[j] == argv[i]) return 1;
+    sort_vector_extent(argv[j], &lo2, &hi2);
+    if (lo >= hi2 || lo2 >= hi) continue;
+    if (lo == lo2 && hi == hi2 && VECTOR_INT_P(argv[i]) == VECTOR_INT_P(argv[j])
+        && sort_vector_size(argv[i]) == sort_vector_size(argv[j]))
+      return 1;
+    rb_raise(rb_eArgError, "vectors %d and %d overlap", j, i);
+  }
+  return 0;
+}
+
+static uint64_t* sort_vector_keys(VALUE v, VALUE holder)
+{
+  gsl_vector *x;
+  gsl_vector_int *xi;
+  uint64_t *key;
+  size_t i;
+  if (VECTOR_INT_P(v)) {
+    Data_Get_Struct(v, gsl_vector_int, xi);
+    key = (uint64_t *) sort_tmp_alloc(holder, xi->size, sizeof(uint64_t));
+    for (i = 0; i < xi->size; i++) key[i] = sort_key_int(xi->data[i * xi->stride]);
+  } else {
+    Data_Get_Vector(v, x);
+    key = (uint64_t *) sort_tmp_alloc(holder, x->size, sizeof(uint64_t));
+    for (i = 0; i < x->size; i++) key[i] = sort_key_double(x->data[i * x->stride]);
+  }
+  return key;
+}
+
+static void sort_vector_store(VALUE v, const uint64_t *key)
+{
+  gsl_vector *x;
+  gsl_vector_int *xi;
+  size_t i;
+  if (VECTOR_INT_P(v)) {
+    Data_Get_Struct(v, gsl_vector_int, xi);
+    for (i = 0; i < xi->size; i++) xi->data[i * xi->stride] = sort_unkey_int(key[i]);
+  } else {
+    Data_Get_Vector(v, x);
+    for (i = 0; i < x->size; i++) x->data[i * x->stride] = sort_unkey_double(key[i]);
+  }
+}
+
+/* v[i] = v[idx[i]] */
+static void sort_vector_gather(VALUE v, const size_t *idx, VALUE holder)
+{
+  gsl_vector *x;
+  gsl_vector_int *xi;
+  double *tmp;
+  int *tmpi;
+  size_t i;
+  if (VECTOR_INT_P(v)) {
+    Data_Get_Struct(v, gsl_vector_int, xi);
+    tmpi = (int *) sort_tmp_alloc(holder, xi->size, sizeof(int));
+    for (i = 0; i < xi->size; i++) tmpi[i] = xi->data[idx[i] * xi->stride];
+    for (i = 0; i < xi->size; i++) xi->data[i * xi->stride] = tmpi[i];
+  } else {
+    Data_Get_Vector(v, x);
+    tmp = (double *) sort_tmp_alloc(holder, x->size, sizeof(double));
+    for (i = 0; i < x->size; i++) tmp[i] = x->data[idx[i] * x->stride];
+    for (i = 0; i < x->size; i++) x->data[i * x->stride] = tmp[i];
+  }
+}
+
+static VALUE sort_vector_clone(VALUE v)
+{
+  gsl_vector *x, *xnew;
+  gsl_vector_int *xi, *xinew;
+  if (VECTOR_INT_P(v)) {
+    Data_Get_Struct(v, gsl_vector_int, xi);
+    xinew = gsl_vector_int_alloc(xi->size);
+    gsl_vector_int_memcpy(xinew, xi);
+    return Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, xinew);
+  }
+  Data_Get_Vector(v, x);
+  xnew = gsl_vector_alloc(x->size);
+  gsl_vector_memcpy(xnew, x);
+  return Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, xnew);
+}
+
+/* :radix (default) or :merge */
+static int sort_get_algorithm(VALUE opts)
+{
+  VALUE alg = rb_gsl_hash_get(opts, "algorithm");
+  const char *name;
+  if (NIL_P(alg)) return 0;
+  name = SYMBOL_P(alg) ? rb_id2name(SYM2ID(alg)) : StringValuePtr(alg);
+  if (strcmp(name, "radix") == 0) return 0;
+  if (strcmp(name, "merge") == 0) return 1;
+  rb_raise(rb_eArgError, "unknown sort algorithm %s (radix or merge expected)", name);
+  return 0;
+}
+
+static VALUE sort_vector(VALUE obj, VALUE opts, int merge)
+{
+  VALUE holder = rb_ary_new();
+  uint64_t *key = sort_vector_keys(obj, holder);
+  sort_keys(key, NULL, sort_vector_size(obj), merge, rb_gsl_parallel_threads(opts), holder);
+  sort_vector_store(obj, key);
+  RB_GC_GUARD(holder);
+  return obj;
+}
+
+/*
+  Vector#radix_sort!(threads: n), Vector::Int#radix_sort!
+  Vector#merge_sort!(threads: n), Vector::Int#merge_sort!
+*/
+static VALUE rb_gsl_vector_radix_sort_bang(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE opts = Qnil;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 0) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0)", argc);
+  return sort_vector(obj, opts, 0);
+}
+
+static VALUE rb_gsl_vector_radix_sort(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_vector_radix_sort_bang(argc, argv, sort_vector_clone(obj));
+}
+
+static VALUE rb_gsl_vector_merge_sort_bang(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE opts = Qnil;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 0) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0)", argc);
+  return sort_vector(obj, opts, 1);
+}
+
+static VALUE rb_gsl_vector_merge_sort(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_vector_merge_sort_bang(argc, argv, sort_vector_clone(obj));
+}
+
+/* the stable sort order of v, in idx */
+static void sort_vector_index(VALUE v, size_t *idx, VALUE opts, VALUE holder)
+{
+  uint64_t *key = sort_vector_keys(v, holder);
+  size_t i, n = sort_vector_size(v);
+  for (i = 0; i < n; i++) idx[i] = i;
+  sort_keys(key, idx, n, sort_get_algorithm(opts), rb_gsl_parallel_threads(opts), holder);
+}
+
+/*
+  Vector#argsort(algorithm: :radix, as: GSL::Permutation, threads: n)
+
+  The permutation p which sorts the vector, v[p[0]] <= v[p[1]] <= ...,
+  with equal elements kept in their order. as: GSL::Vector::Int returns
+  it as a Vector::Int.
+*/
+static VALUE rb_gsl_vector_argsort(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE opts = Qnil, as, holder = rb_ary_new(), vp;
+  gsl_permutation *p;
+  gsl_vector_int *vi;
+  size_t i, n = sort_vector_size(obj);
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 0) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0)", argc);
+  as = rb_gsl_hash_get(opts, "as");
+  p = gsl_permutation_alloc(n > 0 ? n : 1);
+  vp = Data_Wrap_Struct(cgsl_permutation, 0, gsl_permutation_free, p);
+  p->size = n;
+  sort_vector_index(obj, p->data, opts, holder);
+  RB_GC_GUARD(holder);
+  if (NIL_P(as) || as == cgsl_permutation) return vp;
+  if (as != cgsl_vector_int) rb_raise(rb_eArgError, "as: must be GSL::Permutation or GSL::Vector::Int");
+  vi = gsl_vector_int_alloc(n > 0 ? n : 1);
+  vi->size = n;
+  for (i = 0; i < n; i++) vi->data[i] = (int) p->data[i];
+  return Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, vi);
+}
+
+/*
+  GSL.sort_by_key!(keys, *values, algorithm: :radix, threads: n)
+
+  Sorts the Vector or Vector::Int keys, and moves the elements of each
+  of the values (Vectors or Vector::Ints of the same size) along with
+  them. A vector given twice is moved once. Returns keys.
+*/
+static VALUE rb_gsl_sort_by_key_bang(int argc, VALUE *argv, VALUE module)
+{
+  VALUE opts = Qnil, holder = rb_ary_new();
+  size_t *idx, n;
+  int i, *skip;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc < 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or more)", argc);
+  for (i = 0; i < argc; i++) sort_check_vector(argv[i]);
+  n = sort_vector_size(argv[0]);
+  for (i = 1; i < argc; i++) {
+    if (sort_vector_size(argv[i]) != n)
+      rb_raise(rb_eArgError, "vector %d has size %d, keys %d", i, (int) sort_vector_size(argv[i]), (int) n);
+  }
+  skip = ALLOCA_N(int, argc);
+  for (i = 0; i < argc; i++) skip[i] = sort_vector_aliased(argv, i);
+  idx = (size_t *) sort_tmp_alloc(holder, n, sizeof(size_t));
+  sort_vector_index(argv[0], idx, opts, holder);
+  for (i = 0; i < argc; i++)
+    if (!skip[i]) sort_vector_gather(argv[i], idx, holder);
+  RB_GC_GUARD(holder);
+  return argv[0];
+}
+
+/* GSL.sort_by_key(keys, *values), sorted copies in an Array */
+static VALUE rb_gsl_sort_by_key(int argc, VALUE *argv, VALUE module)
+{
+  VALUE ary = rb_ary_new2(argc), *args;
+  int i, n = argc;
+  if (n > 0 && TYPE(argv[n - 1]) == T_HASH) n--;
+  args = ALLOCA_N(VALUE, argc);
+  for (i = 0; i < argc; i++) {
+    if (i < n) {
+      sort_check_vector(argv[i]);
+      args[i] = sort_vector_clone(argv[i]);
+      rb_ary_push(ary, args[i]);
+    } else {
+      args[i] = argv[i];
+    }
+  }
+  rb_gsl_sort_by_key_bang(argc, args, module);
+  return ary;
+}
+
+/*****/
+
+/*
+  Selection: top_k, nth_element! and partition! for Vector, Vector::Int
+  and the rows of Matrix and Matrix::Int. Elements are compared through
+  the keys of the radix sort, so the order (and the place of NaNs) is
+  the one radix_sort gives. top_k keeps the indices of the k best
+  elements seen in a heap whose root is the worst of them, which costs
+  O(n + k log k) for most inputs and O(n log k) at worst; nth_element!
+  is a quickselect on the median of three, falling back to a heapsort
+  of the remaining range if it partitions badly too often.
+*/
+
+enum {
+  SEL_TOP_K, SEL_NTH, SEL_PARTITION,
+};
+
+typedef struct {
+  char *data;
+  size_t stride;        /* in elements */
+  int isint;
+} sel_array;
+
+static uint64_t sel_key(const sel_array *a, size_t i)
+{
+  if (a->isint) return sort_key_int(((const int *) a->data)[i * a->stride]);
+  return sort_key_double(((const double *) a->data)[i * a->stride]);
+}
+
+static void sel_swap(const sel_array *a, size_t i, size_t j)
+{
+  int ti;
+  double t;
+  if (a->isint) {
+    int *x = (int *) a->data;
+    ti = x[i * a->stride];
+    x[i * a->stride] = x[j * a->stride];
+    x[j * a->stride] = ti;
+  } else {
+    double *x = (double *) a->data;
+    t = x[i * a->stride];
+    x[i * a->stride] = x[j * a->stride];
+    x[j * a->stride] = t;
+  }
+}
+
+/* element i ranks after element j; ties go to the lower index */
+static int sel_worse(const sel_array *a, size_t i, size_t j, int largest)
+{
+  uint64_t ki = sel_key(a, i), kj = sel_key(a, j);
+  if (ki != kj) return largest ? ki < kj : ki > kj;
+  return i > j;
+}
+
+static void sel_sift(const sel_array *a, size_t *h, size_t n, size_t r, int largest)
+{
+  size_t c, t;
+  for (;;) {
+    c = 2 * r + 1;
+    if (c >= n) break;
+    if (c + 1 < n && sel_worse(a, h[c + 1], h[c], largest)) c++;
+    if (!sel_worse(a, h[c], h[r], largest)) break;
+    t = h[r];
+    h[r] = h[c];
+    h[c] = t;
+    r = c;
+  }
+}
+
+/* the indices of the k best of the n elements, best first, in h */
+static void sel_top_k(const sel_array *a, size_t n, size_t k, int largest, size_t *h)
+{
+  size_t i, r, m, t;
+  for (i = 0; i < k; i++) h[i] = i;
+  for (r = k / 2; r-- > 0; ) sel_sift(a, h, k, r, largest);
+  for (i = k; i < n; i++) {
+    if (sel_worse(a, h[0], i, largest)) {
+      h[0] = i;
+      sel_sift(a, h, k, 0, largest);
+    }
+  }
+  for (m = k; m > 1; ) {
+    m--;
+    t = h[0];
+    h[0] = h[m];
+    h[m] = t;
+    sel_sift(a, h, m, 0, largest);
+  }
+}
+
+static void sel_sift_down(const sel_array *a, size_t lo, size_t n, size_t s)
+{
+  size_t c;
+  for (; (c = 2 * s + 1) < n; s = c) {
+    if (c + 1 < n && sel_key(a, lo + c + 1) > sel_key(a, lo + c)) c++;
+    if (sel_key(a, lo + c) <= sel_key(a, lo + s)) break;
+    sel_swap(a, lo + s, lo + c);
+  }
+}
+
+/* heapsort of the elements [lo, hi) in place */
+static void sel_heapsort(const sel_array *a, size_t lo, size_t hi)
+{
+  size_t n = hi - lo, r, m;
+  for (r = n / 2; r-- > 0; ) sel_sift_down(a, lo, n, r);
+  for (m = n; m > 1; ) {
+    m--;
+    sel_swap(a, lo, lo + m);
+    sel_sift_down(a, lo, m, 0);
+  }
+}
+
+/*
+  Moves the element of rank k to position k, smaller or equal ones
+  before it and greater or equal ones after.
+*/
+static void sel_nth(const sel_array *a, size_t n, size_t k)
+{
+  size_t lo = 0, hi = n - 1, mid, budget = 64;
+  ptrdiff_t i, j;
+  uint64_t p;
+  for (mid = n; mid > 1; mid /= 2) budget += 2;
+  while (hi > lo) {
+    if (budget-- == 0) {
+      sel_heapsort(a, lo, hi + 1);
+      return;
+    }
+    mid = lo + (hi - lo) / 2;
+    if (sel_key(a, mid) < sel_key(a, lo)) sel_swap(a, lo, mid);
+    if (sel_key(a, hi) < sel_key(a, lo)) sel_swap(a, lo, hi);
+    if (sel_key(a, hi) < sel_key(a, mid)) sel_swap(a, mid, hi);
+    p = sel_key(a, mid);
+    i = (ptrdiff_t) lo;
+    j = (ptrdiff_t) hi;
+    while (i <= j) {
+      while (sel_key(a, i) < p) i++;
+      while (sel_key(a, j) > p) j--;
+      if (i <= j) {
+        sel_swap(a, i, j);
+        i++;
+        j--;
+      }
+    }
+    /* [lo, j] <= p, [i, hi] >= p, and p in between */
+    if ((ptrdiff_t) k <= j) hi = (size_t) j;
+    else if ((ptrdiff_t) k >= i) lo = (size_t) i;
+    else return;
+  }
+}
+
+/* moves the elements below pivot to the front, returns their number */
+static size_t sel_partition(const sel_array *a, size_t n, uint64_t pivot)
+{
+  size_t i = 0, j;
+  for (j = 0; j < n; j++) {
+    if (sel_key(a, j) < pivot) {
+      if (i != j) sel_swap(a, i, j);
+      i++;
+    }
+  }
+  return i;
+}
+
+typedef struct {
+  int op, isint, largest;
+  char *data;
+  size_t nrows, n, tda, stride;     /* row r starts at element r*tda */
+  size_t k;
+  uint64_t pivot;
+  size_t *heap;                     /* k per thread, or index for a vector */
+  char *out;                        /* top_k values (k per row), nth values */
+  size_t *index;                    /* top_k indices of a vector */
+  int *index_int;                   /* top_k indices of matrix rows, k per row */
+  int *count;                       /* partition counts */
+} sel_job;
+
+static void sel_row(sel_job *job, size_t r, size_t *heap)
+{
+  size_t esize = job->isint ? sizeof(int) : sizeof(double), j;
+  sel_array a;
+  a.data = job->data + r * job->tda * esize;
+  a.stride = job->stride;
+  a.isint = job->isint;
+  switch (job->op) {
+  case SEL_TOP_K:
+    sel_top_k(&a, job->n, job->k, job->largest, heap);
+    for (j = 0; j < job->k; j++) {
+      if (job->isint) ((int *) job->out)[r * job->k + j] = ((int *) a.data)[heap[j] * a.stride];
+      else ((double *) job->out)[r * job->k + j] = ((double *) a.data)[heap[j] * a.stride];
+      if (job->index && job->index != heap) job->index[j] = heap[j];
+      if (job->index_int) job->index_int[r * job->k + j] = (int) heap[j];
+    }
+    break;
+  case SEL_NTH:
+    sel_nth(&a, job->n, job->k);
+    if (job->isint) ((int *) job->out)[r] = ((int *) a.data)[job->k * a.stride];
+    else ((double *) job->out)[r] = ((double *) a.data)[job->k * a.stride];
+    break;
+  default:
+    job->count[r] = (int) sel_partition(&a, job->n, job->pivot);
+    break;
+  }
+}
+
+static void sel_worker(size_t tid, size_t nthreads, void *data)
+{
+  sel_job *job = (sel_job *) data;
+  size_t r;
+  for (r = tid; r < job->nrows && !rb_gsl_parallel_interrupted(); r += nthreads) sel_row(job, r, job->heap + tid * job->k);
+}
+
+/* the elements of obj, a vector or the rows of a matrix; returns 1 for a matrix */
+static int sel_get(VALUE obj, sel_job *job)
+{
+  gsl_vector *v;
+  gsl_vector_int *vi;
+  gsl_matrix *m;
+  gsl_matrix_int *mi;
+  if (MATRIX_INT_P(obj)) {
+    Data_Get_Struct(obj, gsl_matrix_int, mi);
+    job->data = (char *) mi->data;
+    job->nrows = mi->size1;
+    job->n = mi->size2;
+    job->tda = mi->tda;
+    job->stride = 1;
+    job->isint = 1;
+    return 1;
+  } else if (MATRIX_P(obj)) {
+    Data_Get_Struct(obj, gsl_matrix, m);
+    job->data = (char *) m->data;
+    job->nrows = m->size1;
+    job->n = m->size2;
+    job->tda = m->tda;
+    job->stride = 1;
+    return 1;
+  } else if (VECTOR_INT_P(obj)) {
+    Data_Get_Struct(obj, gsl_vector_int, vi);
+    job->data = (char *) vi->data;
+    job->n = vi->size;
+    job->stride = vi->stride;
+    job->isint = 1;
+  } else {
+    Data_Get_Vector(obj, v);
+    job->data = (char *) v->data;
+    job->n = v->size;
+    job->stride = v->stride;
+  }
+  job->nrows = 1;
+  return 0;
+}
+
+static void sel_run(sel_job *job, VALUE opts, int matrix, VALUE holder)
+{
+  size_t nthreads = matrix ? rb_gsl_parallel_threads(opts) : 1;
+  if (nthreads > job->nrows) nthreads = job->nrows;
+  if (nthreads < 1 || job->nrows * job->n < SORT_PARALLEL_MIN) nthreads = 1;
+  if (job->op == SEL_TOP_K && job->heap == NULL)
+    job->heap = (size_t *) sort_tmp_alloc(holder, nthreads * job->k, sizeof(size_t));
+  if (job->nrows == 0) return;
+  if (nthreads > 1) rb_gsl_parallel_run(nthreads, sel_worker, job);
+  else sel_worker(0, 1, job);
+}
+
+/*
+  Vector#top_k(k, largest: true, index: false)
+  Matrix#top_k(k, largest: true, index: false, threads: n)
+
+  The k largest (or smallest) elements, best first; of each row for a
+  matrix. With index: true, an Array of the values and their indices
+  (a GSL::Index for a vector, a Matrix::Int for a matrix).
+*/
+static VALUE rb_gsl_top_k(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE opts = Qnil, holder = rb_ary_new(), vals, idx = Qnil, largest;
+  sel_job job;
+  gsl_vector *v;
+  gsl_vector_int *vi;
+  gsl_matrix *m;
+  gsl_matrix_int *mi;
+  gsl_index *p;
+  int matrix;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1)", argc);
+  memset(&job, 0, sizeof(sel_job));
+  matrix = sel_get(obj, &job);
+  job.op = SEL_TOP_K;
+  job.k = NUM2ULONG(argv[0]);
+  largest = rb_gsl_hash_get(opts, "largest");
+  job.largest = NIL_P(largest) || RTEST(largest);
+  if (job.k < 1 || job.k > job.n) rb_raise(rb_eArgError, "k = %d out of [1, %d]", (int) job.k, (int) job.n);
+  if (matrix && job.isint) {
+    mi = gsl_matrix_int_alloc(job.nrows, job.k);
+    vals = Data_Wrap_Struct(cgsl_matrix_int, 0, gsl_matrix_int_free, mi);
+    job.out = (char *) mi->data;
+  } else if (matrix) {
+    m = gsl_matrix_alloc(job.nrows, job.k);
+    vals = Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, m);
+    job.out = (char *) m->data;
+  } else if (job.isint) {
+    vi = gsl_vector_int_alloc(job.k);
+    vals = Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, vi);
+    job.out = (char *) vi->data;
+  } else {
+    v = gsl_vector_alloc(job.k);
+    vals = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+    job.out = (char *) v->data;
+  }
+  if (RTEST(rb_gsl_hash_get(opts, "index"))) {
+    if (matrix) {
+      mi = gsl_matrix_int_alloc(job.nrows, job.k);
+      idx = Data_Wrap_Struct(cgsl_matrix_int, 0, gsl_matrix_int_free, mi);
+      job.index_int = mi->data;
+    } else {
+      p = gsl_permutation_alloc(job.k);
+      idx = Data_Wrap_Struct(cgsl_index, 0, gsl_permutation_free, p);
+      job.index = p->data;
+      /* a vector is done on one thread, whose heap can be the result */
+      job.heap = p->data;
+    }
+  }
+  sel_run(&job, opts, matrix, holder);
+  RB_GC_GUARD(holder);
+  if (NIL_P(idx)) return vals;
+  return rb_ary_new3(2, vals, idx);
+}
+
+/*
+  Vector#nth_element!(k), Matrix#nth_element!(k, threads: n)
+
+  Rearranges the elements (of each row) so that the one of rank k is at
+  position k, with no greater element before it and no smaller one
+  after. Returns that element, or a vector of them for a matrix.
+*/
+static VALUE rb_gsl_nth_element_bang(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE opts = Qnil, holder = rb_ary_new(), vals;
+  sel_job job;
+  gsl_vector *v;
+  gsl_vector_int *vi;
+  double x;
+  int xi, matrix;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1)", argc);
+  memset(&job, 0, sizeof(sel_job));
+  matrix = sel_get(obj, &job);
+  job.op = SEL_NTH;
+  job.k = NUM2ULONG(argv[0]);
+  if (job.k >= job.n) rb_raise(rb_eIndexError, "index %d out of range", (int) job.k);
+  if (!matrix) {
+    job.out = job.isint ? (char *) &xi : (char *) &x;
+    sel_run(&job, opts, 0, holder);
+    return job.isint ? INT2FIX(xi) : rb_float_new(x);
+  }
+  if (job.isint) {
+    vi = gsl_vector_int_alloc(job.nrows);
+    vals = Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, vi);
+    job.out = (char *) vi->data;
+  } else {
+    v = gsl_vector_alloc(job.nrows);
+    vals = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, v);
+    job.out = (char *) v->data;
+  }
+  sel_run(&job, opts, 1, holder);
+  return vals;
+}
+
+/*
+  Vector#partition!(pivot), Matrix#partition!(pivot, threads: n)
+
+  Moves the elements less than pivot to the front (of each row), and
+  returns how many there are: an Integer, or a Vector::Int for a matrix.
+*/
+static VALUE rb_gsl_partition_bang(int argc, VALUE *argv, VALUE obj)
+{
+  VALUE opts = Qnil, holder = rb_ary_new(), vals;
+  sel_job job;
+  gsl_vector_int *vi;
+  int count, matrix;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1)", argc);
+  memset(&job, 0, sizeof(sel_job));
+  matrix = sel_get(obj, &job);
+  job.op = SEL_PARTITION;
+  job.pivot = job.isint ? sort_key_int(NUM2INT(argv[0])) : sort_key_double(NUM2DBL(argv[0]));
+  if (!matrix) {
+    job.count = &count;
+    sel_run(&job, opts, 0, holder);
+    return INT2FIX(count);
+  }
+  vi = gsl_vector_int_alloc(job.nrows);
+  vals = Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, vi);
+  job.count = vi->data;
+  sel_run(&job, opts, 1, holder);
+  return vals;
+}
+
 void Init_gsl_sort(VALUE module)
 {
   rb_define_singleton_method(module, "heapsort!", rb_gsl_heapsort, 1);
@@ -199,6 +1105,32 @@ void Init_gsl_sort(VALUE module)
   rb_define_method(cgsl_vector_complex, "heapsort", rb_gsl_heapsort_vector_complex2, 0);
   rb_define_method(cgsl_vector_complex, "heapsort_index", rb_gsl_heapsort_index_vector_complex, 0);
 
+  rb_define_method(cgsl_vector, "radix_sort!", rb_gsl_vector_radix_sort_bang, -1);
+  rb_define_method(cgsl_vector, "radix_sort", rb_gsl_vector_radix_sort, -1);
+  rb_define_method(cgsl_vector, "merge_sort!", rb_gsl_vector_merge_sort_bang, -1);
+  rb_define_method(cgsl_vector, "merge_sort", rb_gsl_vector_merge_sort, -1);
+  rb_define_method(cgsl_vector, "argsort", rb_gsl_vector_argsort, -1);
+  rb_define_method(cgsl_vector_int, "radix_sort!", rb_gsl_vector_radix_sort_bang, -1);
+  rb_define_method(cgsl_vector_int, "radix_sort", rb_gsl_vector_radix_sort, -1);
+  rb_define_method(cgsl_vector_int, "merge_sort!", rb_gsl_vector_merge_sort_bang, -1);
+  rb_define_method(cgsl_vector_int, "merge_sort", rb_gsl_vector_merge_sort, -1);
+  rb_define_method(cgsl_vector_int, "argsort", rb_gsl_vector_argsort, -1);
+  rb_define_singleton_method(module, "sort_by_key!", rb_gsl_sort_by_key_bang, -1);
+  rb_define_singleton_method(module, "sort_by_key", rb_gsl_sort_by_key, -1);
+
+  rb_define_method(cgsl_vector, "top_k", rb_gsl_top_k, -1);
+  rb_define_method(cgsl_vector, "nth_element!", rb_gsl_nth_element_bang, -1);
+  rb_define_method(cgsl_vector, "partition!", rb_gsl_partition_bang, -1);
+  rb_define_method(cgsl_vector_int, "top_k", rb_gsl_top_k, -1);
+  rb_define_method(cgsl_vector_int, "nth_element!", rb_gsl_nth_element_bang, -1);
+  rb_define_method(cgsl_vector_int, "partition!", rb_gsl_partition_bang, -1);
+  rb_define_method(cgsl_matrix, "top_k", rb_gsl_top_k, -1);
+  rb_define_method(cgsl_matrix, "nth_element!", rb_gsl_nth_element_bang, -1);
+  rb_define_method(cgsl_matrix, "partition!", rb_gsl_partition_bang, -1);
+  rb_define_method(cgsl_matrix_int, "top_k", rb_gsl_top_k, -1);
+  rb_define_method(cgsl_matrix_int, "nth_element!", rb_gsl_nth_element_bang, -1);
+  rb_define_method(cgsl_matrix_int, "partition!", rb_gsl_partition_bang, -1);
+
 #ifdef HAVE_NARRAY_H
   rb_define_method(cNArray, "gsl_sort", rb_gsl_sort_narray, 0);
   rb_define_method(cNArray, "gsl_sort!", rb_gsl_sort_narray_bang, 0);
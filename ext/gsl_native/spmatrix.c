@@ -0,0 +1,860 @@
+/*
+  spmatrix.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  GSL::SpMatrix wraps gsl_spmatrix (GSL-2.6 or later) in triplet (COO),
+  compressed column (CSC) and compressed row (CSR) storage, and
+  GSL::Splinalg exposes the GMRES iterative solver of gsl_splinalg.
+*/
+
+#include "include/rb_gsl.h"
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_function.h"
+
+#ifdef GSL_2_6_LATER
+#include <gsl/gsl_spmatrix.h>
+#include <gsl/gsl_spblas.h>
+#include <gsl/gsl_splinalg.h>
+
+VALUE cgsl_spmatrix;
+static VALUE mgsl_splinalg, cgsl_splinalg_gmres;
+
+#define SPMATRIX_P(x) (rb_obj_is_kind_of(x,cgsl_spmatrix))
+#define CHECK_SPMATRIX(x) if(!rb_obj_is_kind_of(x,cgsl_spmatrix)) \
+    rb_raise(rb_eTypeError, "wrong argument type %s (GSL::SpMatrix expected)", rb_class2name(CLASS_OF(x)));
+
+static int rb_gsl_spmatrix_get_type(VALUE t)
+{
+  char name[16];
+  const char *p;
+  size_t i;
+  if (FIXNUM_P(t)) return FIX2INT(t);
+  if (SYMBOL_P(t)) p = rb_id2name(SYM2ID(t));
+  else p = StringValuePtr(t);
+  for (i = 0; i < sizeof(name) - 1 && p[i] != '\0'; i++) name[i] = tolower(p[i]);
+  name[i] = '\0';
+  if (strcmp(name, "coo") == 0 || strcmp(name, "triplet") == 0) return GSL_SPMATRIX_COO;
+  if (strcmp(name, "csc") == 0 || strcmp(name, "ccs") == 0) return GSL_SPMATRIX_CSC;
+  if (strcmp(name, "csr") == 0 || strcmp(name, "crs") == 0) return GSL_SPMATRIX_CSR;
+  rb_raise(rb_eArgError, "unknown sparse storage type %s (coo, csc or csr expected)", p);
+  return GSL_SPMATRIX_COO;
+}
+
+/* Returns a newly allocated triplet copy of m, whatever its storage. */
+static gsl_spmatrix* mygsl_spmatrix_coo(const gsl_spmatrix *m)
+{
+  gsl_spmatrix *t = NULL;
+  size_t j;
+  int p;
+  t = gsl_spmatrix_alloc_nzmax(m->size1, m->size2, GSL_MAX(m->nz, 1),
+                               GSL_SPMATRIX_COO);
+  if (GSL_SPMATRIX_ISCOO(m)) {
+    gsl_spmatrix_memcpy(t, m);
+  } else if (GSL_SPMATRIX_ISCSC(m)) {
+    for (j = 0; j < m->size2; j++)
+      for (p = m->p[j]; p < m->p[j+1]; p++) gsl_spmatrix_set(t, m->i[p], j, m->data[p]);
+  } else {
+    for (j = 0; j < m->size1; j++)
+      for (p = m->p[j]; p < m->p[j+1]; p++) gsl_spmatrix_set(t, j, m->i[p], m->data[p]);
+  }
+  return t;
+}
+
+/* Returns a newly allocated copy of m in the storage type sptype. */
+static gsl_spmatrix* mygsl_spmatrix_convert(const gsl_spmatrix *m, int sptype)
+{
+  gsl_spmatrix *t = NULL, *mnew = NULL;
+  if ((int) m->sptype == sptype) {
+    mnew = gsl_spmatrix_alloc_nzmax(m->size1, m->size2, GSL_MAX(m->nz, 1), sptype);
+    gsl_spmatrix_memcpy(mnew, m);
+    return mnew;
+  }
+  t = mygsl_spmatrix_coo(m);
+  if (sptype == GSL_SPMATRIX_COO) return t;
+  mnew = gsl_spmatrix_compress(t, sptype);
+  gsl_spmatrix_free(t);
+  return mnew;
+}
+
+static gsl_vector_int* get_spmatrix_index(VALUE obj, int *flag)
+{
+  gsl_vector_int *v = NULL;
+  if (TYPE(obj) == T_ARRAY) {
+    *flag = 1;
+    return make_cvector_int_from_rarray(obj);
+  }
+  CHECK_VECTOR_INT(obj);
+  Data_Get_Struct(obj, gsl_vector_int, v);
+  *flag = 0;
+  return v;
+}
+
+static gsl_vector* get_spmatrix_data(VALUE obj, int *flag)
+{
+  gsl_vector *v = NULL;
+  if (TYPE(obj) == T_ARRAY) {
+    *flag = 1;
+    return make_cvector_from_rarray(obj);
+  }
+  Data_Get_Vector(obj, v);
+  *flag = 0;
+  return v;
+}
+
+/* GSL::SpMatrix.alloc(size1, size2, nzmax = 1, type = "coo") */
+static VALUE rb_gsl_spmatrix_alloc(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_spmatrix *m = NULL;
+  size_t nzmax = 1;
+  int sptype = GSL_SPMATRIX_COO;
+  switch (argc) {
+  case 4:
+    sptype = rb_gsl_spmatrix_get_type(argv[3]);
+  /* no break */
+  case 3:
+    nzmax = GSL_MAX(NUM2ULONG(argv[2]), 1);
+  /* no break */
+  case 2:
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 2-4)", argc);
+  }
+  m = gsl_spmatrix_alloc_nzmax(NUM2ULONG(argv[0]), NUM2ULONG(argv[1]), nzmax, sptype);
+  return Data_Wrap_Struct(klass, 0, gsl_spmatrix_free, m);
+}
+
+/* GSL::SpMatrix.from_triplets(size1, size2, rows, cols, data, type = "coo") */
+static VALUE rb_gsl_spmatrix_from_triplets(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_spmatrix *t = NULL, *m = NULL;
+  gsl_vector_int *vi = NULL, *vj = NULL;
+  gsl_vector *vx = NULL;
+  int flagi, flagj, flagx, sptype = GSL_SPMATRIX_COO;
+  size_t k, n1, n2;
+  double *ptr;
+  switch (argc) {
+  case 6:
+    sptype = rb_gsl_spmatrix_get_type(argv[5]);
+    break;
+  case 5:
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 5 or 6)", argc);
+  }
+  n1 = NUM2ULONG(argv[0]);
+  n2 = NUM2ULONG(argv[1]);
+  vi = get_spmatrix_index(argv[2], &flagi);
+  vj = get_spmatrix_index(argv[3], &flagj);
+  vx = get_spmatrix_data(argv[4], &flagx);
+  if (vi->size != vj->size || vi->size != vx->size) {
+    if (flagi) gsl_vector_int_free(vi);
+    if (flagj) gsl_vector_int_free(vj);
+    if (flagx) gsl_vector_free(vx);
+    rb_raise(rb_eArgError, "rows, cols and data must have the same length");
+  }
+  t = gsl_spmatrix_alloc_nzmax(n1, n2, GSL_MAX(vx->size, 1), GSL_SPMATRIX_COO);
+  for (k = 0; k < vx->size; k++) {
+    int i = gsl_vector_int_get(vi, k), j = gsl_vector_int_get(vj, k);
+    if (i < 0 || j < 0 || (size_t) i >= n1 || (size_t) j >= n2) {
+      gsl_spmatrix_free(t);
+      if (flagi) gsl_vector_int_free(vi);
+      if (flagj) gsl_vector_int_free(vj);
+      if (flagx) gsl_vector_free(vx);
+      rb_raise(rb_eIndexError, "index (%d, %d) out of range", i, j);
+    }
+    /* Duplicate entries are summed, as in the usual triplet convention */
+    if ((ptr = gsl_spmatrix_ptr(t, i, j)) != NULL) *ptr += gsl_vector_get(vx, k);
+    else gsl_spmatrix_set(t, i, j, gsl_vector_get(vx, k));
+  }
+  if (flagi) gsl_vector_int_free(vi);
+  if (flagj) gsl_vector_int_free(vj);
+  if (flagx) gsl_vector_free(vx);
+  if (sptype == GSL_SPMATRIX_COO) return Data_Wrap_Struct(klass, 0, gsl_spmatrix_free, t);
+  m = gsl_spmatrix_compress(t, sptype);
+  gsl_spmatrix_free(t);
+  return Data_Wrap_Struct(klass, 0, gsl_spmatrix_free, m);
+}
+
+/* GSL::SpMatrix.from_matrix(m, type = "coo"), GSL::Matrix#to_sp(type = "coo") */
+static VALUE rb_gsl_spmatrix_from_matrix(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_matrix *A = NULL;
+  gsl_spmatrix *t = NULL, *m = NULL;
+  VALUE vA, vtype = Qnil;
+  int sptype = GSL_SPMATRIX_COO;
+  size_t i, j, nz = 0;
+  if (MATRIX_P(obj)) {
+    vA = obj;
+    if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+    if (argc == 1) vtype = argv[0];
+  } else {
+    if (argc < 1 || argc > 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+    vA = argv[0];
+    if (argc == 2) vtype = argv[1];
+  }
+  if (!NIL_P(vtype)) sptype = rb_gsl_spmatrix_get_type(vtype);
+  Data_Get_Matrix(vA, A);
+  for (i = 0; i < A->size1; i++)
+    for (j = 0; j < A->size2; j++) if (gsl_matrix_get(A, i, j) != 0.0) nz++;
+  t = gsl_spmatrix_alloc_nzmax(A->size1, A->size2, GSL_MAX(nz, 1), GSL_SPMATRIX_COO);
+  gsl_spmatrix_d2sp(t, A);
+  if (sptype == GSL_SPMATRIX_COO) return Data_Wrap_Struct(cgsl_spmatrix, 0, gsl_spmatrix_free, t);
+  m = gsl_spmatrix_compress(t, sptype);
+  gsl_spmatrix_free(t);
+  return Data_Wrap_Struct(cgsl_spmatrix, 0, gsl_spmatrix_free, m);
+}
+
+static VALUE rb_gsl_spmatrix_to_matrix(VALUE obj)
+{
+  gsl_spmatrix *m = NULL;
+  gsl_matrix *A = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  A = gsl_matrix_alloc(m->size1, m->size2);
+  gsl_spmatrix_sp2d(A, m);
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, A);
+}
+
+/* Returns [rows, cols, data] of the nonzero entries. */
+static VALUE rb_gsl_spmatrix_to_triplets(VALUE obj)
+{
+  gsl_spmatrix *m = NULL, *t = NULL;
+  gsl_vector_int *vi = NULL, *vj = NULL;
+  gsl_vector *vx = NULL;
+  size_t k;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  t = GSL_SPMATRIX_ISCOO(m) ? m : mygsl_spmatrix_coo(m);
+  vi = gsl_vector_int_alloc(GSL_MAX(t->nz, 1));
+  vj = gsl_vector_int_alloc(GSL_MAX(t->nz, 1));
+  vx = gsl_vector_alloc(GSL_MAX(t->nz, 1));
+  vi->size = vj->size = vx->size = t->nz;
+  for (k = 0; k < t->nz; k++) {
+    gsl_vector_int_set(vi, k, t->i[k]);
+    gsl_vector_int_set(vj, k, t->p[k]);
+    gsl_vector_set(vx, k, t->data[k]);
+  }
+  if (t != m) gsl_spmatrix_free(t);
+  return rb_ary_new3(3, Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, vi),
+                     Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, vj),
+                     Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vx));
+}
+
+static VALUE rb_gsl_spmatrix_get(VALUE obj, VALUE i, VALUE j)
+{
+  gsl_spmatrix *m = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  return rb_float_new(gsl_spmatrix_get(m, NUM2ULONG(i), NUM2ULONG(j)));
+}
+
+static VALUE rb_gsl_spmatrix_set(VALUE obj, VALUE i, VALUE j, VALUE x)
+{
+  gsl_spmatrix *m = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  gsl_spmatrix_set(m, NUM2ULONG(i), NUM2ULONG(j), NUM2DBL(x));
+  return obj;
+}
+
+static VALUE rb_gsl_spmatrix_size1(VALUE obj)
+{
+  gsl_spmatrix *m = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  return INT2FIX(m->size1);
+}
+
+static VALUE rb_gsl_spmatrix_size2(VALUE obj)
+{
+  gsl_spmatrix *m = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  return INT2FIX(m->size2);
+}
+
+static VALUE rb_gsl_spmatrix_shape(VALUE obj)
+{
+  gsl_spmatrix *m = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  return rb_ary_new3(2, INT2FIX(m->size1), INT2FIX(m->size2));
+}
+
+static VALUE rb_gsl_spmatrix_nnz(VALUE obj)
+{
+  gsl_spmatrix *m = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  return INT2FIX(gsl_spmatrix_nnz(m));
+}
+
+static VALUE rb_gsl_spmatrix_type(VALUE obj)
+{
+  gsl_spmatrix *m = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  return rb_str_new2(gsl_spmatrix_type(m));
+}
+
+/* GSL::SpMatrix#compress(type = "csc") */
+static VALUE rb_gsl_spmatrix_compress(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_spmatrix *m = NULL;
+  int sptype = GSL_SPMATRIX_CSC;
+  if (argc > 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  if (argc == 1) sptype = rb_gsl_spmatrix_get_type(argv[0]);
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  return Data_Wrap_Struct(cgsl_spmatrix, 0, gsl_spmatrix_free,
+                          mygsl_spmatrix_convert(m, sptype));
+}
+
+static VALUE rb_gsl_spmatrix_to_coo(VALUE obj)
+{
+  gsl_spmatrix *m = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  return Data_Wrap_Struct(cgsl_spmatrix, 0, gsl_spmatrix_free,
+                          mygsl_spmatrix_convert(m, GSL_SPMATRIX_COO));
+}
+
+static VALUE rb_gsl_spmatrix_to_csc(VALUE obj)
+{
+  gsl_spmatrix *m = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  return Data_Wrap_Struct(cgsl_spmatrix, 0, gsl_spmatrix_free,
+                          mygsl_spmatrix_convert(m, GSL_SPMATRIX_CSC));
+}
+
+static VALUE rb_gsl_spmatrix_to_csr(VALUE obj)
+{
+  gsl_spmatrix *m = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  return Data_Wrap_Struct(cgsl_spmatrix, 0, gsl_spmatrix_free,
+                          mygsl_spmatrix_convert(m, GSL_SPMATRIX_CSR));
+}
+
+static VALUE rb_gsl_spmatrix_clone(VALUE obj)
+{
+  gsl_spmatrix *m = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  return Data_Wrap_Struct(CLASS_OF(obj), 0, gsl_spmatrix_free,
+                          mygsl_spmatrix_convert(m, m->sptype));
+}
+
+static VALUE rb_gsl_spmatrix_transpose(VALUE obj)
+{
+  gsl_spmatrix *m = NULL, *mnew = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  mnew = gsl_spmatrix_alloc_nzmax(m->size2, m->size1, GSL_MAX(m->nz, 1), m->sptype);
+  gsl_spmatrix_transpose_memcpy(mnew, m);
+  return Data_Wrap_Struct(cgsl_spmatrix, 0, gsl_spmatrix_free, mnew);
+}
+
+static VALUE rb_gsl_spmatrix_scale_bang(VALUE obj, VALUE x)
+{
+  gsl_spmatrix *m = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  gsl_spmatrix_scale(m, NUM2DBL(x));
+  return obj;
+}
+
+static VALUE rb_gsl_spmatrix_scale(VALUE obj, VALUE x)
+{
+  return rb_gsl_spmatrix_scale_bang(rb_gsl_spmatrix_clone(obj), x);
+}
+
+/* y = A x for a dense vector x, without forming A densely. */
+static VALUE rb_gsl_spmatrix_mul_vector(gsl_spmatrix *A, VALUE vx)
+{
+  gsl_vector *x = NULL, *y = NULL;
+  Data_Get_Vector(vx, x);
+  if (x->size != A->size2)
+    rb_raise(rb_eRangeError, "vector length %d does not match matrix size2 %d",
+             (int) x->size, (int) A->size2);
+  y = gsl_vector_alloc(A->size1);
+  gsl_spblas_dgemv(CblasNoTrans, 1.0, A, x, 0.0, y);
+  return Data_Wrap_Struct(VECTOR_ROW_COL(vx), 0, gsl_vector_free, y);
+}
+
+#ifdef HAVE_NARRAY_H
+/* y = A x for an NArray x, returned as an NArray of the same class */
+static VALUE rb_gsl_spmatrix_mul_narray(gsl_spmatrix *A, VALUE na)
+{
+  gsl_vector_const_view x;
+  gsl_vector_view y;
+  VALUE ary;
+  int shape[1];
+  na = na_change_type(na, NA_DFLOAT);
+  if (NA_RANK(na) != 1 || (size_t) NA_TOTAL(na) != A->size2)
+    rb_raise(rb_eRangeError, "NArray of length %d does not match matrix size2 %d",
+             (int) NA_TOTAL(na), (int) A->size2);
+  shape[0] = (int) A->size1;
+  ary = na_make_object(NA_DFLOAT, 1, shape, CLASS_OF(na));
+  x = gsl_vector_const_view_array(NA_PTR_TYPE(na, double*), A->size2);
+  y = gsl_vector_view_array(NA_PTR_TYPE(ary, double*), A->size1);
+  gsl_spblas_dgemv(CblasNoTrans, 1.0, A, &x.vector, 0.0, &y.vector);
+  return ary;
+}
+#endif
+
+/* C = A B for a dense matrix B, one spblas_dgemv per column of B. */
+static VALUE rb_gsl_spmatrix_mul_matrix(gsl_spmatrix *A, VALUE vB)
+{
+  gsl_matrix *B = NULL, *C = NULL;
+  size_t j;
+  Data_Get_Matrix(vB, B);
+  if (B->size1 != A->size2)
+    rb_raise(rb_eRangeError, "matrix size mismatch (%dx%d and %dx%d)",
+             (int) A->size1, (int) A->size2, (int) B->size1, (int) B->size2);
+  C = gsl_matrix_alloc(A->size1, B->size2);
+  for (j = 0; j < B->size2; j++) {
+    gsl_vector_const_view b = gsl_matrix_const_column(B, j);
+    gsl_vector_view c = gsl_matrix_column(C, j);
+    gsl_spblas_dgemv(CblasNoTrans, 1.0, A, &b.vector, 0.0, &c.vector);
+  }
+  return Data_Wrap_Struct(cgsl_matrix, 0, gsl_matrix_free, C);
+}
+
+static VALUE rb_gsl_spmatrix_mul_spmatrix(gsl_spmatrix *A, VALUE vB)
+{
+  gsl_spmatrix *B = NULL, *Acsc = NULL, *Bcsc = NULL, *C = NULL;
+  Data_Get_Struct(vB, gsl_spmatrix, B);
+  if (B->size1 != A->size2)
+    rb_raise(rb_eRangeError, "matrix size mismatch (%dx%d and %dx%d)",
+             (int) A->size1, (int) A->size2, (int) B->size1, (int) B->size2);
+  Acsc = GSL_SPMATRIX_ISCSC(A) ? A : mygsl_spmatrix_convert(A, GSL_SPMATRIX_CSC);
+  Bcsc = GSL_SPMATRIX_ISCSC(B) ? B : mygsl_spmatrix_convert(B, GSL_SPMATRIX_CSC);
+  C = gsl_spmatrix_alloc_nzmax(A->size1, B->size2, GSL_MAX(Acsc->nz + Bcsc->nz, 1),
+                               GSL_SPMATRIX_CSC);
+  gsl_spblas_dgemm(1.0, Acsc, Bcsc, C);
+  if (Acsc != A) gsl_spmatrix_free(Acsc);
+  if (Bcsc != B) gsl_spmatrix_free(Bcsc);
+  return Data_Wrap_Struct(cgsl_spmatrix, 0, gsl_spmatrix_free, C);
+}
+
+static VALUE rb_gsl_spmatrix_mul(VALUE obj, VALUE other)
+{
+  gsl_spmatrix *A = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, A);
+  if (VECTOR_P(other)) return rb_gsl_spmatrix_mul_vector(A, other);
+  if (MATRIX_P(other)) return rb_gsl_spmatrix_mul_matrix(A, other);
+  if (SPMATRIX_P(other)) return rb_gsl_spmatrix_mul_spmatrix(A, other);
+#ifdef HAVE_NARRAY_H
+  if (NA_IsNArray(other)) return rb_gsl_spmatrix_mul_narray(A, other);
+#endif
+  if (rb_obj_is_kind_of(other, rb_cNumeric)) return rb_gsl_spmatrix_scale(obj, other);
+  rb_raise(rb_eTypeError, "wrong argument type %s (Vector, Matrix, SpMatrix or Numeric expected)",
+           rb_class2name(CLASS_OF(other)));
+  return Qnil;
+}
+
+static VALUE rb_gsl_spmatrix_add(VALUE obj, VALUE other)
+{
+  gsl_spmatrix *A = NULL, *B = NULL, *Acsc = NULL, *Bcsc = NULL, *C = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, A);
+  CHECK_SPMATRIX(other);
+  Data_Get_Struct(other, gsl_spmatrix, B);
+  if (A->size1 != B->size1 || A->size2 != B->size2)
+    rb_raise(rb_eRangeError, "matrix sizes are different");
+  Acsc = GSL_SPMATRIX_ISCSC(A) ? A : mygsl_spmatrix_convert(A, GSL_SPMATRIX_CSC);
+  Bcsc = GSL_SPMATRIX_ISCSC(B) ? B : mygsl_spmatrix_convert(B, GSL_SPMATRIX_CSC);
+  C = gsl_spmatrix_alloc_nzmax(A->size1, A->size2, GSL_MAX(Acsc->nz + Bcsc->nz, 1),
+                               GSL_SPMATRIX_CSC);
+  gsl_spmatrix_add(C, Acsc, Bcsc);
+  if (Acsc != A) gsl_spmatrix_free(Acsc);
+  if (Bcsc != B) gsl_spmatrix_free(Bcsc);
+  return Data_Wrap_Struct(cgsl_spmatrix, 0, gsl_spmatrix_free, C);
+}
+
+static VALUE rb_gsl_spmatrix_inspect(VALUE obj)
+{
+  gsl_spmatrix *m = NULL;
+  Data_Get_Struct(obj, gsl_spmatrix, m);
+  return rb_sprintf("%s (%dx%d, %s, nnz=%d)", rb_class2name(CLASS_OF(obj)),
+                    (int) m->size1, (int) m->size2, gsl_spmatrix_type(m), (int) gsl_spmatrix_nnz(m));
+}
+
+/*****/
+
+/* GSL::Splinalg::GMRES.alloc(n, m = 0) */
+static VALUE rb_gsl_splinalg_gmres_alloc(int argc, VALUE *argv, VALUE klass)
+{
+  gsl_splinalg_itersolve *w = NULL;
+  size_t m = 0;
+  switch (argc) {
+  case 2:
+    m = NUM2ULONG(argv[1]);
+  /* no break */
+  case 1:
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 1 or 2)", argc);
+  }
+  w = gsl_splinalg_itersolve_alloc(gsl_splinalg_itersolve_gmres, NUM2ULONG(argv[0]), m);
+  return Data_Wrap_Struct(klass, 0, gsl_splinalg_itersolve_free, w);
+}
+
+static VALUE rb_gsl_splinalg_gmres_name(VALUE obj)
+{
+  gsl_splinalg_itersolve *w = NULL;
+  Data_Get_Struct(obj, gsl_splinalg_itersolve, w);
+  return rb_str_new2(gsl_splinalg_itersolve_name(w));
+}
+
+static VALUE rb_gsl_splinalg_gmres_normr(VALUE obj)
+{
+  gsl_splinalg_itersolve *w = NULL;
+  Data_Get_Struct(obj, gsl_splinalg_itersolve, w);
+  return rb_float_new(gsl_splinalg_itersolve_normr(w));
+}
+
+/*
+  The iterative solvers of GSL take compressed column matrices; other
+  formats are converted into a copy owned by holder.
+*/
+static gsl_spmatrix* rb_gsl_splinalg_csc(gsl_spmatrix *A, VALUE holder)
+{
+  gsl_spmatrix *C;
+  if (GSL_SPMATRIX_ISCSC(A)) return A;
+  C = mygsl_spmatrix_convert(A, GSL_SPMATRIX_CSC);
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, gsl_spmatrix_free, C));
+  return C;
+}
+
+/* GSL::Splinalg::GMRES#iterate(A, b, tol, x): one restart cycle, x is updated */
+static VALUE rb_gsl_splinalg_gmres_iterate(VALUE obj, VALUE vA, VALUE vb,
+                                           VALUE tol, VALUE vx)
+{
+  gsl_splinalg_itersolve *w = NULL;
+  gsl_spmatrix *A = NULL;
+  gsl_vector *b = NULL, *x = NULL;
+  VALUE holder = rb_ary_new();
+  int status;
+  Data_Get_Struct(obj, gsl_splinalg_itersolve, w);
+  CHECK_SPMATRIX(vA);
+  Data_Get_Struct(vA, gsl_spmatrix, A);
+  Data_Get_Vector(vb, b);
+  Data_Get_Vector(vx, x);
+  A = rb_gsl_splinalg_csc(A, holder);
+  status = gsl_splinalg_itersolve_iterate(A, b, NUM2DBL(tol), x, w);
+  RB_GC_GUARD(holder);
+  return INT2FIX(status);
+}
+
+/*
+  Right preconditioned, restarted GMRES(m) (flexible variant, so that the
+  preconditioner may change from step to step, e.g. an inner iteration
+  supplied as a Ruby proc). gsl_splinalg_itersolve has no preconditioner
+  argument, so this path is used whenever one is given.
+*/
+enum {
+  RB_GSL_PRECOND_NONE = 0,
+  RB_GSL_PRECOND_JACOBI,
+  RB_GSL_PRECOND_SPMATRIX,
+  RB_GSL_PRECOND_PROC,
+};
+
+typedef struct {
+  int type;
+  gsl_vector *dinv;     /* Jacobi: inverse diagonal */
+  gsl_spmatrix *P;      /* approximate inverse */
+  VALUE proc;
+} rb_gsl_precond;
+
+/*
+  The buffers of a solve are owned by Ruby objects kept in holder, so
+  that they are freed even when a preconditioner proc raises.
+*/
+static gsl_vector* rb_gsl_splinalg_hold_vector(VALUE holder, gsl_vector *v)
+{
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, gsl_vector_free, v));
+  return v;
+}
+
+static gsl_matrix* rb_gsl_splinalg_hold_matrix(VALUE holder, gsl_matrix *m)
+{
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, gsl_matrix_free, m));
+  return m;
+}
+
+static void rb_gsl_precond_apply(rb_gsl_precond *M, const gsl_vector *v, gsl_vector *z)
+{
+  gsl_vector *vtmp = NULL, *ztmp = NULL;
+  VALUE vv, vz;
+  switch (M->type) {
+  case RB_GSL_PRECOND_JACOBI:
+    gsl_vector_memcpy(z, v);
+    gsl_vector_mul(z, M->dinv);
+    break;
+  case RB_GSL_PRECOND_SPMATRIX:
+    gsl_spblas_dgemv(CblasNoTrans, 1.0, M->P, v, 0.0, z);
+    break;
+  case RB_GSL_PRECOND_PROC:
+    vtmp = gsl_vector_alloc(v->size);
+    gsl_vector_memcpy(vtmp, v);
+    vv = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, vtmp);
+    vz = rb_funcall(M->proc, RBGSL_ID_call, 1, vv);
+    CHECK_VECTOR(vz);
+    Data_Get_Vector(vz, ztmp);
+    if (ztmp->size != z->size)
+      rb_raise(rb_eRangeError, "preconditioner returned a vector of length %d (%d expected)",
+               (int) ztmp->size, (int) z->size);
+    gsl_vector_memcpy(z, ztmp);
+    break;
+  default:
+    gsl_vector_memcpy(z, v);
+    break;
+  }
+}
+
+static double mygsl_spmatrix_residual(const gsl_spmatrix *A, const gsl_vector *b,
+                                      const gsl_vector *x, gsl_vector *r)
+{
+  gsl_vector_memcpy(r, b);
+  gsl_spblas_dgemv(CblasNoTrans, -1.0, A, x, 1.0, r);
+  return gsl_blas_dnrm2(r);
+}
+
+static int mygsl_fgmres(const gsl_spmatrix *A, const gsl_vector *b, gsl_vector *x,
+                        rb_gsl_precond *M, size_t m, double tol, size_t maxiter,
+                        size_t *iter, double *normr, VALUE holder)
+{
+  size_t n = A->size1, i, j, k;
+  gsl_matrix *V = NULL, *Z = NULL, *H = NULL;
+  gsl_vector *r = NULL, *w = NULL, *g = NULL, *cs = NULL, *sn = NULL, *y = NULL;
+  double beta, bnorm, hij, tmp;
+  int status = GSL_CONTINUE;
+  V = rb_gsl_splinalg_hold_matrix(holder, gsl_matrix_alloc(n, m + 1));
+  Z = rb_gsl_splinalg_hold_matrix(holder, gsl_matrix_alloc(n, m));
+  H = rb_gsl_splinalg_hold_matrix(holder, gsl_matrix_calloc(m + 1, m));
+  r = rb_gsl_splinalg_hold_vector(holder, gsl_vector_alloc(n));
+  w = rb_gsl_splinalg_hold_vector(holder, gsl_vector_alloc(n));
+  g = rb_gsl_splinalg_hold_vector(holder, gsl_vector_alloc(m + 1));
+  cs = rb_gsl_splinalg_hold_vector(holder, gsl_vector_alloc(m));
+  sn = rb_gsl_splinalg_hold_vector(holder, gsl_vector_alloc(m));
+  y = rb_gsl_splinalg_hold_vector(holder, gsl_vector_alloc(m));
+  bnorm = gsl_blas_dnrm2(b);
+  if (bnorm == 0.0) bnorm = 1.0;
+  beta = mygsl_spmatrix_residual(A, b, x, r);
+  *iter = 0;
+  while (beta > tol * bnorm && *iter < maxiter) {
+    gsl_vector_view v0 = gsl_matrix_column(V, 0);
+    gsl_vector_memcpy(&v0.vector, r);
+    gsl_vector_scale(&v0.vector, 1.0 / beta);
+    gsl_vector_set_zero(g);
+    gsl_vector_set(g, 0, beta);
+    gsl_matrix_set_zero(H);
+    for (k = 0; k < m && *iter < maxiter; k++) {
+      gsl_vector_view vk = gsl_matrix_column(V, k);
+      gsl_vector_view zk = gsl_matrix_column(Z, k);
+      gsl_vector_view vk1 = gsl_matrix_column(V, k + 1);
+      rb_gsl_precond_apply(M, &vk.vector, &zk.vector);
+      gsl_spblas_dgemv(CblasNoTrans, 1.0, A, &zk.vector, 0.0, w);
+      /* modified Gram-Schmidt */
+      for (i = 0; i <= k; i++) {
+        gsl_vector_view vi = gsl_matrix_column(V, i);
+        gsl_blas_ddot(w, &vi.vector, &hij);
+        gsl_matrix_set(H, i, k, hij);
+        gsl_blas_daxpy(-hij, &vi.vector, w);
+      }
+      hij = gsl_blas_dnrm2(w);
+      gsl_matrix_set(H, k + 1, k, hij);
+      gsl_vector_memcpy(&vk1.vector, w);
+      if (hij != 0.0) gsl_vector_scale(&vk1.vector, 1.0 / hij);
+      /* apply the previous Givens rotations to the new column */
+      for (i = 0; i < k; i++) {
+        double h0 = gsl_matrix_get(H, i, k), h1 = gsl_matrix_get(H, i + 1, k);
+        double c = gsl_vector_get(cs, i), s = gsl_vector_get(sn, i);
+        gsl_matrix_set(H, i, k, c * h0 + s * h1);
+        gsl_matrix_set(H, i + 1, k, -s * h0 + c * h1);
+      }
+      {
+        double h0 = gsl_matrix_get(H, k, k), h1 = gsl_matrix_get(H, k + 1, k);
+        double c, s;
+        tmp = hypot(h0, h1);
+        if (tmp == 0.0) { c = 1.0; s = 0.0; }
+        else { c = h0 / tmp; s = h1 / tmp; }
+        gsl_vector_set(cs, k, c);
+        gsl_vector_set(sn, k, s);
+        gsl_matrix_set(H, k, k, tmp);
+        gsl_matrix_set(H, k + 1, k, 0.0);
+        tmp = gsl_vector_get(g, k);
+        gsl_vector_set(g, k, c * tmp);
+        gsl_vector_set(g, k + 1, -s * tmp);
+      }
+      (*iter)++;
+      if (fabs(gsl_vector_get(g, k + 1)) <= tol * bnorm) {
+        k++;
+        break;
+      }
+    }
+    /* back substitution H(0:k,0:k) y = g(0:k), then x += Z y */
+    for (j = k; j-- > 0;) {
+      tmp = gsl_vector_get(g, j);
+      for (i = j + 1; i < k; i++) tmp -= gsl_matrix_get(H, j, i) * gsl_vector_get(y, i);
+      gsl_vector_set(y, j, tmp / gsl_matrix_get(H, j, j));
+    }
+    for (j = 0; j < k; j++) {
+      gsl_vector_view zj = gsl_matrix_column(Z, j);
+      gsl_blas_daxpy(gsl_vector_get(y, j), &zj.vector, x);
+    }
+    beta = mygsl_spmatrix_residual(A, b, x, r);
+  }
+  if (beta <= tol * bnorm) status = GSL_SUCCESS;
+  *normr = beta;
+  return status;
+}
+
+/*
+  GSL::Splinalg.gmres(A, b, opts = {})
+  opts: :x0, :tol (1e-6), :restart (0, i.e. min(n, 10)), :maxiter (n),
+        :precond (nil, :jacobi, a SpMatrix approximating inv(A), or a proc
+        mapping a Vector to a Vector)
+  Returns [x, status, normr, iterations]; without a preconditioner the
+  GSL solver does not count its iterations, and the number of restart
+  cycles is returned instead.
+*/
+static VALUE rb_gsl_splinalg_gmres(int argc, VALUE *argv, VALUE module)
+{
+  gsl_spmatrix *A0 = NULL, *A = NULL;
+  gsl_vector *b = NULL, *x = NULL, *x0 = NULL;
+  gsl_splinalg_itersolve *w = NULL;
+  rb_gsl_precond M;
+  VALUE vA, vb, opts = Qnil, val, vx, holder = rb_ary_new();
+  double tol = 1e-6, normr = 0.0;
+  size_t m = 0, maxiter, iter = 0, cycles = 0, done = 0, k, i;
+  int status = GSL_CONTINUE;
+  if (argc < 2 || argc > 3) rb_raise(rb_eArgError, "wrong number of arguments (%d for 2 or 3)", argc);
+  vA = argv[0];
+  vb = argv[1];
+  if (argc == 3) {
+    Check_Type(argv[2], T_HASH);
+    opts = argv[2];
+  }
+  CHECK_SPMATRIX(vA);
+  Data_Get_Struct(vA, gsl_spmatrix, A0);
+  Data_Get_Vector(vb, b);
+  if (A0->size1 != A0->size2) rb_raise(rb_eArgError, "matrix must be square");
+  if (b->size != A0->size1) rb_raise(rb_eRangeError, "vector and matrix sizes are different");
+  maxiter = A0->size1;
+  if (!NIL_P(val = rb_gsl_hash_get(opts, "tol"))) tol = NUM2DBL(val);
+  if (!NIL_P(val = rb_gsl_hash_get(opts, "restart"))) m = NUM2ULONG(val);
+  if (!NIL_P(val = rb_gsl_hash_get(opts, "maxiter"))) maxiter = NUM2ULONG(val);
+  x = gsl_vector_calloc(b->size);
+  vx = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, x);
+  if (!NIL_P(val = rb_gsl_hash_get(opts, "x0"))) {
+    Data_Get_Vector(val, x0);
+    gsl_vector_memcpy(x, x0);
+  }
+  M.type = RB_GSL_PRECOND_NONE;
+  M.dinv = NULL;
+  M.P = NULL;
+  M.proc = Qnil;
+  val = rb_gsl_hash_get(opts, "precond");
+  if (NIL_P(val)) {
+    M.type = RB_GSL_PRECOND_NONE;
+  } else if (SYMBOL_P(val) || TYPE(val) == T_STRING) {
+    if (strcmp(SYMBOL_P(val) ? rb_id2name(SYM2ID(val)) : StringValuePtr(val), "jacobi") != 0)
+      rb_raise(rb_eArgError, "unknown preconditioner (:jacobi, SpMatrix or Proc expected)");
+    M.type = RB_GSL_PRECOND_JACOBI;
+  } else if (SPMATRIX_P(val)) {
+    M.type = RB_GSL_PRECOND_SPMATRIX;
+    Data_Get_Struct(val, gsl_spmatrix, M.P);
+  } else if (rb_respond_to(val, RBGSL_ID_call)) {
+    M.type = RB_GSL_PRECOND_PROC;
+    M.proc = val;
+  } else {
+    rb_raise(rb_eTypeError, "wrong preconditioner type %s", rb_class2name(CLASS_OF(val)));
+  }
+  if (m == 0) m = GSL_MIN(A0->size1, 10);
+  A = rb_gsl_splinalg_csc(A0, holder);
+  if (M.type == RB_GSL_PRECOND_NONE) {
+    /*
+      Each call is a restart cycle of m iterations; the last one is
+      shortened so that no more than maxiter are run.
+    */
+    while (status == GSL_CONTINUE && done < maxiter) {
+      k = GSL_MIN(m, maxiter - done);
+      if (w == NULL || k < m) {
+        w = gsl_splinalg_itersolve_alloc(gsl_splinalg_itersolve_gmres, b->size, k);
+        rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, gsl_splinalg_itersolve_free, w));
+      }
+      status = gsl_splinalg_itersolve_iterate(A, b, tol, x, w);
+      done += k;
+      cycles++;
+    }
+    if (w) normr = gsl_splinalg_itersolve_normr(w);
+    else normr = mygsl_spmatrix_residual(A, b, x, rb_gsl_splinalg_hold_vector(holder, gsl_vector_alloc(b->size)));
+    iter = cycles;
+  } else {
+    if (M.type == RB_GSL_PRECOND_JACOBI) {
+      M.dinv = rb_gsl_splinalg_hold_vector(holder, gsl_vector_alloc(b->size));
+      for (i = 0; i < b->size; i++) {
+        double d = gsl_spmatrix_get(A, i, i);
+        gsl_vector_set(M.dinv, i, d != 0.0 ? 1.0 / d : 1.0);
+      }
+    }
+    status = mygsl_fgmres(A, b, x, &M, m, tol, maxiter, &iter, &normr, holder);
+  }
+  RB_GC_GUARD(holder);
+  return rb_ary_new3(4, vx, INT2FIX(status), rb_float_new(normr), INT2FIX(iter));
+}
+
+void Init_gsl_spmatrix(VALUE module)
+{
+  cgsl_spmatrix = rb_define_class_under(module, "SpMatrix", cGSL_Object);
+
+  rb_define_const(cgsl_spmatrix, "COO", INT2FIX(GSL_SPMATRIX_COO));
+  rb_define_const(cgsl_spmatrix, "TRIPLET", INT2FIX(GSL_SPMATRIX_COO));
+  rb_define_const(cgsl_spmatrix, "CSC", INT2FIX(GSL_SPMATRIX_CSC));
+  rb_define_const(cgsl_spmatrix, "CSR", INT2FIX(GSL_SPMATRIX_CSR));
+
+  rb_define_singleton_method(cgsl_spmatrix, "alloc", rb_gsl_spmatrix_alloc, -1);
+  rb_define_singleton_method(cgsl_spmatrix, "new", rb_gsl_spmatrix_alloc, -1);
+  rb_define_singleton_method(cgsl_spmatrix, "from_triplets", rb_gsl_spmatrix_from_triplets, -1);
+  rb_define_singleton_method(cgsl_spmatrix, "from_matrix", rb_gsl_spmatrix_from_matrix, -1);
+  rb_define_method(cgsl_matrix, "to_sp", rb_gsl_spmatrix_from_matrix, -1);
+  rb_define_alias(cgsl_matrix, "to_spmatrix", "to_sp");
+
+  rb_define_method(cgsl_spmatrix, "get", rb_gsl_spmatrix_get, 2);
+  rb_define_alias(cgsl_spmatrix, "[]", "get");
+  rb_define_method(cgsl_spmatrix, "set", rb_gsl_spmatrix_set, 3);
+  rb_define_alias(cgsl_spmatrix, "[]=", "set");
+  rb_define_method(cgsl_spmatrix, "size1", rb_gsl_spmatrix_size1, 0);
+  rb_define_method(cgsl_spmatrix, "size2", rb_gsl_spmatrix_size2, 0);
+  rb_define_method(cgsl_spmatrix, "shape", rb_gsl_spmatrix_shape, 0);
+  rb_define_alias(cgsl_spmatrix, "size", "shape");
+  rb_define_method(cgsl_spmatrix, "nnz", rb_gsl_spmatrix_nnz, 0);
+  rb_define_method(cgsl_spmatrix, "type", rb_gsl_spmatrix_type, 0);
+  rb_define_method(cgsl_spmatrix, "inspect", rb_gsl_spmatrix_inspect, 0);
+
+  rb_define_method(cgsl_spmatrix, "compress", rb_gsl_spmatrix_compress, -1);
+  rb_define_method(cgsl_spmatrix, "to_coo", rb_gsl_spmatrix_to_coo, 0);
+  rb_define_alias(cgsl_spmatrix, "to_triplet", "to_coo");
+  rb_define_method(cgsl_spmatrix, "to_csc", rb_gsl_spmatrix_to_csc, 0);
+  rb_define_method(cgsl_spmatrix, "to_csr", rb_gsl_spmatrix_to_csr, 0);
+  rb_define_method(cgsl_spmatrix, "to_matrix", rb_gsl_spmatrix_to_matrix, 0);
+  rb_define_alias(cgsl_spmatrix, "to_dense", "to_matrix");
+  rb_define_method(cgsl_spmatrix, "to_triplets", rb_gsl_spmatrix_to_triplets, 0);
+  rb_define_method(cgsl_spmatrix, "clone", rb_gsl_spmatrix_clone, 0);
+  rb_define_alias(cgsl_spmatrix, "duplicate", "clone");
+  rb_define_alias(cgsl_spmatrix, "dup", "clone");
+
+  rb_define_method(cgsl_spmatrix, "transpose", rb_gsl_spmatrix_transpose, 0);
+  rb_define_alias(cgsl_spmatrix, "trans", "transpose");
+  rb_define_method(cgsl_spmatrix, "scale", rb_gsl_spmatrix_scale, 1);
+  rb_define_method(cgsl_spmatrix, "scale!", rb_gsl_spmatrix_scale_bang, 1);
+  rb_define_method(cgsl_spmatrix, "mul", rb_gsl_spmatrix_mul, 1);
+  rb_define_alias(cgsl_spmatrix, "*", "mul");
+  rb_define_method(cgsl_spmatrix, "add", rb_gsl_spmatrix_add, 1);
+  rb_define_alias(cgsl_spmatrix, "+", "add");
+
+  mgsl_splinalg = rb_define_module_under(module, "Splinalg");
+  rb_define_module_function(mgsl_splinalg, "gmres", rb_gsl_splinalg_gmres, -1);
+  cgsl_splinalg_gmres = rb_define_class_under(mgsl_splinalg, "GMRES", cGSL_Object);
+  rb_define_singleton_method(cgsl_splinalg_gmres, "alloc", rb_gsl_splinalg_gmres_alloc, -1);
+  rb_define_singleton_method(cgsl_splinalg_gmres, "new", rb_gsl_splinalg_gmres_alloc, -1);
+  rb_define_method(cgsl_splinalg_gmres, "name", rb_gsl_splinalg_gmres_name, 0);
+  rb_define_method(cgsl_splinalg_gmres, "normr", rb_gsl_splinalg_gmres_normr, 0);
+  rb_define_method(cgsl_splinalg_gmres, "iterate", rb_gsl_splinalg_gmres_iterate, 4);
+}
+
+#endif
@@ -10,6 +10,8 @@
 */
 
 #include "include/rb_gsl_array.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_parallel.h"
 #include <gsl/gsl_sum.h>
 
 static VALUE rb_gsl_sum_accel(VALUE obj)
@@ -119,6 +121,120 @@ static VALUE rb_gsl_sum_levin_utrunc_terms_used(VALUE obj)
   return INT2FIX(w->terms_used);
 }
 
+/*
+  Batched acceleration: each row of a matrix is a series. The rows are
+  dealt out to the threads, and each thread reuses one workspace sized
+  for a row.
+*/
+typedef struct {
+  const gsl_matrix *m;
+  int utrunc;
+  void **w;          /* one workspace per thread */
+  gsl_vector *sum, *err, *sum_plain;
+  gsl_vector_int *terms_used;
+} sum_rows_job;
+
+static void sum_rows_worker(size_t tid, size_t nthreads, void *data)
+{
+  sum_rows_job *job = (sum_rows_job *) data;
+  const double *row;
+  double sum, err, sum_plain;
+  size_t i, terms_used, n = job->m->size2;
+  for (i = tid; i < job->m->size1 && !rb_gsl_parallel_interrupted(); i += nthreads) {
+    row = job->m->data + i * job->m->tda;
+    if (job->utrunc) {
+      gsl_sum_levin_utrunc_workspace *w = (gsl_sum_levin_utrunc_workspace *) job->w[tid];
+      gsl_sum_levin_utrunc_accel(row, n, w, &sum, &err);
+      sum_plain = w->sum_plain;
+      terms_used = w->terms_used;
+    } else {
+      gsl_sum_levin_u_workspace *w = (gsl_sum_levin_u_workspace *) job->w[tid];
+      gsl_sum_levin_u_accel(row, n, w, &sum, &err);
+      sum_plain = w->sum_plain;
+      terms_used = w->terms_used;
+    }
+    gsl_vector_set(job->sum, i, sum);
+    gsl_vector_set(job->err, i, err);
+    gsl_vector_set(job->sum_plain, i, sum_plain);
+    gsl_vector_int_set(job->terms_used, i, (int) terms_used);
+  }
+}
+
+/* argv holds the arguments after the nfixed leading ones, the last of which is mm */
+static VALUE rb_gsl_sum_accel_rows0(int argc, VALUE *argv, int nfixed, VALUE mm, int utrunc)
+{
+  VALUE opts = Qnil, holder = rb_ary_new(), vsum, verr, vplain, vterms;
+  sum_rows_job job;
+  gsl_matrix *m = NULL;
+  size_t t, nthreads;
+  if (argc > 0 && TYPE(argv[argc - 1]) == T_HASH) opts = argv[--argc];
+  if (argc != 0) rb_raise(rb_eArgError, "wrong number of arguments (%d for %d)",
+                          argc + nfixed, nfixed);
+  CHECK_MATRIX(mm);
+  Data_Get_Struct(mm, gsl_matrix, m);
+  if (m->size2 == 0) rb_raise(rb_eArgError, "the series must have at least one term");
+  nthreads = rb_gsl_parallel_threads(opts);
+  if (nthreads > m->size1) nthreads = m->size1;
+  if (nthreads < 1) nthreads = 1;
+  memset(&job, 0, sizeof(sum_rows_job));
+  job.m = m;
+  job.utrunc = utrunc;
+  job.w = ALLOC_N(void *, nthreads);
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, free, job.w));
+  for (t = 0; t < nthreads; t++) {
+    if (utrunc) {
+      job.w[t] = gsl_sum_levin_utrunc_alloc(m->size2);
+      rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, gsl_sum_levin_utrunc_free, job.w[t]));
+    } else {
+      job.w[t] = gsl_sum_levin_u_alloc(m->size2);
+      rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, gsl_sum_levin_u_free, job.w[t]));
+    }
+  }
+  job.sum = gsl_vector_alloc(m->size1);
+  vsum = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, job.sum);
+  job.err = gsl_vector_alloc(m->size1);
+  verr = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, job.err);
+  job.sum_plain = gsl_vector_alloc(m->size1);
+  vplain = Data_Wrap_Struct(cgsl_vector, 0, gsl_vector_free, job.sum_plain);
+  job.terms_used = gsl_vector_int_alloc(m->size1);
+  vterms = Data_Wrap_Struct(cgsl_vector_int, 0, gsl_vector_int_free, job.terms_used);
+  if (m->size1 > 0) {
+    if (nthreads == 1) sum_rows_worker(0, 1, &job);
+    else rb_gsl_parallel_run(nthreads, sum_rows_worker, &job);
+  }
+  RB_GC_GUARD(holder);
+  return rb_ary_new3(4, vsum, verr, vplain, vterms);
+}
+
+/*
+  GSL::Sum::Levin_u.accel_rows(m, threads: n), GSL::Matrix#accel_rows(threads: n)
+  GSL::Sum::Levin_utrunc.accel_rows(m, ...), GSL::Matrix#utrunc_accel_rows(...)
+
+  [sum, abserr, sum_plain, terms_used] for the series in the rows of m,
+  as three Vectors and a Vector::Int.
+*/
+static VALUE rb_gsl_sum_levin_u_accel_rows(int argc, VALUE *argv, VALUE obj)
+{
+  if (argc < 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1)", argc);
+  return rb_gsl_sum_accel_rows0(argc - 1, argv + 1, 1, argv[0], 0);
+}
+
+static VALUE rb_gsl_sum_levin_utrunc_accel_rows(int argc, VALUE *argv, VALUE obj)
+{
+  if (argc < 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1)", argc);
+  return rb_gsl_sum_accel_rows0(argc - 1, argv + 1, 1, argv[0], 1);
+}
+
+static VALUE rb_gsl_matrix_accel_rows(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sum_accel_rows0(argc, argv, 0, obj, 0);
+}
+
+static VALUE rb_gsl_matrix_utrunc_accel_rows(int argc, VALUE *argv, VALUE obj)
+{
+  return rb_gsl_sum_accel_rows0(argc, argv, 0, obj, 1);
+}
+
 void Init_gsl_sum(VALUE module)
 {
   VALUE mgsl_sum;
@@ -152,6 +268,11 @@ void Init_gsl_sum(VALUE module)
                    rb_gsl_sum_levin_utrunc_sum_plain, 0);
   rb_define_method(cgsl_sum_levin_utrunc, "terms_used",
                    rb_gsl_sum_levin_utrunc_terms_used, 0);
+
+  rb_define_singleton_method(cgsl_sum_levin_u, "accel_rows",
+                             rb_gsl_sum_levin_u_accel_rows, -1);
+  rb_define_singleton_method(cgsl_sum_levin_utrunc, "accel_rows",
+                             rb_gsl_sum_levin_utrunc_accel_rows, -1);
   /***/
 
   rb_define_method(cgsl_vector, "accel_sum", rb_gsl_sum_accel, 0);
@@ -159,6 +280,9 @@ void Init_gsl_sum(VALUE module)
   rb_define_alias(cgsl_vector, "sum_accel", "accel_sum");
   rb_define_method(cgsl_vector, "utrunc_accel", rb_gsl_utrunc_accel, 0);
 
+  rb_define_method(cgsl_matrix, "accel_rows", rb_gsl_matrix_accel_rows, -1);
+  rb_define_method(cgsl_matrix, "utrunc_accel_rows", rb_gsl_matrix_utrunc_accel_rows, -1);
+
 #ifdef HAVE_NARRAY_H
   rb_define_method(cNArray, "accel_sum", rb_gsl_sum_accel, 0);
   rb_define_alias(cNArray, "accel", "accel_sum");
@@ -1345,6 +1345,7 @@ VALUE rb_gsl_vector_pow_bang(VALUE obj, VALUE pp)
   return obj;
 }
 
+void Init_gsl_vector_sum(VALUE module);
 void Init_gsl_vector(VALUE module)
 {
   rb_define_singleton_method(cgsl_vector, "linspace", rb_gsl_vector_linspace, -1);
@@ -1430,4 +1431,5 @@ void Init_gsl_vector(VALUE module)
   rb_define_method(cgsl_vector, "pow!", rb_gsl_vector_pow_bang, 1);
 
   Init_gsl_vector_init(module);
+  Init_gsl_vector_sum(module);
 }
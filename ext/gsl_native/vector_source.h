@@ -704,6 +704,8 @@ VALUE FUNCTION(rb_gsl_vector,uminus)(VALUE obj)
     return Data_Wrap_Struct(VEC_ROW_COL(obj), 0, FUNCTION(gsl_vector,free), vnew);
 }
 
+/* GSL::Vector#sum, sumsq, prod, cumsum and inner_product are in vector_sum.c */
+#ifndef BASE_DOUBLE
 static VALUE FUNCTION(rb_gsl_vector,sum)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
@@ -713,8 +715,8 @@ static VALUE FUNCTION(rb_gsl_vector,sum)(VALUE obj)
   for (i = 0; i < v->size; i++) sum += FUNCTION(gsl_vector,get)(v, i);
   return C_TO_VALUE2(sum);
 }
+#endif
 
-/* Vector#sumsq is defined in blas1.c */
 #ifdef BASE_INT
 static VALUE FUNCTION(rb_gsl_vector,sumsq)(VALUE obj)
 {
@@ -730,6 +732,7 @@ static VALUE FUNCTION(rb_gsl_vector,sumsq)(VALUE obj)
 }
 #endif
 
+#ifndef BASE_DOUBLE
 static VALUE FUNCTION(rb_gsl_vector,prod)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL;
@@ -739,6 +742,7 @@ static VALUE FUNCTION(rb_gsl_vector,prod)(VALUE obj)
   for (i = 0; i < v->size; i++) x *= FUNCTION(gsl_vector,get)(v, i);
   return C_TO_VALUE(x);
 }
+#endif
 
 static VALUE FUNCTION(rb_gsl_vector,connect)(int argc, VALUE *argv, VALUE obj)
 {
@@ -959,14 +963,13 @@ static VALUE FUNCTION(rb_gsl_vector,fscanf)(VALUE obj, VALUE io)
   return INT2FIX(status);
 }
 
+#ifndef BASE_DOUBLE
 /* 2.Aug.2004 */
 VALUE FUNCTION(rb_gsl_vector,inner_product)(int argc, VALUE *argv, VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v = NULL, *v2 = NULL;
   BASE prod = 0;
-#ifndef BASE_DOUBLE
   size_t i;
-#endif
   switch (TYPE(obj)) {
   case T_MODULE:  case T_CLASS:  case T_OBJECT:
     if (argc != 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 2)",
@@ -985,15 +988,12 @@ VALUE FUNCTION(rb_gsl_vector,inner_product)(int argc, VALUE *argv, VALUE obj)
     break;
   }
   if (v->size != v2->size) rb_raise(rb_eRangeError, "vector lengths are different.");
-#ifdef BASE_DOUBLE
-  gsl_blas_ddot(v, v2, &prod);
-#else
   for (i = 0; i < v->size; i++) {
     prod += FUNCTION(gsl_vector,get)(v, i)*FUNCTION(gsl_vector,get)(v2, i);
   }
-#endif
   return C_TO_VALUE2(prod);
 }
+#endif
 
 int FUNCTION(rbgsl_vector,equal)(const GSL_TYPE(gsl_vector) *v1, const GSL_TYPE(gsl_vector) *v2, double eps)
 {
@@ -2922,6 +2922,7 @@ static VALUE FUNCTION(rb_gsl_vector,join)(int argc, VALUE *argv, VALUE obj)
   return str;
 }
 
+#ifndef BASE_DOUBLE
 static VALUE FUNCTION(rb_gsl_vector,cumsum)(VALUE obj)
 {
   GSL_TYPE(gsl_vector) *v, *vnew;
@@ -2935,6 +2936,7 @@ static VALUE FUNCTION(rb_gsl_vector,cumsum)(VALUE obj)
   }
   return Data_Wrap_Struct(VEC_ROW_COL(obj), 0, FUNCTION(gsl_vector,free), vnew);
 }
+#endif
 
 static VALUE FUNCTION(rb_gsl_vector,cumprod)(VALUE obj)
 {
@@ -3059,14 +3061,14 @@ void FUNCTION(Init_gsl_vector,init)(VALUE module)
   rb_define_method(GSL_TYPE(cgsl_vector), "-@", FUNCTION(rb_gsl_vector,uminus), 0);
   rb_define_method(GSL_TYPE(cgsl_vector), "+@", FUNCTION(rb_gsl_vector,uplus), 0);
 
-  rb_define_method(GSL_TYPE(cgsl_vector), "sum", FUNCTION(rb_gsl_vector,sum), 0);
+  /* GSL::Vector#sum, sumsq, prod and cumsum are defined in vector_sum.c */
 #ifdef BASE_INT
-  /* Vector#sumsq is defined in blas1.c */
+  rb_define_method(GSL_TYPE(cgsl_vector), "sum", FUNCTION(rb_gsl_vector,sum), 0);
   rb_define_method(GSL_TYPE(cgsl_vector), "sumsq", FUNCTION(rb_gsl_vector,sumsq), 0);
-#endif
   rb_define_method(GSL_TYPE(cgsl_vector), "prod", FUNCTION(rb_gsl_vector,prod), 0);
 
   rb_define_method(GSL_TYPE(cgsl_vector), "cumsum", FUNCTION(rb_gsl_vector,cumsum), 0);
+#endif
   rb_define_method(GSL_TYPE(cgsl_vector), "cumprod", FUNCTION(rb_gsl_vector,cumprod), 0);
 
   rb_define_method(GSL_TYPE(cgsl_vector), "connect",
@@ -3107,6 +3109,8 @@ void FUNCTION(Init_gsl_vector,init)(VALUE module)
                    FUNCTION(rb_gsl_vector,fscanf), 1);
 
   /* 2.Aug.2004 */
+  /* GSL::Vector.inner_product is defined in vector_sum.c */
+#ifndef BASE_DOUBLE
   rb_define_singleton_method(GSL_TYPE(cgsl_vector), "inner_product",
                              FUNCTION(rb_gsl_vector,inner_product), -1);
   rb_define_singleton_method(GSL_TYPE(cgsl_vector), "dot",
@@ -3114,6 +3118,7 @@ void FUNCTION(Init_gsl_vector,init)(VALUE module)
   rb_define_method(GSL_TYPE(cgsl_vector), "inner_product",
                    FUNCTION(rb_gsl_vector,inner_product), -1);
   rb_define_alias(GSL_TYPE(cgsl_vector), "dot", "inner_product");
+#endif
 
   rb_define_method(GSL_TYPE(cgsl_vector), "equal?",
                    FUNCTION(rb_gsl_vector,equal), -1);
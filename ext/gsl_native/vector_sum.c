@@ -0,0 +1,665 @@
+/*
+  vector_sum.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Reductions of GSL::Vector: sum, sumsq, prod, cumsum and inner_product
+  (dot). The method: option picks the algorithm,
+
+    :pairwise  blocks of SUM_BLOCK elements summed with SUM_LANES
+               independent accumulators, combined pairwise; the error
+               grows as O(log n) instead of O(n). This is the default.
+    :kahan     Kahan-Neumaier compensated sum (Dot2 of Ogita, Rump and
+               Oishi for products): as accurate as summing in twice the
+               working precision.
+    :exact     the terms are added into a fixed-point accumulator
+               wide enough for any double, and the result is the
+               exact sum rounded once to nearest.
+    :naive     a plain left-to-right loop, as in earlier versions.
+
+  Vectors longer than SUM_CHUNK are cut into chunks of that size and
+  the chunks are dealt out to the threads. The chunk boundaries do not
+  depend on the number of threads and the partial results are combined
+  in chunk order, so sum, sumsq, prod and inner_product give the same
+  result for any threads: value.
+*/
+
+#include "include/rb_gsl_array.h"
+#include "include/rb_gsl_common.h"
+#include "include/rb_gsl_parallel.h"
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define SUM_LANES 8
+#define SUM_BLOCK 128
+#define SUM_CHUNK 65536
+/* limbs of 32 bits; bit 0 of limb 0 has the weight 2^-1074 */
+#define SUM_LIMBS 72
+#define SUM_LIMB_BIAS 1074
+/* additions into a superaccumulator between two carry propagations */
+#define SUM_NORMALIZE 1048576
+
+enum {
+  SUM_PAIRWISE,
+  SUM_KAHAN,
+  SUM_EXACT,
+  SUM_NAIVE
+};
+
+enum {
+  SUM_OP_SUM,
+  SUM_OP_DOT,
+  SUM_OP_PROD
+};
+
+typedef struct {
+  int64_t limb[SUM_LIMBS];
+  size_t nadd;
+  double special;   /* sum of the infinite and NaN terms */
+  int has_special;
+} sum_acc;
+
+typedef struct {
+  int op, method;
+  const double *x, *y;
+  size_t xstride, ystride, n, nchunks;
+  double *part, *comp;  /* per chunk result and its correction */
+  sum_acc *acc;         /* per chunk superaccumulator, for :exact */
+  double *out;          /* cumsum */
+  size_t ostride;
+} sum_job;
+
+/*
+  Error-free transformations: a + b = s + e and a*b = p + e exactly
+  (the latter unless a*b underflows).
+*/
+static inline double sum_two_sum(double a, double b, double *e)
+{
+  double s = a + b, bb = s - a;
+  *e = (a - (s - bb)) + (b - bb);
+  return s;
+}
+
+static inline double sum_two_prod(double a, double b, double *e)
+{
+  double p = a * b;
+  *e = fma(a, b, -p);
+  return p;
+}
+
+/*****/
+
+static double sum_pairwise(const double *x, size_t s, size_t n)
+{
+  double r[SUM_LANES], t;
+  size_t i, j, m;
+  if (n > SUM_BLOCK) {
+    m = n / 2;
+    m -= m % SUM_LANES;
+    return sum_pairwise(x, s, m) + sum_pairwise(x + m * s, s, n - m);
+  }
+  for (j = 0; j < SUM_LANES; j++) r[j] = 0.0;
+  if (s == 1) {
+    for (i = 0; i + SUM_LANES <= n; i += SUM_LANES)
+      for (j = 0; j < SUM_LANES; j++) r[j] += x[i + j];
+  } else {
+    for (i = 0; i + SUM_LANES <= n; i += SUM_LANES)
+      for (j = 0; j < SUM_LANES; j++) r[j] += x[(i + j) * s];
+  }
+  t = ((r[0] + r[1]) + (r[2] + r[3])) + ((r[4] + r[5]) + (r[6] + r[7]));
+  for (; i < n; i++) t += x[i * s];
+  return t;
+}
+
+static double dot_pairwise(const double *x, size_t xs, const double *y, size_t ys, size_t n)
+{
+  double r[SUM_LANES], t;
+  size_t i, j, m;
+  if (n > SUM_BLOCK) {
+    m = n / 2;
+    m -= m % SUM_LANES;
+    return dot_pairwise(x, xs, y, ys, m) + dot_pairwise(x + m * xs, xs, y + m * ys, ys, n - m);
+  }
+  for (j = 0; j < SUM_LANES; j++) r[j] = 0.0;
+  if (xs == 1 && ys == 1) {
+    for (i = 0; i + SUM_LANES <= n; i += SUM_LANES)
+      for (j = 0; j < SUM_LANES; j++) r[j] += x[i + j] * y[i + j];
+  } else {
+    for (i = 0; i + SUM_LANES <= n; i += SUM_LANES)
+      for (j = 0; j < SUM_LANES; j++) r[j] += x[(i + j) * xs] * y[(i + j) * ys];
+  }
+  t = ((r[0] + r[1]) + (r[2] + r[3])) + ((r[4] + r[5]) + (r[6] + r[7]));
+  for (; i < n; i++) t += x[i * xs] * y[i * ys];
+  return t;
+}
+
+static double prod_pairwise(const double *x, size_t s, size_t n)
+{
+  double r[SUM_LANES], t;
+  size_t i, j, m;
+  if (n > SUM_BLOCK) {
+    m = n / 2;
+    m -= m % SUM_LANES;
+    return prod_pairwise(x, s, m) * prod_pairwise(x + m * s, s, n - m);
+  }
+  for (j = 0; j < SUM_LANES; j++) r[j] = 1.0;
+  for (i = 0; i + SUM_LANES <= n; i += SUM_LANES)
+    for (j = 0; j < SUM_LANES; j++) r[j] *= x[(i + j) * s];
+  t = ((r[0] * r[1]) * (r[2] * r[3])) * ((r[4] * r[5]) * (r[6] * r[7]));
+  for (; i < n; i++) t *= x[i * s];
+  return t;
+}
+
+/* Neumaier's variant of Kahan summation; the sum is *s + *c */
+static void sum_kahan(const double *x, size_t xs, const double *y, size_t ys, size_t n,
+                      double *s, double *c)
+{
+  double t = 0.0, comp = 0.0, e, p, ep;
+  size_t i;
+  if (y == NULL) {
+    for (i = 0; i < n; i++) {
+      t = sum_two_sum(t, x[i * xs], &e);
+      comp += e;
+    }
+  } else {
+    for (i = 0; i < n; i++) {
+      p = sum_two_prod(x[i * xs], y[i * ys], &ep);
+      t = sum_two_sum(t, p, &e);
+      comp += e + ep;
+    }
+  }
+  *s = t;
+  *c = comp;
+}
+
+/* compensated product (Graillat); the product is *p + *c */
+static void prod_kahan(const double *x, size_t s, size_t n, double *p, double *c)
+{
+  double t = 1.0, comp = 0.0, e;
+  size_t i;
+  for (i = 0; i < n; i++) {
+    t = sum_two_prod(t, x[i * s], &e);
+    comp = comp * x[i * s] + e;
+  }
+  *p = t;
+  *c = comp;
+}
+
+static double sum_naive(const double *x, size_t xs, const double *y, size_t ys, size_t n)
+{
+  double t = 0.0;
+  size_t i;
+  if (y == NULL) for (i = 0; i < n; i++) t += x[i * xs];
+  else for (i = 0; i < n; i++) t += x[i * xs] * y[i * ys];
+  return t;
+}
+
+static double prod_naive(const double *x, size_t s, size_t n)
+{
+  double t = 1.0;
+  size_t i;
+  for (i = 0; i < n; i++) t *= x[i * s];
+  return t;
+}
+
+/*****/
+
+static void sum_acc_init(sum_acc *a)
+{
+  memset(a, 0, sizeof(sum_acc));
+}
+
+/* propagates the carries: limbs below the top one end up in [0, 2^32) */
+static void sum_acc_normalize(sum_acc *a)
+{
+  int64_t carry = 0, lo;
+  size_t k;
+  for (k = 0; k < SUM_LIMBS - 1; k++) {
+    a->limb[k] += carry;
+    lo = a->limb[k] & 0xffffffff;
+    carry = (a->limb[k] - lo) / 4294967296LL;
+    a->limb[k] = lo;
+  }
+  a->limb[SUM_LIMBS - 1] += carry;
+  a->nadd = 0;
+}
+
+static void sum_acc_add(sum_acc *a, double x)
+{
+  uint64_t bits, m, lo, hi;
+  int ex;
+  size_t pos, k, sh;
+  memcpy(&bits, &x, sizeof(double));
+  ex = (int) ((bits >> 52) & 0x7ff);
+  if (ex == 0x7ff) {
+    a->special += x;
+    a->has_special = 1;
+    return;
+  }
+  m = bits & ((((uint64_t) 1) << 52) - 1);
+  if (m == 0 && ex == 0) return;
+  if (ex == 0) pos = 0;
+  else {
+    m |= ((uint64_t) 1) << 52;
+    pos = (size_t) ex - 1;
+  }
+  k = pos / 32;
+  sh = pos % 32;
+  lo = (m & 0xffffffff) << sh;
+  hi = (m >> 32) << sh;
+  if (bits >> 63) {
+    a->limb[k] -= (int64_t) (lo & 0xffffffff);
+    a->limb[k + 1] -= (int64_t) ((lo >> 32) + (hi & 0xffffffff));
+    a->limb[k + 2] -= (int64_t) (hi >> 32);
+  } else {
+    a->limb[k] += (int64_t) (lo & 0xffffffff);
+    a->limb[k + 1] += (int64_t) ((lo >> 32) + (hi & 0xffffffff));
+    a->limb[k + 2] += (int64_t) (hi >> 32);
+  }
+  if (++a->nadd >= SUM_NORMALIZE) sum_acc_normalize(a);
+}
+
+/* adds b into a; both must be normalized */
+static void sum_acc_merge(sum_acc *a, const sum_acc *b)
+{
+  size_t k;
+  for (k = 0; k < SUM_LIMBS; k++) a->limb[k] += b->limb[k];
+  if (b->has_special) {
+    a->special += b->special;
+    a->has_special = 1;
+  }
+  sum_acc_normalize(a);
+}
+
+/* the value of a rounded to the nearest double, ties to even */
+static double sum_acc_round(const sum_acc *a0)
+{
+  sum_acc a;
+  uint64_t l[SUM_LIMBS], top, mant, rem, half;
+  int neg = 0, sticky = 0, h, b, p, q, drop, k;
+  double r;
+  if (a0->has_special) return a0->special;
+  a = *a0;
+  sum_acc_normalize(&a);
+  if (a.limb[SUM_LIMBS - 1] < 0) {
+    neg = 1;
+    for (k = 0; k < SUM_LIMBS; k++) a.limb[k] = -a.limb[k];
+    sum_acc_normalize(&a);
+  }
+  for (k = 0; k < SUM_LIMBS; k++) l[k] = (uint64_t) a.limb[k];
+  for (h = SUM_LIMBS - 1; h >= 0 && l[h] == 0; h--);
+  if (h < 0) return 0.0;
+  /* the top limb may exceed 32 bits only for sums far beyond DBL_MAX */
+  if (l[h] >> 32) return neg ? -HUGE_VAL : HUGE_VAL;
+  for (b = 32; ((l[h] >> (b - 1)) & 1) == 0; b--);
+  /* top: the 64 bits below and at the leading one */
+  top = (l[h] << 32) | (h >= 1 ? l[h - 1] : 0);
+  if (b < 32) top = (top << (32 - b)) | ((h >= 2 ? l[h - 2] : 0) >> b);
+  if (h >= 2 && b < 32) sticky = (l[h - 2] & ((((uint64_t) 1) << b) - 1)) != 0;
+  else if (h >= 2) sticky = l[h - 2] != 0;
+  for (k = h - 3; k >= 0 && !sticky; k--) sticky = l[k] != 0;
+  p = 32 * h + b - 1;          /* bit position of the leading one */
+  q = p + 1 < 53 ? p + 1 : 53; /* significant bits of the result */
+  drop = 64 - q;
+  mant = top >> drop;
+  rem = top & ((((uint64_t) 1) << drop) - 1);
+  half = ((uint64_t) 1) << (drop - 1);
+  if (rem > half || (rem == half && (sticky || (mant & 1)))) mant++;
+  r = ldexp((double) mant, p - q + 1 - SUM_LIMB_BIAS);
+  return neg ? -r : r;
+}
+
+/*****/
+
+static void sum_chunk(sum_job *job, size_t k)
+{
+  size_t start = k * SUM_CHUNK, n = job->n - start, i;
+  const double *x = job->x + start * job->xstride, *y = NULL;
+  if (n > SUM_CHUNK) n = SUM_CHUNK;
+  if (job->y) y = job->y + start * job->ystride;
+  switch (job->op) {
+  case SUM_OP_PROD:
+    if (job->method == SUM_PAIRWISE) job->part[k] = prod_pairwise(x, job->xstride, n);
+    else prod_kahan(x, job->xstride, n, &job->part[k], &job->comp[k]);
+    break;
+  default:
+    switch (job->method) {
+    case SUM_PAIRWISE:
+      if (y) job->part[k] = dot_pairwise(x, job->xstride, y, job->ystride, n);
+      else job->part[k] = sum_pairwise(x, job->xstride, n);
+      break;
+    case SUM_KAHAN:
+      sum_kahan(x, job->xstride, y, job->ystride, n, &job->part[k], &job->comp[k]);
+      break;
+    case SUM_EXACT:
+      sum_acc_init(&job->acc[k]);
+      if (y) {
+        double p, e;
+        for (i = 0; i < n; i++) {
+          p = sum_two_prod(x[i * job->xstride], y[i * job->ystride], &e);
+          sum_acc_add(&job->acc[k], p);
+          if (isfinite(p)) sum_acc_add(&job->acc[k], e);
+        }
+      } else {
+        for (i = 0; i < n; i++) sum_acc_add(&job->acc[k], x[i * job->xstride]);
+      }
+      sum_acc_normalize(&job->acc[k]);
+      break;
+    }
+    break;
+  }
+}
+
+static void sum_worker(size_t tid, size_t nthreads, void *data)
+{
+  sum_job *job = (sum_job *) data;
+  size_t k;
+  for (k = tid; k < job->nchunks && !rb_gsl_parallel_interrupted(); k += nthreads) sum_chunk(job, k);
+}
+
+static double sum_combine(sum_job *job)
+{
+  double s = 0.0, c = 0.0, e, p, ep;
+  size_t k;
+  switch (job->op) {
+  case SUM_OP_PROD:
+    if (job->method == SUM_PAIRWISE) return prod_pairwise(job->part, 1, job->nchunks);
+    s = 1.0;
+    for (k = 0; k < job->nchunks; k++) {
+      /* (s + c)(part + comp) to first order in the corrections */
+      p = sum_two_prod(s, job->part[k], &ep);
+      c = ep + s * job->comp[k] + c * job->part[k];
+      s = p;
+    }
+    return isfinite(s) ? s + c : s;
+  default:
+    switch (job->method) {
+    case SUM_PAIRWISE:
+      return sum_pairwise(job->part, 1, job->nchunks);
+    case SUM_KAHAN:
+      for (k = 0; k < job->nchunks; k++) {
+        s = sum_two_sum(s, job->part[k], &e);
+        c += e + job->comp[k];
+      }
+      return isfinite(s) ? s + c : s;
+    case SUM_EXACT:
+      for (k = 1; k < job->nchunks; k++) sum_acc_merge(&job->acc[0], &job->acc[k]);
+      return sum_acc_round(&job->acc[0]);
+    }
+  }
+  return 0.0;
+}
+
+static double sum_run(sum_job *job, size_t nthreads, VALUE holder)
+{
+  if (job->n == 0) return job->op == SUM_OP_PROD ? 1.0 : 0.0;
+  if (job->method == SUM_NAIVE) {
+    if (job->op == SUM_OP_PROD) return prod_naive(job->x, job->xstride, job->n);
+    return sum_naive(job->x, job->xstride, job->y, job->ystride, job->n);
+  }
+  job->nchunks = (job->n + SUM_CHUNK - 1) / SUM_CHUNK;
+  job->part = ALLOC_N(double, job->nchunks);
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, free, job->part));
+  job->comp = ALLOC_N(double, job->nchunks);
+  rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, free, job->comp));
+  if (job->method == SUM_EXACT) {
+    job->acc = ALLOC_N(sum_acc, job->nchunks);
+    rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, free, job->acc));
+  }
+  if (nthreads > job->nchunks) nthreads = job->nchunks;
+  if (nthreads <= 1) sum_worker(0, 1, job);
+  else rb_gsl_parallel_run(nthreads, sum_worker, job);
+  return sum_combine(job);
+}
+
+/*****/
+
+static int sum_get_method(VALUE opts)
+{
+  VALUE meth = rb_gsl_hash_get(opts, "method");
+  const char *name;
+  if (NIL_P(meth)) return SUM_PAIRWISE;
+  name = SYMBOL_P(meth) ? rb_id2name(SYM2ID(meth)) : StringValuePtr(meth);
+  if (strcmp(name, "pairwise") == 0) return SUM_PAIRWISE;
+  if (strcmp(name, "kahan") == 0) return SUM_KAHAN;
+  if (strcmp(name, "exact") == 0) return SUM_EXACT;
+  if (strcmp(name, "naive") == 0) return SUM_NAIVE;
+  rb_raise(rb_eArgError, "unknown summation method %s (pairwise, kahan, exact or naive expected)",
+           name);
+  return SUM_PAIRWISE;
+}
+
+static VALUE sum_get_opts(int *argc, VALUE *argv)
+{
+  if (*argc > 0 && TYPE(argv[*argc - 1]) == T_HASH) return argv[--(*argc)];
+  return Qnil;
+}
+
+static double sum_vector(int op, const gsl_vector *x, const gsl_vector *y, VALUE opts)
+{
+  VALUE holder = rb_ary_new();
+  sum_job job;
+  double r;
+  memset(&job, 0, sizeof(sum_job));
+  job.op = op;
+  job.method = sum_get_method(opts);
+  job.x = x->data;
+  job.xstride = x->stride;
+  job.n = x->size;
+  if (y) {
+    job.y = y->data;
+    job.ystride = y->stride;
+  }
+  r = sum_run(&job, rb_gsl_parallel_threads(opts), holder);
+  RB_GC_GUARD(holder);
+  return r;
+}
+
+/*
+  Vector#sum(method: :pairwise, threads: n)
+*/
+static VALUE rb_gsl_vector_sum(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_vector *v;
+  VALUE opts = sum_get_opts(&argc, argv);
+  if (argc != 0) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0)", argc);
+  Data_Get_Vector(obj, v);
+  return rb_float_new(sum_vector(SUM_OP_SUM, v, NULL, opts));
+}
+
+/*
+  Vector#sumsq(method: :pairwise, threads: n)
+*/
+static VALUE rb_gsl_vector_sumsq(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_vector *v;
+  VALUE opts = sum_get_opts(&argc, argv);
+  if (argc != 0) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0)", argc);
+  Data_Get_Vector(obj, v);
+  return rb_float_new(sum_vector(SUM_OP_DOT, v, v, opts));
+}
+
+/*
+  Vector#prod(method: :pairwise, threads: n)
+
+  :exact is taken as :kahan, the compensated product.
+*/
+static VALUE rb_gsl_vector_prod(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_vector *v;
+  VALUE opts = sum_get_opts(&argc, argv);
+  if (argc != 0) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0)", argc);
+  Data_Get_Vector(obj, v);
+  return rb_float_new(sum_vector(SUM_OP_PROD, v, NULL, opts));
+}
+
+/*
+  Vector.inner_product(a, b, method: :pairwise, threads: n), Vector#inner_product(b, ...)
+  Vector.dot, Vector#dot
+*/
+VALUE rb_gsl_vector_inner_product(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_vector *v = NULL, *v2 = NULL;
+  VALUE opts = sum_get_opts(&argc, argv);
+  switch (TYPE(obj)) {
+  case T_MODULE:  case T_CLASS:  case T_OBJECT:
+    if (argc != 2) rb_raise(rb_eArgError, "wrong number of arguments (%d for 2)",
+                            argc);
+    CHECK_VECTOR(argv[0]);
+    CHECK_VECTOR(argv[1]);
+    Data_Get_Struct(argv[0], gsl_vector, v);
+    Data_Get_Struct(argv[1], gsl_vector, v2);
+    break;
+  default:
+    if (argc != 1) rb_raise(rb_eArgError, "wrong number of arguments (%d for 1)",
+                            argc);
+    CHECK_VECTOR(argv[0]);
+    Data_Get_Struct(obj, gsl_vector, v);
+    Data_Get_Struct(argv[0], gsl_vector, v2);
+    break;
+  }
+  if (v->size != v2->size) rb_raise(rb_eRangeError, "vector lengths are different.");
+  return rb_float_new(sum_vector(SUM_OP_DOT, v, v2, opts));
+}
+
+/*****/
+
+/* cumulative sums of chunk k, starting from the compensated sum s + c */
+static void cumsum_chunk(sum_job *job, size_t k, double s, double c)
+{
+  size_t start = k * SUM_CHUNK, n = job->n - start, i;
+  const double *x = job->x + start * job->xstride;
+  double *out = job->out + start * job->ostride, e;
+  if (n > SUM_CHUNK) n = SUM_CHUNK;
+  for (i = 0; i < n; i++) {
+    s = sum_two_sum(s, x[i * job->xstride], &e);
+    c += e;
+    out[i * job->ostride] = isfinite(s) ? s + c : s;
+  }
+}
+
+static void cumsum_whole(sum_job *job)
+{
+  double s = 0.0, c = 0.0, e;
+  size_t i;
+  for (i = 0; i < job->n; i++) {
+    s = sum_two_sum(s, job->x[i * job->xstride], &e);
+    c += e;
+    job->out[i * job->ostride] = isfinite(s) ? s + c : s;
+  }
+}
+
+static void cumsum_total_worker(size_t tid, size_t nthreads, void *data)
+{
+  sum_job *job = (sum_job *) data;
+  size_t k, start, n;
+  for (k = tid; k < job->nchunks && !rb_gsl_parallel_interrupted(); k += nthreads) {
+    start = k * SUM_CHUNK;
+    n = job->n - start;
+    if (n > SUM_CHUNK) n = SUM_CHUNK;
+    sum_kahan(job->x + start * job->xstride, job->xstride, NULL, 0, n, &job->part[k], &job->comp[k]);
+  }
+}
+
+static void cumsum_worker(size_t tid, size_t nthreads, void *data)
+{
+  sum_job *job = (sum_job *) data;
+  size_t k;
+  /* after cumsum_offsets, part[k] + comp[k] is the sum of the chunks before k */
+  for (k = tid; k < job->nchunks && !rb_gsl_parallel_interrupted(); k += nthreads) cumsum_chunk(job, k, job->part[k], job->comp[k]);
+}
+
+static void cumsum_offsets(sum_job *job)
+{
+  double s = 0.0, c = 0.0, e, ps, pc;
+  size_t k;
+  for (k = 0; k < job->nchunks; k++) {
+    ps = job->part[k];
+    pc = job->comp[k];
+    job->part[k] = s;
+    job->comp[k] = c;
+    s = sum_two_sum(s, ps, &e);
+    c += e + pc;
+  }
+}
+
+/*
+  Vector#cumsum(method: :kahan, threads: n)
+
+  The default keeps a compensated running sum (:pairwise is taken as
+  :kahan); :exact rounds the exact prefix sums, and :naive is the plain
+  running sum. With threads, each thread starts from the compensated
+  sum of the chunks before its own, which may change the last bit.
+*/
+static VALUE rb_gsl_vector_cumsum(int argc, VALUE *argv, VALUE obj)
+{
+  gsl_vector *v, *vnew;
+  VALUE opts = sum_get_opts(&argc, argv), holder = rb_ary_new();
+  sum_job job;
+  sum_acc acc;
+  size_t i, nthreads;
+  double s;
+  if (argc != 0) rb_raise(rb_eArgError, "wrong number of arguments (%d for 0)", argc);
+  Data_Get_Vector(obj, v);
+  vnew = gsl_vector_alloc(v->size);
+  memset(&job, 0, sizeof(sum_job));
+  job.method = sum_get_method(opts);
+  job.x = v->data;
+  job.xstride = v->stride;
+  job.n = v->size;
+  job.out = vnew->data;
+  job.ostride = vnew->stride;
+  job.nchunks = (job.n + SUM_CHUNK - 1) / SUM_CHUNK;
+  nthreads = rb_gsl_parallel_threads(opts);
+  if (nthreads > job.nchunks) nthreads = job.nchunks;
+  switch (job.method) {
+  case SUM_NAIVE:
+    for (i = 0, s = 0.0; i < job.n; i++) {
+      s += job.x[i * job.xstride];
+      job.out[i * job.ostride] = s;
+    }
+    break;
+  case SUM_EXACT:
+    sum_acc_init(&acc);
+    for (i = 0; i < job.n; i++) {
+      sum_acc_add(&acc, job.x[i * job.xstride]);
+      job.out[i * job.ostride] = sum_acc_round(&acc);
+    }
+    break;
+  default:
+    if (nthreads <= 1) {
+      if (job.n > 0) cumsum_whole(&job);
+      break;
+    }
+    job.part = ALLOC_N(double, job.nchunks);
+    rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, free, job.part));
+    job.comp = ALLOC_N(double, job.nchunks);
+    rb_ary_push(holder, Data_Wrap_Struct(rb_cObject, 0, free, job.comp));
+    rb_gsl_parallel_run(nthreads, cumsum_total_worker, &job);
+    cumsum_offsets(&job);
+    rb_gsl_parallel_run(nthreads, cumsum_worker, &job);
+    break;
+  }
+  RB_GC_GUARD(holder);
+  return Data_Wrap_Struct(VECTOR_ROW_COL(obj), 0, gsl_vector_free, vnew);
+}
+
+void Init_gsl_vector_sum(VALUE module)
+{
+  rb_define_method(cgsl_vector, "sum", rb_gsl_vector_sum, -1);
+  rb_define_method(cgsl_vector, "sumsq", rb_gsl_vector_sumsq, -1);
+  rb_define_method(cgsl_vector, "prod", rb_gsl_vector_prod, -1);
+  rb_define_method(cgsl_vector, "cumsum", rb_gsl_vector_cumsum, -1);
+
+  rb_define_singleton_method(cgsl_vector, "inner_product", rb_gsl_vector_inner_product, -1);
+  rb_define_singleton_method(cgsl_vector, "dot", rb_gsl_vector_inner_product, -1);
+  rb_define_method(cgsl_vector, "inner_product", rb_gsl_vector_inner_product, -1);
+  rb_define_alias(cgsl_vector, "dot", "inner_product");
+}
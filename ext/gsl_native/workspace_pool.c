@@ -0,0 +1,238 @@
+/*
+  workspace_pool.c
+  Ruby/GSL: Ruby extension library for GSL (GNU Scientific Library)
+
+  Ruby/GSL is free software: you can redistribute it and/or modify it
+  under the terms of the GNU General Public License.
+  This library is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY.
+*/
+
+/*
+  Methods like Matrix#eigen_symm or Function#qag need a GSL workspace, and
+  allocate a temporary one when none is given. The pool keeps those
+  temporaries, keyed by kind and size, so that repeated calls of the same
+  size reuse them. Each thread has its own pool; the least recently
+  returned workspace is freed when a pool is full.
+*/
+
+#include "include/rb_gsl.h"
+#include "include/rb_gsl_workspace_pool.h"
+#include <gsl/gsl_eigen.h>
+#include <gsl/gsl_integration.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#define RB_GSL_WORKSPACE_POOL_SIZE 16
+
+typedef struct {
+  const rb_gsl_workspace_type *type;
+  size_t n;
+  void *w;
+  unsigned long stamp;
+} rb_gsl_workspace_entry;
+
+typedef struct {
+  rb_gsl_workspace_entry entries[RB_GSL_WORKSPACE_POOL_SIZE];
+  size_t count;
+  unsigned long clock;
+  unsigned long hits, misses, evictions;
+} rb_gsl_workspace_pool;
+
+/*****/
+
+static void* ws_eigen_symm_alloc(size_t n) { return gsl_eigen_symm_alloc(n); }
+static void ws_eigen_symm_free(void *w) { gsl_eigen_symm_free(w); }
+static size_t ws_eigen_symm_size(const void *w) { return ((const gsl_eigen_symm_workspace *) w)->size; }
+
+static void* ws_eigen_symmv_alloc(size_t n) { return gsl_eigen_symmv_alloc(n); }
+static void ws_eigen_symmv_free(void *w) { gsl_eigen_symmv_free(w); }
+static size_t ws_eigen_symmv_size(const void *w) { return ((const gsl_eigen_symmv_workspace *) w)->size; }
+
+static void* ws_eigen_herm_alloc(size_t n) { return gsl_eigen_herm_alloc(n); }
+static void ws_eigen_herm_free(void *w) { gsl_eigen_herm_free(w); }
+static size_t ws_eigen_herm_size(const void *w) { return ((const gsl_eigen_herm_workspace *) w)->size; }
+
+static void* ws_eigen_hermv_alloc(size_t n) { return gsl_eigen_hermv_alloc(n); }
+static void ws_eigen_hermv_free(void *w) { gsl_eigen_hermv_free(w); }
+static size_t ws_eigen_hermv_size(const void *w) { return ((const gsl_eigen_hermv_workspace *) w)->size; }
+
+static void* ws_eigen_nonsymm_alloc(size_t n) { return gsl_eigen_nonsymm_alloc(n); }
+static void ws_eigen_nonsymm_free(void *w) { gsl_eigen_nonsymm_free(w); }
+static size_t ws_eigen_nonsymm_size(const void *w) { return ((const gsl_eigen_nonsymm_workspace *) w)->size; }
+
+static void* ws_eigen_nonsymmv_alloc(size_t n) { return gsl_eigen_nonsymmv_alloc(n); }
+static void ws_eigen_nonsymmv_free(void *w) { gsl_eigen_nonsymmv_free(w); }
+static size_t ws_eigen_nonsymmv_size(const void *w) { return ((const gsl_eigen_nonsymmv_workspace *) w)->size; }
+
+static void* ws_integration_alloc(size_t n) { return gsl_integration_workspace_alloc(n); }
+static void ws_integration_free(void *w) { gsl_integration_workspace_free(w); }
+static size_t ws_integration_size(const void *w) { return ((const gsl_integration_workspace *) w)->limit; }
+
+static void* ws_vector_alloc(size_t n) { return gsl_vector_alloc(n); }
+static void ws_vector_free(void *w) { gsl_vector_free(w); }
+static size_t ws_vector_size(const void *w) { return ((const gsl_vector *) w)->size; }
+
+const rb_gsl_workspace_type rb_gsl_workspace_eigen_symm = {
+  "eigen_symm", ws_eigen_symm_alloc, ws_eigen_symm_free, ws_eigen_symm_size
+};
+const rb_gsl_workspace_type rb_gsl_workspace_eigen_symmv = {
+  "eigen_symmv", ws_eigen_symmv_alloc, ws_eigen_symmv_free, ws_eigen_symmv_size
+};
+const rb_gsl_workspace_type rb_gsl_workspace_eigen_herm = {
+  "eigen_herm", ws_eigen_herm_alloc, ws_eigen_herm_free, ws_eigen_herm_size
+};
+const rb_gsl_workspace_type rb_gsl_workspace_eigen_hermv = {
+  "eigen_hermv", ws_eigen_hermv_alloc, ws_eigen_hermv_free, ws_eigen_hermv_size
+};
+const rb_gsl_workspace_type rb_gsl_workspace_eigen_nonsymm = {
+  "eigen_nonsymm", ws_eigen_nonsymm_alloc, ws_eigen_nonsymm_free, ws_eigen_nonsymm_size
+};
+const rb_gsl_workspace_type rb_gsl_workspace_eigen_nonsymmv = {
+  "eigen_nonsymmv", ws_eigen_nonsymmv_alloc, ws_eigen_nonsymmv_free, ws_eigen_nonsymmv_size
+};
+const rb_gsl_workspace_type rb_gsl_workspace_integration = {
+  "integration", ws_integration_alloc, ws_integration_free, ws_integration_size
+};
+const rb_gsl_workspace_type rb_gsl_workspace_vector = {
+  "vector", ws_vector_alloc, ws_vector_free, ws_vector_size
+};
+
+/*****/
+
+static void rb_gsl_workspace_pool_clear(rb_gsl_workspace_pool *pool)
+{
+  size_t i;
+  for (i = 0; i < pool->count; i++)
+    (*pool->entries[i].type->free)(pool->entries[i].w);
+  memset(pool, 0, sizeof(rb_gsl_workspace_pool));
+}
+
+#ifdef HAVE_PTHREAD_H
+static pthread_key_t rb_gsl_workspace_pool_key;
+
+static void rb_gsl_workspace_pool_destroy(void *p)
+{
+  rb_gsl_workspace_pool_clear((rb_gsl_workspace_pool *) p);
+  free(p);
+}
+
+static rb_gsl_workspace_pool* rb_gsl_workspace_pool_current(void)
+{
+  rb_gsl_workspace_pool *pool;
+  pool = (rb_gsl_workspace_pool *) pthread_getspecific(rb_gsl_workspace_pool_key);
+  if (pool == NULL) {
+    /* may run without the GVL: no Ruby allocator here */
+    pool = (rb_gsl_workspace_pool *) calloc(1, sizeof(rb_gsl_workspace_pool));
+    if (pool == NULL) return NULL;
+    pthread_setspecific(rb_gsl_workspace_pool_key, pool);
+  }
+  return pool;
+}
+#else
+static rb_gsl_workspace_pool rb_gsl_workspace_pool_global;
+
+static rb_gsl_workspace_pool* rb_gsl_workspace_pool_current(void)
+{
+  return &rb_gsl_workspace_pool_global;
+}
+#endif
+
+void* rb_gsl_workspace_get(const rb_gsl_workspace_type *T, size_t n)
+{
+  rb_gsl_workspace_pool *pool = rb_gsl_workspace_pool_current();
+  size_t i;
+  void *w;
+  if (pool) {
+    for (i = 0; i < pool->count; i++) {
+      if (pool->entries[i].type == T && pool->entries[i].n == n) {
+        w = pool->entries[i].w;
+        pool->entries[i] = pool->entries[--pool->count];
+        pool->hits++;
+        return w;
+      }
+    }
+    pool->misses++;
+  }
+  return (*T->alloc)(n);
+}
+
+void rb_gsl_workspace_put(const rb_gsl_workspace_type *T, void *w)
+{
+  rb_gsl_workspace_pool *pool = rb_gsl_workspace_pool_current();
+  size_t i, oldest = 0;
+  if (w == NULL) return;
+  if (pool == NULL) {
+    (*T->free)(w);
+    return;
+  }
+  if (pool->count == RB_GSL_WORKSPACE_POOL_SIZE) {
+    for (i = 1; i < pool->count; i++)
+      if (pool->entries[i].stamp < pool->entries[oldest].stamp) oldest = i;
+    (*pool->entries[oldest].type->free)(pool->entries[oldest].w);
+    pool->entries[oldest] = pool->entries[--pool->count];
+    pool->evictions++;
+  }
+  pool->entries[pool->count].type = T;
+  pool->entries[pool->count].n = (*T->size)(w);
+  pool->entries[pool->count].w = w;
+  pool->entries[pool->count].stamp = ++pool->clock;
+  pool->count++;
+}
+
+/*****/
+
+static VALUE cgsl_workspace_pool, rb_gsl_workspace_pool_instance;
+
+static VALUE rb_gsl_workspace_pool_get(VALUE obj)
+{
+  return rb_gsl_workspace_pool_instance;
+}
+
+/* GSL.workspace_pool.stats, counters of the pool of the calling thread */
+static VALUE rb_gsl_workspace_pool_stats(VALUE obj)
+{
+  rb_gsl_workspace_pool *pool = rb_gsl_workspace_pool_current();
+  VALUE hash, cached;
+  size_t i;
+  VALUE key, val;
+  hash = rb_hash_new();
+  cached = rb_hash_new();
+  if (pool == NULL) return hash;
+  for (i = 0; i < pool->count; i++) {
+    key = ID2SYM(rb_intern(pool->entries[i].type->name));
+    val = rb_hash_aref(cached, key);
+    rb_hash_aset(cached, key, INT2FIX(NIL_P(val) ? 1 : FIX2INT(val) + 1));
+  }
+  rb_hash_aset(hash, ID2SYM(rb_intern("hits")), ULONG2NUM(pool->hits));
+  rb_hash_aset(hash, ID2SYM(rb_intern("misses")), ULONG2NUM(pool->misses));
+  rb_hash_aset(hash, ID2SYM(rb_intern("evictions")), ULONG2NUM(pool->evictions));
+  rb_hash_aset(hash, ID2SYM(rb_intern("size")), INT2FIX(pool->count));
+  rb_hash_aset(hash, ID2SYM(rb_intern("capacity")), INT2FIX(RB_GSL_WORKSPACE_POOL_SIZE));
+  rb_hash_aset(hash, ID2SYM(rb_intern("cached")), cached);
+  return hash;
+}
+
+/* GSL.workspace_pool.clear, frees the cached workspaces of the calling thread */
+static VALUE rb_gsl_workspace_pool_clear_method(VALUE obj)
+{
+  rb_gsl_workspace_pool *pool = rb_gsl_workspace_pool_current();
+  if (pool) rb_gsl_workspace_pool_clear(pool);
+  return obj;
+}
+
+void Init_gsl_workspace_pool(VALUE module)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_key_create(&rb_gsl_workspace_pool_key, rb_gsl_workspace_pool_destroy);
+#endif
+  cgsl_workspace_pool = rb_define_class_under(module, "WorkspacePool", cGSL_Object);
+  rb_undef_alloc_func(cgsl_workspace_pool);
+  rb_define_method(cgsl_workspace_pool, "stats", rb_gsl_workspace_pool_stats, 0);
+  rb_define_method(cgsl_workspace_pool, "clear", rb_gsl_workspace_pool_clear_method, 0);
+
+  rb_gsl_workspace_pool_instance = Data_Wrap_Struct(cgsl_workspace_pool, 0, 0, 0);
+  rb_global_variable(&rb_gsl_workspace_pool_instance);
+  rb_define_module_function(module, "workspace_pool", rb_gsl_workspace_pool_get, 0);
+}
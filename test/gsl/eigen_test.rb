@@ -560,4 +560,79 @@ class EigenTest < GSL::TestCase
     _test_eigen_herm('herm(4) diag', r.to_complex)
   end
 
+  def _laplacian(n)
+    m = GSL::Matrix.calloc(n, n)
+    n.times { |i|
+      m[i, i] = 2.0
+      m[i, i + 1] = m[i + 1, i] = -1.0 if i < n - 1
+    }
+    m
+  end
+
+  def test_lanczos
+    n = 60
+    m = _laplacian(n)
+    exact = lambda { |j| 2.0 - 2.0 * Math.cos(j * Math::PI / (n + 1)) }
+
+    eval, evec = GSL::Eigen.lanczos(m, k: 3, tol: 1e-12)
+    3.times { |i|
+      assert_rel eval[i], exact.(n - i), 1e-9, "lanczos largest #{i}"
+      x = evec.col(i)
+      assert_abs (m * x - x * eval[i]).dnrm2, 0.0, 1e-7, "lanczos residual #{i}"
+    }
+
+    eval, = m.eigen_lanczos(k: 2, which: :smallest, tol: 1e-12, ncv: 30)
+    assert_rel eval[0], exact.(1), 1e-8, 'lanczos smallest 0'
+    assert_rel eval[1], exact.(2), 1e-8, 'lanczos smallest 1'
+
+    op = lambda { |x| m * x }
+    eval, = GSL::Eigen.lanczos(op, n: n, k: 2, tol: 1e-12)
+    assert_rel eval[0], exact.(n), 1e-9, 'lanczos proc 0'
+    assert_rel eval[1], exact.(n - 1), 1e-9, 'lanczos proc 1'
+
+    calls = 0
+    assert_raises(ZeroDivisionError) {
+      GSL::Eigen.lanczos(lambda { |x| (calls += 1) > 5 ? 1 / 0 : m * x }, n: n, k: 2)
+    }
+    assert_raises(RangeError) { GSL::Eigen.lanczos(lambda { |x| x.subvector(0, 2) }, n: n, k: 2) }
+    assert_raises(TypeError) { GSL::Eigen.lanczos(lambda { |x| x.to_a }, n: n, k: 2) }
+  end
+
+  def test_arnoldi
+    n = 40
+    m = GSL::Matrix.calloc(n, n)
+    n.times { |i|
+      m[i, i] = i + 1.0
+      m[i, i + 1] = 0.5 if i < n - 1
+      m[i, i + 2] = 0.25 if i < n - 2
+    }
+
+    eval, evec = GSL::Eigen.arnoldi(m, k: 3, tol: 1e-12)
+    3.times { |i|
+      assert_rel eval[i].re, n - i, 1e-8, "arnoldi largest #{i}"
+      assert_abs eval[i].im, 0.0, 1e-8, "arnoldi largest imag #{i}"
+    }
+    assert_equal [n, 3], evec.size
+
+    # rotation blocks give complex conjugate pairs 1 +- 2i, ...
+    r = GSL::Matrix.calloc(20, 20)
+    10.times { |i|
+      a, b = i + 1.0, 2.0 * (i + 1)
+      r[2 * i, 2 * i] = r[2 * i + 1, 2 * i + 1] = a
+      r[2 * i, 2 * i + 1] = b
+      r[2 * i + 1, 2 * i] = -b
+    }
+    eval, = r.eigen_arnoldi(k: 2, ncv: 12, tol: 1e-12)
+    assert_rel eval[0].abs, 10 * Math.sqrt(5.0), 1e-8, 'arnoldi complex 0'
+    assert_rel eval[1].abs, 10 * Math.sqrt(5.0), 1e-8, 'arnoldi complex 1'
+    assert_abs eval[0].im + eval[1].im, 0.0, 1e-8, 'arnoldi conjugate pair'
+
+    # a repeated eigenvalue makes the restart vectors linearly dependent
+    eval, evec = GSL::Eigen.arnoldi(GSL::Matrix.identity(30) * 2.0, k: 3, ncv: 8, tol: 1e-12)
+    3.times { |i| assert_rel eval[i].re, 2.0, 1e-10, "arnoldi repeated #{i}" }
+    assert evec.real.to_a.flatten.none?(&:nan?), 'arnoldi repeated: no NaN'
+
+    assert_raises(ZeroDivisionError) { GSL::Eigen.arnoldi(lambda { |x| 1 / 0 }, n: n, k: 2) }
+  end
+
 end
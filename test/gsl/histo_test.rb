@@ -1,4 +1,5 @@
 require 'test_helper'
+require 'tmpdir'
 
 class HistoTest < GSL::TestCase
 
@@ -11,4 +12,175 @@ class HistoTest < GSL::TestCase
     assert h.bin
   end
 
+  def test_bulk_fill
+    r = GSL::Rng.alloc('mt19937', 3)
+    x = GSL::Vector.alloc(200000).map { r.gaussian(2.0) }
+    w = GSL::Vector.alloc(x.size).map { r.uniform }
+
+    # uniform bins with odd limits, and uneven bins
+    [GSL::Histogram.alloc(37, [-3.3, 4.1]),
+     GSL::Histogram.alloc([-5.0, -1.0, -0.5, 0.0, 0.1, 0.2, 1.0, 3.0, 5.0])].each { |h0|
+      h1, h4, hw = h0.clone, h0.clone, h0.clone
+      x.each { |v| h0.increment(v) }
+      h1.increment(x, threads: 1)
+      h4.increment(x, threads: 4)
+      assert_equal h0.bin.to_a, h1.bin.to_a
+      assert_equal h0.bin.to_a, h4.bin.to_a
+
+      ref = hw.clone
+      hw.increment(x, w, threads: 4)
+      x.size.times { |i| ref.increment(x[i], w[i]) }
+      ref.bin.size.times { |i| assert_rel hw.bin[i], ref.bin[i], 1e-10, 'Histogram#increment weights' }
+    }
+
+    h = GSL::Histogram.alloc(4, [0, 4])
+    h.increment([0.0, 1.0, 3.999, 4.0, -0.1])
+    assert_equal [1.0, 1.0, 0.0, 1.0], h.bin.to_a
+    # NaN raises like the scalar increment, and nothing is added
+    assert_raises(GSL::ERROR::ESANITY) { h.increment(0.0 / 0.0) }
+    assert_raises(GSL::ERROR::ESANITY) { h.increment([0.5, 0.0 / 0.0], threads: 2) }
+    assert_equal [1.0, 1.0, 0.0, 1.0], h.bin.to_a
+    assert_raises(ArgumentError) { h.increment(x, GSL::Vector.alloc(3)) }
+
+    y = GSL::Vector.alloc(x.size).map { r.gaussian(1.0) }
+    h2a = GSL::Histogram2d.alloc(8, [-4, 4], 6, [-1.5, 1.5])
+    h2b = GSL::Histogram2d.alloc(8, [-4, 4], 6, [-1.5, 1.5])
+    x.size.times { |i| h2a.increment(x[i], y[i]) }
+    h2b.increment(x, y, threads: 4)
+    assert_equal h2a.bin.to_a, h2b.bin.to_a
+    assert_raises(GSL::ERROR::ESANITY) { h2b.increment(GSL::Vector[0.0], GSL::Vector[0.0 / 0.0]) }
+    assert_equal h2a.bin.to_a, h2b.bin.to_a
+  end
+
+  def test_sparse
+    h = GSL::Histogram::Sparse.new([1000, 0, 1], [1000, 0, 1], [1000, -1, 1])
+    assert_equal 3, h.dim
+    assert_equal [1000, 1000, 1000], h.shape
+
+    m = GSL::Matrix.alloc([0.0005, 0.5, 0.0], [0.0005, 0.5, 0.0], [0.9999, 0.25, -1.0], [1.0, 0.5, 0.0])
+    h.increment(m)
+    h.increment([0.0005, 0.5, 0.0], 2.0)
+    assert_equal 2, h.nnz
+    assert_equal 4.0, h[0, 500, 500]
+    assert_equal 1.0, h[999, 250, 0]
+    assert_equal 0.0, h[1, 1, 1]
+    assert_equal 5.0, h.sum
+
+    h2 = h.project(0, 2)
+    assert_equal [1000, 1000], [h2.nx, h2.ny]
+    assert_equal 4.0, h2[0, 500]
+    h1 = h.project(1)
+    assert_equal 5.0, h1.sum
+    assert_equal 1.0, h1[250]
+    assert_equal 1, h.marginalize(2, 1).dim
+
+    h3 = h.project(2, 1, 0)
+    assert_equal 4.0, h3[500, 500, 0]
+
+    # merging partial histograms
+    a = GSL::Histogram::Sparse.new(GSL::Vector[0, 1, 3, 10], [4, 0, 4])
+    b = a.clone
+    a.increment(GSL::Matrix.alloc([0.5, 0.5], [2.0, 3.5]), GSL::Vector[1.0, 2.0])
+    b.increment([2.5, 3.9])
+    c = a + b
+    assert_equal 3.0, c[1, 3]
+    assert_equal 2, c.nnz
+    a.merge!(b)
+    assert_equal 3.0, a[1, 3]
+    assert_raises(ArgumentError) { a.merge!(GSL::Histogram::Sparse.new([4, 0, 4], [4, 0, 4])) }
+
+    # merging with itself, with the table full enough to grow on insert
+    d = GSL::Histogram::Sparse.new([100, 0, 100])
+    48.times { |i| d.increment([i + 0.5]) }
+    d.merge!(d)
+    assert_equal 48, d.nnz
+    assert_equal 96.0, d.sum
+    assert_equal 192.0, (d + d).sum
+
+    # NaN coordinates raise like the dense histograms, leaving the bins as they were
+    assert_raises(GSL::ERROR::ESANITY) { d.increment([0.0 / 0.0]) }
+    assert_raises(GSL::ERROR::ESANITY) { a.increment(GSL::Matrix.alloc([0.5, 0.5], [0.5, 0.0 / 0.0])) }
+    assert_equal 96.0, d.sum
+    assert_equal 3.0, a[1, 3]
+    assert_equal 2, a.nnz
+
+    # unbounded stream
+    s = GSL::Histogram::Sparse.new([10, 0, 1], extend: true)
+    s.increment([-0.35])
+    s.increment([2.05])
+    assert_equal [25], s.shape
+    assert_abs s.range(0)[0], -0.4, 1e-12, 'Sparse extend lower edge'
+    assert_abs s.range(0)[25], 2.1, 1e-12, 'Sparse extend upper edge'
+    assert_equal 1.0, s[0]
+    assert_equal 1.0, s[24]
+    s.increment([0.05])
+    assert_equal 1.0, s[4]
+    assert_equal 3.0, s.project(0).sum
+  end
+
+
+  # compressed dumps need zlib, which is optional at build time
+  def _zlib?
+    GSL::Histogram.alloc(2, [0, 1]).dump(compress: true)
+    true
+  rescue NotImplementedError
+    false
+  end
+
+  def test_dump_load
+    zlib = _zlib?
+    r = GSL::Rng.alloc('mt19937', 7)
+    h1 = GSL::Histogram.alloc([-2.0, -1.0, 0.0, 0.5, 3.0])
+    h2 = GSL::Histogram2d.alloc(5, [0, 1], 4, [-1, 1])
+    h3 = GSL::Histogram3d.alloc(3, [0, 1], 2, [0, 1], 4, [0, 2])
+    500.times {
+      h1.increment(r.gaussian, r.uniform)
+      h2.increment(r.uniform, r.gaussian)
+      h3.increment(r.uniform, r.uniform, 2 * r.uniform)
+    }
+    [h1, h2, h3].each { |h|
+      (zlib ? [h.dump, h.dump(compress: true), h.dump(compress: 9)] : [h.dump]).each { |s|
+        g = h.class.load(s)
+        assert_equal h.class, g.class
+        assert_equal h.bin.to_a, g.bin.to_a
+      }
+    }
+    assert_equal h1.range.to_a, GSL::Histogram.load(h1.dump).range.to_a
+    assert_equal h2.bin.to_a, Marshal.load(Marshal.dump(h2)).bin.to_a
+    assert_raises(ArgumentError) { GSL::Histogram.load(h2.dump) }
+    assert_raises(ArgumentError) { GSL::Histogram.load(h1.dump[0..-2]) }
+    assert_raises(NotImplementedError) { h1.dump(compress: true) } unless zlib
+
+    # bin counts whose value count overflows must not pass the length check
+    head = "GSLH\x02\x01\x00\x00".b + [2**60 - 1, 1].pack('Q<2')
+    assert_raises(ArgumentError) { GSL::Histogram2d.load(head + [0.0].pack('E')) }
+    assert_raises(ArgumentError) { GSL::Histogram2d.load(head + [0.0].pack('E') * 3) }
+    head = "GSLH\x03\x01\x00\x00".b + [2**40, 2**19, 2**1].pack('Q<3')
+    assert_raises(ArgumentError) { GSL::Histogram3d.load(head + [0.0].pack('E')) }
+
+    Dir.mktmpdir { |dir|
+      sum = GSL::Histogram2d.alloc(5, [0, 1], 4, [-1, 1])
+      paths = (0...12).map { |k|
+        h = GSL::Histogram2d.alloc(5, [0, 1], 4, [-1, 1])
+        50.times {
+          x, y = r.uniform, r.gaussian
+          h.increment(x, y)
+          sum.increment(x, y)
+        }
+        path = File.join(dir, "shard#{k}.gslh")
+        h.dump_file(path, compress: zlib && k.odd?)
+        assert_equal h.bin.to_a, GSL::Histogram2d.load_file(path).bin.to_a
+        path
+      }
+      merged = GSL::Histogram.merge_files(paths, threads: 4)
+      assert_kind_of GSL::Histogram2d, merged
+      assert_equal sum.bin.to_a, merged.bin.to_a
+      assert_equal sum.bin.to_a, GSL::Histogram.merge_files(paths, threads: 1).bin.to_a
+
+      h1.dump_file(File.join(dir, 'other.gslh'))
+      assert_raises(ArgumentError) { GSL::Histogram.merge_files(paths + [File.join(dir, 'other.gslh')]) }
+      assert_raises(Errno::ENOENT) { GSL::Histogram.merge_files([paths[0], File.join(dir, 'missing')]) }
+    }
+  end
+
 end
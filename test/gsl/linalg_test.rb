@@ -296,6 +296,63 @@ class LinalgTest < GSL::TestCase
     assert a.trans * u == v * sm, "#{a.class}#SV_decomp"
   end
 
+  def _low_rank_matrix(m, n, sv, rng)
+    a = GSL::Matrix.calloc(m, n)
+    sv.each { |sigma|
+      x = GSL::Vector.alloc(m)
+      y = GSL::Vector.alloc(n)
+      m.times { |i| x[i] = rng.gaussian }
+      n.times { |j| y[j] = rng.gaussian }
+      x /= x.dnrm2
+      y /= y.dnrm2
+      m.times { |i| n.times { |j| a[i, j] += sigma * x[i] * y[j] } }
+    }
+    a
+  end
+
+  def test_SV_rdecomp
+    rng = GSL::Rng.alloc
+    a = _low_rank_matrix(120, 40, [10.0, 5.0, 2.0, 1.0], rng)
+    _, _, s0 = a.SV_decomp
+
+    u, v, s = a.SV_rdecomp(3, oversample: 5, power_iter: 1, rng: rng)
+    assert_equal [120, 3], u.size
+    assert_equal [40, 3], v.size
+    3.times { |i| assert_rel s[i], s0[i], 1e-10, "SV_rdecomp s[#{i}]" }
+
+    # the residual of the rank-3 approximation is the 4th singular value
+    r = a - u * s.to_m_diagonal * v.trans
+    assert_rel r.SV_decomp[2][0], s0[3], 1e-8, 'SV_rdecomp residual'
+
+    _, _, s = GSL::Linalg::SV.rdecomp(a, 2)
+    assert_rel s[0], s0[0], 1e-10, 'SV.rdecomp'
+  end
+
+  def test_PCA
+    rng = GSL::Rng.alloc
+    x = _low_rank_matrix(400, 12, [30.0, 20.0, 10.0], rng)
+    400.times { |i| 12.times { |j| x[i, j] += 5.0 + j + 1e-3 * rng.gaussian } }
+
+    x0 = x.clone
+    pca = GSL::PCA.new(3, rng: rng).fit(x)
+    batch = pca.explained_variance
+    assert_equal x0, x, 'PCA fit leaves the data alone'
+
+    stream = GSL::PCA.new(3)
+    stream.fit_stream((0...400).step(50).map { |i| x.submatrix(i, 0, 50, 12) }.each)
+    assert_equal 400, stream.nsamples
+    3.times { |i| assert_rel stream.explained_variance[i], batch[i], 1e-6, "PCA stream variance #{i}" }
+    12.times { |j| assert_rel stream.mean[j], pca.mean[j], 1e-10, "PCA stream mean #{j}" }
+    assert_rel stream.total_variance, pca.total_variance, 1e-10, 'PCA total variance'
+    assert stream.explained_variance_ratio.sum > 0.99, 'PCA explained variance ratio'
+    assert_raises(ArgumentError) { GSL::PCA.new(3, power_iter: 1).fit_stream([x].each) }
+
+    z = pca.transform(x)
+    assert_equal [400, 3], z.size
+    y = pca.inverse_transform(z)
+    assert_abs (y - x).norm / x.norm, 0.0, 1e-3, 'PCA reconstruction'
+  end
+
   def _test_TDN_solve_dim(dim, d, a, b, actual, eps, desc)
     eps *= GSL::DBL_EPSILON
 
@@ -74,4 +74,87 @@ class MonteTest < GSL::TestCase
     assert_int vegas.verbose, -1, 'vegas_verbose -1'
   end
 
+  def test_qmc_integrate
+    dim = 6
+    xl, xu = GSL::Vector[*[0.0] * dim], GSL::Vector[*[1.0] * dim]
+    ones = GSL::Vector[*[1.0] * dim].col
+    f = ->(x) { x * ones }
+
+    result, abserr = GSL::Monte.qmc_integrate(f, xl, xu, 8 * 4096, rng: GSL::Rng.alloc('mt19937', 1))
+    assert_abs result, 3.0, 1e-4, 'qmc_integrate sobol'
+    assert abserr < 1e-4, 'qmc_integrate error estimate'
+
+    result, abserr = GSL::Monte.qmc_integrate(f, xl, xu, 8 * 4096, qrng: 'halton')
+    assert_abs result, 3.0, 1e-2, 'qmc_integrate halton'
+
+    g = GSL::Monte::Function.alloc(->(x, d) { x.sum }, dim)
+    result, abserr = GSL::Monte.qmc_integrate(g, xl, xu, 4 * 1024, replicates: 4)
+    assert_abs result, 3.0, 1e-3, 'qmc_integrate Monte::Function'
+  end
+
+  def test_plain_integrate
+    dim = 6
+    xl, xu = GSL::Vector[*[0.0] * dim], GSL::Vector[*[2.0] * dim]
+    ones = GSL::Vector[*[1.0] * dim].col
+    f = ->(x) { x * ones }
+
+    r1 = GSL::Monte.plain_integrate(f, xl, xu, 100000, seed: 3, threads: 1)
+    r2 = GSL::Monte.plain_integrate(f, xl, xu, 100000, seed: 3, threads: 4)
+    assert_equal r1, r2, 'batch integrands run on one thread'
+    assert_abs r1[0], 384.0, 5 * r1[1], 'plain_integrate result within 5 sigma'
+  end
+
+  NATIVE = <<-EOS
+    #include <stddef.h>
+    #include <math.h>
+    double monte_sum(double *x, size_t dim, void *params)
+    {
+      double s = 0.0;
+      size_t i;
+      for (i = 0; i < dim; i++) s += x[i];
+      return s;
+    }
+    double monte_gauss(double *x, size_t dim, void *params)
+    {
+      return exp(-(x[0] * x[0] + x[1] * x[1]));
+    }
+  EOS
+
+  def test_native_integrands
+    lib = native_library(NATIVE)
+    dim = 6
+    f = GSL::Monte::Function::Native.new(lib['monte_sum'], dim)
+    assert_equal 6.0, f.call(GSL::Vector[*[1.0] * dim])
+    xl, xu = GSL::Vector[*[0.0] * dim], GSL::Vector[*[2.0] * dim]
+
+    r1 = GSL::Monte.plain_integrate(f, xl, xu, 100000, seed: 3, threads: 1)
+    r4 = GSL::Monte.plain_integrate(f, xl, xu, 100000, seed: 3, threads: 4)
+    assert_equal r1, r4, 'native plain_integrate does not depend on the number of threads'
+    assert_abs r1[0], 384.0, 5 * r1[1], 'native plain_integrate within 5 sigma'
+
+    r1 = GSL::Monte.qmc_integrate(f, xl, xu, 4 * 4096, replicates: 8, threads: 1)
+    r4 = GSL::Monte.qmc_integrate(f, xl, xu, 4 * 4096, replicates: 8, threads: 4)
+    assert_equal r1, r4, 'native qmc_integrate does not depend on the number of threads'
+    assert_abs r1[0], 384.0, 1e-2, 'native qmc_integrate'
+
+    g = GSL::Monte::Function::Native.new(lib['monte_gauss'], 2)
+    xl, xu = GSL::Vector[-3.0, -3.0], GSL::Vector[3.0, 3.0]
+    r1 = GSL::Monte.vegas_integrate(g, xl, xu, 40000, replicas: 4, seed: 5, threads: 1)
+    r4 = GSL::Monte.vegas_integrate(g, xl, xu, 40000, replicas: 4, seed: 5, threads: 4)
+    assert_equal r1, r4, 'native vegas_integrate does not depend on the number of threads'
+    assert_abs r1[0], Math::PI, [5 * r1[1], 1e-2].max, 'native vegas_integrate'
+
+    x6 = GSL::Vector[*[0.0] * dim]
+    assert_raises(ArgumentError) { GSL::Monte.plain_integrate(g, x6, x6 + 1, 1000) }
+    assert_raises(ArgumentError) { GSL::Monte.qmc_integrate(f, xl, xu, 1000) }
+  end
+
+  def test_vegas_integrate
+    g = GSL::Monte::Function.alloc(->(x, d) { Math.exp(-(x[0] ** 2 + x[1] ** 2)) }, 2)
+    xl, xu = GSL::Vector[-3.0, -3.0], GSL::Vector[3.0, 3.0]
+    result, abserr = GSL::Monte.vegas_integrate(g, xl, xu, 40000, replicas: 4)
+    assert_abs result, Math::PI, [5 * abserr, 1e-2].max, 'vegas_integrate'
+    assert_raises(TypeError) { GSL::Monte.vegas_integrate(->(x) { x.col(0) }, xl, xu, 1000) }
+  end
+
 end
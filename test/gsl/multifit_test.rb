@@ -750,4 +750,53 @@ class MultifitTest < GSL::TestCase
     assert_rel chisq, expected_chisq, 1e-10, 'longley gsl_fit_wmultilinear chisq'
   end
 
+  def test_recursive_linear
+    rng = GSL::Rng.alloc
+    n, p = 200, 4
+    x = GSL::Matrix.alloc(n, p)
+    y = GSL::Vector.alloc(n)
+    n.times { |i|
+      x[i, 0] = 1.0
+      (1...p).each { |j| x[i, j] = rng.uniform * 10 }
+      y[i] = 1.0 + 2.0 * x[i, 1] - 0.5 * x[i, 2] + 0.25 * x[i, 3] + 0.1 * rng.gaussian
+    }
+    c0, cov0, chisq0, = GSL::MultiFit.linear(x, y)
+
+    rls = GSL::MultiFit::RecursiveLinear.new(p)
+    rls.add(x.submatrix(0, 0, 50, p), y.subvector(0, 50))
+    (50...n).each { |i| rls.add(x.row(i), y[i]) }
+    assert_equal n, rls.count
+
+    c, cov, chisq, = rls.fit
+    p.times { |i|
+      assert_rel c[i], c0[i], 1e-10, "recursive linear c#{i}"
+      p.times { |j| assert_rel cov[i, j], cov0[i, j], 1e-8, "recursive linear cov(#{i},#{j})" }
+    }
+    assert_rel chisq, chisq0, 1e-10, 'recursive linear chisq'
+    assert_rel rls.predict(x.row(0)), x.row(0).ddot(c0), 1e-10, 'recursive linear predict'
+
+    # a bad weight or value rejects the whole call, leaving the fit as it was
+    w = GSL::Vector.alloc(10).set_all(1.0)
+    w[5] = -1.0
+    assert_raises(ArgumentError) { rls.add(x.submatrix(0, 0, 10, p), y.subvector(0, 10), w) }
+    assert_raises(ArgumentError) { rls.add(x.row(0), y[0], -1.0) }
+    assert_raises(TypeError) { rls.add([1.0, 2.0, 3.0, 4.0], 'y') }
+    assert_equal n, rls.count
+    assert_rel rls.fit[2], chisq0, 1e-10, 'recursive linear chisq after rejected rows'
+  end
+
+  def test_recursive_linear_forgetting
+    rls = GSL::MultiFit::RecursiveLinear.new(2, forgetting: 0.5)
+    assert_equal 0.5, rls.forgetting
+    100.times { |i| rls.add([1.0, i], 1.0 + 2.0 * i) }
+    100.times { |i| rls.add([1.0, i], 3.0 - 1.0 * i) }
+    c = rls.coefficients
+    assert_rel c[0], 3.0, 1e-8, 'forgetting c0'
+    assert_rel c[1], -1.0, 1e-8, 'forgetting c1'
+    assert_rel rls.nobs, (1 - 0.5**200) / (1 - 0.5), 1e-10, 'forgetting nobs'
+
+    rls.reset
+    assert_raises(RuntimeError) { rls.coefficients }
+  end
+
 end
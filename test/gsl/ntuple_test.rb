@@ -0,0 +1,65 @@
+require 'test_helper'
+require 'tmpdir'
+
+class NtupleTest < GSL::TestCase
+
+  def test_columnar
+    Dir.mktmpdir do |dir|
+      path = File.join(dir, 'events.dat')
+      n = 1000
+
+      w = GSL::Ntuple::Columnar.create(path, { 'x' => :double, 'k' => :int32, 'f' => :float }, chunk: 64)
+      n.times { |i| w << [i * 0.01, i % 10, 0.5] }
+      assert_equal n, w.size
+      w.close
+
+      nt = GSL::Ntuple::Columnar.open(path)
+      assert_equal n, nt.size
+      assert_equal %w[x k f], nt.columns
+      assert_equal :int32, nt.types['k']
+      assert_equal 16, nt.nchunks
+      assert_rel 999 * 0.01, nt['x'][n - 1], 1e-15, 'column'
+      assert_equal 9.0, nt['k'][9]
+
+      stats = nt.stats('x')
+      assert_rel 64 * 0.01, stats[1, 0], 1e-15, 'stats min'
+      assert_rel 127 * 0.01, stats[1, 1], 1e-15, 'stats max'
+
+      assert_equal 100, nt.count(where: { 'k' => 3..3 })
+      assert_equal 100, nt.count(where: { 'x' => [1.0, 2.0] }, threads: 4)
+      assert_equal 50, nt.count(select: 'k == 3 && x < 5')
+
+      h = GSL::Histogram.alloc(10, [0, 10])
+      nt.project(h, 'k + 0.5', where: { 'x' => 0.0...5.0 }, weight: 'f * 2')
+      assert_equal 50.0, h[3]
+      assert_equal 500.0, h.sum
+
+      h1 = GSL::Histogram.alloc(10, [0, 10])
+      h4 = GSL::Histogram.alloc(10, [0, 10])
+      nt.project(h1, 'sqrt(x) * 3', select: 'k != 2', threads: 1)
+      nt.project(h4, 'sqrt(x) * 3', select: 'k != 2', threads: 4)
+      assert_equal h1.bin, h4.bin
+
+      h2 = GSL::Histogram2d.alloc(10, [0, 10], 10, [0, 10])
+      nt.project(h2, ['x', 'k'], threads: 3)
+      assert_equal 10.0, h2[4, 7]
+      assert_equal n.to_f, h2.sum
+
+      assert_raises(ArgumentError) { nt.count(select: 'nope > 1') }
+      assert_raises(ArgumentError) { nt.count(select: 'x >') }
+      assert_raises(ArgumentError) { nt.count(select: '(' * 100000 + 'x' + ')' * 100000) }
+      assert_raises(ArgumentError) { nt.count(select: '-' * 100000 + 'x') }
+      assert_equal nt.count(select: 'x > 1'), nt.count(select: '(' * 50 + 'x > 1' + ')' * 50)
+
+      # headers with offsets that are not 8-byte aligned are rejected
+      bytes = File.binread(path)
+      [48, 56].each { |at|
+        bad = bytes.dup
+        bad[at, 8] = [bad[at, 8].unpack1('Q') + 4].pack('Q')
+        File.binwrite(File.join(dir, 'bad.dat'), bad)
+        assert_raises(ArgumentError) { GSL::Ntuple::Columnar.open(File.join(dir, 'bad.dat')) }
+      }
+    end
+  end
+
+end
@@ -82,6 +82,53 @@ class QRngTest < GSL::TestCase
     g
   end
 
+  def test_get_matrix
+    %w[sobol niederreiter_2 halton reversehalton].each { |t|
+      g1, g2 = GSL::QRng.alloc(t, 3), GSL::QRng.alloc(t, 3)
+      m = g1.get_matrix(100)
+      assert_equal [100, 3], m.shape
+      assert((0...100).all? { |i| g2.get == m.row(i) }, "#{t} get_matrix")
+
+      m1, m2 = GSL::Matrix.alloc(1000, 3), GSL::Matrix.alloc(1000, 3)
+      g1.fill!(m1, threads: 1)
+      g2.fill!(m2, threads: 4)
+      assert_equal m1, m2, "#{t} fill! does not depend on the number of threads"
+      assert_equal g1.get, g2.get, "#{t} fill! advances the generator"
+    }
+
+    g = GSL::QRng.alloc('sobol', 3).skip(2**30 - 10)
+    assert_raises(RangeError, GSL::ERROR::EINVAL, GSL::ERROR::EFAILED) { g.fill!(GSL::Matrix.alloc(100, 3), threads: 4) }
+    g = GSL::QRng.alloc('sobol', 3).skip(2**30 - 10)
+    assert_raises(RangeError, GSL::ERROR::EFAILED) { g.fill!(GSL::Matrix.alloc(100, 3), threads: 1) }
+  end
+
+  def test_skip
+    %w[sobol niederreiter_2 halton].each { |t|
+      g1, g2 = GSL::QRng.alloc(t, 4), GSL::QRng.alloc(t, 4)
+      5.times { g1.get }
+      1000.times { g1.get }
+      g2.skip(5).skip(1000)
+      assert_equal g1.get, g2.get, "#{t} skip"
+    }
+  end
+
+  def test_scramble
+    r = GSL::Rng.alloc('mt19937', 1)
+    [['sobol', :owen], ['sobol', :shift], ['halton', :rotation]].each { |t, s|
+      g = GSL::QRng.alloc(t, 2).scramble!(r, s)
+      assert g.scrambled?
+      m = g.get_matrix(4096)
+      assert((0...4096).all? { |i| m[i, 0] > 0 && m[i, 0] < 1 }, "#{t} #{s} in (0, 1)")
+      assert_abs m.col(0).mean, 0.5, 1e-3, "#{t} #{s} mean"
+
+      g2 = g.clone
+      g2.init
+      g.init
+      assert_equal g.get, g2.get, "#{t} #{s} clone keeps the scramble"
+    }
+    assert_raises(ArgumentError) { GSL::QRng.alloc('halton', 2).scramble!(r, :owen) }
+  end
+
   def test_hdsobol
     return unless GSL::QRng.const_defined?(:HDSOBOL)
 
@@ -130,6 +130,183 @@ class RandistTest < GSL::TestCase
     _test_pdf(:ugaussian_tail, 0.1, 2.0)
   end
 
+  def test_fill
+    n = 1000
+
+    r1, r2 = GSL::Rng.alloc('mt19937', 5), GSL::Rng.alloc('mt19937', 5)
+    v = GSL::Vector.alloc(n)
+    assert_same v, r1.fill!(v, :exponential, 2.0)
+    w = r2.exponential(2.0, n)
+    assert((0...n).all? { |i| v[i] == w[i] }, 'fill! exponential')
+
+    vi = GSL::Vector::Int.alloc(n)
+    r1.fill!(vi, :poisson, 3.0)
+    wi = r2.poisson(3.0, n)
+    assert((0...n).all? { |i| vi[i] == wi[i] }, 'fill! poisson')
+
+    r1, r2 = GSL::Rng.alloc('philox4x32', 5), GSL::Rng.alloc('philox4x32', 5)
+    r1.get
+    r2.get
+    r1.fill!(v, :flat, -1.0, 3.0)
+    w = r2.flat(-1.0, 3.0, n)
+    assert((0...n).all? { |i| v[i] == w[i] }, 'fill! flat, counter-based')
+
+    m = GSL::Matrix.alloc(400, 50)
+    r1.fill!(m, 'gaussian', 2.0)
+    x = m.to_v
+    assert_abs x.mean, 0.0, 0.05, 'fill! gaussian mean'
+    assert_rel x.sd, 2.0, 0.02, 'fill! gaussian sd'
+
+    alpha = GSL::Vector.alloc(1.0, 2.0, 3.0)
+    d = GSL::Matrix.alloc(100, 3)
+    r1.fill!(d, :dirichlet, alpha)
+    assert((0...100).all? { |i| (d.row(i).sum - 1.0).abs < 1e-12 }, 'fill! dirichlet')
+
+    b = GSL::Matrix.alloc(100, 2)
+    GSL::Ran.fill!(r1, b, :bivariate_gaussian, 1.0, 2.0, 0.5)
+    assert_raises(ArgumentError) { r1.fill!(d, :dir_2d) }
+    assert_raises(TypeError) { r1.fill!(vi, :gaussian) }
+  end
+
+  def test_discrete_samplers
+    n = 20000
+    w = GSL::Vector.alloc(1.0, 0.0, 3.0, 6.0)
+    r = GSL::Rng.alloc('mt19937', 3)
+
+    [GSL::Ran::Discrete.alloc(w), GSL::Ran::Discrete::Compact.new(w),
+     GSL::Ran::Discrete::Dynamic.new(w)].each { |g|
+      vi = g.sample(r, n)
+      assert_equal n, vi.size
+      count = Array.new(4, 0)
+      vi.each { |k| count[k] += 1 }
+      assert_equal 0, count[1], "#{g.class} never draws a zero weight"
+      [0, 2, 3].each { |k| assert_abs count[k].to_f / n, w[k] / 10.0, 0.02, "#{g.class} frequency of #{k}" }
+      assert_same vi, r.discrete(g, vi)
+    }
+
+    d = GSL::Ran::Discrete::Dynamic.new(1000)
+    assert_equal 0.0, d.total
+    d[7] = 2.0
+    d.update([3, 500], [1.0, 1.0])
+    assert_rel d.total, 4.0, 1e-15
+    assert_rel d.pdf(7), 0.5, 1e-15
+    assert_raises(IndexError) { d.update([4, 1000], [1.0, 1.0]) }
+    assert_raises(ArgumentError) { d.update([4, 5], [1.0, -1.0]) }
+    assert_equal 0.0, d[4]
+    assert_rel d.total, 4.0, 1e-15
+    vi = d.sample(r, n)
+    assert vi.to_a.all? { |k| [3, 7, 500].include?(k) }, 'Dynamic draws only positive weights'
+
+    3000.times { |i| d[i % 1000] = (i % 7).to_f }
+    d[7] = 0.0
+    assert_rel d.total, d.to_v.sum, 1e-12
+    assert_equal 0, r.discrete(d, n).to_a.count(7)
+  end
+
+  def test_mvnormal
+    mu = GSL::Vector.alloc(1.0, -2.0, 0.5)
+    sigma = GSL::Matrix.alloc([4.0, 1.0, 0.5], [1.0, 3.0, -0.5], [0.5, -0.5, 2.0])
+    g = GSL::Ran::MVNormal.new(mu, sigma)
+    assert_equal 3, g.dim
+
+    c = g.covariance
+    3.times { |i| 3.times { |j| assert_rel c[i, j], sigma[i, j], 1e-14, 'MVNormal covariance' } }
+
+    # log density against the explicit formula
+    x = GSL::Vector.alloc(0.3, -1.0, 2.0)
+    d = x - mu
+    q = d * sigma.inv * d.col
+    lp = -0.5 * (3 * Math.log(2 * Math::PI) + Math.log(sigma.det) + q)
+    assert_rel g.logpdf(x), lp, 1e-13, 'MVNormal logpdf'
+    assert_rel g.pdf(x), Math.exp(lp), 1e-13, 'MVNormal pdf'
+
+    m = g.sample(GSL::Rng.alloc('mt19937', 5), 20000)
+    assert_equal [20000, 3], m.size
+    lps = g.logpdf(m)
+    assert_rel lps[17], g.logpdf(m.row(17)), 1e-14, 'MVNormal batch logpdf'
+    3.times { |j|
+      col = m.col(j)
+      assert_abs col.mean, mu[j], 0.05, 'MVNormal sample mean'
+      3.times { |k| assert_abs GSL::Stats.covariance(col, m.col(k)), sigma[j, k], 0.15, 'MVNormal sample covariance' }
+    }
+
+    # rank-1 update and downdate
+    v = GSL::Vector.alloc(0.5, 1.0, -1.0)
+    g.update!(v, 2.0)
+    c = g.covariance
+    3.times { |i| 3.times { |j| assert_rel c[i, j], sigma[i, j] + 2.0 * v[i] * v[j], 1e-13, 'MVNormal update' } }
+    g.update!(v, -2.0)
+    c = g.covariance
+    3.times { |i| 3.times { |j| assert_abs c[i, j], sigma[i, j], 1e-13, 'MVNormal downdate' } }
+    assert_raises(RuntimeError) { g.update!(v, -100.0) }
+    assert_rel g.logpdf(x), lp, 1e-12, 'MVNormal unchanged after a failed downdate'
+  end
+
+  def test_vectorized_eval
+    x = GSL::Vector.linspace(0.1, 8.0, 200001)
+    y = GSL::Ran.pdf(:gaussian, x, 2.0)
+    assert_equal x.size, y.size
+    [0, 777, 200000].each { |i|
+      assert_rel y[i], GSL::Ran.gaussian_pdf(x[i], 2.0), 1e-13, 'Ran.pdf gaussian'
+    }
+    c = GSL::Ran.cdf(:gamma, x, 2.5, 1.5)
+    assert_rel c[123456], GSL::Cdf.gamma_P(x[123456], 2.5, 1.5), 1e-13, 'Ran.cdf gamma'
+    l = GSL::Ran.logpdf(:gamma, x, 2.5, 1.5)
+    assert_rel l[4242], Math.log(GSL::Ran.gamma_pdf(x[4242], 2.5, 1.5)), 1e-12, 'Ran.logpdf gamma'
+
+    k = GSL::Vector::Int[0, 1, 2, 7]
+    p = GSL::Ran.pdf(:poisson, k, 3.0)
+    4.times { |i| assert_rel p[i], GSL::Ran.poisson_pdf(k[i], 3.0), 1e-13, 'Ran.pdf poisson' }
+    assert_rel GSL::Ran.pdf(:binomial, [3], 0.3, 10)[0], GSL::Ran.binomial_pdf(3, 0.3, 10), 1e-13, 'Ran.pdf binomial'
+
+    # log tails stay finite where the values underflow
+    lc = GSL::Ran.logcdf(:ugaussian, -40.0)
+    assert_rel lc, -804.608442013754, 1e-10, 'Ran.logcdf far tail'
+    assert_rel GSL::Ran.logsf(:ugaussian, 40.0), lc, 1e-14, 'Ran.logsf far tail'
+    assert_rel GSL::Ran.logpdf(:gaussian, 100.0, 1.0), -5000.0 - 0.5 * Math.log(2 * Math::PI), 1e-14, 'Ran.logpdf far tail'
+
+    out = GSL::Vector.alloc(x.size)
+    assert_same out, GSL::Ran.sf(:exponential, x, 2.0, out: out)
+    assert_rel out[99], GSL::Cdf.exponential_Q(x[99], 2.0), 1e-13, 'Ran.sf out:'
+    assert_raises(ArgumentError) { GSL::Ran.pdf(:gaussian, x, 1.0, out: GSL::Vector.alloc(3)) }
+    assert_raises(ArgumentError) { GSL::Ran.pdf(:no_such_dist, x) }
+
+    ll1 = GSL::Ran.loglikelihood(:gamma, x, 2.5, 1.5, threads: 1)
+    ll4 = GSL::Ran.loglikelihood(:gamma, x, 2.5, 1.5, threads: 4)
+    assert_equal ll1, ll4
+    assert_rel ll1, l.sum, 1e-10, 'Ran.loglikelihood'
+  end
+
+  def test_pool_fill
+    n = 10000
+    v1, v2, w = GSL::Vector.alloc(n), GSL::Vector.alloc(n), GSL::Vector.alloc(n / 8)
+
+    p1, p2, p3 = GSL::Rng::Pool.new(8, 42), GSL::Rng::Pool.new(8, 42), GSL::Rng::Pool.new(8, 42)
+    assert_equal 8, p1.size
+
+    p1.fill!(v1, :gaussian, 2.0, threads: 1)
+    p2.fill!(v2, :gaussian, 2.0, threads: 4)
+    assert((0...n).all? { |i| v1[i] == v2[i] }, 'Rng::Pool#fill! does not depend on the number of threads')
+
+    p3[0].fill!(w, :gaussian, 2.0)
+    assert((0...n / 8).all? { |i| v1[i] == w[i] }, 'Rng::Pool#fill! first chunk from the first generator')
+
+    m = GSL::Matrix::Int.alloc(100, 3)
+    p1.fill!(m, :multinomial, 10, GSL::Vector.alloc(0.2, 0.3, 0.5))
+    assert((0...100).all? { |i| m.row(i).sum == 10 }, 'Rng::Pool#fill! multinomial')
+
+    k = 100000
+    d = GSL::Vector.alloc(2 * k)
+    p1[0].fill!(d, :multinomial, 50, GSL::Vector.alloc(k).set_all(1.0 / k))
+    assert_equal 100.0, d.sum, 'fill! multinomial with many categories'
+
+    r = p1[0]
+    assert_raises(ArgumentError) { r.fill!(m, :multinomial, -1, GSL::Vector.alloc(0.2, 0.3, 0.5)) }
+    assert_raises(ArgumentError) { r.fill!(m, :multinomial, 2**31, GSL::Vector.alloc(0.2, 0.3, 0.5)) }
+    assert_raises(ArgumentError) { r.fill!(GSL::Vector.alloc(10), :binomial, 0.5, -3) }
+    assert_raises(ArgumentError) { r.fill!(GSL::Vector.alloc(10), :hypergeometric, 5, -1, 3) }
+  end
+
   def test_randist
     @@use_nmatrix = false
     _test_randist
@@ -80,7 +80,10 @@ class RngTest < GSL::TestCase
     'random256_libc5' => [[0, 10000, 116367984]],
 
     'ranf' => [[0, 10000, 2152890433],
-               [2, 10000, 339327233]]
+               [2, 10000, 339327233]],
+
+    'philox4x32'   => [[0, 1, 0x6627e8d5]],
+    'threefry4x32' => [[0, 1, 0x9c6ca96a]]
   }.each { |type, args|
     args.each_with_index { |(seed, n, result), i|
       define_method("test_#{type}_#{i}") {
@@ -99,9 +102,55 @@ class RngTest < GSL::TestCase
     define_method("test_state_#{type}")          { _rng_state_test(type) }
     define_method("test_parallel_state_#{type}") { _rng_parallel_state_test(type) }
     define_method("test_read_write_#{type}")     { _rng_read_write_test(type) }
+    define_method("test_dump_load_#{type}")      { _rng_dump_load_test(type) }
     define_method("test_generic_#{type}")        { _generic_rng_test(type) }
   }
 
+  %w[philox4x32 threefry4x32].each { |type|
+    define_method("test_split_#{type}") {
+      r = GSL::Rng.alloc(type, 7)
+      a, b = r.split(2)
+      assert a.stream != b.stream && a.stream != r.stream, "#{type}, split stream ids"
+
+      x = a.get
+      c, = r.split(2)
+      assert_equal x, c.get, "#{type}, split is reproducible"
+
+      aa = a.split(3)
+      ids = aa.map(&:stream) + [a.stream, b.stream, r.stream]
+      assert_equal ids.uniq.size, ids.size, "#{type}, nested split stream ids"
+    }
+
+    define_method("test_jump_#{type}") {
+      r1 = GSL::Rng.alloc(type, 3)
+      r2 = GSL::Rng.alloc(type, 3)
+      r1.get
+      11.times { r2.get }
+      r1.jump(10)
+      assert_equal r2.get, r1.get, "#{type}, jump"
+    }
+  }
+
+  def test_pool_dump
+    v1, v2 = GSL::Vector.alloc(1000), GSL::Vector.alloc(1000)
+    pool = GSL::Rng::Pool.new(4, 9, 'mt19937')
+    pool.fill!(v1, :uniform)
+    s = pool.dump
+    pool.fill!(v1, :gaussian, 1.0)
+
+    copy = GSL::Rng::Pool.load(s)
+    assert_equal 4, copy.size
+    copy.fill!(v2, :gaussian, 1.0)
+    assert((0...1000).all? { |i| v1[i] == v2[i] }, 'Rng::Pool.load resumes the sequences')
+
+    copy = Marshal.load(Marshal.dump(Marshal.load(Marshal.dump(pool))))
+    assert_equal pool.dump, copy.dump
+
+    assert_raises(ArgumentError) { GSL::Rng::Pool.load(s[0...-1]) }
+    assert_raises(ArgumentError) { GSL::Rng::Pool.load(s + 'x') }
+    assert_raises(ArgumentError) { GSL::Rng.load('GSLR') }
+  end
+
   def _rng_float_test(type)
     ri = GSL::Rng.alloc(type)
     rf = GSL::Rng.alloc(type)
@@ -195,6 +244,25 @@ class RngTest < GSL::TestCase
     File.delete('test.dat') if FileTest.exist?('test.dat')
   end
 
+  def _rng_dump_load_test(type)
+    r = GSL::Rng.alloc(type)
+
+    test_a = GSL::Vector.alloc(N)
+    test_b = GSL::Vector.alloc(N)
+
+    N.times { r.get }
+
+    s = r.dump
+    N.times { |i| test_a[i] = r.get }
+
+    r2 = GSL::Rng.load(s)
+    N.times { |i| test_b[i] = r2.get }
+
+    assert_equal r.name, r2.name
+    assert((0...N).all? { |i| test_b[i] == test_a[i] }, "#{r.name}, random number generator dump and load")
+    assert_equal r.get, Marshal.load(Marshal.dump(r)).get, "#{r.name}, Marshal"
+  end
+
   def _generic_rng_test(type)
     r = GSL::Rng.alloc(type)
 
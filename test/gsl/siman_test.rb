@@ -0,0 +1,119 @@
+require 'test_helper'
+
+class SimanTest < GSL::TestCase
+
+  # (x - 1)^2 + (y + 2)^2 + z^2, minimum 0 at [1, -2, 0]
+  X_MIN = [1.0, -2.0, 0.0]
+
+  def energy(x)
+    (0...3).inject(0.0) { |s, i| s + (x[i] - X_MIN[i]) ** 2 }
+  end
+
+  def test_multi_solve
+    params = GSL::Siman::Params.alloc(200, 50, 0.2, 1.0, 1.0, 1.2, 1.0e-4)
+    efunc = GSL::Siman::Efunc.alloc { |x| energy(x) }
+    x0 = GSL::Vector[5.0, 5.0, 5.0]
+
+    res = GSL::Siman.multi_solve(x0, efunc, :uniform, params, chains: 4, seed: 1)
+    assert_equal [4, 3], res[:best_x].size
+    assert_equal 4, res[:acceptance].size
+    assert_abs res[:energy], res[:best_energy].min, 0.0, 'multi_solve best energy'
+    assert res[:energy] < 0.05, 'multi_solve reaches the minimum'
+    3.times { |i| assert_abs res[:x][i], X_MIN[i], 0.25, 'multi_solve x' }
+
+    # a batched energy over the rows gives the same chains
+    batch = ->(m) { GSL::Vector[*(0...m.size1).map { |i| energy(m.row(i)) }] }
+    res2 = GSL::Siman.multi_solve(x0, batch, :uniform, params, chains: 4, seed: 1)
+    assert_equal res[:best_energy].to_a, res2[:best_energy].to_a
+    assert_equal res[:acceptance].to_a, res2[:acceptance].to_a
+  end
+
+  def test_parallel_tempering
+    efunc = GSL::Siman::Efunc.alloc { |x| energy(x) }
+    step = GSL::Siman::Step.alloc { |rng, x, step_size|
+      i = rng.uniform_int(3)
+      x[i] += step_size * (2 * rng.uniform - 1)
+    }
+    res = GSL::Siman.parallel_tempering(GSL::Vector[5.0, 5.0, 5.0], efunc, step,
+                                        t_min: 0.001, t_max: 10.0, replicas: 5,
+                                        sweeps: 400, exchange: 5,
+                                        step_size: [0.1, 0.2, 0.5, 1.0, 2.0], seed: 7)
+    assert_equal 5, res[:temperatures].size
+    assert_abs res[:temperatures][0], 0.001, 1e-12, 'parallel_tempering t_min'
+    assert_abs res[:temperatures][4], 10.0, 1e-9, 'parallel_tempering t_max'
+    assert_equal 4, res[:exchange_acceptance].size
+    assert res[:exchange_acceptance].max > 0, 'parallel_tempering exchanges'
+    assert res[:energy] < 0.05, 'parallel_tempering reaches the minimum'
+    assert_raises(ArgumentError) {
+      GSL::Siman.parallel_tempering(GSL::Vector[0.0], efunc, step, temperatures: [1.0, -1.0])
+    }
+  end
+
+  NATIVE = <<-EOS
+    #include <stddef.h>
+    #include <gsl/gsl_rng.h>
+    double siman_energy(const double *x, size_t n, void *params)
+    {
+      static const double xmin[3] = {1.0, -2.0, 0.0};
+      double s = 0.0;
+      size_t i;
+      for (i = 0; i < n; i++) s += (x[i] - xmin[i % 3]) * (x[i] - xmin[i % 3]);
+      return s;
+    }
+    void siman_step(const gsl_rng *r, double *x, size_t n, double step_size, void *params)
+    {
+      size_t i;
+      for (i = 0; i < n; i++) x[i] += step_size * (2.0 * r->type->get_double(r->state) - 1.0);
+    }
+  EOS
+
+  def test_native
+    lib = native_library(NATIVE)
+    efunc = GSL::Siman::Efunc::Native.new(lib['siman_energy'])
+    step = GSL::Siman::Step::Native.new(lib['siman_step'])
+    assert_equal 0.0, efunc.call(GSL::Vector[1.0, -2.0, 0.0])
+    assert_equal 3, step.call(GSL::Rng.alloc, GSL::Vector[0.0, 0.0, 0.0], 0.1).size
+
+    params = GSL::Siman::Params.alloc(200, 50, 0.2, 1.0, 1.0, 1.2, 1.0e-4)
+    x0 = GSL::Vector[5.0, 5.0, 5.0]
+    r1 = GSL::Siman.multi_solve(x0, efunc, step, params, chains: 6, seed: 2, threads: 1)
+    r4 = GSL::Siman.multi_solve(x0, efunc, step, params, chains: 6, seed: 2, threads: 4)
+    assert r1[:energy] < 0.05, 'native multi_solve reaches the minimum'
+    assert_equal r1[:best_energy].to_a, r4[:best_energy].to_a, 'multi_solve does not depend on the number of threads'
+    assert_equal r1[:x].to_a, r4[:x].to_a
+
+    t1 = GSL::Siman.parallel_tempering(x0, efunc, :gaussian, t_min: 0.001, t_max: 10.0,
+                                       replicas: 5, sweeps: 400, seed: 7, threads: 1)
+    t4 = GSL::Siman.parallel_tempering(x0, efunc, :gaussian, t_min: 0.001, t_max: 10.0,
+                                       replicas: 5, sweeps: 400, seed: 7, threads: 4)
+    assert t1[:energy] < 0.05, 'native parallel_tempering reaches the minimum'
+    assert_equal t1[:last_energy].to_a, t4[:last_energy].to_a, 'parallel_tempering does not depend on the number of threads'
+    assert_equal t1[:exchange_acceptance].to_a, t4[:exchange_acceptance].to_a
+  end
+
+  def test_kept_arguments
+    kept = []
+    efunc = GSL::Siman::Efunc.alloc { |x| kept << x; energy(x) }
+    step = GSL::Siman::Step.alloc { |rng, x, step_size|
+      kept << rng
+      x[0] += step_size * (2 * rng.uniform - 1)
+    }
+    GSL::Siman.parallel_tempering(GSL::Vector[5.0, 5.0, 5.0], efunc, step,
+                                  replicas: 3, sweeps: 20, seed: 1)
+    GC.start
+    vectors = kept.grep(GSL::Vector)
+    assert vectors.all? { |v| v.size == 3 && v[1] == 5.0 }, 'kept states stay valid'
+    kept.grep(GSL::Rng).each { |r| assert r.uniform < 1.0 }
+  end
+
+  def test_swap
+    # sort a permutation: the energy counts the misplaced entries
+    efunc = ->(m) { (0...m.size1).map { |i| (0...m.size2).count { |j| m[i, j] != j } } }
+    res = GSL::Siman.parallel_tempering(GSL::Vector[4, 2, 0, 3, 1, 5], efunc, :swap,
+                                        t_min: 0.05, t_max: 2.0, replicas: 4, sweeps: 500, seed: 3)
+    assert_equal 0.0, res[:energy]
+    assert_equal [0, 1, 2, 3, 4, 5], res[:x].to_a.map(&:to_i)
+    assert_equal res[:x].to_a.sort, res[:last_x].row(0).to_a.sort
+  end
+
+end
@@ -0,0 +1,95 @@
+require 'test_helper'
+
+class SpMatrixTest < GSL::TestCase
+
+  N = 50
+
+  def setup
+    return unless GSL.const_defined?(:SpMatrix)
+
+    # 1-D Laplacian, tridiag(-1, 2, -1)
+    rows, cols, vals = [], [], []
+
+    N.times { |i|
+      rows << i; cols << i; vals << 2.0
+      next if i == N - 1
+      rows << i;     cols << i + 1; vals << -1.0
+      rows << i + 1; cols << i;     vals << -1.0
+    }
+
+    @sp = GSL::SpMatrix.from_triplets(N, N, rows, cols, vals)
+    @dense = @sp.to_matrix
+  end
+
+  def test_storage
+    return unless GSL.const_defined?(:SpMatrix)
+
+    assert_int @sp.nnz, 3 * N - 2, 'nnz'
+
+    %w[coo csc csr].each { |type|
+      m = @sp.compress(type)
+      assert_equal type.upcase, m.type, "type #{type}"
+      assert_abs m[3, 4], -1.0, 0.0, "get #{type}"
+      assert_abs m[3, 5], 0.0, 0.0, "get zero #{type}"
+      assert m.to_matrix == @dense, "to_matrix #{type}"
+    }
+
+    assert @dense.to_sp(:csr).to_matrix == @dense, 'Matrix#to_sp'
+  end
+
+  def test_mul
+    return unless GSL.const_defined?(:SpMatrix)
+
+    x = GSL::Vector.indgen(N)
+    b = GSL::Matrix.alloc(N, 3)
+    3.times { |j| N.times { |i| b[i, j] = i * (j + 1.0) } }
+
+    [@sp, @sp.to_csc, @sp.to_csr].each { |m|
+      assert_enum_abs m * x, @dense * x, 1e-12, "mul vector #{m.type}"
+      assert_enum_abs (m * b).to_v, (@dense * b).to_v, 1e-12, "mul matrix #{m.type}"
+      assert_enum_abs (m.to_csc * m.to_csc).to_matrix.to_v, (@dense * @dense).to_v, 1e-12, 'mul spmatrix'
+    }
+  end
+
+  def test_transpose
+    return unless GSL.const_defined?(:SpMatrix)
+
+    a = GSL::SpMatrix.from_triplets(2, 3, [0, 1, 1], [2, 0, 1], [1.0, 2.0, 3.0], :csr)
+    t = a.transpose
+
+    assert_equal [3, 2], t.shape
+    assert t.to_matrix == a.to_matrix.transpose, 'transpose'
+  end
+
+  def test_gmres
+    return unless GSL.const_defined?(:SpMatrix)
+
+    b = GSL::Vector.alloc(N).set_all(1.0)
+
+    [nil, :jacobi, lambda { |v| v * 0.5 }].each { |precond|
+      opts = { tol: 1e-10, restart: N, maxiter: 10 * N }
+      opts[:precond] = precond if precond
+
+      x, status, normr, _ = GSL::Splinalg.gmres(@sp, b, opts)
+      assert_int status, GSL::SUCCESS, "gmres status, precond #{precond.inspect}"
+      assert normr < 1e-8, "gmres residual, precond #{precond.inspect}"
+      assert_enum_abs @sp * x, b, 1e-8, "gmres solution, precond #{precond.inspect}"
+    }
+
+    _, _, _, iter = GSL::Splinalg.gmres(@sp, b, tol: 1e-10, restart: 3, maxiter: 5, precond: :jacobi)
+    assert iter <= 5, 'gmres iterations'
+    _, _, _, cycles = GSL::Splinalg.gmres(@sp, b, tol: 1e-10, restart: 3, maxiter: 5)
+    assert cycles <= 2, 'gmres restart cycles'
+    # the last cycle stops at maxiter, so one iteration cannot solve it
+    _, status, = GSL::Splinalg.gmres(@sp, b, tol: 1e-10, restart: N, maxiter: 1)
+    assert status != GSL::SUCCESS, 'gmres maxiter within a cycle'
+    [@sp.to_csr, @sp.to_csc].each { |m|
+      x, status, = GSL::Splinalg.gmres(m, b, tol: 1e-10, restart: N, maxiter: 10 * N)
+      assert_int status, GSL::SUCCESS, "gmres status #{m.type}"
+      assert_enum_abs @sp * x, b, 1e-8, "gmres solution #{m.type}"
+    }
+    assert_raises(TypeError) { GSL::Splinalg.gmres(@sp, b, precond: ->(v) { v.to_a }) }
+    assert_raises(ZeroDivisionError) { GSL::Splinalg.gmres(@sp, b, precond: ->(v) { 1 / 0 }) }
+  end
+
+end
@@ -119,4 +119,101 @@ class StatsTest < GSL::TestCase
     assert_raises(ArgumentError, 'check for no args') { v.variance_with_fixed_mean }
   end
 
+  def test_quantile_sketches
+    rng = GSL::Rng.alloc('mt19937', 1)
+    data = GSL::Vector.alloc(100000)
+    data.size.times { |i| data[i] = rng.uniform }
+    sorted = data.sort
+
+    sketches = {
+      GSL::Sketch::TDigest.new(100) => 0.01,
+      GSL::Sketch::KLL.new(200, seed: 7) => 0.02,
+      GSL::Sketch::DDSketch.new(0.01) => 0.011
+    }
+    sketches.each do |s, tol|
+      half = s.class.load(s.dump)
+      half.add(data.subvector(0, 50000))
+      s.add(data.subvector(50000, 50000))
+      s.merge!(half)
+
+      assert_equal data.size.to_f, s.count
+      assert_equal sorted[0], s.min
+      assert_equal sorted[sorted.size - 1], s.max
+      assert_equal sorted[0], s.quantile(0.0)
+      [0.01, 0.5, 0.99].each { |p|
+        q = sorted[(p * data.size).floor]
+        assert_abs q, s.quantile(p), tol, "#{s.class} quantile(#{p})"
+        assert_abs p, s.cdf(q), 2 * tol, "#{s.class} cdf(#{q})"
+      }
+      assert_equal 3, s.quantile(GSL::Vector[0.1, 0.2, 0.3]).size
+
+      s2 = s.class.load(s.dump)
+      assert_equal s.quantile(0.99), s2.quantile(0.99)
+      assert_equal s.count, Marshal.load(Marshal.dump(s)).count
+      assert_equal 2 * s.count, (s + s).count
+      assert_raises(ArgumentError) { s.quantile(1.5) }
+    end
+
+    dd = GSL::Sketch::DDSketch.new(0.02)
+    dd.add([-100.0, -1.0, 0.0, 1.0, 100.0])
+    assert_rel(-100.0, dd.quantile(0.2), 0.02, 'negative')
+    assert_equal 0.0, dd.quantile(0.6)
+    assert_rel 1.0, dd.quantile(0.8), 0.02, 'positive'
+
+    td = GSL::Sketch::TDigest.new
+    td.add(GSL::Vector[1, 2, 3], GSL::Vector[1, 1, 2])
+    assert_equal 4.0, td.count
+    assert_raises(ArgumentError) { GSL::Sketch::KLL.new.add(1.0, 2.0) }
+    assert_raises(TypeError) { td.merge!(dd) }
+  end
+
+  def test_kde
+    rng = GSL::Rng.alloc('mt19937', 3)
+    x = GSL::Vector.alloc(300)
+    y = GSL::Vector.alloc(300)
+    x.size.times { |i| x[i] = rng.gaussian(1.0); y[i] = 0.5 * x[i] + rng.gaussian(2.0) }
+
+    [:gaussian, :epanechnikov].each { |kernel|
+      kde = GSL::KDE.new(x, kernel: kernel)
+      assert_equal kernel, kde.kernel
+      assert_rel kde.bandwidth, 1.0592 * x.sd * 300**-0.2, 1e-4, "#{kernel} scott"
+      h = kde.bandwidth
+      [-1.0, 0.3, 2.0].each { |t|
+        direct = x.to_a.inject(0.0) { |s, xi|
+          u = (t - xi) / h
+          s + (kernel == :gaussian ? Math.exp(-0.5 * u * u) / Math.sqrt(2 * Math::PI) :
+               (u.abs < Math.sqrt(5) ? 0.75 * (1 - u * u / 5) / Math.sqrt(5) : 0.0))
+        } / (300 * h)
+        assert_rel kde.evaluate(t), direct, 1e-12, "#{kernel} evaluate(#{t})"
+      }
+
+      gx, f = kde.grid(1024)
+      dx = gx[1] - gx[0]
+      assert_rel f.sum * dx, 1.0, 2e-3, "#{kernel} grid normalization"
+      exact = kde.evaluate(gx, threads: 2)
+      assert (f - exact).abs.max < 1e-2 * exact.max, "#{kernel} grid vs evaluate"
+      approx = kde.evaluate(gx, approx: true, threads: 2)
+      assert (approx - exact).abs.max < 2e-3 * exact.max, "#{kernel} approx evaluate"
+      assert_equal approx[100], kde.evaluate(gx[100], approx: true)
+      assert_equal 0.0, kde.evaluate(1e6, approx: true)
+    }
+
+    kde = GSL::KDE.new(x, y, bandwidth: :silverman)
+    assert_equal 2, kde.dim
+    gx, gy, f = kde.grid([200, 160], threads: 2)
+    assert_equal [200, 160], f.size
+    assert_rel f.sum * (gx[1] - gx[0]) * (gy[1] - gy[0]), 1.0, 2e-3, '2-D grid normalization'
+    i, j = f.max_index
+    assert_abs kde.evaluate(gx[i], gy[j]), f[i, j], 1e-2 * f[i, j], '2-D grid vs evaluate'
+    assert_equal kde.evaluate(gx[i], gy[j]), kde.evaluate(GSL::Vector[gx[i]], GSL::Vector[gy[j]])[0]
+    assert_abs kde.evaluate(gx[i], gy[j], approx: true), kde.evaluate(gx[i], gy[j]), 2e-3 * f[i, j], '2-D approx evaluate'
+
+    h = GSL::KDE.new(x).bandwidth
+    hcv = GSL::KDE.new(x, bandwidth: :cv).bandwidth
+    assert hcv > 0.1 * h && hcv < 2.0 * h, 'cross-validated bandwidth'
+    assert_equal [0.5, 1.0], GSL::KDE.new(x, y, bandwidth: [0.5, 1.0]).bandwidth
+    assert_raises(ArgumentError) { GSL::KDE.new(GSL::Vector[1, 1, 1]) }
+    assert_raises(ArgumentError) { GSL::KDE.new(x, kernel: :box) }
+  end
+
 end
@@ -66,4 +66,26 @@ class SumTest < GSL::TestCase
     _test_sum(0.6048986434216305, 'eta(1/2)')
   end
 
+
+  def test_accel_rows
+    m = GSL::Matrix.alloc(64, N)
+    64.times { |i|
+      x = -10.0 + 20.0 * i / 63
+      t = 1.0
+      N.times { |n| m[i, n] = t; t *= x / (n + 1) }
+    }
+    sums, errs, plain, terms = GSL::Sum::Levin_u.accel_rows(m, threads: 4)
+    assert_equal 64, sums.size
+    assert_kind_of GSL::Vector::Int, terms
+    64.times { |i|
+      x = -10.0 + 20.0 * i / 63
+      assert_rel sums[i], Math.exp(x), 1e-8, 'accel_rows exp(%g)' % x
+      expected = GSL::Sum::Levin_u.accel(m.row(i))
+      assert_equal expected, [sums[i], errs[i], plain[i], terms[i]]
+    }
+    sums2, = m.utrunc_accel_rows(threads: 1)
+    assert_equal GSL::Sum::Levin_utrunc.accel(m.row(5))[0], sums2[5]
+    assert_raises(ArgumentError) { m.accel_rows(1) }
+  end
+
 end
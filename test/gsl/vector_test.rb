@@ -220,4 +220,131 @@ class VectorTest < GSL::TestCase
     }
   end
 
+  def test_radix_merge_sort
+    rng = GSL::Rng.alloc('mt19937', 3)
+    v = GSL::Vector.alloc(200000)
+    v.size.times { |i| v[i] = rng.gaussian(1e3).round(1) }
+    v[7] = -0.0
+    v[8] = 0.0
+    sorted = v.sort
+
+    [1, 4].each { |threads|
+      assert_equal sorted, v.radix_sort(threads: threads), "radix_sort threads #{threads}"
+      assert_equal sorted, v.merge_sort(threads: threads), "merge_sort threads #{threads}"
+
+      [:radix, :merge].each { |algorithm|
+        p = v.argsort(algorithm: algorithm, threads: threads)
+        assert_equal sorted, GSL::Vector.alloc(p.to_a.map { |i| v[i] }), "argsort #{algorithm}"
+        # stable: ties keep their order
+        (1...p.size).each { |i|
+          assert p[i - 1] < p[i], "stable #{algorithm}" if v[p[i - 1]] == v[p[i]]
+        }
+      }
+    }
+
+    vi = GSL::Vector::Int[5, -3, 7, -3, 0, 2**30, -2**30]
+    assert_equal [-2**30, -3, -3, 0, 5, 7, 2**30], vi.radix_sort.to_a
+    assert_equal [-2**30, -3, -3, 0, 5, 7, 2**30], vi.merge_sort.to_a
+    assert_equal [6, 1, 3, 4, 0, 2, 5], vi.argsort(as: GSL::Vector::Int).to_a
+
+    x = GSL::Vector[-1.0, GSL::POSINF, 2.5, GSL::NEGINF, 0.5]
+    assert_equal [GSL::NEGINF, -1.0, 0.5, 2.5, GSL::POSINF], x.radix_sort!.to_a
+
+    t = GSL::Vector[3.0, 1.0, 2.0, 1.0]
+    a = GSL::Vector[30.0, 10.0, 20.0, 11.0]
+    b = GSL::Vector::Int[3, 1, 2, 4]
+    st, sa, sb = GSL.sort_by_key(t, a, b)
+    assert_equal [1.0, 1.0, 2.0, 3.0], st.to_a
+    assert_equal [10.0, 11.0, 20.0, 30.0], sa.to_a
+    assert_equal [1, 4, 2, 3], sb.to_a
+    assert_equal [3.0, 1.0, 2.0, 1.0], t.to_a
+    GSL.sort_by_key!(t, a, algorithm: :merge)
+    assert_equal [10.0, 11.0, 20.0, 30.0], a.to_a
+    assert_raises(ArgumentError) { GSL.sort_by_key!(t, GSL::Vector[1.0]) }
+
+    # a vector given twice is moved once
+    u = GSL::Vector[3.0, 1.0, 2.0, 4.0]
+    c = GSL::Vector[30.0, 10.0, 20.0, 40.0]
+    GSL.sort_by_key!(u, u, c, c.view)
+    assert_equal [1.0, 2.0, 3.0, 4.0], u.to_a
+    assert_equal [10.0, 20.0, 30.0, 40.0], c.to_a
+    d = GSL::Vector[1, 2, 3, 4, 5, 6]
+    assert_raises(ArgumentError) { GSL.sort_by_key!(GSL::Vector[4, 3, 2, 1], d.subvector(0, 4), d.subvector(2, 4)) }
+    assert_equal [1.0, 2.0, 3.0, 4.0, 5.0, 6.0], d.to_a
+  end
+
+  def test_selection
+    v = GSL::Vector[5.0, 1.0, 4.0, 1.0, 9.0, 2.0, 6.0]
+    assert_equal [9.0, 6.0, 5.0], v.top_k(3).to_a
+    vals, idx = v.top_k(3, largest: false, index: true)
+    assert_equal [1.0, 1.0, 2.0], vals.to_a
+    assert_equal [1, 3, 5], idx.to_a
+
+    w = v.clone
+    assert_equal 4.0, w.nth_element!(3)
+    assert_equal 4.0, w[3]
+    (0...3).each { |i| assert w[i] <= 4.0 }
+    (4...7).each { |i| assert w[i] >= 4.0 }
+
+    w = v.clone
+    assert_equal 4, w.partition!(4.5)
+    assert_equal [1.0, 1.0, 2.0, 4.0], w.subvector(0, 4).to_a.sort
+
+    vi = GSL::Vector::Int[3, -1, 7, 0]
+    assert_equal [7, 3], vi.top_k(2).to_a
+    assert_equal 0, vi.clone.nth_element!(1)
+
+    rng = GSL::Rng.alloc('mt19937', 5)
+    m = GSL::Matrix.alloc(40, 5000)
+    m.size1.times { |i| m.size2.times { |j| m[i, j] = rng.uniform } }
+    top, ti = m.top_k(100, index: true, threads: 4)
+    med = m.clone.nth_element!(2500, threads: 4)
+    cnt = m.clone.partition!(0.5, threads: 4)
+    m.size1.times { |i|
+      row = m.row(i).sort
+      assert_equal row.subvector(4900, 100).to_a.reverse, top.row(i).to_a
+      assert_equal m[i, ti[i, 0]], top[i, 0]
+      assert_equal row[2500], med[i]
+      assert_equal row.to_a.count { |x| x < 0.5 }, cnt[i]
+    }
+    assert_raises(ArgumentError) { v.top_k(8) }
+    assert_raises(IndexError) { v.nth_element!(7) }
+  end
+
+
+  def test_summation
+    v = GSL::Vector.alloc(1000).set_all(0.1)
+    assert_equal 100.0, v.sum(method: :exact)
+    assert_equal 100.0, v.sum(method: :kahan)
+    assert_rel v.sum, 100.0, 1e-15, 'pairwise sum'
+
+    w = GSL::Vector[1e100, 1.0, -1e100, 1e-3]
+    assert_equal 1.001, w.sum(method: :exact)
+    assert_equal 1.001, w.sum(method: :kahan)
+    assert_equal 1.0, GSL::Vector[1e16, 1.0, -1e16].dot(GSL::Vector[1, 1, 1], method: :exact)
+    assert_equal 200000001.0, GSL::Vector.dot(GSL::Vector[1e8 + 1, 1e8], GSL::Vector[1e8 + 1, -1e8], method: :kahan)
+    assert GSL::Vector[1.0, GSL::POSINF].sum(method: :exact).infinite?
+    assert GSL::Vector[GSL::POSINF, GSL::NEGINF].sum(method: :kahan).nan?
+
+    rng = GSL::Rng.alloc('mt19937', 3)
+    x = GSL::Vector.alloc(300000)
+    x.size.times { |i| x[i] = rng.gaussian * 10**rng.uniform_int(8) }
+    exact = x.sum(method: :exact)
+    assert_equal exact, x.sum(method: :exact, threads: 4)
+    assert_equal x.sum(threads: 1), x.sum(threads: 4)
+    assert_equal x.sum(method: :kahan, threads: 1), x.sum(method: :kahan, threads: 4)
+    assert_rel x.sum(method: :kahan), exact, 1e-14, 'kahan sum'
+    assert_equal x.sumsq(method: :exact), x.dot(x, method: :exact)
+    assert_rel x.sumsq, x.sumsq(method: :exact), 1e-14, 'pairwise sumsq'
+
+    c = x.cumsum(threads: 4)
+    assert_rel c[-1], exact, 1e-14, 'cumsum'
+    assert_rel c[1000], x.subvector(0, 1001).sum(method: :exact), 1e-14, 'cumsum prefix'
+    assert_equal x.subvector(0, 10).sum(method: :exact), x.cumsum(method: :exact)[9]
+
+    assert_equal 24.0, GSL::Vector[1, 2, 3, 4].prod
+    assert_rel GSL::Vector.alloc(300).set_all(1.01).prod(method: :kahan), 1.01**300, 1e-15, 'prod'
+    assert_raises(ArgumentError) { v.sum(method: :fast) }
+  end
+
 end
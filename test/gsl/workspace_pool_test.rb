@@ -0,0 +1,56 @@
+require 'test_helper'
+
+class WorkspacePoolTest < GSL::TestCase
+
+  def setup
+    GSL.workspace_pool.clear
+  end
+
+  def test_eigen_symm
+    m = GSL::Matrix.alloc([2, 1, 0], [1, 2, 1], [0, 1, 2])
+    e0 = m.eigen_symm
+
+    3.times { assert_equal e0, m.eigen_symm }
+
+    stats = GSL.workspace_pool.stats
+    assert_equal 1, stats[:misses]
+    assert_equal 2, stats[:hits]
+    assert_equal 1, stats[:cached][:eigen_symm]
+
+    # a different size is a different key
+    GSL::Matrix.identity(4).eigen_symm
+    assert_equal 2, GSL.workspace_pool.stats[:misses]
+  end
+
+  def test_integration
+    f = GSL::Function.alloc { |x| Math.exp(-x * x) }
+    r0 = f.integration_qag(0, 1, 0.0, 1.0e-7, 1000, GSL::Integration::GAUSS15)[0]
+    2.times {
+      assert_equal r0, f.integration_qag(0, 1, 0.0, 1.0e-7, 1000, GSL::Integration::GAUSS15)[0]
+    }
+
+    stats = GSL.workspace_pool.stats
+    assert_equal 1, stats[:misses]
+    assert_equal 2, stats[:hits]
+  end
+
+  def test_clear
+    GSL::Matrix.identity(3).eigen_symmv
+    assert_equal 1, GSL.workspace_pool.stats[:size]
+
+    GSL.workspace_pool.clear
+    stats = GSL.workspace_pool.stats
+    assert_equal 0, stats[:size]
+    assert_equal 0, stats[:misses]
+  end
+
+  def test_eviction
+    capacity = GSL.workspace_pool.stats[:capacity]
+    (capacity + 2).times { |i| GSL::Matrix.identity(i + 1).eigen_symm }
+
+    stats = GSL.workspace_pool.stats
+    assert_equal capacity, stats[:size]
+    assert_equal 2, stats[:evictions]
+  end
+
+end
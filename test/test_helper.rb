@@ -15,6 +15,24 @@ GSL::Rng.env_setup
 
 class GSL::TestCase < Test::Unit::TestCase
 
+  # Compiles C source into a shared library and opens it with Fiddle, for
+  # the native callbacks; omits the test when there is no C compiler.
+  def native_library(source)
+    require 'fiddle'
+    require 'rbconfig'
+    require 'tmpdir'
+    cflags = `gsl-config --cflags 2>/dev/null`.strip rescue ''
+    Dir.mktmpdir { |dir|
+      src = File.join(dir, 'native.c')
+      lib = File.join(dir, "native.#{RbConfig::CONFIG['DLEXT']}")
+      File.write(src, source)
+      ok = system("#{RbConfig::CONFIG['CC']} -shared -fPIC #{cflags} -o #{lib} #{src}",
+                  out: File::NULL, err: File::NULL)
+      omit('no C compiler for native callbacks') unless ok
+      Fiddle.dlopen(lib)
+    }
+  end
+
   def assert_factor(result, expected, factor, desc)
     refute result == expected ? false : (
       expected.zero? ? result != expected :